@@ -0,0 +1,145 @@
+/**------------------------------------------------------------------------
+ * @file buffer_monitor.cpp
+ * @brief measure how full the flowgraph buffers run
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ----------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------
+ * Include Files
+ * ----------------------------------------------------------------------*/
+#include "application/buffer_monitor.h"
+#include <gnuradio/block_detail.h>
+#include <gnuradio/buffer.h>
+#include <algorithm>
+#include <chrono>
+
+/*-------------------------------------------------------------------------
+ * Type Definitions
+ * ----------------------------------------------------------------------*/
+static const std::chrono::milliseconds sample_period(10);
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     Buffer_Monitor
+ */
+Buffer_Monitor::Buffer_Monitor()
+    : m_samples(0),
+      m_running(false)
+{
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     ~Buffer_Monitor
+ */
+Buffer_Monitor::~Buffer_Monitor()
+{
+    stop();
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     start
+ */
+void Buffer_Monitor::start(const std::vector<std::vector<gr::block_sptr>> &chains, const std::vector<double> &rates)
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_probes.clear();
+    m_samples = 0;
+    for( size_t c = 0; c < chains.size(); c++ )
+    {
+        double rate = rates[c];
+        for( size_t i = 0; i + 1 < chains[c].size(); i++ )
+        {
+            if( i > 0 )
+            {
+                rate *= chains[c][i]->relative_rate();
+            }
+            m_probes.push_back({ chains[c][i], rate, 0, 0, 0, 0.0 });
+        }
+    }
+
+    m_running = true;
+    m_thread = std::thread(&Buffer_Monitor::run, this);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+void Buffer_Monitor::stop()
+{
+    m_running = false;
+    if( m_thread.joinable() )
+    {
+        m_thread.join();
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     run
+ */
+void Buffer_Monitor::run()
+{
+    while( m_running )
+    {
+        std::this_thread::sleep_for(sample_period);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for( probe_t &probe : m_probes )
+        {
+            gr::block_detail_sptr detail = probe.block->detail();
+            if( nullptr == detail )
+            {
+                continue;
+            }
+            gr::buffer_sptr buffer = detail->output(0);
+            // one slot is always kept empty to tell full from empty
+            probe.size = buffer->bufsize();
+            probe.now = probe.size - 1 - buffer->space_available();
+            probe.max = std::max(probe.max, probe.now);
+            probe.total += probe.now;
+        }
+        m_samples++;
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     report
+ */
+std::string Buffer_Monitor::report()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string rval = "";
+    for( probe_t &probe : m_probes )
+    {
+        double mean = m_samples ? probe.total / m_samples : 0.0;
+        rval += probe.block->name()+std::to_string(probe.block->unique_id())
+            +" size="+std::to_string(probe.size)
+            +" mean="+std::to_string((long)mean)
+            +" max="+std::to_string(probe.max)
+            +" mean_ms="+std::to_string(mean * 1e3 / probe.rate)
+            +" max_ms="+std::to_string(probe.max * 1e3 / probe.rate)+"\n";
+    }
+    return rval;
+}
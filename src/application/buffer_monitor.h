@@ -0,0 +1,99 @@
+/**-------------------------------------------------------------------------
+ * @file buffer_monitor.h
+ * @brief measure how full the flowgraph buffers run
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * -----------------------------------------------------------------------*/
+#ifndef __BUFFER_MONITOR_H__
+#define __BUFFER_MONITOR_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/block.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Samples the output buffer of every block in the chains every 10 ms.
+ * The items a buffer holds, at the rate it runs at, is the latency it
+ * adds; the report shows where the end to end latency lives.
+ */
+class Buffer_Monitor
+{
+public:
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Constructor
+     *
+     */
+    Buffer_Monitor();
+
+    /** @brief Deconstructor
+     *
+     */
+    ~Buffer_Monitor();
+
+    /** @brief start sampling, after the flowgraph is started
+     *
+     * @param chains - blocks connected output 0 to input 0
+     * @param rates - sample rate out of the first block of each chain
+     * @return Void.
+     */
+    void start(const std::vector<std::vector<gr::block_sptr>> &chains, const std::vector<double> &rates);
+
+    /** @brief stop sampling, before the flowgraph is stopped
+     *
+     * @return Void.
+     */
+    void stop();
+
+    /** @brief one line per buffer: size, mean and max fill in items and ms
+     *
+     * @return std::string
+     */
+    std::string report();
+
+private:
+    struct {
+        gr::block_sptr block;
+        double rate;            // samples per second through the buffer
+        long size;              // items, 0 until the flowgraph allocates it
+        long now;
+        long max;
+        double total;           // of the samples, for the mean
+    } typedef probe_t;
+
+    std::vector<probe_t> m_probes;
+    unsigned long m_samples;
+    std::mutex m_mutex;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    /** @brief sample every 10 ms until stopped
+     *
+     * @return Void.
+     */
+    void run();
+};
+
+#endif /* __BUFFER_MONITOR_H__ */
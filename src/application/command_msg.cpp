@@ -40,7 +40,35 @@ const std::vector<std::string> Command_Msg::short_list ({
         "t",
         "0xf0",
         "0x8f",
-        "q" });
+        "q",
+        // extended commands only have a long form
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        // split
+        "S",
+        "s",
+        "I",
+        "i",
+        "X",
+        "x",
+        // extended commands only have a long form
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "",
+        "" });
 // long commands are preceeded by '\'
 const std::vector<std::string> Command_Msg::long_list ({
         "dump_caps",
@@ -54,7 +82,32 @@ const std::vector<std::string> Command_Msg::long_list ({
         "get_ptt",
         "chk_vfo",
         "dump_state",
-        "quit" });
+        "quit",
+        "send_tones",
+        "send_carrier",
+        "send_symbols",
+        "stop_tones",
+        "get_audio_stats",
+        "get_buffers",
+        "set_split_vfo",
+        "get_split_vfo",
+        "set_split_freq",
+        "get_split_freq",
+        "set_split_mode",
+        "get_split_mode",
+        "start_recording",
+        "stop_recording",
+        "seek_playback",
+        "get_playback",
+        "replay",
+        "stop_replay",
+        "set_iq_correction",
+        "get_iq_correction",
+        "scan",
+        "stop_scan",
+        "get_scan",
+        "get_decodes",
+        "set_tx_time" });
 
 /*--------------------------------------------------------------------------
  * Function:
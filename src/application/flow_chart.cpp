@@ -28,17 +28,80 @@
 #include "application/logger.h"
 #include "application/utility.h"
 #include "application/message_queue.h"
+#include "application/realtime.h"
+#include "audio/alsa_latency.h"
+#include "sdr/sample_time.h"
 #include <stdio.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <stdexcept>
 
 /*-------------------------------------------------------------------------
  * Type Definitions
  * ----------------------------------------------------------------------*/
+const std::string Flow_Chart::shm_prefix = "shm:";
+const std::string Flow_Chart::udp_prefix = "udp:";
+const std::string Flow_Chart::file_prefix = "file:";
+
+// SCHED_FIFO priorities; the sound card can't wait, the SDR has a FIFO
+static const int audio_priority = 70;
+static const int sdr_priority = 60;
+
+// the modes a VFO takes; the receive filter is one sideband of normal width
+static const struct {
+    const char *name;
+    bool upper;
+    int normal;
+} vfo_modes[] = {
+    { "USB",    true,  2400 },
+    { "LSB",    false, 2400 },
+    { "PKTUSB", true,  5000 },
+    { "PKTLSB", false, 5000 }
+};
+// the filter edge next to the carrier, it keeps the other sideband out
+static const double vfo_mode_tw = 300.0;
+// widest signal either side of a dial that must stay inside the SDR stream
+static const double vfo_band = 5000.0;
+// share of the SDR stream a scan measures; the edges roll off
+static const double scan_span_fraction = 0.8;
+// after the SDR moves, samples to let go by before measuring
+static const double scan_settle = 0.05;
+static const size_t max_scan_steps = 1000000;
+// results kept for \get_scan; the oldest go first
+static const size_t max_scan_results = 65536;
+// decodes kept for \get_decodes; the oldest go first
+static const size_t max_decode_lines = 1000;
+// the furthest ahead \set_tx_time takes, in seconds
+static const double max_tx_wait = 3600.0;
 
 /*-------------------------------------------------------------------------
  * Function:
- *     get_audio_rate
+ *     set_mode_filter
+ */
+static void set_mode_filter( ssbrx::sptr receiver, bool upper, int passband )
+{
+    // the carrier side's transition band ends at 0 Hz
+    double edge = vfo_mode_tw / 2;
+    if( upper )
+    {
+        receiver->set_filter(edge, passband, vfo_mode_tw);
+    }
+    else
+    {
+        receiver->set_filter(-passband, -edge, vfo_mode_tw);
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_max_audio_rate
  */
-constexpr double Flow_Chart::get_audio_rate()
+constexpr double Flow_Chart::get_max_audio_rate()
 {
     return 48000;
 }
@@ -48,8 +111,27 @@ constexpr double Flow_Chart::get_audio_rate()
  */
 constexpr double Flow_Chart::set_input_rate(const double i)
 {
-    // the i here gets factored into two filters in transmitters/ssbtx.cpp
-    return i*get_audio_rate();
+    // i times the audio rate's ratio to the maximum gets factored into
+    // stages; see Receiver_Util::get_rate_stages
+    return i*get_max_audio_rate();
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_audio_rate
+ */
+double Flow_Chart::get_audio_rate()
+{
+    return m_rconfig.get_audio_rate();
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     is_audio_rate_valid
+ */
+bool Flow_Chart::is_audio_rate_valid( unsigned int rate )
+{
+    return rate == 12000 || rate == 24000 || rate == 48000;
 }
 
 // frequencies bellow this caused a seg fault
@@ -119,39 +201,141 @@ Flow_Chart::Flow_Chart(Radio_Config &rconfig, double center_freq )
     m_list.push_back(&Flow_Chart::cmd_check_vfo);
     m_list.push_back(&Flow_Chart::cmd_dump_state);
     m_list.push_back(&Flow_Chart::cmd_status);
+    m_list.push_back(&Flow_Chart::cmd_send_tones);
+    m_list.push_back(&Flow_Chart::cmd_send_carrier);
+    m_list.push_back(&Flow_Chart::cmd_send_symbols);
+    m_list.push_back(&Flow_Chart::cmd_stop_tones);
+    m_list.push_back(&Flow_Chart::cmd_get_audio_stats);
+    m_list.push_back(&Flow_Chart::cmd_get_buffers);
+    m_list.push_back(&Flow_Chart::cmd_set_split_vfo);
+    m_list.push_back(&Flow_Chart::cmd_get_split_vfo);
+    m_list.push_back(&Flow_Chart::cmd_set_split_freq);
+    m_list.push_back(&Flow_Chart::cmd_get_split_freq);
+    m_list.push_back(&Flow_Chart::cmd_set_split_mode);
+    m_list.push_back(&Flow_Chart::cmd_get_split_mode);
+    m_list.push_back(&Flow_Chart::cmd_start_recording);
+    m_list.push_back(&Flow_Chart::cmd_stop_recording);
+    m_list.push_back(&Flow_Chart::cmd_seek_playback);
+    m_list.push_back(&Flow_Chart::cmd_get_playback);
+    m_list.push_back(&Flow_Chart::cmd_replay);
+    m_list.push_back(&Flow_Chart::cmd_stop_replay);
+    m_list.push_back(&Flow_Chart::cmd_set_iq_correction);
+    m_list.push_back(&Flow_Chart::cmd_get_iq_correction);
+    m_list.push_back(&Flow_Chart::cmd_scan);
+    m_list.push_back(&Flow_Chart::cmd_stop_scan);
+    m_list.push_back(&Flow_Chart::cmd_get_scan);
+    m_list.push_back(&Flow_Chart::cmd_get_decodes);
+    m_list.push_back(&Flow_Chart::cmd_set_tx_time);
 
     m_rconfig = rconfig;
     // initialize member variables
     m_ptt = PTT_RX;
-    m_vfo = "VFO";
+    m_vfo = 0;
+    m_split = false;
+    // VFOB, made by make_vfos
+    m_tx_vfo = 1;
+    m_slice = -1;
+    m_scan.active = false;
+    m_scan.moved = false;
+    m_scan.done = 0;
+    m_scan.seconds = 0;
 
     // sound pointers
     std::string program_name = m_rconfig.get_program_name();
-    m_alsa_sink = gnuradio::get_initial_sptr(new gr::audio::alsa_sink(get_audio_rate(), m_rconfig.get_sound_output_alsa(), true ));
-    m_alsa_source = gnuradio::get_initial_sptr(new gr::audio::alsa_source(get_audio_rate(), m_rconfig.get_sound_input_alsa(), true ));
+    make_audio();
 
     // SDR pointers
-    std::string serial = rconfig.get_sdr().serial; 
-    double input_rate = get_input_rate(m_rconfig.get_sdr_type());
-    double min_freq = get_min_freq(m_rconfig.get_sdr_type());
-    if(center_freq < min_freq)
+    double min_freq;
+    Radio_Config::playback_t playback = m_rconfig.get_playback();
+    m_sc16 = m_rconfig.get_sc16();
+    if( !playback.path.empty() )
+    {
+        if( m_sc16 )
+        {
+            // the file source always makes gr_complex
+            Logger::warn("[Flow_Chart::Flow_Chart] sc16 is ignored during playback");
+            m_sc16 = false;
+        }
+        m_playback = Playback_Source_c::make( playback.path, playback.realtime, playback.loop );
+        m_input_rate = m_playback->get_rate();
+        // the receivers' rate change plans only divide multiples of this
+        if( 0 != fmod(m_input_rate, get_max_audio_rate()) )
+        {
+            Logger::crit("[Flow_Chart::Flow_Chart] "+playback.path+": the sample rate "+std::to_string(m_input_rate)
+                +" is not a multiple of "+std::to_string(get_max_audio_rate()));
+            throw std::runtime_error("Flow_Chart");
+        }
+        min_freq = m_playback->get_recorded_frequency() - m_input_rate / 2;
+        if( !m_playback->set_center_frequency(center_freq) )
+        {
+            center_freq = m_playback->get_recorded_frequency();
+        }
+        m_sdr_source = m_playback;
+        m_sdr_sink = Playback_Sink_c::make( center_freq, m_input_rate );
+    }
+    else
+    {
+        std::string serial = rconfig.get_sdr().serial; 
+        m_input_rate = get_input_rate(m_rconfig.get_sdr_type());
+        min_freq = get_min_freq(m_rconfig.get_sdr_type());
+        if(center_freq < min_freq)
+        {
+            center_freq = Limey_Device_List::oscillator;
+        }
+        m_sdr_source = Limey_Source_c::make( serial, center_freq, m_input_rate, min_freq, m_sc16 );
+        m_sdr_sink = Limey_Sink_c::make( serial, center_freq, m_input_rate, min_freq, m_sc16 );
+    }
+    m_recorder = iq_recorder_c::make(m_sc16);
+    m_iq_correct = iq_correct_c::make(m_input_rate, m_sc16);
+    m_scan_power = scan_power_c::make(m_input_rate, m_sc16);
+    Radio_Config::spectrum_t spectrum = m_rconfig.get_spectrum();
+    if( 0 < spectrum.fft_size )
     {
-        center_freq = Limey_Device_List::oscillator;
+        if( 0 == spectrum.decimation )
+        {
+            // about 10 frames a second
+            spectrum.decimation = std::max(1L, std::lround(m_input_rate / (10.0 * spectrum.fft_size * spectrum.average)));
+        }
+        m_spectrum_tap = spectrum_tap_c::make(m_input_rate, spectrum.fft_size, spectrum.average, spectrum.decimation, spectrum.name, m_sc16);
+        m_spectrum_tap->set_frequency(m_sdr_source->get_center_frequency());
     }
-    m_sdr_source = Limey_Source_c::make( serial, center_freq, input_rate, min_freq );
-    m_sdr_sink = Limey_Sink_c::make( serial, center_freq, input_rate, min_freq );
 
     // receiver
-    m_receiver = ssbrx::make(input_rate, get_audio_rate());
+    if( !m_sc16 )
+    {
+        m_rx_tuner = gr::blocks::rotator_cc::make(0.0);
+    }
+    // the replay ring and "tap" I & Q servers are fed all of output 1, so
+    // it must be clean across it
+    bool wide_tap = 0 < m_rconfig.get_replay().seconds;
+    for( Radio_Config::iq_server_t server : m_rconfig.get_iq_servers() )
+    {
+        wide_tap = wide_tap || "tap" == server.point;
+    }
+    m_receiver = ssbrx::make(m_input_rate, get_audio_rate(), m_sc16, wide_tap);
     // transmitter
-    m_transmitter = ssbtx::make(input_rate, get_audio_rate());
+    // the sc16 sink starts a scheduled burst on the LimeSDR's own clock
+    m_transmitter = ssbtx::make(m_input_rate, get_audio_rate(), m_sc16);
+    if( m_sc16 )
+    {
+        // full scale is 32767; complex_to_interleaved_short only rounds
+        m_tx_scale = gr::blocks::multiply_const_cc::make(gr_complex(32767.0, 0.0));
+        m_tx_sc16 = gr::blocks::complex_to_interleaved_short::make(true);
+    }
+    // extra receivers
+    make_slices(m_input_rate);
+    make_vfos(center_freq);
+    make_replay();
+    make_iq_servers();
+    make_decoders();
 
     // create the range list for receive and transmit
     // mode information is from include/hamlib/rig.h
     unsigned long long int rig_mode_usb = 1ull << 2; 
     unsigned long long int rig_mode_lsb = 1ull << 3; 
+    unsigned long long int rig_mode_pktlsb = 1ull << 10; 
     unsigned long long int rig_mode_pktusb = 1ull << 11; 
-    unsigned long long int mode = rig_mode_usb | rig_mode_lsb | rig_mode_pktusb ;
+    unsigned long long int mode = rig_mode_usb | rig_mode_lsb | rig_mode_pktlsb | rig_mode_pktusb ;
     double max_freq = 3000000000; // 3 GHz
     int low_power = -1;
     int high_power = -1;
@@ -186,11 +370,16 @@ void Flow_Chart::start( void )
     m_top_block = gr::make_top_block("top_block");
     try
     {
-        m_top_block->connect( m_sdr_source, 0, m_receiver, 0);
-        m_top_block->connect( m_receiver, 0, m_alsa_sink, 0);
-
-        m_top_block->connect( m_alsa_source, 0, m_transmitter, 0);
-        m_top_block->connect( m_transmitter, 0, m_sdr_sink, 0);
+        for( auto &chain : get_chains() )
+        {
+            for( size_t i = 1; i < chain.size(); i++ )
+            {
+                m_top_block->connect( chain[i-1], 0, chain[i], 0);
+            }
+        }
+        connect_slices(true);
+        connect_replay(true);
+        connect_iq_servers(true);
     }
     catch(std::invalid_argument& e)
     {
@@ -198,7 +387,25 @@ void Flow_Chart::start( void )
         throw std::string(e.what());
     }
 
+    set_affinity();
+
+    // buffers are allocated when the flowgraph starts
+    std::vector<std::vector<gr::block_sptr>> block_chains = get_block_chains();
+    std::vector<double> rates = { m_input_rate, get_audio_rate() };
+    for( size_t i = 0; i < block_chains.size(); i++ )
+    {
+        Latency_Profile::apply(m_rconfig.get_latency_profile(), block_chains[i], rates[i]);
+    }
+    Logger::info("[Flow_Chart::start] latency profile: "+Latency_Profile::name(m_rconfig.get_latency_profile()));
+
     m_top_block->start();
+    m_buffers.start(block_chains, rates);
+
+    if( m_rconfig.get_realtime() )
+    {
+        set_priorities();
+    }
+    Realtime::report_threads();
 }
 
 /*-------------------------------------------------------------------------
@@ -209,14 +416,27 @@ void Flow_Chart::stop( void )
 {
     if( nullptr != m_top_block )
     {
+        m_buffers.stop();
+        std::istringstream report(m_buffers.report());
+        std::string line;
+        while( std::getline(report, line) )
+        {
+            Logger::info("[Flow_Chart::stop] buffer "+line);
+        }
+
         m_top_block->stop();
         m_top_block->wait();
 
-        m_top_block->disconnect( m_sdr_source, 0, m_receiver, 0);
-        m_top_block->disconnect( m_receiver, 0, m_alsa_sink, 0);
-
-        m_top_block->disconnect( m_alsa_source, 0, m_transmitter, 0);
-        m_top_block->disconnect( m_transmitter, 0, m_sdr_sink, 0);
+        for( auto &chain : get_chains() )
+        {
+            for( size_t i = 1; i < chain.size(); i++ )
+            {
+                m_top_block->disconnect( chain[i-1], 0, chain[i], 0);
+            }
+        }
+        connect_slices(false);
+        connect_replay(false);
+        connect_iq_servers(false);
 
         m_top_block = nullptr;
     }
@@ -224,212 +444,1168 @@ void Flow_Chart::stop( void )
 
 /*-------------------------------------------------------------------------
  * Function:
- *     listen
+ *     get_block_chains
  */
-void Flow_Chart::listen( void )
+std::vector<std::vector<gr::block_sptr>> Flow_Chart::get_block_chains( void )
 {
-    Message_Queue::sptr cmd_queue = m_rconfig.get_cmd_queue();
-    Message_Queue::sptr rsp_queue = m_rconfig.get_rsp_queue();
-    while( !cmd_queue->empty() )
+    std::vector<gr::block_sptr> rx = m_sdr_source->get_blocks();
+    rx.push_back(m_iq_correct);
+    if( nullptr != m_rx_tuner )
     {
-        std::string param = "";
-        Message_Queue::message_t msg_struct = cmd_queue->pop_struct();
-        std::string msg = msg_struct.msg;
-        // get the index
-        int index = Command_Msg::get_index(msg);
-        std::size_t list_size = m_list.size();
-        if(-1 < index && index < (int)list_size)
-        {
-            Flow_Chart_fnc_ptr cmd_fnc = m_list[index];
-            std::string rsp = (this->*cmd_fnc)(msg);
-            Message_Queue::message_t rsp_struct;
-            rsp_struct.msg = rsp;
-            rsp_struct.fd = msg_struct.fd;
-            rsp_queue->push(rsp_struct);
-        }
-        else
-        {
-            Logger::warn("[Flow_Chart::listen] This command does not have a matching function pointer "+msg);
-            Message_Queue::message_t rsp_struct;
-            rsp_struct.msg = Command_Msg::append_delim("RPRT -4");
-            rsp_struct.fd = msg_struct.fd;
-            rsp_queue->push(rsp_struct);
-        }
+        rx.push_back(m_rx_tuner);
+    }
+    for( gr::block_sptr block : m_receiver->get_blocks() )
+    {
+        rx.push_back(block);
+    }
+    if( nullptr != m_rx_drift )
+    {
+        rx.push_back(m_rx_drift);
+    }
+    rx.push_back(m_audio_sink);
+
+    std::vector<gr::block_sptr> tx = { m_audio_source };
+    if( nullptr != m_tx_drift )
+    {
+        tx.push_back(m_tx_drift);
+    }
+    for( gr::block_sptr block : m_transmitter->get_blocks() )
+    {
+        tx.push_back(block);
+    }
+    if( nullptr != m_tx_sc16 )
+    {
+        tx.push_back(m_tx_scale);
+        tx.push_back(m_tx_sc16);
     }
+    for( gr::block_sptr block : m_sdr_sink->get_blocks() )
+    {
+        tx.push_back(block);
+    }
+
+    return { rx, tx };
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_set_freq
+ *     set_priorities
  */
-std::string Flow_Chart::cmd_set_freq(std::string cmd)
+void Flow_Chart::set_priorities( void )
 {
-    std::string rval;
-    unsigned int freq = 0;
-    // parse cmd
-    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
-    // rval is set if stoui is false
-    // freq is set if stoui is true
-    if(Utility::stoui(param,&freq,&rval))
+    // only blocks the hardware paces; one that never waits, like a file or
+    // a playback, would spin SCHED_FIFO and starve the host
+    if( nullptr != boost::dynamic_pointer_cast<gr::audio::alsa_sink>(m_audio_sink) )
     {
-        Logger::debug("[Flow_Chart::cmd_set_freq] frequency="+std::to_string(freq));
-        // TODO: check if(m_ptt == PTT_RX) before allowed to change freq
-        bool source = m_sdr_source->set_center_frequency(freq);
-        bool sink = m_sdr_sink->set_center_frequency(freq);
-        if( !(source && sink) )
-        {
-            Logger::notice("There was a error chaning the frequency.");
-        }
-        rval = Command_Msg::append_delim("RPRT 0");
+        Realtime::set_fifo(m_audio_sink, audio_priority);
     }
-    return rval;
+    if( nullptr != boost::dynamic_pointer_cast<gr::audio::alsa_source>(m_audio_source) )
+    {
+        Realtime::set_fifo(m_audio_source, audio_priority);
+    }
+    // the playback SDR blocks ignore this
+    m_sdr_source->set_thread_priority(sdr_priority);
+    m_sdr_sink->set_thread_priority(sdr_priority);
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_get_freq
+ *     set_affinity
  */
-std::string Flow_Chart::cmd_get_freq(std::string cmd)
+void Flow_Chart::set_affinity( void )
 {
-    std::string rval = "";
-    double source = m_sdr_source->get_center_frequency();
-    double sink = m_sdr_sink->get_center_frequency();
-    if(source == sink)
+    typedef std::function<void(const std::vector<int>&)> pin_t;
+    std::map<std::string, pin_t> roles = {
+        { "sdr_source",   [this](const std::vector<int> &m){ m_sdr_source->set_processor_affinity(m); } },
+        { "iq_correct",   [this](const std::vector<int> &m){ m_iq_correct->set_processor_affinity(m); } },
+        { "scan",         [this](const std::vector<int> &m){ m_scan_power->set_processor_affinity(m); } },
+        { "receiver",     [this](const std::vector<int> &m){ m_receiver->set_processor_affinity(m); } },
+        { "audio_sink",   [this](const std::vector<int> &m){ m_audio_sink->set_processor_affinity(m); } },
+        { "audio_source", [this](const std::vector<int> &m){ m_audio_source->set_processor_affinity(m); } },
+        { "transmitter",  [this](const std::vector<int> &m){ m_transmitter->set_processor_affinity(m); } },
+        { "sdr_sink",     [this](const std::vector<int> &m){ m_sdr_sink->set_processor_affinity(m); } }
+    };
+    if( nullptr != m_rx_tuner )
     {
-        rval = std::to_string(source);
+        roles["receiver"] = [this](const std::vector<int> &m){ m_rx_tuner->set_processor_affinity(m);
+                                                               m_receiver->set_processor_affinity(m); };
     }
-    else
+    if( nullptr != m_tx_sc16 )
     {
-        rval = std::to_string(source)+" "+std::to_string(sink);
+        roles["transmitter"] = [this](const std::vector<int> &m){ m_transmitter->set_processor_affinity(m);
+                                                                  m_tx_scale->set_processor_affinity(m);
+                                                                  m_tx_sc16->set_processor_affinity(m); };
+    }
+    if( nullptr != m_spectrum_tap )
+    {
+        roles["spectrum"] = [this](const std::vector<int> &m){ m_spectrum_tap->set_processor_affinity(m); };
+    }
+    if( nullptr != m_rx_drift )
+    {
+        roles["rx_drift"] = [this](const std::vector<int> &m){ m_rx_drift->set_processor_affinity(m); };
+    }
+    if( nullptr != m_tx_drift )
+    {
+        roles["tx_drift"] = [this](const std::vector<int> &m){ m_tx_drift->set_processor_affinity(m); };
+    }
+
+    std::istringstream list(m_rconfig.get_affinity());
+    std::string item;
+    while( std::getline(list, item, ',') )
+    {
+        size_t eq = item.find('=');
+        std::vector<int> mask;
+        if( eq == std::string::npos || !Realtime::parse_cpus(item.substr(eq + 1), &mask) )
+        {
+            Logger::warn("[Flow_Chart::set_affinity] expected role=cpus, got "+item);
+            continue;
+        }
+
+        auto role = roles.find(item.substr(0, eq));
+        if( role == roles.end() )
+        {
+            Logger::warn("[Flow_Chart::set_affinity] no block for "+item.substr(0, eq));
+            continue;
+        }
+        role->second(mask);
     }
-    return (Command_Msg::append_delim(rval));
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_set_mode
+ *     is_wav
  */
-std::string Flow_Chart::cmd_set_mode(std::string cmd)
+static bool is_wav(const std::string &path)
 {
-    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
-    Logger::debug("[Flow_Chart::cmd_set_mode] mode="+param);
-    return (Command_Msg::append_delim("RPRT 0"));
+    std::string ext = path.size() < 4 ? "" : path.substr(path.size() - 4);
+    for( char &c : ext )
+    {
+        c = tolower(c);
+    }
+    return ext == ".wav";
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_get_mode
+ *     make_audio
  */
-std::string Flow_Chart::cmd_get_mode(std::string cmd)
+void Flow_Chart::make_audio( void )
 {
-    return (Command_Msg::append_delim("PKTUSB"));
+    std::string output = m_rconfig.get_sound_output_alsa();
+    std::string input = m_rconfig.get_sound_input_alsa();
+
+    m_audio_sink = make_audio_sink(output, &m_rx_drift);
+
+    if( 0 == input.compare(0, shm_prefix.size(), shm_prefix) )
+    {
+        m_audio_source = shm_audio_source_f::make(input.substr(shm_prefix.size()), get_audio_rate());
+    }
+    else if( 0 == input.compare(0, udp_prefix.size(), udp_prefix) )
+    {
+        m_audio_source = udp_audio_source_f::make(input.substr(udp_prefix.size()), get_audio_rate());
+    }
+    else if( 0 == input.compare(0, file_prefix.size(), file_prefix) )
+    {
+        std::string path = input.substr(file_prefix.size());
+        if( is_wav(path) )
+        {
+            gr::blocks::wavfile_source::sptr wav = gr::blocks::wavfile_source::make(path.c_str());
+            if( wav->sample_rate() != get_audio_rate() || wav->channels() != 1 )
+            {
+                // played as is from the first channel, no resampling
+                Logger::warn("[Flow_Chart::make_audio] "+path+" is "+std::to_string(wav->channels())
+                    +" channel "+std::to_string(wav->sample_rate())+" Hz; expected mono "
+                    +std::to_string((int)get_audio_rate())+" Hz");
+            }
+            m_audio_source = wav;
+        }
+        else
+        {
+            m_audio_source = gr::blocks::file_source::make(sizeof(float), path.c_str());
+        }
+    }
+    else
+    {
+        gr::audio::alsa_source_sptr alsa_source = gnuradio::get_initial_sptr(new gr::audio::alsa_source(get_audio_rate(), input, true ));
+        m_tx_drift = drift_resampler_ff::make([alsa_source]() { return alsa_source->fill_level(); });
+        m_audio_source = alsa_source;
+    }
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_set_vfo
+ *     make_audio_sink
  */
-std::string Flow_Chart::cmd_set_vfo(std::string cmd)
+gr::block_sptr Flow_Chart::make_audio_sink( const std::string &output, drift_resampler_ff::sptr *drift )
 {
-    const std::vector<std::string> vfo_list = 
-        { "VFOA",
-          "VFOB",
-          "VFOC",
-          "currVFO",
-          "VFO",
-          "MEM",
-          "Main",
-          "Sub",
-          "TX",
-          "RX" };
-    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
-    Logger::debug("[Flow_Chart::cmd_set_vfo] vfo="+param);
-    for(unsigned int i = 0; i < vfo_list.size(); i++)
+    gr::block_sptr audio_sink;
+    if( 0 == output.compare(0, shm_prefix.size(), shm_prefix) )
+    {
+        // the SDR clock paces both ends of the ring, nothing to track
+        audio_sink = shm_audio_sink_f::make(output.substr(shm_prefix.size()), get_audio_rate());
+    }
+    else if( 0 == output.compare(0, udp_prefix.size(), udp_prefix) )
+    {
+        // the far end's jitter buffer takes up any clock difference
+        audio_sink = udp_audio_sink_f::make(output.substr(udp_prefix.size()), get_audio_rate());
+    }
+    else if( 0 == output.compare(0, file_prefix.size(), file_prefix) )
     {
-        if(param == vfo_list[i])
+        // a file never blocks, so the receive chain runs as fast as its source
+        std::string path = output.substr(file_prefix.size());
+        if( is_wav(path) )
+        {
+            audio_sink = gr::blocks::wavfile_sink::make(path.c_str(), 1, get_audio_rate(), 16);
+        }
+        else
         {
-            m_vfo = vfo_list[i];
-            return (Command_Msg::append_delim("RPRT 0"));
+            audio_sink = gr::blocks::file_sink::make(sizeof(float), path.c_str());
         }
     }
-    return (Command_Msg::append_delim("RPRT -9"));
+    else
+    {
+        gr::audio::alsa_sink_sptr alsa_sink = gnuradio::get_initial_sptr(new gr::audio::alsa_sink(get_audio_rate(), output, true ));
+        // hold the ALSA ring half full against sound card clock drift
+        *drift = drift_resampler_ff::make([alsa_sink]() { return alsa_sink->fill_level(); });
+        audio_sink = alsa_sink;
+    }
+    return audio_sink;
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_get_vfo
+ *     make_slices
  */
-std::string Flow_Chart::cmd_get_vfo(std::string cmd)
+void Flow_Chart::make_slices( double input_rate )
 {
-    return (Command_Msg::append_delim(m_vfo));
+    std::vector<Radio_Config::slice_t> slices = m_rconfig.get_slices();
+    if( slices.empty() )
+    {
+        return;
+    }
+
+    // channels a max audio rate apart divide every SDR rate
+    m_wideband = wideband_rx::make(input_rate, get_audio_rate(), get_max_audio_rate(), slices.size());
+    if( m_sc16 )
+    {
+        // the channelizer only takes gr_complex
+        m_wideband_sc16 = gr::blocks::interleaved_short_to_complex::make(true);
+        m_wideband_scale = gr::blocks::multiply_const_cc::make(gr_complex(1.0 / 32768.0, 0.0));
+    }
+    for( size_t i = 0; i < slices.size(); i++ )
+    {
+        slice_state_t slice;
+        slice.config = slices[i];
+        slice.cmd_queue = Message_Queue::make();
+        slice.rsp_queue = Message_Queue::make();
+        slice.server = std::make_shared<Message_Server>(slice.cmd_queue, slice.rsp_queue, slice.config.port);
+        try
+        {
+            slice.server->connect();
+        }
+        catch (const char* msg)
+        {
+            Logger::crit("[Flow_Chart::make_slices] can not open port "+std::to_string(slice.config.port));
+            exit(1);
+        }
+        slice.audio_sink = make_audio_sink(slice.config.audio, &slice.drift);
+        // VFOA is the main port's
+        slice.vfo = i + 1;
+        m_slices.push_back(slice);
+    }
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_get_mode
+ *     connect_slices
  */
-std::string Flow_Chart::cmd_set_ptt(std::string cmd)
+void Flow_Chart::connect_slices( bool do_connect )
 {
-    std::string rval;
-    unsigned int mode = PTT_SIZE;
-    // parse cmd
-    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
-    if(Utility::stoui(param,&mode,&rval))
+    if( nullptr == m_wideband )
     {
-        if(PTT_SIZE > mode)
+        return;
+    }
+
+    std::vector<std::vector<gr::basic_block_sptr>> chains;
+    for( slice_state_t &slice : m_slices )
+    {
+        std::vector<gr::basic_block_sptr> chain;
+        if( nullptr != slice.drift )
         {
-            Logger::debug("[Flow_Chart::cmd_set_ptt] ptt="+std::to_string(mode));
-            m_ptt = (PTT_ENUM)(mode);
-            if(mode == PTT_RX)
+            chain.push_back(slice.drift);
+        }
+        chain.push_back(slice.audio_sink);
+        chains.push_back(chain);
+    }
+
+    std::vector<gr::basic_block_sptr> input = { m_iq_correct };
+    if( nullptr != m_wideband_sc16 )
+    {
+        input.push_back(m_wideband_sc16);
+        input.push_back(m_wideband_scale);
+    }
+    input.push_back(m_wideband);
+    for( size_t i = 1; i < input.size(); i++ )
+    {
+        if( do_connect )
+        {
+            m_top_block->connect( input[i-1], 0, input[i], 0);
+        }
+        else
+        {
+            m_top_block->disconnect( input[i-1], 0, input[i], 0);
+        }
+    }
+    // slice i is on the wideband receiver's output i
+    for( size_t i = 0; i < chains.size(); i++ )
+    {
+        gr::basic_block_sptr last = m_wideband;
+        int port = i;
+        for( gr::basic_block_sptr block : chains[i] )
+        {
+            if( do_connect )
             {
-                m_transmitter->ptt_off();
+                m_top_block->connect( last, port, block, 0);
             }
             else
             {
-                m_transmitter->ptt_on();
+                m_top_block->disconnect( last, port, block, 0);
             }
-            rval = Command_Msg::append_delim("RPRT 0");
-        }
-        else
-        {
-            rval = Utility::INVALID_PARAM;
+            last = block;
+            port = 0;
         }
     }
-    return rval;
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_get_mode
+ *     make_replay
  */
-std::string Flow_Chart::cmd_get_ptt(std::string cmd)
+void Flow_Chart::make_replay( void )
 {
-    unsigned int ptt_mode = (unsigned int) m_ptt;
-    std::string rval (Command_Msg::append_delim(ptt_mode));
-    return rval;
+    Radio_Config::replay_t replay = m_rconfig.get_replay();
+    if( 0 >= replay.seconds )
+    {
+        return;
+    }
+    // after the first stage the ring costs a fraction of the SDR rate,
+    // and still covers more than VFOA's passband
+    double rate = m_receiver->get_tap_rate();
+    m_ring = iq_ring_c::make(rate, replay.seconds);
+    m_replay_sink = make_audio_sink(replay.audio, &m_replay_drift);
+    // a file takes a replay as fast as it comes, anything else in real time
+    bool realtime = 0 != replay.audio.compare(0, file_prefix.size(), file_prefix);
+    m_replay = iq_replay_c::make(m_ring, realtime);
+    m_replay_receiver = ssbrx::make(rate, get_audio_rate());
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_check_vfo
+ *     connect_replay
  */
-std::string Flow_Chart::cmd_check_vfo(std::string cmd)
+void Flow_Chart::connect_replay( bool do_connect )
 {
-    std::string rval (Command_Msg::append_delim("CHKVFO 0"));
-    return rval;
-}
+    if( nullptr == m_ring )
+    {
+        return;
+    }
 
-/*-------------------------------------------------------------------------
- * Function:
- *     cmd_dump_state(
- */
-std::string Flow_Chart::cmd_dump_state(std::string cmd)
-{
-    std::vector<std::string> state = 
-                       { "0", // always 0
-                         "2", // %d rig->caps->rig_model Hamlib NET rigctl
-                         "2", // %d rs->itu_region RIG_ITU_REGION2
-                         // repeat the following for each in rs->rx_range_list
+    // the ring hangs off output 1, the live audio carries on from output 0
+    std::vector<std::pair<gr::basic_block_sptr, int>> chain = {
+        { m_replay, 0 }, { m_replay_receiver, 0 } };
+    if( nullptr != m_replay_drift )
+    {
+        chain.push_back({ m_replay_drift, 0 });
+    }
+    chain.push_back({ m_replay_sink, 0 });
+
+    if( do_connect )
+    {
+        m_top_block->connect( m_receiver, 1, m_ring, 0);
+    }
+    else
+    {
+        m_top_block->disconnect( m_receiver, 1, m_ring, 0);
+    }
+    for( size_t i = 1; i < chain.size(); i++ )
+    {
+        if( do_connect )
+        {
+            m_top_block->connect( chain[i-1].first, chain[i-1].second, chain[i].first, 0);
+        }
+        else
+        {
+            m_top_block->disconnect( chain[i-1].first, chain[i-1].second, chain[i].first, 0);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     make_iq_servers
+ */
+void Flow_Chart::make_iq_servers( void )
+{
+    for( Radio_Config::iq_server_t server : m_rconfig.get_iq_servers() )
+    {
+        // "tap" is output 1, wide and first stage decimated; "filter" is
+        // output 2, VFOA's passband at the audio rate
+        bool tap = "tap" == server.point;
+        double rate = tap ? m_receiver->get_tap_rate() : m_receiver->get_audio_rate();
+        m_iq_servers.push_back(iq_server_c::make(server.port, rate,
+            server.native ? iq_server_c::NATIVE : iq_server_c::RTL_TCP));
+        Logger::info("[Flow_Chart::make_iq_servers] port "+std::to_string(server.port)+": "+std::to_string(rate)+" samples/s, clean over "
+            +std::to_string(tap ? m_receiver->get_tap_width() : rate)+" Hz");
+        m_iq_server_ports.push_back(tap ? 1 : 2);
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     connect_iq_servers
+ */
+void Flow_Chart::connect_iq_servers( bool do_connect )
+{
+    for( size_t i = 0; i < m_iq_servers.size(); i++ )
+    {
+        if( do_connect )
+        {
+            m_top_block->connect( m_receiver, m_iq_server_ports[i], m_iq_servers[i], 0);
+        }
+        else
+        {
+            m_top_block->disconnect( m_receiver, m_iq_server_ports[i], m_iq_servers[i], 0);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     make_decoders
+ */
+void Flow_Chart::make_decoders( void )
+{
+    for( Radio_Config::decoder_t config : m_rconfig.get_decoders() )
+    {
+        slot_decoder_f::slot_mode_t mode = ("wspr" == config.mode) ? slot_decoder_f::WSPR : slot_decoder_f::FT8;
+        slot_decoder_f::sptr decoder = slot_decoder_f::make(mode, get_audio_rate(), config.udp);
+        decoder->set_dial(m_vfos[0].freq);
+        m_decoders.push_back(decoder);
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     poll_decoders
+ */
+void Flow_Chart::poll_decoders( void )
+{
+    for( slot_decoder_f::sptr decoder : m_decoders )
+    {
+        decoder->heartbeat();
+        for( const slot_decoder_f::decode_t &decode : decoder->get_decodes() )
+        {
+            time_t start = (time_t)decode.slot;
+            struct tm utc;
+            gmtime_r(&start, &utc);
+            char line[128];
+            snprintf(line, sizeof(line), "%02d%02d%02d %s %d %.1f %.0f ", utc.tm_hour, utc.tm_min, utc.tm_sec,
+                decode.mode.c_str(), decode.snr, decode.dt, decode.freq);
+            m_decodes.push_back(line + decode.message);
+        }
+    }
+    while( m_decodes.size() > max_decode_lines )
+    {
+        m_decodes.pop_front();
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     make_vfos
+ */
+void Flow_Chart::make_vfos( double center_freq )
+{
+    vfo_t vfo;
+    vfo.name = "VFOA";
+    vfo.freq = center_freq;
+    vfo.receiver = m_receiver;
+    m_vfos.push_back(vfo);
+    for( size_t i = 0; i < m_slices.size(); i++ )
+    {
+        vfo.name = std::string("VFO") + (char)('B' + i);
+        vfo.freq = m_slices[i].config.freq;
+        vfo.receiver = m_wideband->get_receiver(i);
+        m_vfos.push_back(vfo);
+    }
+    if( m_vfos.size() < 2 )
+    {
+        // rigctl clients expect a VFOB; without a slice it only has a dial
+        vfo.name = "VFOB";
+        vfo.freq = center_freq;
+        vfo.receiver = nullptr;
+        m_vfos.push_back(vfo);
+    }
+
+    for( size_t i = 0; i < m_vfos.size(); i++ )
+    {
+        set_vfo_mode(i, "PKTUSB", 0);
+        if( !tune_vfo(i, m_vfos[i].freq) )
+        {
+            Logger::warn("[Flow_Chart::make_vfos] could not tune "+m_vfos[i].name+" to "+std::to_string(m_vfos[i].freq));
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_current_vfo
+ */
+size_t &Flow_Chart::get_current_vfo( void )
+{
+    if( m_slice >= 0 )
+    {
+        return m_slices[m_slice].vfo;
+    }
+    return m_vfo;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     find_vfo
+ */
+bool Flow_Chart::find_vfo( const std::string &name, size_t *vfo )
+{
+    if( name == "currVFO" || name == "VFO" || name == "MEM" )
+    {
+        *vfo = get_current_vfo();
+        return true;
+    }
+    // hamlib's other names for the first two
+    if( name == "TX" )
+    {
+        *vfo = m_split ? m_tx_vfo : 0;
+        return true;
+    }
+    std::string vfo_name = name;
+    if( name == "Main" || name == "RX" )
+    {
+        vfo_name = "VFOA";
+    }
+    else if( name == "Sub" )
+    {
+        vfo_name = "VFOB";
+    }
+    for( size_t i = 0; i < m_vfos.size(); i++ )
+    {
+        if( m_vfos[i].name == vfo_name )
+        {
+            *vfo = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_max_offset
+ */
+double Flow_Chart::get_max_offset( size_t vfo )
+{
+    if( 0 == vfo )
+    {
+        return m_input_rate / 2 - vfo_band;
+    }
+    return m_wideband->get_max_offset();
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     is_in_span
+ */
+bool Flow_Chart::is_in_span( double lo )
+{
+    for( size_t i = 0; i < m_vfos.size(); i++ )
+    {
+        if( nullptr != m_vfos[i].receiver && std::abs(m_vfos[i].freq - lo) > get_max_offset(i) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_vfo_offset
+ */
+bool Flow_Chart::set_vfo_offset( size_t vfo )
+{
+    double offset = m_vfos[vfo].freq - m_sdr_source->get_center_frequency();
+    if( nullptr == m_vfos[vfo].receiver || std::abs(offset) > get_max_offset(vfo) )
+    {
+        return false;
+    }
+    if( 0 == vfo && nullptr == m_rx_tuner )
+    {
+        m_receiver->set_offset(offset);
+        return true;
+    }
+    if( 0 == vfo )
+    {
+        m_rx_tuner->set_phase_inc(-2.0 * M_PI * offset / m_input_rate);
+        return true;
+    }
+    return m_wideband->set_offset(vfo - 1, offset);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     tune_vfo
+ */
+bool Flow_Chart::tune_vfo( size_t vfo, double freq )
+{
+    bool rval = true;
+    m_vfos[vfo].freq = freq;
+    if( 0 == vfo )
+    {
+        for( slot_decoder_f::sptr decoder : m_decoders )
+        {
+            decoder->set_dial(freq);
+        }
+    }
+    if( vfo == (m_split ? m_tx_vfo : 0) )
+    {
+        rval = tune_tx();
+    }
+    if( nullptr == m_vfos[vfo].receiver )
+    {
+        return rval;
+    }
+
+    if( is_in_span(m_sdr_source->get_center_frequency()) )
+    {
+        // the other VFOs don't hear a thing
+        return set_vfo_offset(vfo) && rval;
+    }
+    if( m_scan.active )
+    {
+        // the scan has the SDR; it comes back to the VFOs at the end
+        return rval;
+    }
+
+    // center the SDR on all the receiving VFOs, or on this one if they don't fit
+    double low = freq;
+    double high = freq;
+    for( vfo_t &other : m_vfos )
+    {
+        if( nullptr != other.receiver )
+        {
+            low = std::min(low, other.freq);
+            high = std::max(high, other.freq);
+        }
+    }
+    double lo = (low + high) / 2;
+    if( !is_in_span(lo) )
+    {
+        lo = freq;
+    }
+    return move_sdr(lo) && rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     move_sdr
+ */
+bool Flow_Chart::move_sdr( double lo )
+{
+    bool rval = m_sdr_source->set_center_frequency(lo);
+    Logger::info("[Flow_Chart::move_sdr] SDR moved to "+std::to_string(m_sdr_source->get_center_frequency()));
+    // the LO leakage and the mixer's balance move with the LO
+    m_iq_correct->reset();
+    m_recorder->set_frequency(m_sdr_source->get_center_frequency());
+    if( nullptr != m_spectrum_tap )
+    {
+        m_spectrum_tap->set_frequency(m_sdr_source->get_center_frequency());
+    }
+
+    for( size_t i = 0; i < m_vfos.size(); i++ )
+    {
+        if( nullptr != m_vfos[i].receiver && !set_vfo_offset(i) )
+        {
+            Logger::notice("[Flow_Chart::move_sdr] "+m_vfos[i].name+" is outside the SDR stream");
+        }
+    }
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     scan_span
+ */
+void Flow_Chart::scan_span( void )
+{
+    double half = scan_span_fraction * m_input_rate / 2;
+    double edge = m_scan.step / 2;
+    double lo = m_sdr_source->get_center_frequency();
+    // inside the span the channels are picked out of the same samples;
+    // only the next span needs the SDR to move
+    bool hop = std::abs(m_scan.freqs[m_scan.next] - lo) + edge > half;
+    if( hop )
+    {
+        m_scan.moved = true;
+        move_sdr(m_scan.freqs[m_scan.next] - edge + half);
+        lo = m_sdr_source->get_center_frequency();
+    }
+
+    std::vector<double> offsets;
+    for( size_t i = m_scan.next; i < m_scan.freqs.size() && std::abs(m_scan.freqs[i] - lo) + edge <= half; i++ )
+    {
+        offsets.push_back(m_scan.freqs[i] - lo);
+    }
+    if( offsets.empty() )
+    {
+        Logger::warn("[Flow_Chart::scan_span] the SDR can't reach "+std::to_string(m_scan.freqs[m_scan.next]));
+        end_scan();
+        return;
+    }
+    m_scan.count = offsets.size();
+    m_scan_power->measure(offsets, m_scan.step, m_scan.dwell, hop ? scan_settle : 0.0);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     poll_scan
+ */
+void Flow_Chart::poll_scan( void )
+{
+    std::vector<float> powers;
+    if( !m_scan.active || !m_scan_power->get_powers(&powers) )
+    {
+        return;
+    }
+
+    char line[64];
+    for( size_t i = 0; i < powers.size(); i++ )
+    {
+        snprintf(line, sizeof(line), "%.0f %.1f", m_scan.freqs[m_scan.next + i], powers[i]);
+        m_scan.results.push_back(line);
+    }
+    while( m_scan.results.size() > max_scan_results )
+    {
+        m_scan.results.pop_front();
+    }
+    m_scan.next += m_scan.count;
+    m_scan.done += m_scan.count;
+
+    if( m_scan.next < m_scan.freqs.size() )
+    {
+        scan_span();
+        return;
+    }
+    end_scan();
+    Logger::info("[Flow_Chart::poll_scan] "+std::to_string(m_scan.done)+" steps in "
+        +std::to_string(m_scan.seconds)+" s, "+std::to_string(m_scan.done / m_scan.seconds)+" steps/s");
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     end_scan
+ */
+void Flow_Chart::end_scan( void )
+{
+    m_scan_power->cancel();
+    m_scan.active = false;
+    m_scan.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_scan.start).count();
+    if( !m_scan.moved )
+    {
+        return;
+    }
+    m_scan.moved = false;
+    move_sdr(m_scan.home);
+    // the VFOs may have been tuned away from home during the scan
+    if( !is_in_span(m_scan.home) )
+    {
+        tune_vfo(0, m_vfos[0].freq);
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     tune_tx
+ */
+bool Flow_Chart::tune_tx( void )
+{
+    double freq = m_vfos[m_split ? m_tx_vfo : 0].freq;
+    if( m_transmitter->set_offset(freq - m_sdr_sink->get_center_frequency()) )
+    {
+        return true;
+    }
+    bool rval = m_sdr_sink->set_center_frequency(freq);
+    Logger::info("[Flow_Chart::tune_tx] SDR moved to "+std::to_string(m_sdr_sink->get_center_frequency()));
+    m_transmitter->set_offset(freq - m_sdr_sink->get_center_frequency());
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_mode
+ */
+std::string Flow_Chart::set_mode( size_t vfo, const std::string &param )
+{
+    // parse cmd: <mode> [<passband>]
+    std::vector<std::string> fields = Utility::split(param, Command_Msg::space);
+    int passband = 0;
+    if(fields.empty() || 2 < fields.size())
+    {
+        return Utility::INVALID_PARAM;
+    }
+    if(2 == fields.size())
+    {
+        try
+        {
+            passband = std::stoi(fields[1]);
+        }
+        catch(const std::exception &e)
+        {
+            return Utility::INVALID_PARAM;
+        }
+    }
+    if(!set_vfo_mode(vfo, fields[0], passband))
+    {
+        return Utility::INVALID_PARAM;
+    }
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_vfo_mode
+ */
+bool Flow_Chart::set_vfo_mode( size_t vfo, const std::string &mode, int passband )
+{
+    for( auto &vfo_mode : vfo_modes )
+    {
+        if( mode != vfo_mode.name )
+        {
+            continue;
+        }
+        if( 0 == passband )
+        {
+            passband = vfo_mode.normal;
+        }
+        else if( 0 > passband )
+        {
+            passband = m_vfos[vfo].passband;
+        }
+        m_vfos[vfo].mode = mode;
+        m_vfos[vfo].passband = passband;
+        if( nullptr != m_vfos[vfo].receiver )
+        {
+            set_mode_filter(m_vfos[vfo].receiver, vfo_mode.upper, passband);
+        }
+        return true;
+    }
+    return false;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_chains
+ */
+std::vector<std::vector<gr::basic_block_sptr>> Flow_Chart::get_chains( void )
+{
+    std::vector<gr::basic_block_sptr> rx = { m_sdr_source, m_iq_correct };
+    if( nullptr != m_rx_tuner )
+    {
+        rx.push_back(m_rx_tuner);
+    }
+    rx.push_back(m_receiver);
+    if( nullptr != m_rx_drift )
+    {
+        rx.push_back(m_rx_drift);
+    }
+    rx.push_back(m_audio_sink);
+
+    std::vector<gr::basic_block_sptr> tx = { m_audio_source };
+    if( nullptr != m_tx_drift )
+    {
+        tx.push_back(m_tx_drift);
+    }
+    tx.push_back(m_transmitter);
+    if( nullptr != m_tx_sc16 )
+    {
+        tx.push_back(m_tx_scale);
+        tx.push_back(m_tx_sc16);
+    }
+    tx.push_back(m_sdr_sink);
+
+    // the recorder taps the SDR stream on its own
+    std::vector<gr::basic_block_sptr> iq = { m_sdr_source, m_recorder };
+    // the band scan measures the corrected stream
+    std::vector<gr::basic_block_sptr> scan = { m_iq_correct, m_scan_power };
+    std::vector<std::vector<gr::basic_block_sptr>> chains = { rx, tx, iq, scan };
+    // and the panadapter's FFT taps the SDR stream too
+    if( nullptr != m_spectrum_tap )
+    {
+        chains.push_back({ m_sdr_source, m_spectrum_tap });
+    }
+    // the decoders take VFOA's audio as the sink does
+    for( slot_decoder_f::sptr decoder : m_decoders )
+    {
+        chains.push_back({ m_receiver, decoder });
+    }
+    return chains;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     calibrate_audio
+ */
+void Flow_Chart::calibrate_audio( Radio_Config &rconfig )
+{
+    // seconds spent on each period size
+    const double probe_time = 3;
+    struct {
+        std::string device;
+        snd_pcm_stream_t stream;
+    } devices[] = {
+        { rconfig.get_sound_output_alsa(), SND_PCM_STREAM_PLAYBACK },
+        { rconfig.get_sound_input_alsa(), SND_PCM_STREAM_CAPTURE }
+    };
+
+    for( auto &dev : devices )
+    {
+        // the shared memory rings, network streams and files have no periods to size
+        if( 0 == dev.device.compare(0, shm_prefix.size(), shm_prefix) ||
+            0 == dev.device.compare(0, udp_prefix.size(), udp_prefix) ||
+            0 == dev.device.compare(0, file_prefix.size(), file_prefix) )
+        {
+            continue;
+        }
+        std::string name = gri_alsa_device_name(dev.device, dev.stream);
+        gri_alsa_latency latency;
+        if( gri_alsa_calibrate_latency(name, dev.stream, rconfig.get_audio_rate(), probe_time, &latency) )
+        {
+            gri_alsa_save_latency(name, dev.stream, latency);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     listen
+ */
+void Flow_Chart::listen( void )
+{
+    poll_scan();
+    poll_decoders();
+    m_slice = -1;
+    dispatch(m_rconfig.get_cmd_queue(), m_rconfig.get_rsp_queue());
+
+    // the slices' servers are polled here, main only knows the main port
+    for( size_t i = 0; i < m_slices.size(); i++ )
+    {
+        m_slice = i;
+        m_slices[i].server->listen();
+        dispatch(m_slices[i].cmd_queue, m_slices[i].rsp_queue);
+        m_slices[i].server->send_response();
+    }
+    m_slice = -1;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     dispatch
+ */
+void Flow_Chart::dispatch( Message_Queue::sptr cmd_queue, Message_Queue::sptr rsp_queue )
+{
+    while( !cmd_queue->empty() )
+    {
+        std::string param = "";
+        Message_Queue::message_t msg_struct = cmd_queue->pop_struct();
+        std::string msg = msg_struct.msg;
+        // get the index
+        int index = Command_Msg::get_index(msg);
+        std::size_t list_size = m_list.size();
+        if(-1 < index && index < (int)list_size)
+        {
+            Flow_Chart_fnc_ptr cmd_fnc = m_list[index];
+            std::string rsp = (this->*cmd_fnc)(msg);
+            Message_Queue::message_t rsp_struct;
+            rsp_struct.msg = rsp;
+            rsp_struct.fd = msg_struct.fd;
+            rsp_queue->push(rsp_struct);
+        }
+        else
+        {
+            Logger::warn("[Flow_Chart::dispatch] This command does not have a matching function pointer "+msg);
+            Message_Queue::message_t rsp_struct;
+            rsp_struct.msg = Command_Msg::append_delim("RPRT -4");
+            rsp_struct.fd = msg_struct.fd;
+            rsp_queue->push(rsp_struct);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_freq
+ */
+std::string Flow_Chart::cmd_set_freq(std::string cmd)
+{
+    std::string rval;
+    unsigned int freq = 0;
+    // parse cmd
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    // rval is set if stoui is false
+    // freq is set if stoui is true
+    if(Utility::stoui(param,&freq,&rval))
+    {
+        size_t vfo = get_current_vfo();
+        Logger::debug("[Flow_Chart::cmd_set_freq] "+m_vfos[vfo].name+" frequency="+std::to_string(freq));
+        // TODO: check if(m_ptt == PTT_RX) before allowed to change freq
+        if( !tune_vfo(vfo, freq) )
+        {
+            Logger::notice("There was a error chaning the frequency.");
+        }
+        rval = Command_Msg::append_delim("RPRT 0");
+    }
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_freq
+ */
+std::string Flow_Chart::cmd_get_freq(std::string cmd)
+{
+    return (Command_Msg::append_delim(std::to_string(m_vfos[get_current_vfo()].freq)));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_mode
+ */
+std::string Flow_Chart::cmd_set_mode(std::string cmd)
+{
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    Logger::debug("[Flow_Chart::cmd_set_mode] mode="+param);
+    return set_mode(get_current_vfo(), param);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_mode
+ */
+std::string Flow_Chart::cmd_get_mode(std::string cmd)
+{
+    vfo_t &vfo = m_vfos[get_current_vfo()];
+    return (Command_Msg::append_delim(vfo.mode)+Command_Msg::append_delim(vfo.passband));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_vfo
+ */
+std::string Flow_Chart::cmd_set_vfo(std::string cmd)
+{
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    Logger::debug("[Flow_Chart::cmd_set_vfo] vfo="+param);
+    size_t vfo;
+    if(find_vfo(param, &vfo))
+    {
+        // F, f, M and m on this port now act on it
+        get_current_vfo() = vfo;
+        return (Command_Msg::append_delim("RPRT 0"));
+    }
+    return (Command_Msg::append_delim("RPRT -9"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_vfo
+ */
+std::string Flow_Chart::cmd_get_vfo(std::string cmd)
+{
+    return (Command_Msg::append_delim(m_vfos[get_current_vfo()].name));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_mode
+ */
+std::string Flow_Chart::cmd_set_ptt(std::string cmd)
+{
+    std::string rval;
+    unsigned int mode = PTT_SIZE;
+    // parse cmd
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    if(Utility::stoui(param,&mode,&rval))
+    {
+        if( m_slice >= 0 )
+        {
+            // slices only receive
+            rval = Command_Msg::append_delim(mode == PTT_RX ? "RPRT 0" : "RPRT -11");
+        }
+        else if(PTT_SIZE > mode)
+        {
+            Logger::debug("[Flow_Chart::cmd_set_ptt] ptt="+std::to_string(mode));
+            m_ptt = (PTT_ENUM)(mode);
+            for( slot_decoder_f::sptr decoder : m_decoders )
+            {
+                decoder->set_transmitting(mode != PTT_RX);
+            }
+            if(mode == PTT_RX)
+            {
+                m_transmitter->ptt_off();
+            }
+            else
+            {
+                m_transmitter->ptt_on();
+            }
+            rval = Command_Msg::append_delim("RPRT 0");
+        }
+        else
+        {
+            rval = Utility::INVALID_PARAM;
+        }
+    }
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_mode
+ */
+std::string Flow_Chart::cmd_get_ptt(std::string cmd)
+{
+    unsigned int ptt_mode = m_slice >= 0 ? (unsigned int) PTT_RX : (unsigned int) m_ptt;
+    std::string rval (Command_Msg::append_delim(ptt_mode));
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_check_vfo
+ */
+std::string Flow_Chart::cmd_check_vfo(std::string cmd)
+{
+    std::string rval (Command_Msg::append_delim("CHKVFO 0"));
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_dump_state(
+ */
+std::string Flow_Chart::cmd_dump_state(std::string cmd)
+{
+    std::vector<std::string> state = 
+                       { "0", // always 0
+                         "2", // %d rig->caps->rig_model Hamlib NET rigctl
+                         "2", // %d rs->itu_region RIG_ITU_REGION2
+                         // repeat the following for each in rs->rx_range_list
                          range_list,
                          // delimeter
                          "0 0 0 0 0 0 0",
@@ -465,157 +1641,790 @@ std::string Flow_Chart::cmd_dump_state(std::string cmd)
                          "0x0", // rs->has_set_parm
                          "0" };
     std::string rval = "";
-    for( unsigned int i = 0; i < state.size(); i++ )
+    for( unsigned int i = 0; i < state.size(); i++ )
+    {
+        rval += Command_Msg::append_delim(state[i]);
+    }
+    Logger::debug("[Flow_Chart::cmd_dump_state] dump state.");
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_dump_caps
+ */
+std::string Flow_Chart::cmd_dump_caps(std::string cmd)
+{
+    std::string vfo_list = "";
+    for( vfo_t &vfo : m_vfos )
+    {
+        vfo_list += vfo.name + " ";
+    }
+    std::vector<std::string> rlist = 
+                     { "Caps dump for model: lime",
+                       "Model name:	LimeSDR Mini",
+                       "Mfg name:	Myriadrf",
+                       "Backend version:	0.0",
+                       "Backend copyright:	GPL ver. 3",
+                       "Backend status:	Beta",
+                       "Rig type:	Transceiver",
+                       "PTT type:	Rig capable",
+                       "DCD type:	Rig capable",
+                       "Port type:	Network link",
+                       "Write delay: 0mS, timeout 2000mS, 3 retry",
+                       "Post Write delay: 0mS",
+                       "Has targetable VFO: Y",
+                       "Has transceive: N",
+                       "Announce: 0x0",
+                       "Max RIT: -0.0kHz/+0.0kHz",
+                       "Max XIT: -0.0kHz/+0.0kHz",
+                       "Max IF-SHIFT: -0.0kHz/+0.0kHz",
+                       "Preamp: None",
+                       "Attenuator: None",
+                       "CTCSS: None",
+                       "DCS: None",
+                       "Get functions: ",
+                       "Set functions: ",
+                       "Get level: ",
+                       "Set level: ",
+                       "Extra levels:",
+                       "Get parameters: ",
+                       "Set parameters: ",
+                       "Extra parameters:",
+                       "Mode list: USB LSB PKTUSB PKTLSB",
+                       "",
+                       "VFO list: "+vfo_list,
+                       "",
+                       "VFO Ops: ",
+                       "Scan Ops: ",
+                       "Number of banks:	0",
+                       "Memory name desc size:	0",
+                       "Memories: None",
+                       "TX ranges status, region 1:	OK (0)",
+                       "RX ranges status, region 1:	OK (0)",
+                       "TX ranges status, region 2:	OK (0)",
+                       "RX ranges status, region 2:	OK (0)",
+                       "Tuning steps: ",
+                       "        1 Hz:           USB LSB PKTUSB PKTLSB",
+                       "Tuning steps status:	OK (0)",
+                       "Filters: ",
+                       "       2.4 kHz:          USB LSB",
+                       "       5 kHz:            PKTUSB PKTLSB",
+                       "Bandwidths:",
+                       "       USB      Normal: 2.4 kHz, Narrow: 0 Hz, Wide: 0 Hz ",
+                       "       LSB      Normal: 2.4 kHz, Narrow: 0 Hz, Wide: 0 Hz ",
+                       "       PKTUSB   Normal: 5 kHz, Narrow: 0 Hz, Wide: 0 Hz ",
+                       "       PKTLSB   Normal: 5 kHz, Narrow: 0 Hz, Wide: 0 Hz ",
+                       "Has priv data:	N",
+                       "Has Init:	Y",
+                       "Has Cleanup:	Y",
+                       "Has Open:	Y",
+                       "Has Close:	Y",
+                       "Can set Conf:	N",
+                       "Can get Conf:	N",
+                       "Can set Frequency:	Y",
+                       "Can get Frequency:	Y",
+                       "Can set Mode:	Y",
+                       "Can get Mode:	Y",
+                       "Can set VFO:	Y",
+                       "Can get VFO:	Y",
+                       "Can set PTT:	N",
+                       "Can get PTT:	N",
+                       "Can get DCD:	N",
+                       "Can set Repeater Duplex:	N",
+                       "Can get Repeater Duplex:	N",
+                       "Can set Repeater Offset:	N",
+                       "Can get Repeater Offset:	N",
+                       "Can set Split Freq:	Y",
+                       "Can get Split Freq:	Y",
+                       "Can set Split Mode:	Y",
+                       "Can get Split Mode:	Y",
+                       "Can set Split VFO:	Y",
+                       "Can get Split VFO:	Y",
+                       "Can set Tuning Step:	N",
+                       "Can get Tuning Step:	N",
+                       "Can set RIT:	N",
+                       "Can get RIT:	N",
+                       "Can set XIT:	N",
+                       "Can get XIT:	N",
+                       "Can set CTCSS:	N",
+                       "Can get CTCSS:	N",
+                       "Can set DCS:	N",
+                       "Can get DCS:	N",
+                       "Can set CTCSS Squelch:	N",
+                       "Can get CTCSS Squelch:	N",
+                       "Can set DCS Squelch:	N",
+                       "Can get DCS Squelch:	N",
+                       "Can set Power Stat:	N",
+                       "Can get Power Stat:	N",
+                       "Can Reset:	N",
+                       "Can get Ant:	N",
+                       "Can set Ant:	N",
+                       "Can set Transceive:	N",
+                       "Can get Transceive:	N",
+                       "Can set Func:	N",
+                       "Can get Func:	N",
+                       "Can set Level:	N",
+                       "Can get Level:	N",
+                       "Can set Param:	N",
+                       "Can get Param:	N",
+                       "Can send DTMF:	N",
+                       "Can recv DTMF:	N",
+                       "Can send Morse:	N",
+                       "Can decode Events:	N",
+                       "Can set Bank:	N",
+                       "Can set Mem:	N",
+                       "Can get Mem:	N",
+                       "Can set Channel:	N",
+                       "Can get Channel:	N",
+                       "Can ctl Mem/VFO:	N",
+                       "Can Scan:	N",
+                       "Can get Info:	N",
+                       "Can get power2mW:	N",
+                       "Can get mW2power:	N",
+                       "",
+                       "Overall backend warnings: 0",
+                       "RPRT 0"};
+    std::string rval = "";
+    for( unsigned int i = 0; i < rlist.size(); i++ )
+    {
+        rval += Command_Msg::append_delim(rlist[i]);
+    }
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_status
+ */
+std::string Flow_Chart::cmd_status(std::string cmd)
+{
+    Logger::debug("[Flow_Chart::cmd_status] '"+cmd+"' ");
+
+    return cmd;
+}
+
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_audio_stats
+ */
+std::string Flow_Chart::cmd_get_audio_stats(std::string cmd)
+{
+    std::string rval = "";
+    udp_audio_sink_f::sptr sink = boost::dynamic_pointer_cast<udp_audio_sink_f>(m_audio_sink);
+    udp_audio_source_f::sptr source = boost::dynamic_pointer_cast<udp_audio_source_f>(m_audio_source);
+
+    if( nullptr != sink )
+    {
+        rval += "RX sent="+std::to_string(sink->get_sent())
+            +" errors="+std::to_string(sink->get_send_errors())+"\n";
+    }
+    if( nullptr != source )
+    {
+        jitter_buffer::stats_t stats = source->get_stats();
+        rval += "TX received="+std::to_string(stats.received)
+            +" lost="+std::to_string(stats.lost)
+            +" late="+std::to_string(stats.late)
+            +" duplicate="+std::to_string(stats.duplicate)
+            +" concealed="+std::to_string(stats.concealed)
+            +" dropped="+std::to_string(stats.dropped)
+            +" rebuffers="+std::to_string(stats.rebuffers)
+            +" delay_ms="+std::to_string(stats.delay * 1e3)
+            +" max_delay_ms="+std::to_string(stats.max_delay * 1e3)
+            +" jitter_ms="+std::to_string(stats.jitter * 1e3)
+            +" buffer_ms="+std::to_string(stats.depth * 1e3)
+            +" target_ms="+std::to_string(stats.target * 1e3)+"\n";
+    }
+    if( rval.empty() )
+    {
+        // neither side is on the network
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    return (rval+Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_buffers
+ */
+std::string Flow_Chart::cmd_get_buffers(std::string cmd)
+{
+    std::string rval = m_buffers.report();
+    if( rval.empty() )
+    {
+        // the flowgraph isn't running
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    return (rval+Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_split_vfo
+ */
+std::string Flow_Chart::cmd_set_split_vfo(std::string cmd)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string rval;
+    unsigned int split = 0;
+    size_t vfo = m_tx_vfo;
+    // parse cmd: <split> <tx_vfo>
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    std::vector<std::string> fields = Utility::split(param, Command_Msg::space);
+    if(2 != fields.size() || !Utility::stoui(fields[0], &split, &rval) || 1 < split)
+    {
+        return Utility::INVALID_PARAM;
+    }
+    // the TX VFO is where split points, not VFOA itself
+    if(fields[1] != "TX" && !find_vfo(fields[1], &vfo))
+    {
+        return Utility::INVALID_PARAM;
+    }
+    Logger::debug("[Flow_Chart::cmd_set_split_vfo] split="+std::to_string(split)+" tx_vfo="+m_vfos[vfo].name);
+    m_split = (1 == split);
+    m_tx_vfo = vfo;
+    if( !tune_tx() )
+    {
+        Logger::notice("There was a error chaning the frequency.");
+    }
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_split_vfo
+ */
+std::string Flow_Chart::cmd_get_split_vfo(std::string cmd)
+{
+    unsigned int split = (m_slice < 0 && m_split) ? 1 : 0;
+    return (Command_Msg::append_delim(split)+Command_Msg::append_delim(m_vfos[m_tx_vfo].name));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_split_freq
+ */
+std::string Flow_Chart::cmd_set_split_freq(std::string cmd)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string rval;
+    unsigned int freq = 0;
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    if(Utility::stoui(param,&freq,&rval))
+    {
+        Logger::debug("[Flow_Chart::cmd_set_split_freq] "+m_vfos[m_tx_vfo].name+" frequency="+std::to_string(freq));
+        if( !tune_vfo(m_tx_vfo, freq) )
+        {
+            Logger::notice("There was a error chaning the frequency.");
+        }
+        rval = Command_Msg::append_delim("RPRT 0");
+    }
+    return rval;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_split_freq
+ */
+std::string Flow_Chart::cmd_get_split_freq(std::string cmd)
+{
+    return (Command_Msg::append_delim(std::to_string(m_vfos[m_tx_vfo].freq)));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_split_mode
+ */
+std::string Flow_Chart::cmd_set_split_mode(std::string cmd)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    Logger::debug("[Flow_Chart::cmd_set_split_mode] mode="+param);
+    return set_mode(m_tx_vfo, param);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_split_mode
+ */
+std::string Flow_Chart::cmd_get_split_mode(std::string cmd)
+{
+    vfo_t &vfo = m_vfos[m_tx_vfo];
+    return (Command_Msg::append_delim(vfo.mode)+Command_Msg::append_delim(vfo.passband));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_start_recording
+ */
+std::string Flow_Chart::cmd_start_recording(std::string cmd)
+{
+    std::string base = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    if( base.empty() )
+    {
+        // ex: sdr_ctld-20190601T120000Z in the working directory
+        time_t now = time(nullptr);
+        struct tm utc;
+        gmtime_r(&now, &utc);
+        char name[40];
+        strftime(name, sizeof(name), "sdr_ctld-%Y%m%dT%H%M%SZ", &utc);
+        base = name;
+    }
+    Logger::debug("[Flow_Chart::cmd_start_recording] base="+base);
+    std::string hw = m_playback ? "playback" : "LimeSDR "+m_rconfig.get_sdr().serial;
+    if( !m_recorder->start_recording(base, m_input_rate, m_sdr_source->get_center_frequency(), hw) )
+    {
+        // already recording, or the file can't be made
+        return (Command_Msg::append_delim("RPRT -6"));
+    }
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_stop_recording
+ */
+std::string Flow_Chart::cmd_stop_recording(std::string cmd)
+{
+    m_recorder->stop_recording();
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_seek_playback
+ */
+std::string Flow_Chart::cmd_seek_playback(std::string cmd)
+{
+    if( !m_playback )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    Logger::debug("[Flow_Chart::cmd_seek_playback] param="+param);
+    // no position starts over
+    double seconds = param.empty() ? 0 : atof(param.c_str());
+    if( !m_playback->seek(seconds) )
+    {
+        return Utility::INVALID_PARAM;
+    }
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_playback
+ */
+std::string Flow_Chart::cmd_get_playback(std::string cmd)
+{
+    if( !m_playback )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    // position and length in seconds
+    return (Command_Msg::append_delim(std::to_string(m_playback->get_position()))
+        +Command_Msg::append_delim(std::to_string(m_playback->get_duration())));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_replay
+ */
+std::string Flow_Chart::cmd_replay(std::string cmd)
+{
+    if( nullptr == m_ring || m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string rval;
+    // parse cmd: [seconds ago] [seconds] [offset_hz]
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    std::vector<std::string> fields = Utility::split(param, Command_Msg::space);
+    double rate = m_ring->get_rate();
+    uint64_t now = m_ring->get_write_pos();
+    // all the ring holds, up to now
+    double ago = (now - m_ring->get_oldest()) / rate;
+    double seconds = -1;
+    double offset = 0;
+    if(3 < fields.size() ||
+       (0 < fields.size() && !Utility::stod(fields[0], &ago, &rval)) ||
+       (1 < fields.size() && !Utility::stod(fields[1], &seconds, &rval)) ||
+       (2 < fields.size() && !Utility::stod(fields[2], &offset, &rval)) ||
+       0 >= ago)
+    {
+        return Utility::INVALID_PARAM;
+    }
+    if( 0 > seconds )
+    {
+        seconds = ago;
+    }
+    Logger::debug("[Flow_Chart::cmd_replay] ago="+std::to_string(ago)+" seconds="+std::to_string(seconds)+" offset="+std::to_string(offset));
+    // the passband must stay inside the clean part of the first stage's output
+    if( std::abs(offset) + vfo_band > m_receiver->get_tap_width() / 2 || (uint64_t)(ago * rate) > now )
+    {
+        return Utility::INVALID_PARAM;
+    }
+
+    // hear it the way VFOA is set now
+    vfo_t &vfo = m_vfos[0];
+    for( auto &vfo_mode : vfo_modes )
+    {
+        if( vfo.mode == vfo_mode.name )
+        {
+            set_mode_filter(m_replay_receiver, vfo_mode.upper, vfo.passband);
+        }
+    }
+    uint64_t start = now - (uint64_t)(ago * rate);
+    if( !m_replay->replay(start, (uint64_t)(seconds * rate), offset) )
+    {
+        // older than the ring, or it ends in the future
+        return Utility::INVALID_PARAM;
+    }
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_stop_replay
+ */
+std::string Flow_Chart::cmd_stop_replay(std::string cmd)
+{
+    if( nullptr == m_ring )
     {
-        rval += Command_Msg::append_delim(state[i]);
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    m_replay->stop_replay();
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_iq_correction
+ */
+std::string Flow_Chart::cmd_set_iq_correction(std::string cmd)
+{
+    std::string rval;
+    unsigned int enable = 0;
+    // parse cmd
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    if(Utility::stoui(param,&enable,&rval))
+    {
+        if( m_slice >= 0 )
+        {
+            // every receiver shares it
+            rval = Command_Msg::append_delim("RPRT -11");
+        }
+        else if( 1 >= enable )
+        {
+            Logger::debug("[Flow_Chart::cmd_set_iq_correction] enable="+std::to_string(enable));
+            m_iq_correct->set_enabled(1 == enable);
+            rval = Command_Msg::append_delim("RPRT 0");
+        }
+        else
+        {
+            rval = Utility::INVALID_PARAM;
+        }
     }
-    Logger::debug("[Flow_Chart::cmd_dump_state] dump state.");
     return rval;
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_dump_caps
+ *     cmd_get_iq_correction
  */
-std::string Flow_Chart::cmd_dump_caps(std::string cmd)
+std::string Flow_Chart::cmd_get_iq_correction(std::string cmd)
 {
-    std::vector<std::string> rlist = 
-                     { "Caps dump for model: lime",
-                       "Model name:	LimeSDR Mini",
-                       "Mfg name:	Myriadrf",
-                       "Backend version:	0.0",
-                       "Backend copyright:	GPL ver. 3",
-                       "Backend status:	Beta",
-                       "Rig type:	Transceiver",
-                       "PTT type:	Rig capable",
-                       "DCD type:	Rig capable",
-                       "Port type:	Network link",
-                       "Write delay: 0mS, timeout 2000mS, 3 retry",
-                       "Post Write delay: 0mS",
-                       "Has targetable VFO: Y",
-                       "Has transceive: N",
-                       "Announce: 0x0",
-                       "Max RIT: -0.0kHz/+0.0kHz",
-                       "Max XIT: -0.0kHz/+0.0kHz",
-                       "Max IF-SHIFT: -0.0kHz/+0.0kHz",
-                       "Preamp: None",
-                       "Attenuator: None",
-                       "CTCSS: None",
-                       "DCS: None",
-                       "Get functions: ",
-                       "Set functions: ",
-                       "Get level: ",
-                       "Set level: ",
-                       "Extra levels:",
-                       "Get parameters: ",
-                       "Set parameters: ",
-                       "Extra parameters:",
-                       "Mode list: PKTUSB",
-                       "",
-                       "VFO list: "+m_vfo,
-                       "",
-                       "VFO Ops: ",
-                       "Scan Ops: ",
-                       "Number of banks:	0",
-                       "Memory name desc size:	0",
-                       "Memories: None",
-                       "TX ranges status, region 1:	OK (0)",
-                       "RX ranges status, region 1:	OK (0)",
-                       "TX ranges status, region 2:	OK (0)",
-                       "RX ranges status, region 2:	OK (0)",
-                       "Tuning steps: ",
-                       "        1 Hz:           PKTUSB",
-                       "Tuning steps status:	OK (0)",
-                       "Filters: ",
-                       "       2.2 kHz:          PKTUSB",
-                       "Bandwidths:",
-                       "       PKTUSB   Normal: 2.2 kHz, Narrow: 0 Hz, Wide: 0 Hz ",
-                       "Has priv data:	N",
-                       "Has Init:	Y",
-                       "Has Cleanup:	Y",
-                       "Has Open:	Y",
-                       "Has Close:	Y",
-                       "Can set Conf:	N",
-                       "Can get Conf:	N",
-                       "Can set Frequency:	Y",
-                       "Can get Frequency:	Y",
-                       "Can set Mode:	Y",
-                       "Can get Mode:	Y",
-                       "Can set VFO:	Y",
-                       "Can get VFO:	Y",
-                       "Can set PTT:	N",
-                       "Can get PTT:	N",
-                       "Can get DCD:	N",
-                       "Can set Repeater Duplex:	N",
-                       "Can get Repeater Duplex:	N",
-                       "Can set Repeater Offset:	N",
-                       "Can get Repeater Offset:	N",
-                       "Can set Split Freq:	N",
-                       "Can get Split Freq:	N",
-                       "Can set Split Mode:	N",
-                       "Can get Split Mode:	N",
-                       "Can set Split VFO:	N",
-                       "Can get Split VFO:	N",
-                       "Can set Tuning Step:	N",
-                       "Can get Tuning Step:	N",
-                       "Can set RIT:	N",
-                       "Can get RIT:	N",
-                       "Can set XIT:	N",
-                       "Can get XIT:	N",
-                       "Can set CTCSS:	N",
-                       "Can get CTCSS:	N",
-                       "Can set DCS:	N",
-                       "Can get DCS:	N",
-                       "Can set CTCSS Squelch:	N",
-                       "Can get CTCSS Squelch:	N",
-                       "Can set DCS Squelch:	N",
-                       "Can get DCS Squelch:	N",
-                       "Can set Power Stat:	N",
-                       "Can get Power Stat:	N",
-                       "Can Reset:	N",
-                       "Can get Ant:	N",
-                       "Can set Ant:	N",
-                       "Can set Transceive:	N",
-                       "Can get Transceive:	N",
-                       "Can set Func:	N",
-                       "Can get Func:	N",
-                       "Can set Level:	N",
-                       "Can get Level:	N",
-                       "Can set Param:	N",
-                       "Can get Param:	N",
-                       "Can send DTMF:	N",
-                       "Can recv DTMF:	N",
-                       "Can send Morse:	N",
-                       "Can decode Events:	N",
-                       "Can set Bank:	N",
-                       "Can set Mem:	N",
-                       "Can get Mem:	N",
-                       "Can set Channel:	N",
-                       "Can get Channel:	N",
-                       "Can ctl Mem/VFO:	N",
-                       "Can Scan:	N",
-                       "Can get Info:	N",
-                       "Can get power2mW:	N",
-                       "Can get mW2power:	N",
-                       "",
-                       "Overall backend warnings: 0",
-                       "RPRT 0"};
-    std::string rval = "";
-    for( unsigned int i = 0; i < rlist.size(); i++ )
+    iq_correct_c::coeffs_t coeffs = m_iq_correct->get_coeffs();
+    return (Command_Msg::append_delim(m_iq_correct->get_enabled() ? "1" : "0")
+        +Command_Msg::append_delim(std::to_string(coeffs.dc.real()))
+        +Command_Msg::append_delim(std::to_string(coeffs.dc.imag()))
+        +Command_Msg::append_delim(std::to_string(coeffs.phase))
+        +Command_Msg::append_delim(std::to_string(coeffs.gain)));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_scan
+ */
+std::string Flow_Chart::cmd_scan(std::string cmd)
+{
+    if( m_slice >= 0 )
     {
-        rval += Command_Msg::append_delim(rlist[i]);
+        // it moves the SDR out from under every VFO
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string rval;
+    // parse cmd: [start Hz] [stop Hz] [step Hz] [dwell ms]
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    std::vector<std::string> fields = Utility::split(param, Command_Msg::space);
+    double start = 0;
+    double stop = 0;
+    double step = 0;
+    double dwell_ms = 0;
+    if(4 != fields.size() ||
+       !Utility::stod(fields[0], &start, &rval) ||
+       !Utility::stod(fields[1], &stop, &rval) ||
+       !Utility::stod(fields[2], &step, &rval) ||
+       !Utility::stod(fields[3], &dwell_ms, &rval))
+    {
+        return Utility::INVALID_PARAM;
+    }
+    // a channel must fit in the span, and the list in memory
+    if( 0 >= start || start > stop || 0 >= step || step > scan_span_fraction * m_input_rate ||
+        0 >= dwell_ms || (stop - start) / step >= max_scan_steps )
+    {
+        return Utility::INVALID_PARAM;
+    }
+    Logger::debug("[Flow_Chart::cmd_scan] start="+std::to_string(start)+" stop="+std::to_string(stop)
+        +" step="+std::to_string(step)+" dwell="+std::to_string(dwell_ms));
+
+    if( m_scan.active )
+    {
+        end_scan();
+    }
+    m_scan.freqs.clear();
+    // the last step may land a hair past stop
+    for( size_t i = 0; start + i * step <= stop + step * 1e-6; i++ )
+    {
+        m_scan.freqs.push_back(start + i * step);
+    }
+    m_scan.step = step;
+    m_scan.dwell = dwell_ms / 1000;
+    m_scan.next = 0;
+    m_scan.count = 0;
+    m_scan.home = m_sdr_source->get_center_frequency();
+    m_scan.moved = false;
+    m_scan.done = 0;
+    m_scan.results.clear();
+    m_scan.start = std::chrono::steady_clock::now();
+    m_scan.active = true;
+    scan_span();
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_stop_scan
+ */
+std::string Flow_Chart::cmd_stop_scan(std::string cmd)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    if( m_scan.active )
+    {
+        end_scan();
+    }
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_get_scan
+ */
+std::string Flow_Chart::cmd_get_scan(std::string cmd)
+{
+    double seconds = m_scan.active
+        ? std::chrono::duration<double>(std::chrono::steady_clock::now() - m_scan.start).count()
+        : m_scan.seconds;
+    double rate = (0 < seconds) ? m_scan.done / seconds : 0;
+    // [scanning] [steps done] [steps] [steps/s], then one line per result
+    std::string rval = Command_Msg::append_delim(std::string(m_scan.active ? "1" : "0")
+        +" "+std::to_string(m_scan.done)+" "+std::to_string(m_scan.freqs.size())
+        +" "+std::to_string(rate));
+    for( const std::string &line : m_scan.results )
+    {
+        rval += Command_Msg::append_delim(line);
     }
+    m_scan.results.clear();
     return rval;
 }
 
 /*-------------------------------------------------------------------------
  * Function:
- *     cmd_status
+ *     cmd_get_decodes
  */
-std::string Flow_Chart::cmd_status(std::string cmd)
+std::string Flow_Chart::cmd_get_decodes(std::string cmd)
 {
-    Logger::debug("[Flow_Chart::cmd_status] '"+cmd+"' ");
+    if( m_decoders.empty() )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    // [UTC hhmmss] [mode] [snr] [dt] [freq] [message]
+    std::string rval;
+    for( const std::string &line : m_decodes )
+    {
+        rval += Command_Msg::append_delim(line);
+    }
+    m_decodes.clear();
+    return rval.empty() ? Command_Msg::append_delim("RPRT 0") : rval;
+}
 
-    return cmd;
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_set_tx_time
+ */
+std::string Flow_Chart::cmd_set_tx_time(std::string cmd)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    std::string rval;
+    // parse cmd: <UTC seconds>, 0 to start the next burst straight away
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    double utc = 0;
+    if(!Utility::stod(param, &utc, &rval))
+    {
+        return Utility::INVALID_PARAM;
+    }
+    double now = Sample_Time::now();
+    if( 0 != utc && (utc < now || utc > now + max_tx_wait) )
+    {
+        Logger::notice("[Flow_Chart::cmd_set_tx_time] "+std::to_string(utc - now)+" s from now is out of range");
+        return Utility::INVALID_PARAM;
+    }
+    Logger::debug("[Flow_Chart::cmd_set_tx_time] utc="+std::to_string(utc));
+    m_transmitter->set_start_time(utc);
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     start_tones
+ */
+std::string Flow_Chart::start_tones(const std::vector<tone_synth_cc::tone_t> &tones)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    if(m_ptt == PTT_RX)
+    {
+        // the tones are only sent while the transmitter is keyed
+        Logger::notice("[Flow_Chart::start_tones] PTT is off. Key the transmitter before sending tones.");
+        return Utility::INVALID_PARAM;
+    }
+    if(tones.empty())
+    {
+        return Utility::INVALID_PARAM;
+    }
+    m_transmitter->send_tones(tones);
+    return (Command_Msg::append_delim("RPRT 0"));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_send_tones
+ */
+std::string Flow_Chart::cmd_send_tones(std::string cmd)
+{
+    std::string rval;
+    std::vector<tone_synth_cc::tone_t> tones;
+    // parse cmd: <freq_hz>:<duration_ms> [<freq_hz>:<duration_ms> ...]
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    for(std::string field : Utility::split(param, Command_Msg::space))
+    {
+        std::vector<std::string> pair = Utility::split(field, ':');
+        tone_synth_cc::tone_t tone;
+        double duration_ms = 0;
+        if(2 != pair.size() ||
+           !Utility::stod(pair[0], &tone.freq, &rval) ||
+           !Utility::stod(pair[1], &duration_ms, &rval) ||
+           0 > duration_ms)
+        {
+            return Utility::INVALID_PARAM;
+        }
+        tone.duration = duration_ms / 1000.0;
+        tones.push_back(tone);
+    }
+    Logger::debug("[Flow_Chart::cmd_send_tones] tones="+std::to_string(tones.size()));
+    return start_tones(tones);
 }
 
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_send_carrier
+ */
+std::string Flow_Chart::cmd_send_carrier(std::string cmd)
+{
+    std::string rval;
+    // parse cmd: <freq_hz> <duration_ms>
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    std::vector<std::string> fields = Utility::split(param, Command_Msg::space);
+    tone_synth_cc::tone_t tone;
+    double duration_ms = 0;
+    if(2 != fields.size() ||
+       !Utility::stod(fields[0], &tone.freq, &rval) ||
+       !Utility::stod(fields[1], &duration_ms, &rval) ||
+       0 > duration_ms)
+    {
+        return Utility::INVALID_PARAM;
+    }
+    tone.duration = duration_ms / 1000.0;
+    Logger::debug("[Flow_Chart::cmd_send_carrier] freq="+std::to_string(tone.freq)+" duration="+std::to_string(tone.duration));
+    return start_tones(std::vector<tone_synth_cc::tone_t>(1, tone));
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_send_symbols
+ */
+std::string Flow_Chart::cmd_send_symbols(std::string cmd)
+{
+    std::string rval;
+    // parse cmd: <base_hz> <spacing_hz> <symbol_ms> <symbols>
+    // ex: FT8 is "\send_symbols 1500 6.25 160 3140652..." with 79 symbols
+    std::string param = Utility::get_substring(cmd, Command_Msg::space, Command_Msg::delim);
+    std::vector<std::string> fields = Utility::split(param, Command_Msg::space);
+    double base = 0;
+    double spacing = 0;
+    double symbol_ms = 0;
+    if(4 != fields.size() ||
+       !Utility::stod(fields[0], &base, &rval) ||
+       !Utility::stod(fields[1], &spacing, &rval) ||
+       !Utility::stod(fields[2], &symbol_ms, &rval) ||
+       0 > symbol_ms)
+    {
+        return Utility::INVALID_PARAM;
+    }
+    std::vector<tone_synth_cc::tone_t> tones;
+    for(char symbol : fields[3])
+    {
+        if(!std::isdigit(symbol))
+        {
+            return Utility::INVALID_PARAM;
+        }
+        tone_synth_cc::tone_t tone;
+        tone.freq = base + spacing * (symbol - '0');
+        tone.duration = symbol_ms / 1000.0;
+        tones.push_back(tone);
+    }
+    Logger::debug("[Flow_Chart::cmd_send_symbols] symbols="+std::to_string(tones.size()));
+    return start_tones(tones);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     cmd_stop_tones
+ */
+std::string Flow_Chart::cmd_stop_tones(std::string cmd)
+{
+    if( m_slice >= 0 )
+    {
+        return (Command_Msg::append_delim("RPRT -11"));
+    }
+    m_transmitter->stop_tones();
+    return (Command_Msg::append_delim("RPRT 0"));
+}
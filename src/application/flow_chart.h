@@ -26,14 +26,43 @@
  * Include Files
  * -----------------------------------------------------------------------*/
 #include "application/radio_config.h"
+#include "application/buffer_monitor.h"
+#include "application/message_server.h"
+#include <chrono>
+#include <deque>
+#include <memory>
 #include <vector>
 #include <string>
 #include <gnuradio/top_block.h>
 #include "audio/alsa_source.h"
 #include "audio/alsa_sink.h"
+#include "audio/drift_resampler_ff.h"
+#include "audio/shm_audio_sink_f.h"
+#include "audio/shm_audio_source_f.h"
+#include "audio/udp_audio_sink_f.h"
+#include "audio/udp_audio_source_f.h"
+#include <gnuradio/blocks/file_sink.h>
+#include <gnuradio/blocks/file_source.h>
+#include <gnuradio/blocks/wavfile_sink.h>
+#include <gnuradio/blocks/wavfile_source.h>
+#include <gnuradio/blocks/rotator_cc.h>
+#include <gnuradio/blocks/multiply_const_cc.h>
+#include <gnuradio/blocks/complex_to_interleaved_short.h>
+#include <gnuradio/blocks/interleaved_short_to_complex.h>
 #include "sdr/limey_sink_c.h"
 #include "sdr/limey_source_c.h"
+#include "sdr/playback_sink_c.h"
+#include "sdr/playback_source_c.h"
+#include "sdr/iq_correct_c.h"
+#include "sdr/iq_recorder_c.h"
+#include "sdr/scan_power_c.h"
+#include "sdr/spectrum_tap_c.h"
+#include "decoders/slot_decoder_f.h"
+#include "receivers/iq_replay_c.h"
+#include "receivers/iq_server_c.h"
+#include "receivers/iq_ring_c.h"
 #include "receivers/ssbrx.h"
+#include "receivers/wideband_rx.h"
 #include "transmitters/ssbtx.h"
 
 class Flow_Chart;
@@ -47,7 +76,8 @@ public:
 /*--------------------------------------------------------------------------
  * Type Definitions
  * -----------------------------------------------------------------------*/
-    static constexpr double get_audio_rate();
+    /** the highest audio rate; the SDR rates are multiples of it */
+    static constexpr double get_max_audio_rate();
 
 /*--------------------------------------------------------------------------
  * Function Definitions
@@ -82,6 +112,23 @@ public:
      */
     void listen( void );
 
+    /** @brief true for the audio rates the rate change plans divide into
+     *
+     * @param rate - Hz
+     * @return bool
+     */
+    static bool is_audio_rate_valid( unsigned int rate );
+
+    /** @brief probe the sound devices for the smallest stable period size
+     *
+     * Run before constructing the Flow_Chart; the result is saved per
+     * device and picked up by the audio blocks.
+     *
+     * @param rconfig - configuration with the sound devices set
+     * @return Void.
+     */
+    static void calibrate_audio( Radio_Config &rconfig );
+
 private:
     struct {
         double input_rate;
@@ -90,6 +137,7 @@ private:
     static const input_rate_t m_input_rate_lime[];
     static constexpr double set_input_rate(const double i);
     double get_input_rate(const Radio_Config::radio_enum_t sdr);
+    double get_audio_rate();
     double get_min_freq(const Radio_Config::radio_enum_t sdr);
     std::string range_list;
 
@@ -103,15 +151,315 @@ private:
     Radio_Config m_rconfig;
     std::vector<Flow_Chart_fnc_ptr> m_list;
     PTT_ENUM m_ptt;
-    std::string m_vfo;
 
     gr::top_block_sptr m_top_block;
-    gr::audio::alsa_source_sptr m_alsa_source;
-    gr::audio::alsa_sink_sptr m_alsa_sink;
-    Limey_Source_c::sptr m_sdr_source;
-    Limey_Sink_c::sptr m_sdr_sink;
+    gr::block_sptr m_audio_source;
+    gr::block_sptr m_audio_sink;
+    // only used with a sound card; null for the rings, network and files
+    drift_resampler_ff::sptr m_rx_drift;
+    drift_resampler_ff::sptr m_tx_drift;
+    Sdr_Source_c::sptr m_sdr_source;
+    Sdr_Sink_c::sptr m_sdr_sink;
+    // the SDR source when a recording plays, else null
+    Playback_Source_c::sptr m_playback;
+    double m_input_rate;
+    // always connected; only writes between start and stop_recording
+    iq_recorder_c::sptr m_recorder;
+    // between the SDR and every receiver; the recorder keeps the raw stream
+    iq_correct_c::sptr m_iq_correct;
+    // FFT frames for panadapters; null without -F
+    spectrum_tap_c::sptr m_spectrum_tap;
+    // the band scan's channel power, on the corrected stream; idle
+    // unless a scan is running
+    scan_power_c::sptr m_scan_power;
+    // the SDR streams 16 bit I & Q instead of gr_complex
+    bool m_sc16;
+    // moves VFOA around inside the SDR stream; null with m_sc16, where
+    // the receiver's first stage does it
+    gr::blocks::rotator_cc::sptr m_rx_tuner;
+    // with m_sc16, the transmitter's gr_complex to 16 bit I & Q
+    gr::blocks::multiply_const_cc::sptr m_tx_scale;
+    gr::blocks::complex_to_interleaved_short::sptr m_tx_sc16;
     ssbrx::sptr m_receiver;
     ssbtx::sptr m_transmitter;
+    Buffer_Monitor m_buffers;
+
+    /** a wideband receiver slice with its own rigctl port */
+    struct {
+        Radio_Config::slice_t config;
+        Message_Queue::sptr cmd_queue;
+        Message_Queue::sptr rsp_queue;
+        std::shared_ptr<Message_Server> server;
+        gr::block_sptr audio_sink;
+        drift_resampler_ff::sptr drift;     // null unless on a sound card
+        size_t vfo;                         // this port's current VFO
+    } typedef slice_state_t;
+    // null without slices
+    wideband_rx::sptr m_wideband;
+    // with m_sc16, 16 bit I & Q back to gr_complex for m_wideband
+    gr::blocks::interleaved_short_to_complex::sptr m_wideband_sc16;
+    gr::blocks::multiply_const_cc::sptr m_wideband_scale;
+    std::vector<slice_state_t> m_slices;
+    // slice the command being handled came in on; -1 for the main port
+    int m_slice;
+
+    /** a virtual VFO, a down converter on the shared SDR stream */
+    struct {
+        std::string name;
+        double freq;                        // dial frequency in Hz
+        std::string mode;
+        int passband;                       // Hz
+        ssbrx::sptr receiver;               // null for a VFO with no receiver
+    } typedef vfo_t;
+    // VFOA is the main receiver, then one per slice
+    std::vector<vfo_t> m_vfos;
+    // the main port's current VFO
+    size_t m_vfo;
+    // transmit on m_tx_vfo instead of VFOA
+    bool m_split;
+    size_t m_tx_vfo;
+
+    // the time shift ring on VFOA's first decimation stage and its own
+    // receiver; all null without -R
+    iq_ring_c::sptr m_ring;
+    iq_replay_c::sptr m_replay;
+    ssbrx::sptr m_replay_receiver;
+    gr::block_sptr m_replay_sink;
+    drift_resampler_ff::sptr m_replay_drift;
+
+    /** a band scan, see cmd_scan */
+    struct {
+        bool active;
+        std::vector<double> freqs;      // every step, lowest first
+        double step;                    // Hz, also the channel width
+        double dwell;                   // seconds per span
+        size_t next;                    // first channel of the span being measured
+        size_t count;                   // channels in that span
+        double home;                    // SDR frequency before the scan
+        bool moved;                     // the SDR has left home
+        size_t done;                    // channels measured
+        std::chrono::steady_clock::time_point start;
+        double seconds;                 // how long the last scan took
+        std::deque<std::string> results;    // "freq dBFS" lines not yet read
+    } typedef scan_t;
+    scan_t m_scan;
+
+    // FT8 and WSPR decoders on VFOA's audio, and the decodes not yet read
+    std::vector<slot_decoder_f::sptr> m_decoders;
+    std::deque<std::string> m_decodes;
+
+    // I & Q servers and the ssbrx output each one hangs off
+    std::vector<iq_server_c::sptr> m_iq_servers;
+    std::vector<int> m_iq_server_ports;
+
+    /** prefix of a sound device name that selects the shared memory rings */
+    static const std::string shm_prefix;
+    /** prefix of a sound device name that selects a network stream */
+    static const std::string udp_prefix;
+    /** prefix of a sound device name that selects a WAV or raw float file */
+    static const std::string file_prefix;
+
+    /** @brief create the audio source and sink from the sound device names
+     *
+     * @return Void.
+     */
+    void make_audio( void );
+
+    /** @brief create a receive audio sink from a sound device name
+     *
+     * @param output - device name, or shm:, udp: or file:
+     * @param drift - set to the drift resampler a sound card needs
+     * @return gr::block_sptr
+     */
+    gr::block_sptr make_audio_sink( const std::string &output, drift_resampler_ff::sptr *drift );
+
+    /** @brief create the wideband receiver and a rigctl port per slice
+     *
+     * @param input_rate - SDR sample rate
+     * @return Void.
+     */
+    void make_slices( double input_rate );
+
+    /** @brief connect or disconnect the slices' audio
+     *
+     * @param do_connect - false to disconnect
+     * @return Void.
+     */
+    void connect_slices( bool do_connect );
+
+    /** @brief create the time shift ring and its replay receiver
+     *
+     * @return Void.
+     */
+    void make_replay( void );
+
+    /** @brief connect or disconnect the ring and the replay chain
+     *
+     * @param do_connect - false to disconnect
+     * @return Void.
+     */
+    void connect_replay( bool do_connect );
+
+    /** @brief create the I & Q servers on VFOA's receiver
+     *
+     * @return Void.
+     */
+    void make_iq_servers( void );
+
+    /** @brief connect or disconnect the I & Q servers
+     *
+     * @param do_connect - false to disconnect
+     * @return Void.
+     */
+    void connect_iq_servers( bool do_connect );
+
+    /** @brief create the slot decoders on VFOA's audio
+     *
+     * @return Void.
+     */
+    void make_decoders( void );
+
+    /** @brief collect the decoders' results and send their heartbeats, from listen()
+     *
+     * @return Void.
+     */
+    void poll_decoders( void );
+
+    /** @brief create VFOA, a VFO per slice, and VFOB if there is no slice
+     *
+     * @param center_freq - VFOA's frequency
+     * @return Void.
+     */
+    void make_vfos( double center_freq );
+
+    /** @brief the current VFO of the port the command came in on
+     *
+     * @return size_t& - index into m_vfos
+     */
+    size_t &get_current_vfo( void );
+
+    /** @brief look up a VFO by its rigctl name
+     *
+     * @param name - ex: VFOA, Main, currVFO
+     * @param vfo - set to the index into m_vfos
+     * @return bool - false if there is no such VFO
+     */
+    bool find_vfo( const std::string &name, size_t *vfo );
+
+    /** @brief the furthest a VFO's receiver reaches from the SDR frequency
+     *
+     * @param vfo - index into m_vfos
+     * @return double - Hz
+     */
+    double get_max_offset( size_t vfo );
+
+    /** @brief true if every receiving VFO is in reach of an SDR frequency
+     *
+     * @param lo - SDR frequency in Hz
+     * @return bool
+     */
+    bool is_in_span( double lo );
+
+    /** @brief move a VFO's receiver to its dial, relative to the SDR frequency
+     *
+     * @param vfo - index into m_vfos
+     * @return bool - false if outside the SDR stream
+     */
+    bool set_vfo_offset( size_t vfo );
+
+    /** @brief tune a VFO's dial, moving the SDR only if a VFO falls outside
+     *
+     * @param vfo - index into m_vfos
+     * @param freq - dial frequency in Hz
+     * @return bool - false if the SDR could not be tuned
+     */
+    bool tune_vfo( size_t vfo, double freq );
+
+    /** @brief put the transmitter on VFOA, or on the TX VFO when split
+     *
+     * Shifts inside the band the SDR sends; only moves the SDR if the
+     * frequency is outside it.
+     *
+     * @return bool - false if the SDR could not be tuned
+     */
+    bool tune_tx( void );
+
+    /** @brief move the SDR and put every VFO back on its dial
+     *
+     * @param lo - SDR frequency in Hz
+     * @return bool - false if the SDR could not be tuned
+     */
+    bool move_sdr( double lo );
+
+    /** @brief measure the channels from m_scan.next that fit in one span,
+     *         moving the SDR only if the next channel is outside it
+     *
+     * @return Void.
+     */
+    void scan_span( void );
+
+    /** @brief collect a finished span and start the next, from listen()
+     *
+     * @return Void.
+     */
+    void poll_scan( void );
+
+    /** @brief stop the scan and bring the SDR back to the VFOs
+     *
+     * @return Void.
+     */
+    void end_scan( void );
+
+    /** @brief handle a mode and passband from M or X
+     *
+     * @param vfo - index into m_vfos
+     * @param param - <mode> [<passband>]
+     * @return std::string - the rigctl response
+     */
+    std::string set_mode( size_t vfo, const std::string &param );
+
+    /** @brief set the sideband and width of a VFO's receive filter
+     *
+     * @param vfo - index into m_vfos
+     * @param mode - USB, LSB, PKTUSB or PKTLSB
+     * @param passband - Hz; 0 for the mode's normal width, -1 for no change
+     * @return bool - false for an unknown mode
+     */
+    bool set_vfo_mode( size_t vfo, const std::string &mode, int passband );
+
+    /** @brief handle the commands waiting on one pair of queues
+     *
+     * @param cmd_queue - commands in
+     * @param rsp_queue - responses out
+     * @return Void.
+     */
+    void dispatch( Message_Queue::sptr cmd_queue, Message_Queue::sptr rsp_queue );
+
+    /** @brief receive, transmit and recording chains, in connection order
+     *
+     * @return std::vector - each chain is connected port 0 to port 0
+     */
+    std::vector<std::vector<gr::basic_block_sptr>> get_chains( void );
+
+    /** @brief the chains again, with the hierarchical blocks opened up
+     *
+     * @return std::vector - GNU Radio blocks in connection order
+     */
+    std::vector<std::vector<gr::block_sptr>> get_block_chains( void );
+
+    /** @brief run the ALSA and LimeSDR threads SCHED_FIFO
+     *
+     * The rest of the blocks stay SCHED_OTHER; call once they've started.
+     *
+     * @return Void.
+     */
+    void set_priorities( void );
+
+    /** @brief pin blocks to CPUs from the configured affinity list
+     *
+     * @return Void.
+     */
+    void set_affinity( void );
 
     /** @brief 
      *
@@ -197,6 +545,188 @@ private:
      */
     std::string cmd_status(std::string cmd);
 
+    /** @brief send a list of tones; each is <freq_hz>:<duration_ms>
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_send_tones(std::string cmd);
+
+    /** @brief send a single carrier; <freq_hz> <duration_ms>
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_send_carrier(std::string cmd);
+
+    /** @brief send channel symbols; <base_hz> <spacing_hz> <symbol_ms> <symbols>
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_send_symbols(std::string cmd);
+
+    /** @brief stop sending tones and return to the audio input
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_stop_tones(std::string cmd);
+
+    /** @brief loss and delay counters of the network audio streams
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_audio_stats(std::string cmd);
+
+    /** @brief fill of each flowgraph buffer since start
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_buffers(std::string cmd);
+
+    /** @brief turn split on or off; <split> <tx_vfo>
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_set_split_vfo(std::string cmd);
+
+    /** @brief split on or off and the TX VFO
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_split_vfo(std::string cmd);
+
+    /** @brief tune the TX VFO; <freq_hz>
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_set_split_freq(std::string cmd);
+
+    /** @brief the TX VFO's frequency
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_split_freq(std::string cmd);
+
+    /** @brief set the TX VFO's mode; <mode> [<passband>]
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_set_split_mode(std::string cmd);
+
+    /** @brief the TX VFO's mode and passband
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_split_mode(std::string cmd);
+
+    /** @brief record the SDR samples as SigMF; [base path]
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_start_recording(std::string cmd);
+
+    /** @brief finish the recording
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_stop_recording(std::string cmd);
+
+    /** @brief move the playback; [seconds from the start]
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_seek_playback(std::string cmd);
+
+    /** @brief playback position and length in seconds
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_playback(std::string cmd);
+
+    /** @brief replay VFOA from the ring; [seconds ago] [seconds] [offset Hz]
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_replay(std::string cmd);
+
+    /** @brief stop a replay
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_stop_replay(std::string cmd);
+
+    /** @brief turn the DC and I & Q correction on or off; [0|1]
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_set_iq_correction(std::string cmd);
+
+    /** @brief whether the correction is on, the DC in I and Q, phase and gain
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_iq_correction(std::string cmd);
+
+    /** @brief scan a band; [start Hz] [stop Hz] [step Hz] [dwell ms]
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_scan(std::string cmd);
+
+    /** @brief stop a scan
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_stop_scan(std::string cmd);
+
+    /** @brief scan progress and steps/s, then the results not yet read
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_scan(std::string cmd);
+
+    /** @brief the FT8 and WSPR decodes not yet read, one per line
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_get_decodes(std::string cmd);
+
+    /** @brief start the next keyed burst at a UTC instant
+     *
+     * @param std::string 
+     * @return std::string 
+     */
+    std::string cmd_set_tx_time(std::string cmd);
+
+    /** @brief hand the tone schedule to the transmitter if PTT is on
+     *
+     * @param tones - tone schedule
+     * @return std::string - the rigctl response
+     */
+    std::string start_tones(const std::vector<tone_synth_cc::tone_t> &tones);
+
 };
 
 #endif /* __FLOW_CHART_H__ */
@@ -0,0 +1,113 @@
+/**------------------------------------------------------------------------
+ * @file latency_profile.cpp
+ * @brief size the flowgraph buffers for latency or throughput
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ----------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------
+ * Include Files
+ * ----------------------------------------------------------------------*/
+#include "application/latency_profile.h"
+#include "application/logger.h"
+#include <algorithm>
+
+/*-------------------------------------------------------------------------
+ * Type Definitions
+ * ----------------------------------------------------------------------*/
+// low-latency: the most time a buffer holds, and half that per work call
+static const double low_latency_buffer = 0.005;
+// throughput: the least time a buffer holds
+static const double throughput_buffer = 0.100;
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     parse
+ */
+bool Latency_Profile::parse(const std::string &name, profile_t *profile)
+{
+    for( profile_t p : { DEFAULT, LOW_LATENCY, THROUGHPUT } )
+    {
+        if( name == Latency_Profile::name(p) )
+        {
+            *profile = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     name
+ */
+std::string Latency_Profile::name(profile_t profile)
+{
+    switch(profile)
+    {
+        case LOW_LATENCY:
+            return "low-latency";
+        case THROUGHPUT:
+            return "throughput";
+        default:
+            return "default";
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     apply
+ */
+void Latency_Profile::apply(profile_t profile, const std::vector<gr::block_sptr> &chain, double rate)
+{
+    if( profile == DEFAULT )
+    {
+        return;
+    }
+
+    // the last block is the sink, it has no output buffer
+    for( size_t i = 0; i + 1 < chain.size(); i++ )
+    {
+        gr::block_sptr block = chain[i];
+        gr::block_sptr next = chain[i+1];
+        if( i > 0 )
+        {
+            rate *= block->relative_rate();
+        }
+
+        // what the next block needs queued to make one call
+        int decimation = std::max(1, (int)(1.0 / next->relative_rate()));
+        long floor = std::max(2L * block->output_multiple(),
+            2L * (decimation * next->output_multiple() + next->history()));
+
+        long nitems;
+        if( profile == LOW_LATENCY )
+        {
+            nitems = std::max(floor, (long)(rate * low_latency_buffer));
+            block->set_max_output_buffer(nitems);
+            block->set_max_noutput_items(std::max(block->output_multiple(), (int)(nitems / 2)));
+        }
+        else
+        {
+            nitems = std::max(floor, (long)(rate * throughput_buffer));
+            block->set_min_output_buffer(nitems);
+        }
+        Logger::debug("[Latency_Profile::apply] "+block->name()+": "+std::to_string(nitems)
+            +" items, "+std::to_string(nitems * 1e3 / rate)+" ms");
+    }
+}
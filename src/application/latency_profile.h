@@ -0,0 +1,87 @@
+/**-------------------------------------------------------------------------
+ * @file latency_profile.h
+ * @brief size the flowgraph buffers for latency or throughput
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * -----------------------------------------------------------------------*/
+#ifndef __LATENCY_PROFILE_H__
+#define __LATENCY_PROFILE_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/block.h>
+#include <string>
+#include <vector>
+
+/**
+ * GNU Radio gives every block output a 64 KiB buffer by default, which is
+ * a few ms of IQ but over 300 ms of float audio.  A profile trades that
+ * depth for latency (small buffers, small work calls) or the other way.
+ *
+ * Buffers are never made smaller than the next block needs to run
+ * (twice its decimation times output multiple, plus history), and GNU
+ * Radio rounds every buffer up to a whole number of pages.
+ */
+class Latency_Profile
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    enum {
+        DEFAULT = 0,        // leave GNU Radio's sizes alone
+        LOW_LATENCY = 1,
+        THROUGHPUT = 2
+    } typedef profile_t;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief look up a profile by name
+     *
+     * @param name - "default", "low-latency" or "throughput"
+     * @param profile - the profile
+     * @return bool - false if the name is unknown
+     */
+    static bool parse(const std::string &name, profile_t *profile);
+
+    /** @brief name of a profile
+     *
+     * @param profile - the profile
+     * @return std::string
+     */
+    static std::string name(profile_t profile);
+
+    /** @brief set the buffer sizes along a chain, before the flowgraph starts
+     *
+     * @param profile - the profile
+     * @param chain - blocks connected output 0 to input 0
+     * @param rate - sample rate out of the first block
+     * @return Void.
+     */
+    static void apply(profile_t profile, const std::vector<gr::block_sptr> &chain, double rate);
+
+private:
+    /** @brief Constructor
+     *
+     */
+    Latency_Profile();
+};
+
+#endif /* __LATENCY_PROFILE_H__ */
@@ -23,6 +23,7 @@
 #include <getopt.h>
 #include <stdlib.h> // strtoul
 #include <string>
+#include <vector>
 #include "sdr/limey_device_list.h"
 #include "application/radio_config.h"
 #include "application/logger.h"
@@ -30,6 +31,7 @@
 #include "application/message_queue.h"
 #include "application/message_server.h"
 #include "application/flow_chart.h"
+#include "application/realtime.h"
 #include <thread>
 #include <future>
 #include <chrono>
@@ -60,12 +62,42 @@ int main(int argc, char* argv[])
 
     // default TCP port number
     int port_num = 4532;
+    // probe the sound devices before starting
+    bool calibrate_audio = false;
+    // SCHED_FIFO and locked memory for the flowgraph
+    bool realtime = false;
+    // 16 bit I & Q from the SDR
+    bool sc16 = false;
+    // block to CPU list
+    std::string affinity = "";
+    // flowgraph buffer sizing
+    Latency_Profile::profile_t latency_profile = Latency_Profile::DEFAULT;
+    // audio sample rate in Hz
+    unsigned int audio_rate = 48000;
+    // wideband receiver slices
+    std::vector<Radio_Config::slice_t> slices;
+    // a recording to play in place of the SDR
+    Radio_Config::playback_t playback;
+    playback.realtime = true;
+    playback.loop = false;
+    // time shift ring behind VFOA
+    Radio_Config::replay_t replay;
+    replay.seconds = 0;
+    // FFT tap for panadapters
+    Radio_Config::spectrum_t spectrum;
+    spectrum.fft_size = 0;
+    spectrum.average = 1;
+    spectrum.decimation = 0;
+    // I & Q over TCP
+    std::vector<Radio_Config::iq_server_t> iq_servers;
+    // FT8 and WSPR decoders
+    std::vector<Radio_Config::decoder_t> decoders;
     // default center frequency
     unsigned long center_freq  = 50293000;
     // the name of this program
     const char* program_name = argv[0];
     // A string listing valid short options letters.
-    const char* const short_options = "ht:lo:i:s:f:";
+    const char* const short_options = "ht:lo:i:s:f:crNa:p:A:S:P:R:F:Q:D:";
     // An array describing valid long options
     const struct option long_options[] = {
         { "help",       0, NULL, 'h' },
@@ -74,6 +106,18 @@ int main(int argc, char* argv[])
         { "snd-in",     0, NULL, 'i' },
         { "snd-out",    0, NULL, 'o' },
         { "list-sdr",   0, NULL, 'l' },
+        { "calibrate-audio", 0, NULL, 'c' },
+        { "realtime",   0, NULL, 'r' },
+        { "sc16",       0, NULL, 'N' },
+        { "affinity",   1, NULL, 'a' },
+        { "latency",    1, NULL, 'p' },
+        { "audio-rate", 1, NULL, 'A' },
+        { "slice",      1, NULL, 'S' },
+        { "playback",   1, NULL, 'P' },
+        { "replay",     1, NULL, 'R' },
+        { "spectrum",   1, NULL, 'F' },
+        { "iq-server",  1, NULL, 'Q' },
+        { "decode",     1, NULL, 'D' },
         { "tcp-port",   0, NULL, 't'},
         { NULL,         0, NULL, 0 } // Required at end of array
     };
@@ -103,6 +147,152 @@ int main(int argc, char* argv[])
                 }
                 std::exit(0);
                 break;
+        case 'c': // -c or --calibrate-audio
+                calibrate_audio = true;
+                break;
+        case 'r': // -r or --realtime
+                realtime = true;
+                break;
+        case 'N': // -N or --sc16
+                sc16 = true;
+                break;
+        case 'a': // -a or --affinity
+                affinity = std::string(optarg);
+                break;
+        case 'p': // -p or --latency
+                if(!Latency_Profile::parse(std::string(optarg), &latency_profile))
+                {
+                    std::cerr << "Latency profile "<< optarg << " is not valid. Please select low-latency or throughput."<< std::endl;
+                    exit(1);
+                }
+                break;
+        case 'A': // -A or --audio-rate
+                audio_rate = strtoul(optarg,NULL,0);
+                if(!Flow_Chart::is_audio_rate_valid(audio_rate))
+                {
+                    std::cerr << "Audio rate "<< optarg << " is not valid. Please select 12000, 24000 or 48000."<< std::endl;
+                    exit(1);
+                }
+                break;
+        case 'S': // -S or --slice
+            {
+                // [freq],[port],[audio]
+                std::vector<std::string> fields = Utility::split(std::string(optarg), ',');
+                Radio_Config::slice_t slice;
+                slice.freq = 0;
+                slice.port = 0;
+                if(2 <= fields.size() && 3 >= fields.size())
+                {
+                    slice.freq = strtod(fields[0].c_str(),NULL);
+                    slice.port = std::atoi(fields[1].c_str());
+                    slice.audio = (3 == fields.size()) ? fields[2] : "";
+                }
+                if(0 >= slice.freq || 1024 > slice.port || 49151 < slice.port)
+                {
+                    std::cerr << "Slice "<< optarg << " is not valid. Please use [freq],[port],[audio] with a port from 1024 to 49151."<< std::endl;
+                    exit(1);
+                }
+                slices.push_back(slice);
+                break;
+            }
+        case 'P': // -P or --playback
+            {
+                // [path][,fast][,loop]
+                std::vector<std::string> fields = Utility::split(std::string(optarg), ',');
+                playback.path = fields.empty() ? "" : fields[0];
+                bool valid = !playback.path.empty();
+                for(size_t i = 1; i < fields.size(); i++)
+                {
+                    if("fast" == fields[i])
+                    {
+                        playback.realtime = false;
+                    }
+                    else if("loop" == fields[i])
+                    {
+                        playback.loop = true;
+                    }
+                    else
+                    {
+                        valid = false;
+                    }
+                }
+                if(!valid)
+                {
+                    std::cerr << "Playback "<< optarg << " is not valid. Please use [path][,fast][,loop]."<< std::endl;
+                    exit(1);
+                }
+                break;
+            }
+        case 'R': // -R or --replay
+            {
+                // [seconds],[audio]
+                std::vector<std::string> fields = Utility::split(std::string(optarg), ',');
+                if(2 == fields.size())
+                {
+                    replay.seconds = strtod(fields[0].c_str(),NULL);
+                    replay.audio = fields[1];
+                }
+                if(0 >= replay.seconds || 3600 < replay.seconds || replay.audio.empty())
+                {
+                    std::cerr << "Replay "<< optarg << " is not valid. Please use [seconds],[audio] with up to 3600 seconds."<< std::endl;
+                    exit(1);
+                }
+                break;
+            }
+        case 'F': // -F or --spectrum
+            {
+                // [fft size],[average],[decimation],[name]; the later ones may be left off
+                std::vector<std::string> fields = Utility::split(std::string(optarg), ',');
+                spectrum.fft_size = (fields.size() > 0) ? std::atoi(fields[0].c_str()) : 0;
+                spectrum.average = (fields.size() > 1) ? std::atoi(fields[1].c_str()) : 4;
+                // 0 picks about 10 frames a second
+                spectrum.decimation = (fields.size() > 2) ? std::atoi(fields[2].c_str()) : 0;
+                spectrum.name = (fields.size() > 3) ? fields[3] : "";
+                if(16 > spectrum.fft_size || 65536 < spectrum.fft_size || 0 != (spectrum.fft_size & (spectrum.fft_size - 1))
+                   || 1 > spectrum.average || 0 > spectrum.decimation || 4 < fields.size())
+                {
+                    std::cerr << "Spectrum "<< optarg << " is not valid. Please use [fft size],[average],[decimation],[name] with a power of two size from 16 to 65536."<< std::endl;
+                    exit(1);
+                }
+                break;
+            }
+        case 'Q': // -Q or --iq-server
+            {
+                // [port],[tap|filter][,native]
+                std::vector<std::string> fields = Utility::split(std::string(optarg), ',');
+                Radio_Config::iq_server_t server;
+                server.port = 0;
+                server.native = false;
+                if(2 <= fields.size() && 3 >= fields.size())
+                {
+                    server.port = std::atoi(fields[0].c_str());
+                    server.point = fields[1];
+                    server.native = (3 == fields.size()) && ("native" == fields[2]);
+                }
+                if(1024 > server.port || 49151 < server.port || ("tap" != server.point && "filter" != server.point)
+                   || (3 == fields.size() && !server.native))
+                {
+                    std::cerr << "I & Q server "<< optarg << " is not valid. Please use [port],[tap|filter][,native] with a port from 1024 to 49151."<< std::endl;
+                    exit(1);
+                }
+                iq_servers.push_back(server);
+                break;
+            }
+        case 'D': // -D or --decode
+            {
+                // [ft8|wspr][,host:port]
+                std::vector<std::string> fields = Utility::split(std::string(optarg), ',');
+                Radio_Config::decoder_t decoder;
+                decoder.mode = fields.empty() ? "" : fields[0];
+                decoder.udp = (2 == fields.size()) ? fields[1] : "";
+                if(("ft8" != decoder.mode && "wspr" != decoder.mode) || 2 < fields.size())
+                {
+                    std::cerr << "Decoder "<< optarg << " is not valid. Please use [ft8|wspr][,host:port]."<< std::endl;
+                    exit(1);
+                }
+                decoders.push_back(decoder);
+                break;
+            }
         case 't': // -t or --tcp-port
                 port_num = std::atoi(optarg);
                 if(1024 > port_num || 49151 < port_num)
@@ -132,6 +322,31 @@ int main(int argc, char* argv[])
     // configure
     Radio_Config rconfig;
     rconfig.set_program_name(program_name);
+    rconfig.set_audio_rate(audio_rate);
+    rconfig.set_realtime(realtime);
+    rconfig.set_sc16(sc16);
+    rconfig.set_affinity(affinity);
+    rconfig.set_latency_profile(latency_profile);
+    for(Radio_Config::slice_t slice : slices)
+    {
+        rconfig.add_slice(slice);
+    }
+    rconfig.set_playback(playback);
+    rconfig.set_replay(replay);
+    rconfig.set_spectrum(spectrum);
+    for(Radio_Config::iq_server_t server : iq_servers)
+    {
+        rconfig.add_iq_server(server);
+    }
+    for(Radio_Config::decoder_t decoder : decoders)
+    {
+        rconfig.add_decoder(decoder);
+    }
+    if(realtime)
+    {
+        // before the buffers are allocated, so they're locked as they're made
+        Realtime::lock_memory();
+    }
     // setup message queues
     rconfig.set_cmd_queue(Message_Queue::make());
     rconfig.set_rsp_queue(Message_Queue::make());
@@ -152,33 +367,49 @@ int main(int argc, char* argv[])
     Logger::info("Audio input: "+rconfig.get_sound_input_alsa());
     rconfig.set_sound_output_alsa(snd_out_idx);
     Logger::info("Audio output: "+rconfig.get_sound_output_alsa());
+    if(calibrate_audio)
+    {
+        std::cout << "Calibrating audio latency, this takes about a minute." << std::endl;
+        Flow_Chart::calibrate_audio(rconfig);
+    }
     // SDR information, Do this after setting up logging
-    std::vector<Limey_Device_List::limey_device_t> sdr_list = Limey_Device_List::get_device_list();
+    std::vector<Limey_Device_List::limey_device_t> sdr_list;
     Limey_Device_List::limey_device_t sdr_dev;
-    if("" == sdr_serial_str)
+    if(!playback.path.empty())
     {
-        // if the sdr_serial_str was not specified with the command line 
-        // option, i the pick the first device in the list
-        sdr_serial_str = sdr_list[0].serial;
-        sdr_dev = sdr_list[0];
+        // the recording stands in for the SDR; no device needed
+        sdr_dev.serial = "";
+        sdr_dev.is_mini = false;
+        sdr_dev.info = "playback of "+playback.path;
     }
     else
     {
-        unsigned int i = 0;
-        for( i=0; i < sdr_list.size(); i++)
+        sdr_list = Limey_Device_List::get_device_list();
+        if("" == sdr_serial_str)
         {
-            if(sdr_list[i].serial == sdr_serial_str)
-            {
-                sdr_dev = sdr_list[i];
-                break;
-            }
+            // if the sdr_serial_str was not specified with the command line 
+            // option, i the pick the first device in the list
+            sdr_serial_str = sdr_list[0].serial;
+            sdr_dev = sdr_list[0];
         }
-        if(i == sdr_list.size())
+        else
         {
-            Logger::notice("SDR not found: '"+sdr_serial_str+"'");
-            //disable logger
-            Logger::reset_config();
-            exit(1);
+            unsigned int i = 0;
+            for( i=0; i < sdr_list.size(); i++)
+            {
+                if(sdr_list[i].serial == sdr_serial_str)
+                {
+                    sdr_dev = sdr_list[i];
+                    break;
+                }
+            }
+            if(i == sdr_list.size())
+            {
+                Logger::notice("SDR not found: '"+sdr_serial_str+"'");
+                //disable logger
+                Logger::reset_config();
+                exit(1);
+            }
         }
     }
     rconfig.set_sdr(sdr_dev);
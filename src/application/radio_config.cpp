@@ -34,7 +34,17 @@
  *     Radio_Config
  */
 Radio_Config::Radio_Config()
+    : m_audio_rate(48000),
+      m_sc16(false),
+      m_realtime(false),
+      m_latency_profile(Latency_Profile::DEFAULT)
 {
+    m_playback.realtime = true;
+    m_playback.loop = false;
+    m_replay.seconds = 0;
+    m_spectrum.fft_size = 0;
+    m_spectrum.average = 1;
+    m_spectrum.decimation = 1;
 }
 
 /*-------------------------------------------------------------------------
@@ -110,6 +120,204 @@ void Radio_Config::set_sound_output_alsa(std::string snd)
     m_sound_output_alsa = snd;
 }
 
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_audio_rate
+ */
+unsigned int Radio_Config::get_audio_rate()
+{
+    return m_audio_rate;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_audio_rate
+ */
+void Radio_Config::set_audio_rate(unsigned int rate)
+{
+    m_audio_rate = rate;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_slices
+ */
+std::vector<Radio_Config::slice_t> Radio_Config::get_slices()
+{
+    return m_slices;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     add_slice
+ */
+void Radio_Config::add_slice(slice_t slice)
+{
+    m_slices.push_back(slice);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_playback
+ */
+Radio_Config::playback_t Radio_Config::get_playback()
+{
+    return m_playback;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_playback
+ */
+void Radio_Config::set_playback(playback_t playback)
+{
+    m_playback = playback;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_replay
+ */
+Radio_Config::replay_t Radio_Config::get_replay()
+{
+    return m_replay;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_replay
+ */
+void Radio_Config::set_replay(replay_t replay)
+{
+    m_replay = replay;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_spectrum
+ */
+Radio_Config::spectrum_t Radio_Config::get_spectrum()
+{
+    return m_spectrum;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_spectrum
+ */
+void Radio_Config::set_spectrum(spectrum_t spectrum)
+{
+    m_spectrum = spectrum;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_iq_servers
+ */
+std::vector<Radio_Config::iq_server_t> Radio_Config::get_iq_servers()
+{
+    return m_iq_servers;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     add_iq_server
+ */
+void Radio_Config::add_iq_server(iq_server_t server)
+{
+    m_iq_servers.push_back(server);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_decoders
+ */
+std::vector<Radio_Config::decoder_t> Radio_Config::get_decoders()
+{
+    return m_decoders;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     add_decoder
+ */
+void Radio_Config::add_decoder(decoder_t decoder)
+{
+    m_decoders.push_back(decoder);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_sc16
+ */
+bool Radio_Config::get_sc16()
+{
+    return m_sc16;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_sc16
+ */
+void Radio_Config::set_sc16(bool sc16)
+{
+    m_sc16 = sc16;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_realtime
+ */
+bool Radio_Config::get_realtime()
+{
+    return m_realtime;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_realtime
+ */
+void Radio_Config::set_realtime(bool realtime)
+{
+    m_realtime = realtime;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_affinity
+ */
+std::string Radio_Config::get_affinity()
+{
+    return m_affinity;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_affinity
+ */
+void Radio_Config::set_affinity(std::string affinity)
+{
+    m_affinity = affinity;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     get_latency_profile
+ */
+Latency_Profile::profile_t Radio_Config::get_latency_profile()
+{
+    return m_latency_profile;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_latency_profile
+ */
+void Radio_Config::set_latency_profile(Latency_Profile::profile_t profile)
+{
+    m_latency_profile = profile;
+}
+
 /*-------------------------------------------------------------------------
  * Function:
  *     get_sdr_type
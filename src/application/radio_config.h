@@ -25,9 +25,11 @@
 /*--------------------------------------------------------------------------
  * Include Files
  * -----------------------------------------------------------------------*/
+#include "application/latency_profile.h"
 #include "application/message_queue.h"
 #include "sdr/limey_device_list.h"
 #include <string>
+#include <vector>
 
 class Radio_Config
 {
@@ -40,6 +42,47 @@ public:
         LIMSDR_USB
     } typedef radio_enum_t;
 
+    /** an extra receiver cut from the SDR stream */
+    struct {
+        double freq;            // dial frequency in Hz
+        int port;               // its own rigctl TCP port
+        std::string audio;      // audio output, named as for -o
+    } typedef slice_t;
+
+    /** a recording played in place of the SDR */
+    struct {
+        std::string path;       // empty for the live SDR
+        bool realtime;          // paced to the sample rate
+        bool loop;              // start over at the end
+    } typedef playback_t;
+
+    /** the time shift ring behind VFOA and where its replays go */
+    struct {
+        double seconds;         // 0 for no ring
+        std::string audio;      // audio output, named as for -o
+    } typedef replay_t;
+
+    /** the FFT tap for panadapters */
+    struct {
+        int fft_size;           // 0 for no tap
+        int average;            // FFTs per frame
+        int decimation;         // one FFT per this many blocks of samples
+        std::string name;       // shared memory ring, see shm_spectrum_ring
+    } typedef spectrum_t;
+
+    /** a TCP server for I & Q from the receiver */
+    struct {
+        int port;
+        std::string point;      // "tap" or "filter", see ssbrx outputs 1 and 2
+        bool native;            // 16 bit native protocol instead of rtl_tcp
+    } typedef iq_server_t;
+
+    /** an FT8 or WSPR decoder on VFOA's audio */
+    struct {
+        std::string mode;       // "ft8" or "wspr"
+        std::string udp;        // host:port for WSJT-X messages, or empty
+    } typedef decoder_t;
+
 /*--------------------------------------------------------------------------
  * Function Definitions
  * -----------------------------------------------------------------------*/
@@ -94,6 +137,149 @@ public:
      */
     void set_sound_output_alsa(std::string snd);
 
+    /** @brief get the audio sample rate
+     *
+     * @return unsigned int - Hz
+     */
+    unsigned int get_audio_rate();
+
+    /** @brief set the audio sample rate
+     *
+     * @param rate - 12000, 24000 or 48000 Hz
+     * @return Void.
+     */
+    void set_audio_rate(unsigned int rate);
+
+    /** @brief get the wideband receiver slices
+     *
+     * @return std::vector<slice_t>
+     */
+    std::vector<slice_t> get_slices();
+
+    /** @brief add a wideband receiver slice
+     *
+     * @param slice - frequency, port and audio output
+     * @return Void.
+     */
+    void add_slice(slice_t slice);
+
+    /** @brief get the recording to play in place of the SDR
+     *
+     * @return playback_t - path is empty for the live SDR
+     */
+    playback_t get_playback();
+
+    /** @brief set the recording to play in place of the SDR
+     *
+     * @param playback - SigMF recording and how to play it
+     * @return Void.
+     */
+    void set_playback(playback_t playback);
+
+    /** @brief get the time shift ring settings
+     *
+     * @return replay_t - seconds is 0 without a ring
+     */
+    replay_t get_replay();
+
+    /** @brief set the time shift ring settings
+     *
+     * @param replay - seconds kept and the replay audio output
+     * @return Void.
+     */
+    void set_replay(replay_t replay);
+
+    /** @brief get the FFT tap settings
+     *
+     * @return spectrum_t - fft_size is 0 without a tap
+     */
+    spectrum_t get_spectrum();
+
+    /** @brief set the FFT tap settings
+     *
+     * @param spectrum - FFT size, averaging, decimation and ring name
+     * @return Void.
+     */
+    void set_spectrum(spectrum_t spectrum);
+
+    /** @brief get the I & Q servers
+     *
+     * @return std::vector<iq_server_t>
+     */
+    std::vector<iq_server_t> get_iq_servers();
+
+    /** @brief add an I & Q server
+     *
+     * @param server - port, tap point and protocol
+     * @return Void.
+     */
+    void add_iq_server(iq_server_t server);
+
+    /** @brief get the slot decoders
+     *
+     * @return std::vector<decoder_t>
+     */
+    std::vector<decoder_t> get_decoders();
+
+    /** @brief add a slot decoder
+     *
+     * @param decoder - mode and where its WSJT-X messages go
+     * @return Void.
+     */
+    void add_decoder(decoder_t decoder);
+
+    /** @brief get whether the SDR streams 16 bit I & Q instead of gr_complex
+     *
+     * @return bool
+     */
+    bool get_sc16();
+
+    /** @brief set whether the SDR streams 16 bit I & Q instead of gr_complex
+     *
+     * @param sc16 - true for 16 bit I & Q
+     * @return Void.
+     */
+    void set_sc16(bool sc16);
+
+    /** @brief get whether to run the flowgraph SCHED_FIFO and locked in memory
+     *
+     * @return bool
+     */
+    bool get_realtime();
+
+    /** @brief set whether to run the flowgraph SCHED_FIFO and locked in memory
+     *
+     * @param realtime - true for real-time
+     * @return Void.
+     */
+    void set_realtime(bool realtime);
+
+    /** @brief get the block to CPU list, ex: "sdr_source=2,receiver=3"
+     *
+     * @return std::string
+     */
+    std::string get_affinity();
+
+    /** @brief set the block to CPU list
+     *
+     * @param affinity - comma separated role=cpus
+     * @return Void.
+     */
+    void set_affinity(std::string affinity);
+
+    /** @brief get how the flowgraph buffers are sized
+     *
+     * @return Latency_Profile::profile_t
+     */
+    Latency_Profile::profile_t get_latency_profile();
+
+    /** @brief set how the flowgraph buffers are sized
+     *
+     * @param profile - latency profile
+     * @return Void.
+     */
+    void set_latency_profile(Latency_Profile::profile_t profile);
+
     /** @brief Get the SDR specified by radio_enum_t
      *
      * @return radio_enum_t
@@ -145,6 +331,17 @@ private:
     std::string m_program_name;
     std::string m_sound_input_alsa;
     std::string m_sound_output_alsa;
+    unsigned int m_audio_rate;
+    std::vector<slice_t> m_slices;
+    playback_t m_playback;
+    replay_t m_replay;
+    spectrum_t m_spectrum;
+    std::vector<iq_server_t> m_iq_servers;
+    std::vector<decoder_t> m_decoders;
+    bool m_sc16;
+    bool m_realtime;
+    std::string m_affinity;
+    Latency_Profile::profile_t m_latency_profile;
     std::string m_sdr_name;
     Limey_Device_List::limey_device_t m_sdr_dev;
 
@@ -0,0 +1,217 @@
+/**------------------------------------------------------------------------
+ * @file realtime.cpp
+ * @brief real-time scheduling, CPU pinning and memory locking
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ----------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------
+ * Include Files
+ * ----------------------------------------------------------------------*/
+#include "application/realtime.h"
+#include "application/logger.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*-------------------------------------------------------------------------
+ * Type Definitions
+ * ----------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     lock_memory
+ */
+bool Realtime::lock_memory()
+{
+    if(0 != mlockall(MCL_CURRENT | MCL_FUTURE))
+    {
+        Logger::notice("[Realtime::lock_memory] mlockall: "+std::string(strerror(errno))+"; raise the memlock limit");
+        return false;
+    }
+    Logger::info("[Realtime::lock_memory] memory locked");
+    return true;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     find_thread
+ */
+static pid_t find_thread(const std::string &name)
+{
+    DIR *dir = opendir("/proc/self/task");
+    if(nullptr == dir)
+    {
+        return 0;
+    }
+
+    pid_t found = 0;
+    struct dirent *entry;
+    while(0 == found && nullptr != (entry = readdir(dir)))
+    {
+        if(entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        std::string comm_name;
+        std::ifstream comm("/proc/self/task/"+std::string(entry->d_name)+"/comm");
+        std::getline(comm, comm_name);
+        if(comm_name == name)
+        {
+            found = atoi(entry->d_name);
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     set_fifo
+ */
+bool Realtime::set_fifo(gr::block_sptr block, int priority)
+{
+    // GNU Radio names a block's thread <block name><unique id>; the
+    // kernel keeps 15 characters of it
+    std::string comm_name = (block->name()+std::to_string(block->unique_id())).substr(0, 15);
+    pid_t tid = 0;
+    for(int tries = 0; tries < 100 && 0 == (tid = find_thread(comm_name)); tries++)
+    {
+        usleep(10000);
+    }
+    if(0 == tid)
+    {
+        Logger::notice("[Realtime::set_fifo] no thread named "+comm_name);
+        return false;
+    }
+
+    struct sched_param param;
+    param.sched_priority = priority;
+    if(0 != sched_setscheduler(tid, SCHED_FIFO, &param))
+    {
+        Logger::notice("[Realtime::set_fifo] SCHED_FIFO: "+std::string(strerror(errno))+"; raise the rtprio limit");
+        return false;
+    }
+    return true;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     parse_cpus
+ */
+bool Realtime::parse_cpus(const std::string &cpus, std::vector<int> *mask)
+{
+    // "," already separates the roles, so the CPUs of one role are joined with "+"
+    std::vector<int> cpu_list;
+    std::istringstream list(cpus);
+    std::string item;
+    while(std::getline(list, item, '+'))
+    {
+        char *end = nullptr;
+        long first = strtol(item.c_str(), &end, 10);
+        long last = first;
+        if(*end == '-')
+        {
+            last = strtol(end + 1, &end, 10);
+        }
+        if(item.empty() || *end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        for(long cpu = first; cpu <= last; cpu++)
+        {
+            cpu_list.push_back((int)cpu);
+        }
+    }
+    if(cpu_list.empty() || cpus.back() == '+')
+    {
+        return false;
+    }
+
+    mask->swap(cpu_list);
+    return true;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:
+ *     report_threads
+ */
+void Realtime::report_threads()
+{
+    DIR *dir = opendir("/proc/self/task");
+    if(nullptr == dir)
+    {
+        return;
+    }
+
+    struct dirent *entry;
+    while(nullptr != (entry = readdir(dir)))
+    {
+        if(entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        pid_t tid = atoi(entry->d_name);
+        std::string task = "/proc/self/task/"+std::string(entry->d_name);
+
+        // GNU Radio names each block's thread <block name><unique id>
+        std::string name;
+        std::ifstream comm(task+"/comm");
+        std::getline(comm, name);
+
+        // the CPU it last ran on is field 39; the name may hold spaces
+        std::string stat_line;
+        std::ifstream stat(task+"/stat");
+        std::getline(stat, stat_line);
+        std::istringstream fields(stat_line.substr(stat_line.rfind(')') + 2));
+        std::string field;
+        for(int i = 3; i <= 39 && fields >> field; i++)
+        {
+        }
+
+        int policy = sched_getscheduler(tid);
+        struct sched_param param;
+        sched_getparam(tid, &param);
+
+        std::string allowed;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(0 == sched_getaffinity(tid, sizeof(set), &set))
+        {
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if(CPU_ISSET(cpu, &set))
+                {
+                    allowed += (allowed.empty() ? "" : ",")+std::to_string(cpu);
+                }
+            }
+        }
+
+        Logger::info("[Realtime::report_threads] "+std::to_string(tid)+" "+name
+            +": cpu "+field
+            +", "+(policy == SCHED_FIFO ? "SCHED_FIFO "+std::to_string(param.sched_priority) : std::string("SCHED_OTHER"))
+            +", allowed "+allowed);
+    }
+    closedir(dir);
+}
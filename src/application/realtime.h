@@ -0,0 +1,85 @@
+/**-------------------------------------------------------------------------
+ * @file realtime.h
+ * @brief real-time scheduling, CPU pinning and memory locking
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * -----------------------------------------------------------------------*/
+#ifndef __REALTIME_H__
+#define __REALTIME_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/block.h>
+#include <string>
+#include <vector>
+
+/**
+ * Helpers for running the flowgraph ahead of everything else on a busy
+ * host.  GNU Radio starts one thread per block and names it after the
+ * block, so once the top block runs Flow_Chart finds the threads of the
+ * hardware blocks by name and switches just those to SCHED_FIFO.
+ *
+ * SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit, and mlockall needs
+ * CAP_IPC_LOCK or a big enough memlock limit; see limits.conf(5).
+ */
+class Realtime
+{
+public:
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief lock all current and future pages into memory
+     *
+     * @return bool - false if the limits don't allow it
+     */
+    static bool lock_memory();
+
+    /** @brief switch a running block's thread to SCHED_FIFO
+     *
+     * A new block thread names itself once it runs, so this waits up to
+     * a second for the name to show up.
+     *
+     * @param block - the block
+     * @param priority - 1 to 99
+     * @return bool - false if there's no such thread or we aren't allowed
+     */
+    static bool set_fifo(gr::block_sptr block, int priority);
+
+    /** @brief parse a CPU list, ex: "2", "0-3" or "0+2-3"
+     *
+     * @param cpus - the list
+     * @param mask - the CPU numbers
+     * @return bool - false if it doesn't parse
+     */
+    static bool parse_cpus(const std::string &cpus, std::vector<int> *mask);
+
+    /** @brief log every thread of this process with its policy and CPUs
+     *
+     * @return Void.
+     */
+    static void report_threads();
+
+private:
+    /** @brief Constructor
+     *
+     */
+    Realtime();
+};
+
+#endif /* __REALTIME_H__ */
@@ -42,10 +42,22 @@ void Utility::print_usage (std::ostream& pOstream, const char* app_name)
     pOstream << "Usage: " << app_name << " [ options ]"<< std::endl;
     pOstream << "  -h --help                  Display this usage information.\n"
         << "  -f --freq [center freq.]   Default center frequency in Hz.\n"
-        << "  -o --snd-out [name]        Name of the audio output.\n"
-        << "  -i --snd-in [name]         Name of the audio input.\n"
+        << "  -o --snd-out [name]        Audio output, shm:[ring], udp:[host]:[port] or file:[path].\n"
+        << "  -i --snd-in [name]         Audio input, shm:[ring], udp:[port] or file:[path].\n"
         << "  -s --sel-sdr [name]        Select the SDR from the list of SDRs.\n"
         << "  -l --list-sdr              Print the available SDRs and exit.\n"
+        << "  -A --audio-rate [Hz]       12000, 24000 or 48000 (default).\n"
+        << "  -c --calibrate-audio       Find and save the lowest stable audio latency.\n"
+        << "  -r --realtime              Run the flowgraph SCHED_FIFO with memory locked.\n"
+        << "  -N --sc16                  Stream 16 bit I & Q from the SDR, not float.\n"
+        << "  -a --affinity [list]       Pin blocks to CPUs, ex: sdr_source=2,receiver=0+3-4.\n"
+        << "  -p --latency [profile]     Buffer sizing, low-latency or throughput.\n"
+        << "  -S --slice [f,port,out]    Extra receiver at f Hz with its own port.\n"
+        << "  -P --playback [path]       Play a SigMF recording instead, ex: rec,fast,loop.\n"
+        << "  -R --replay [s,out]        Keep s seconds of VFOA to replay to out.\n"
+        << "  -F --spectrum [n,avg,dec]  Publish an n bin FFT to shared memory for panadapters.\n"
+        << "  -Q --iq-server [port,at]   rtl_tcp I & Q from tap or filter, ex: 1234,tap,native.\n"
+        << "  -D --decode [mode,udp]     Decode ft8 or wspr from VFOA, ex: ft8,127.0.0.1:2237.\n"
         << "  -t --tcp-port [portNumber] The TCP port number." <<std::endl;
 }
 
@@ -176,6 +188,30 @@ std::string Utility::get_substring(std::string input, std::string start, std::st
     return rval;
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     split
+ */
+std::vector<std::string> Utility::split(std::string input, const char delim)
+{
+    std::vector<std::string> rval;
+    size_t start = 0;
+    while(start < input.size())
+    {
+        size_t end = input.find(delim, start);
+        if(end == std::string::npos)
+        {
+            end = input.size();
+        }
+        if(end > start)
+        {
+            rval.push_back(input.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return rval;
+}
+
 /*--------------------------------------------------------------------------
  * Function:
  *     Utility
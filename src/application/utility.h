@@ -91,6 +91,14 @@ public:
     static std::string get_substring(std::string input, const char start, const char end);
     static std::string get_substring(std::string input, std::string start, std::string end);
 
+    /** @brief split a string on a delimiter, skipping empty fields
+     *
+     * @param input - the input string
+     * @param delim - the char between fields
+     * @return std::vector<std::string>
+     */
+    static std::vector<std::string> split(std::string input, const char delim);
+
 private:
     /** @brief Constructor
      *
@@ -0,0 +1,1180 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "audio/alsa_convert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define GRI_ALSA_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define GRI_ALSA_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// full scale of the integer formats
+static const float s16_scale = 32767.0f;
+static const float s16_unscale = 1.0f / 32768.0f;
+static const float s32_scale = 2147483648.0f;
+static const float s32_unscale = 1.0f / 2147483648.0f;
+// +1.0 * s32_scale doesn't fit in an int32; this is the largest float that does
+static const float s32_max = 2147483520.0f;
+static const float s32_min = -2147483648.0f;
+static const float s24_scale = 8388607.0f;
+static const float s24_unscale = 1.0f / 8388608.0f;
+
+// one packed SND_PCM_FORMAT_S24_3LE sample
+struct s24_3_t {
+  uint8_t b[3];
+};
+
+// ----------------------------------------------------------------
+// generic versions; the SIMD kernels use these for the tail frames
+
+static inline void
+to_sample(float x, int16_t &s)
+{
+  x = std::min(std::max(x, -1.0f), 1.0f);
+  s = (int16_t) lrintf(x * s16_scale);
+}
+
+static inline void
+to_sample(float x, int32_t &s)
+{
+  x = std::min(std::max(x * s32_scale, s32_min), s32_max);
+  s = (int32_t) lrintf(x);
+}
+
+static inline void
+to_sample(float x, float &s)
+{
+  s = x;
+}
+
+static inline void
+to_sample(float x, s24_3_t &s)
+{
+  x = std::min(std::max(x, -1.0f), 1.0f);
+  int32_t t = (int32_t) lrintf(x * s24_scale);
+  s.b[0] = t & 0xff;
+  s.b[1] = (t >> 8) & 0xff;
+  s.b[2] = (t >> 16) & 0xff;
+}
+
+static inline float
+from_sample(int16_t s)
+{
+  return (float) s * s16_unscale;
+}
+
+static inline float
+from_sample(int32_t s)
+{
+  return (float) s * s32_unscale;
+}
+
+static inline float
+from_sample(float s)
+{
+  return s;
+}
+
+static inline float
+from_sample(const s24_3_t &s)
+{
+  // land the sample in the top of an int32 to sign extend it
+  int32_t t = (int32_t) (((uint32_t) s.b[0] << 8) |
+                         ((uint32_t) s.b[1] << 16) |
+                         ((uint32_t) s.b[2] << 24)) >> 8;
+  return (float) t * s24_unscale;
+}
+
+template<typename sample_t>
+static void
+pack_from(void *dst, const float **in, unsigned int nchan,
+          unsigned int i, unsigned int nframes)
+{
+  sample_t *buf = (sample_t *) dst + i * nchan;
+
+  for(; i < nframes; i++) {
+    for(unsigned int chan = 0; chan < nchan; chan++)
+      to_sample(in[chan][i], *buf++);
+  }
+}
+
+template<typename sample_t>
+static void
+pack_1x2_from(void *dst, const float **in,
+              unsigned int i, unsigned int nframes)
+{
+  sample_t *buf = (sample_t *) dst + i * 2;
+
+  for(; i < nframes; i++) {
+    sample_t t;
+    to_sample(in[0][i], t);
+    *buf++ = t;
+    *buf++ = t;
+  }
+}
+
+template<typename sample_t>
+static void
+unpack_from(float **out, const void *src, unsigned int nchan,
+            unsigned int i, unsigned int nframes)
+{
+  const sample_t *buf = (const sample_t *) src + i * nchan;
+
+  for(; i < nframes; i++) {
+    for(unsigned int chan = 0; chan < nchan; chan++)
+      out[chan][i] = from_sample(*buf++);
+  }
+}
+
+template<typename sample_t>
+static void
+unpack_2x1_from(float **out, const void *src,
+                unsigned int i, unsigned int nframes)
+{
+  const sample_t *buf = (const sample_t *) src + i * 2;
+
+  for(; i < nframes; i++) {
+    out[0][i] = (from_sample(buf[0]) + from_sample(buf[1])) * 0.5f;
+    buf += 2;
+  }
+}
+
+template<typename sample_t>
+static void
+generic_pack(void *dst, const float **in,
+             unsigned int nchan, unsigned int nframes)
+{
+  pack_from<sample_t>(dst, in, nchan, 0, nframes);
+}
+
+template<typename sample_t>
+static void
+generic_pack_1x2(void *dst, const float **in,
+                 unsigned int nchan, unsigned int nframes)
+{
+  pack_1x2_from<sample_t>(dst, in, 0, nframes);
+}
+
+template<typename sample_t>
+static void
+generic_unpack(float **out, const void *src,
+               unsigned int nchan, unsigned int nframes)
+{
+  unpack_from<sample_t>(out, src, nchan, 0, nframes);
+}
+
+template<typename sample_t>
+static void
+generic_unpack_2x1(float **out, const void *src,
+                   unsigned int nchan, unsigned int nframes)
+{
+  unpack_2x1_from<sample_t>(out, src, 0, nframes);
+}
+
+// mono float needs no conversion at all
+static void
+generic_float_to_f32(void *dst, const float **in,
+                     unsigned int nchan, unsigned int nframes)
+{
+  if(nchan == 1)
+    memcpy(dst, in[0], nframes * sizeof(float));
+  else
+    pack_from<float>(dst, in, nchan, 0, nframes);
+}
+
+static void
+generic_f32_to_float(float **out, const void *src,
+                     unsigned int nchan, unsigned int nframes)
+{
+  if(nchan == 1)
+    memcpy(out[0], src, nframes * sizeof(float));
+  else
+    unpack_from<float>(out, src, nchan, 0, nframes);
+}
+
+static const gri_alsa_convert generic_convert = {
+  "generic",
+  generic_pack<int16_t>,
+  generic_pack_1x2<int16_t>,
+  generic_pack<int32_t>,
+  generic_pack_1x2<int32_t>,
+  generic_float_to_f32,
+  generic_pack_1x2<float>,
+  generic_pack<s24_3_t>,
+  generic_pack_1x2<s24_3_t>,
+  generic_unpack<int16_t>,
+  generic_unpack_2x1<int16_t>,
+  generic_unpack<int32_t>,
+  generic_unpack_2x1<int32_t>,
+  generic_f32_to_float,
+  generic_unpack_2x1<float>,
+  generic_unpack<s24_3_t>,
+  generic_unpack_2x1<s24_3_t>
+};
+
+// ----------------------------------------------------------------
+// SSE2: 4 frames per iteration (8 for mono S16)
+
+#if defined(__SSE2__)
+
+static inline __m128i
+sse2_cvt_s16(__m128 x)
+{
+  x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+  return _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(s16_scale)));
+}
+
+static inline __m128i
+sse2_cvt_s32(__m128 x)
+{
+  x = _mm_mul_ps(x, _mm_set1_ps(s32_scale));
+  x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(s32_min)), _mm_set1_ps(s32_max));
+  return _mm_cvtps_epi32(x);
+}
+
+static void
+sse2_float_to_s16(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  int16_t *buf = (int16_t *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m128i a = sse2_cvt_s16(_mm_loadu_ps(in[0] + i));
+      __m128i b = sse2_cvt_s16(_mm_loadu_ps(in[0] + i + 4));
+      _mm_storeu_si128((__m128i *) (buf + i), _mm_packs_epi32(a, b));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      __m128i l = sse2_cvt_s16(_mm_loadu_ps(in[0] + i));
+      __m128i r = sse2_cvt_s16(_mm_loadu_ps(in[1] + i));
+      _mm_storeu_si128((__m128i *) (buf + 2 * i),
+                       _mm_packs_epi32(_mm_unpacklo_epi32(l, r),
+                                       _mm_unpackhi_epi32(l, r)));
+    }
+  }
+  pack_from<int16_t>(dst, in, nchan, i, nframes);
+}
+
+static void
+sse2_float_to_s16_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  int16_t *buf = (int16_t *) dst;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    __m128i l = sse2_cvt_s16(_mm_loadu_ps(in[0] + i));
+    _mm_storeu_si128((__m128i *) (buf + 2 * i),
+                     _mm_packs_epi32(_mm_unpacklo_epi32(l, l),
+                                     _mm_unpackhi_epi32(l, l)));
+  }
+  pack_1x2_from<int16_t>(dst, in, i, nframes);
+}
+
+static void
+sse2_float_to_s32(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  int32_t *buf = (int32_t *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 4 <= nframes; i += 4)
+      _mm_storeu_si128((__m128i *) (buf + i),
+                       sse2_cvt_s32(_mm_loadu_ps(in[0] + i)));
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      __m128i l = sse2_cvt_s32(_mm_loadu_ps(in[0] + i));
+      __m128i r = sse2_cvt_s32(_mm_loadu_ps(in[1] + i));
+      _mm_storeu_si128((__m128i *) (buf + 2 * i), _mm_unpacklo_epi32(l, r));
+      _mm_storeu_si128((__m128i *) (buf + 2 * i + 4), _mm_unpackhi_epi32(l, r));
+    }
+  }
+  pack_from<int32_t>(dst, in, nchan, i, nframes);
+}
+
+static void
+sse2_float_to_s32_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  int32_t *buf = (int32_t *) dst;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    __m128i l = sse2_cvt_s32(_mm_loadu_ps(in[0] + i));
+    _mm_storeu_si128((__m128i *) (buf + 2 * i), _mm_unpacklo_epi32(l, l));
+    _mm_storeu_si128((__m128i *) (buf + 2 * i + 4), _mm_unpackhi_epi32(l, l));
+  }
+  pack_1x2_from<int32_t>(dst, in, i, nframes);
+}
+
+static void
+sse2_s16_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const int16_t *buf = (const int16_t *) src;
+  const __m128 scale = _mm_set1_ps(s16_unscale);
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (buf + i));
+      // sign extend by landing each sample in the top half of a lane
+      __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+      _mm_storeu_ps(out[0] + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+      _mm_storeu_ps(out[0] + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      // each 32-bit lane holds one L/R frame
+      __m128i v = _mm_loadu_si128((const __m128i *) (buf + 2 * i));
+      __m128i l = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+      __m128i r = _mm_srai_epi32(v, 16);
+      _mm_storeu_ps(out[0] + i, _mm_mul_ps(_mm_cvtepi32_ps(l), scale));
+      _mm_storeu_ps(out[1] + i, _mm_mul_ps(_mm_cvtepi32_ps(r), scale));
+    }
+  }
+  unpack_from<int16_t>(out, src, nchan, i, nframes);
+}
+
+static void
+sse2_s16_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const int16_t *buf = (const int16_t *) src;
+  const __m128 scale = _mm_set1_ps(s16_unscale * 0.5f);
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (buf + 2 * i));
+    __m128i l = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+    __m128i r = _mm_srai_epi32(v, 16);
+    __m128i t = _mm_add_epi32(l, r);
+    _mm_storeu_ps(out[0] + i, _mm_mul_ps(_mm_cvtepi32_ps(t), scale));
+  }
+  unpack_2x1_from<int16_t>(out, src, i, nframes);
+}
+
+static void
+sse2_s32_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const int32_t *buf = (const int32_t *) src;
+  const __m128 scale = _mm_set1_ps(s32_unscale);
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 4 <= nframes; i += 4) {
+      __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (buf + i)));
+      _mm_storeu_ps(out[0] + i, _mm_mul_ps(a, scale));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (buf + 2 * i)));
+      __m128 b = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (buf + 2 * i + 4)));
+      __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+      __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+      _mm_storeu_ps(out[0] + i, _mm_mul_ps(l, scale));
+      _mm_storeu_ps(out[1] + i, _mm_mul_ps(r, scale));
+    }
+  }
+  unpack_from<int32_t>(out, src, nchan, i, nframes);
+}
+
+static void
+sse2_s32_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const int32_t *buf = (const int32_t *) src;
+  const __m128 scale = _mm_set1_ps(s32_unscale);
+  const __m128 half = _mm_set1_ps(0.5f);
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (buf + 2 * i)));
+    __m128 b = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (buf + 2 * i + 4)));
+    // average in float; the int32 sum could overflow
+    __m128 l = _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), scale);
+    __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), scale);
+    _mm_storeu_ps(out[0] + i, _mm_mul_ps(_mm_add_ps(l, r), half));
+  }
+  unpack_2x1_from<int32_t>(out, src, i, nframes);
+}
+
+static void
+sse2_float_to_f32(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  float *buf = (float *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    memcpy(dst, in[0], nframes * sizeof(float));
+    return;
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      __m128 l = _mm_loadu_ps(in[0] + i);
+      __m128 r = _mm_loadu_ps(in[1] + i);
+      _mm_storeu_ps(buf + 2 * i, _mm_unpacklo_ps(l, r));
+      _mm_storeu_ps(buf + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+  }
+  pack_from<float>(dst, in, nchan, i, nframes);
+}
+
+static void
+sse2_float_to_f32_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  float *buf = (float *) dst;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    __m128 l = _mm_loadu_ps(in[0] + i);
+    _mm_storeu_ps(buf + 2 * i, _mm_unpacklo_ps(l, l));
+    _mm_storeu_ps(buf + 2 * i + 4, _mm_unpackhi_ps(l, l));
+  }
+  pack_1x2_from<float>(dst, in, i, nframes);
+}
+
+static void
+sse2_f32_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const float *buf = (const float *) src;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    memcpy(out[0], src, nframes * sizeof(float));
+    return;
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      __m128 a = _mm_loadu_ps(buf + 2 * i);
+      __m128 b = _mm_loadu_ps(buf + 2 * i + 4);
+      _mm_storeu_ps(out[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_storeu_ps(out[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+  }
+  unpack_from<float>(out, src, nchan, i, nframes);
+}
+
+static void
+sse2_f32_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const float *buf = (const float *) src;
+  const __m128 half = _mm_set1_ps(0.5f);
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    __m128 a = _mm_loadu_ps(buf + 2 * i);
+    __m128 b = _mm_loadu_ps(buf + 2 * i + 4);
+    __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(out[0] + i, _mm_mul_ps(_mm_add_ps(l, r), half));
+  }
+  unpack_2x1_from<float>(out, src, i, nframes);
+}
+
+// packed 24 bit doesn't line up with the vector lanes; use the generic ones
+static const gri_alsa_convert sse2_convert = {
+  "sse2",
+  sse2_float_to_s16,
+  sse2_float_to_s16_1x2,
+  sse2_float_to_s32,
+  sse2_float_to_s32_1x2,
+  sse2_float_to_f32,
+  sse2_float_to_f32_1x2,
+  generic_pack<s24_3_t>,
+  generic_pack_1x2<s24_3_t>,
+  sse2_s16_to_float,
+  sse2_s16_to_float_2x1,
+  sse2_s32_to_float,
+  sse2_s32_to_float_2x1,
+  sse2_f32_to_float,
+  sse2_f32_to_float_2x1,
+  generic_unpack<s24_3_t>,
+  generic_unpack_2x1<s24_3_t>
+};
+
+#endif /* __SSE2__ */
+
+// ----------------------------------------------------------------
+// AVX2: 8 frames per iteration (16 for mono S16).  Built for every x86
+// target and only selected when the running CPU has it.
+
+#if defined(GRI_ALSA_HAVE_AVX2)
+
+#define AVX2 __attribute__((target("avx2")))
+
+// restore frame order after a per-lane pack or shuffle
+#define AVX2_FIX_LANES _MM_SHUFFLE(3, 1, 2, 0)
+
+AVX2 static inline __m256i
+avx2_cvt_s16(__m256 x)
+{
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+  return _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(s16_scale)));
+}
+
+AVX2 static inline __m256i
+avx2_cvt_s32(__m256 x)
+{
+  x = _mm256_mul_ps(x, _mm256_set1_ps(s32_scale));
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(s32_min)), _mm256_set1_ps(s32_max));
+  return _mm256_cvtps_epi32(x);
+}
+
+AVX2 static void
+avx2_float_to_s16(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  int16_t *buf = (int16_t *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 16 <= nframes; i += 16) {
+      __m256i a = avx2_cvt_s16(_mm256_loadu_ps(in[0] + i));
+      __m256i b = avx2_cvt_s16(_mm256_loadu_ps(in[0] + i + 8));
+      __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), AVX2_FIX_LANES);
+      _mm256_storeu_si256((__m256i *) (buf + i), p);
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256i l = avx2_cvt_s16(_mm256_loadu_ps(in[0] + i));
+      __m256i r = avx2_cvt_s16(_mm256_loadu_ps(in[1] + i));
+      // the per-lane unpack and pack cancel out; frames stay in order
+      _mm256_storeu_si256((__m256i *) (buf + 2 * i),
+                          _mm256_packs_epi32(_mm256_unpacklo_epi32(l, r),
+                                             _mm256_unpackhi_epi32(l, r)));
+    }
+  }
+  pack_from<int16_t>(dst, in, nchan, i, nframes);
+}
+
+AVX2 static void
+avx2_float_to_s16_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  int16_t *buf = (int16_t *) dst;
+  unsigned int i = 0;
+
+  for(; i + 8 <= nframes; i += 8) {
+    __m256i l = avx2_cvt_s16(_mm256_loadu_ps(in[0] + i));
+    _mm256_storeu_si256((__m256i *) (buf + 2 * i),
+                        _mm256_packs_epi32(_mm256_unpacklo_epi32(l, l),
+                                           _mm256_unpackhi_epi32(l, l)));
+  }
+  pack_1x2_from<int16_t>(dst, in, i, nframes);
+}
+
+AVX2 static void
+avx2_float_to_s32(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  int32_t *buf = (int32_t *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8)
+      _mm256_storeu_si256((__m256i *) (buf + i),
+                          avx2_cvt_s32(_mm256_loadu_ps(in[0] + i)));
+  }
+  else if(nchan == 2) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256i l = avx2_cvt_s32(_mm256_loadu_ps(in[0] + i));
+      __m256i r = avx2_cvt_s32(_mm256_loadu_ps(in[1] + i));
+      __m256i lo = _mm256_unpacklo_epi32(l, r);
+      __m256i hi = _mm256_unpackhi_epi32(l, r);
+      _mm256_storeu_si256((__m256i *) (buf + 2 * i),
+                          _mm256_permute2x128_si256(lo, hi, 0x20));
+      _mm256_storeu_si256((__m256i *) (buf + 2 * i + 8),
+                          _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+  }
+  pack_from<int32_t>(dst, in, nchan, i, nframes);
+}
+
+AVX2 static void
+avx2_float_to_s32_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  int32_t *buf = (int32_t *) dst;
+  unsigned int i = 0;
+
+  for(; i + 8 <= nframes; i += 8) {
+    __m256i l = avx2_cvt_s32(_mm256_loadu_ps(in[0] + i));
+    __m256i lo = _mm256_unpacklo_epi32(l, l);
+    __m256i hi = _mm256_unpackhi_epi32(l, l);
+    _mm256_storeu_si256((__m256i *) (buf + 2 * i),
+                        _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *) (buf + 2 * i + 8),
+                        _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  pack_1x2_from<int32_t>(dst, in, i, nframes);
+}
+
+AVX2 static void
+avx2_s16_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const int16_t *buf = (const int16_t *) src;
+  const __m256 scale = _mm256_set1_ps(s16_unscale);
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (buf + i)));
+      _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 8 <= nframes; i += 8) {
+      // each 32-bit lane holds one L/R frame
+      __m256i v = _mm256_loadu_si256((const __m256i *) (buf + 2 * i));
+      __m256i l = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+      __m256i r = _mm256_srai_epi32(v, 16);
+      _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(_mm256_cvtepi32_ps(l), scale));
+      _mm256_storeu_ps(out[1] + i, _mm256_mul_ps(_mm256_cvtepi32_ps(r), scale));
+    }
+  }
+  unpack_from<int16_t>(out, src, nchan, i, nframes);
+}
+
+AVX2 static void
+avx2_s16_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const int16_t *buf = (const int16_t *) src;
+  const __m256 scale = _mm256_set1_ps(s16_unscale * 0.5f);
+  unsigned int i = 0;
+
+  for(; i + 8 <= nframes; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (buf + 2 * i));
+    __m256i l = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+    __m256i r = _mm256_srai_epi32(v, 16);
+    __m256i t = _mm256_add_epi32(l, r);
+    _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(_mm256_cvtepi32_ps(t), scale));
+  }
+  unpack_2x1_from<int16_t>(out, src, i, nframes);
+}
+
+AVX2 static inline __m256
+avx2_pick(__m256 a, __m256 b, bool right)
+{
+  __m256 v = right ? _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))
+                   : _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+  return _mm256_castsi256_ps(
+           _mm256_permute4x64_epi64(_mm256_castps_si256(v), AVX2_FIX_LANES));
+}
+
+AVX2 static void
+avx2_s32_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const int32_t *buf = (const int32_t *) src;
+  const __m256 scale = _mm256_set1_ps(s32_unscale);
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256 a = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) (buf + i)));
+      _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(a, scale));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256 a = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) (buf + 2 * i)));
+      __m256 b = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) (buf + 2 * i + 8)));
+      _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(avx2_pick(a, b, false), scale));
+      _mm256_storeu_ps(out[1] + i, _mm256_mul_ps(avx2_pick(a, b, true), scale));
+    }
+  }
+  unpack_from<int32_t>(out, src, nchan, i, nframes);
+}
+
+AVX2 static void
+avx2_s32_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const int32_t *buf = (const int32_t *) src;
+  const __m256 scale = _mm256_set1_ps(s32_unscale);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  unsigned int i = 0;
+
+  for(; i + 8 <= nframes; i += 8) {
+    __m256 a = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) (buf + 2 * i)));
+    __m256 b = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) (buf + 2 * i + 8)));
+    __m256 l = _mm256_mul_ps(avx2_pick(a, b, false), scale);
+    __m256 r = _mm256_mul_ps(avx2_pick(a, b, true), scale);
+    _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(_mm256_add_ps(l, r), half));
+  }
+  unpack_2x1_from<int32_t>(out, src, i, nframes);
+}
+
+AVX2 static void
+avx2_float_to_f32(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  float *buf = (float *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    memcpy(dst, in[0], nframes * sizeof(float));
+    return;
+  }
+  else if(nchan == 2) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256 l = _mm256_loadu_ps(in[0] + i);
+      __m256 r = _mm256_loadu_ps(in[1] + i);
+      __m256 lo = _mm256_unpacklo_ps(l, r);
+      __m256 hi = _mm256_unpackhi_ps(l, r);
+      _mm256_storeu_ps(buf + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+      _mm256_storeu_ps(buf + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+  }
+  pack_from<float>(dst, in, nchan, i, nframes);
+}
+
+AVX2 static void
+avx2_float_to_f32_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  float *buf = (float *) dst;
+  unsigned int i = 0;
+
+  for(; i + 8 <= nframes; i += 8) {
+    __m256 l = _mm256_loadu_ps(in[0] + i);
+    __m256 lo = _mm256_unpacklo_ps(l, l);
+    __m256 hi = _mm256_unpackhi_ps(l, l);
+    _mm256_storeu_ps(buf + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(buf + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  pack_1x2_from<float>(dst, in, i, nframes);
+}
+
+AVX2 static void
+avx2_f32_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const float *buf = (const float *) src;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    memcpy(out[0], src, nframes * sizeof(float));
+    return;
+  }
+  else if(nchan == 2) {
+    for(; i + 8 <= nframes; i += 8) {
+      __m256 a = _mm256_loadu_ps(buf + 2 * i);
+      __m256 b = _mm256_loadu_ps(buf + 2 * i + 8);
+      _mm256_storeu_ps(out[0] + i, avx2_pick(a, b, false));
+      _mm256_storeu_ps(out[1] + i, avx2_pick(a, b, true));
+    }
+  }
+  unpack_from<float>(out, src, nchan, i, nframes);
+}
+
+AVX2 static void
+avx2_f32_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const float *buf = (const float *) src;
+  const __m256 half = _mm256_set1_ps(0.5f);
+  unsigned int i = 0;
+
+  for(; i + 8 <= nframes; i += 8) {
+    __m256 a = _mm256_loadu_ps(buf + 2 * i);
+    __m256 b = _mm256_loadu_ps(buf + 2 * i + 8);
+    __m256 t = _mm256_add_ps(avx2_pick(a, b, false), avx2_pick(a, b, true));
+    _mm256_storeu_ps(out[0] + i, _mm256_mul_ps(t, half));
+  }
+  unpack_2x1_from<float>(out, src, i, nframes);
+}
+
+static const gri_alsa_convert avx2_convert = {
+  "avx2",
+  avx2_float_to_s16,
+  avx2_float_to_s16_1x2,
+  avx2_float_to_s32,
+  avx2_float_to_s32_1x2,
+  avx2_float_to_f32,
+  avx2_float_to_f32_1x2,
+  generic_pack<s24_3_t>,
+  generic_pack_1x2<s24_3_t>,
+  avx2_s16_to_float,
+  avx2_s16_to_float_2x1,
+  avx2_s32_to_float,
+  avx2_s32_to_float_2x1,
+  avx2_f32_to_float,
+  avx2_f32_to_float_2x1,
+  generic_unpack<s24_3_t>,
+  generic_unpack_2x1<s24_3_t>
+};
+
+#undef AVX2
+
+#endif /* GRI_ALSA_HAVE_AVX2 */
+
+// ----------------------------------------------------------------
+// NEON (aarch64): 4 frames per iteration (8 for mono S16)
+
+#if defined(GRI_ALSA_HAVE_NEON)
+
+static inline int32x4_t
+neon_cvt_s16(float32x4_t x)
+{
+  x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+  return vcvtnq_s32_f32(vmulq_n_f32(x, s16_scale));
+}
+
+static inline int32x4_t
+neon_cvt_s32(float32x4_t x)
+{
+  // vcvtnq saturates, so no need to clamp against s32_max
+  return vcvtnq_s32_f32(vmulq_n_f32(x, s32_scale));
+}
+
+static void
+neon_float_to_s16(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  int16_t *buf = (int16_t *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8) {
+      int16x4_t a = vqmovn_s32(neon_cvt_s16(vld1q_f32(in[0] + i)));
+      int16x4_t b = vqmovn_s32(neon_cvt_s16(vld1q_f32(in[0] + i + 4)));
+      vst1q_s16(buf + i, vcombine_s16(a, b));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      int16x4x2_t v;
+      v.val[0] = vqmovn_s32(neon_cvt_s16(vld1q_f32(in[0] + i)));
+      v.val[1] = vqmovn_s32(neon_cvt_s16(vld1q_f32(in[1] + i)));
+      vst2_s16(buf + 2 * i, v);
+    }
+  }
+  pack_from<int16_t>(dst, in, nchan, i, nframes);
+}
+
+static void
+neon_float_to_s16_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  int16_t *buf = (int16_t *) dst;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    int16x4x2_t v;
+    v.val[0] = v.val[1] = vqmovn_s32(neon_cvt_s16(vld1q_f32(in[0] + i)));
+    vst2_s16(buf + 2 * i, v);
+  }
+  pack_1x2_from<int16_t>(dst, in, i, nframes);
+}
+
+static void
+neon_float_to_s32(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  int32_t *buf = (int32_t *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 4 <= nframes; i += 4)
+      vst1q_s32(buf + i, neon_cvt_s32(vld1q_f32(in[0] + i)));
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      int32x4x2_t v;
+      v.val[0] = neon_cvt_s32(vld1q_f32(in[0] + i));
+      v.val[1] = neon_cvt_s32(vld1q_f32(in[1] + i));
+      vst2q_s32(buf + 2 * i, v);
+    }
+  }
+  pack_from<int32_t>(dst, in, nchan, i, nframes);
+}
+
+static void
+neon_float_to_s32_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  int32_t *buf = (int32_t *) dst;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    int32x4x2_t v;
+    v.val[0] = v.val[1] = neon_cvt_s32(vld1q_f32(in[0] + i));
+    vst2q_s32(buf + 2 * i, v);
+  }
+  pack_1x2_from<int32_t>(dst, in, i, nframes);
+}
+
+static void
+neon_s16_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const int16_t *buf = (const int16_t *) src;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 8 <= nframes; i += 8) {
+      int16x8_t v = vld1q_s16(buf + i);
+      int32x4_t lo = vmovl_s16(vget_low_s16(v));
+      int32x4_t hi = vmovl_s16(vget_high_s16(v));
+      vst1q_f32(out[0] + i, vmulq_n_f32(vcvtq_f32_s32(lo), s16_unscale));
+      vst1q_f32(out[0] + i + 4, vmulq_n_f32(vcvtq_f32_s32(hi), s16_unscale));
+    }
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      int16x4x2_t v = vld2_s16(buf + 2 * i);
+      vst1q_f32(out[0] + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[0])), s16_unscale));
+      vst1q_f32(out[1] + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[1])), s16_unscale));
+    }
+  }
+  unpack_from<int16_t>(out, src, nchan, i, nframes);
+}
+
+static void
+neon_s16_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const int16_t *buf = (const int16_t *) src;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    int16x4x2_t v = vld2_s16(buf + 2 * i);
+    int32x4_t t = vaddl_s16(v.val[0], v.val[1]);
+    vst1q_f32(out[0] + i, vmulq_n_f32(vcvtq_f32_s32(t), s16_unscale * 0.5f));
+  }
+  unpack_2x1_from<int16_t>(out, src, i, nframes);
+}
+
+static void
+neon_s32_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const int32_t *buf = (const int32_t *) src;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    for(; i + 4 <= nframes; i += 4)
+      vst1q_f32(out[0] + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(buf + i)), s32_unscale));
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      int32x4x2_t v = vld2q_s32(buf + 2 * i);
+      vst1q_f32(out[0] + i, vmulq_n_f32(vcvtq_f32_s32(v.val[0]), s32_unscale));
+      vst1q_f32(out[1] + i, vmulq_n_f32(vcvtq_f32_s32(v.val[1]), s32_unscale));
+    }
+  }
+  unpack_from<int32_t>(out, src, nchan, i, nframes);
+}
+
+static void
+neon_s32_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const int32_t *buf = (const int32_t *) src;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    int32x4x2_t v = vld2q_s32(buf + 2 * i);
+    // average in float; the int32 sum could overflow
+    float32x4_t l = vmulq_n_f32(vcvtq_f32_s32(v.val[0]), s32_unscale);
+    float32x4_t r = vmulq_n_f32(vcvtq_f32_s32(v.val[1]), s32_unscale);
+    vst1q_f32(out[0] + i, vmulq_n_f32(vaddq_f32(l, r), 0.5f));
+  }
+  unpack_2x1_from<int32_t>(out, src, i, nframes);
+}
+
+static void
+neon_float_to_f32(void *dst, const float **in,
+                  unsigned int nchan, unsigned int nframes)
+{
+  float *buf = (float *) dst;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    memcpy(dst, in[0], nframes * sizeof(float));
+    return;
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      float32x4x2_t v;
+      v.val[0] = vld1q_f32(in[0] + i);
+      v.val[1] = vld1q_f32(in[1] + i);
+      vst2q_f32(buf + 2 * i, v);
+    }
+  }
+  pack_from<float>(dst, in, nchan, i, nframes);
+}
+
+static void
+neon_float_to_f32_1x2(void *dst, const float **in,
+                      unsigned int nchan, unsigned int nframes)
+{
+  float *buf = (float *) dst;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    float32x4x2_t v;
+    v.val[0] = v.val[1] = vld1q_f32(in[0] + i);
+    vst2q_f32(buf + 2 * i, v);
+  }
+  pack_1x2_from<float>(dst, in, i, nframes);
+}
+
+static void
+neon_f32_to_float(float **out, const void *src,
+                  unsigned int nchan, unsigned int nframes)
+{
+  const float *buf = (const float *) src;
+  unsigned int i = 0;
+
+  if(nchan == 1) {
+    memcpy(out[0], src, nframes * sizeof(float));
+    return;
+  }
+  else if(nchan == 2) {
+    for(; i + 4 <= nframes; i += 4) {
+      float32x4x2_t v = vld2q_f32(buf + 2 * i);
+      vst1q_f32(out[0] + i, v.val[0]);
+      vst1q_f32(out[1] + i, v.val[1]);
+    }
+  }
+  unpack_from<float>(out, src, nchan, i, nframes);
+}
+
+static void
+neon_f32_to_float_2x1(float **out, const void *src,
+                      unsigned int nchan, unsigned int nframes)
+{
+  const float *buf = (const float *) src;
+  unsigned int i = 0;
+
+  for(; i + 4 <= nframes; i += 4) {
+    float32x4x2_t v = vld2q_f32(buf + 2 * i);
+    vst1q_f32(out[0] + i, vmulq_n_f32(vaddq_f32(v.val[0], v.val[1]), 0.5f));
+  }
+  unpack_2x1_from<float>(out, src, i, nframes);
+}
+
+static const gri_alsa_convert neon_convert = {
+  "neon",
+  neon_float_to_s16,
+  neon_float_to_s16_1x2,
+  neon_float_to_s32,
+  neon_float_to_s32_1x2,
+  neon_float_to_f32,
+  neon_float_to_f32_1x2,
+  generic_pack<s24_3_t>,
+  generic_pack_1x2<s24_3_t>,
+  neon_s16_to_float,
+  neon_s16_to_float_2x1,
+  neon_s32_to_float,
+  neon_s32_to_float_2x1,
+  neon_f32_to_float,
+  neon_f32_to_float_2x1,
+  generic_unpack<s24_3_t>,
+  generic_unpack_2x1<s24_3_t>
+};
+
+#endif /* GRI_ALSA_HAVE_NEON */
+
+// ----------------------------------------------------------------
+
+const gri_alsa_convert *
+gri_alsa_convert_by_name (const char *name)
+{
+  if(strcmp(name, generic_convert.name) == 0)
+    return &generic_convert;
+
+#if defined(__SSE2__)
+  if(strcmp(name, sse2_convert.name) == 0)
+    return &sse2_convert;
+#endif
+
+#if defined(GRI_ALSA_HAVE_AVX2)
+  if(strcmp(name, avx2_convert.name) == 0) {
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+      return &avx2_convert;
+  }
+#endif
+
+#if defined(GRI_ALSA_HAVE_NEON)
+  if(strcmp(name, neon_convert.name) == 0)
+    return &neon_convert;
+#endif
+
+  return 0;
+}
+
+static const gri_alsa_convert *
+pick_best ()
+{
+  // in our preferred order...
+  static const char *names[] = { "avx2", "sse2", "neon" };
+
+  for(unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    const gri_alsa_convert *c = gri_alsa_convert_by_name(names[i]);
+    if(c)
+      return c;
+  }
+  return &generic_convert;
+}
+
+const gri_alsa_convert *
+gri_alsa_convert_best ()
+{
+  static const gri_alsa_convert *best = pick_best();
+  return best;
+}
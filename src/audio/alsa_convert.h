@@ -0,0 +1,79 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ALSA_CONVERT_H
+#define INCLUDED_ALSA_CONVERT_H
+
+/*
+ * Sample format conversion between the per-channel float streams used
+ * by the flowgraph and the interleaved integer frames used by ALSA.
+ *
+ * float -> integer conversions clip to [-1, 1] and round to nearest.
+ * integer -> float conversions scale full scale to [-1, 1).
+ * f32 is native endian float and is copied through untouched; s24_3 is
+ * packed 3 byte little endian (SND_PCM_FORMAT_S24_3LE).
+ * The 1x2 variants duplicate one float stream into both channels of a
+ * stereo frame; the 2x1 variants average a stereo frame into one stream.
+ */
+
+// playback: nchan float streams -> interleaved frames at dst
+typedef void (*gri_alsa_pack_t)(void *dst, const float **in,
+                                unsigned int nchan, unsigned int nframes);
+
+// capture: interleaved frames at src -> nchan float streams
+typedef void (*gri_alsa_unpack_t)(float **out, const void *src,
+                                  unsigned int nchan, unsigned int nframes);
+
+struct gri_alsa_convert {
+  const char        *name;		// instruction set, e.g. "sse2"
+  gri_alsa_pack_t    float_to_s16;
+  gri_alsa_pack_t    float_to_s16_1x2;
+  gri_alsa_pack_t    float_to_s32;
+  gri_alsa_pack_t    float_to_s32_1x2;
+  gri_alsa_pack_t    float_to_f32;
+  gri_alsa_pack_t    float_to_f32_1x2;
+  gri_alsa_pack_t    float_to_s24_3;
+  gri_alsa_pack_t    float_to_s24_3_1x2;
+  gri_alsa_unpack_t  s16_to_float;
+  gri_alsa_unpack_t  s16_to_float_2x1;
+  gri_alsa_unpack_t  s32_to_float;
+  gri_alsa_unpack_t  s32_to_float_2x1;
+  gri_alsa_unpack_t  f32_to_float;
+  gri_alsa_unpack_t  f32_to_float_2x1;
+  gri_alsa_unpack_t  s24_3_to_float;
+  gri_alsa_unpack_t  s24_3_to_float_2x1;
+};
+
+/*
+ * Return the fastest kernel set the running CPU supports.
+ * The choice is made once, on the first call.
+ */
+const gri_alsa_convert *
+gri_alsa_convert_best ();
+
+/*
+ * Return the kernel set for the named instruction set ("generic",
+ * "sse2", "avx2" or "neon"), or 0 if it isn't built in or the running
+ * CPU doesn't support it.
+ */
+const gri_alsa_convert *
+gri_alsa_convert_by_name (const char *name);
+
+#endif /* INCLUDED_ALSA_CONVERT_H */
@@ -0,0 +1,332 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Microbenchmark for the ALSA sample format conversion kernels.
+ *
+ * Times every kernel set the CPU supports on period sized buffers, and
+ * checks that they produce the same samples as the generic (scalar) one.
+ * The baseline is the per-sample loops the ALSA blocks' work_* functions
+ * ran before the kernels; it only had S16 and S32, so the other formats
+ * are compared against generic.
+ *
+ * usage: alsa_convert_bench [period_frames ...]
+ */
+
+#include "audio/alsa_convert.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// about one second of calls per kernel at typical period sizes
+static const unsigned int target_frames = 50000000;
+
+struct buffers {
+  std::vector<float>   in[2];
+  std::vector<float>   out[2];
+  std::vector<int32_t> frames;		// big enough for stereo S32
+  const float         *in_ptr[2];
+  float               *out_ptr[2];
+
+  buffers(unsigned int nframes, float peak = 1.1f)
+  {
+    for(int chan = 0; chan < 2; chan++) {
+      in[chan].resize(nframes);
+      out[chan].resize(nframes);
+      // by default a little over full scale so the clipping path is exercised
+      for(unsigned int i = 0; i < nframes; i++)
+        in[chan][i] = peak * (2.0f * rand() / RAND_MAX - 1.0f);
+      in_ptr[chan] = &in[chan][0];
+      out_ptr[chan] = &out[chan][0];
+    }
+    frames.resize(2 * nframes);
+  }
+};
+
+struct kernel {
+  const char   *name;
+  unsigned int  nchan;		// flowgraph side channel count
+  unsigned int  hw_nchan;	// ALSA side channel count
+  size_t        sizeof_sample;
+  bool          pack;
+  size_t        offset;		// of the kernel in gri_alsa_convert
+};
+
+#define PACK(f, n, hw, s) { #f, n, hw, sizeof(s), true, offsetof(gri_alsa_convert, f) }
+#define UNPACK(f, n, hw, s) { #f, n, hw, sizeof(s), false, offsetof(gri_alsa_convert, f) }
+
+static const kernel kernels[] = {
+  PACK(float_to_s16, 1, 1, int16_t),
+  PACK(float_to_s16, 2, 2, int16_t),
+  PACK(float_to_s16_1x2, 1, 2, int16_t),
+  PACK(float_to_s32, 1, 1, int32_t),
+  PACK(float_to_s32, 2, 2, int32_t),
+  PACK(float_to_s32_1x2, 1, 2, int32_t),
+  PACK(float_to_f32, 1, 1, float),
+  PACK(float_to_f32, 2, 2, float),
+  PACK(float_to_f32_1x2, 1, 2, float),
+  PACK(float_to_s24_3, 1, 1, uint8_t[3]),
+  PACK(float_to_s24_3, 2, 2, uint8_t[3]),
+  PACK(float_to_s24_3_1x2, 1, 2, uint8_t[3]),
+  UNPACK(s16_to_float, 1, 1, int16_t),
+  UNPACK(s16_to_float, 2, 2, int16_t),
+  UNPACK(s16_to_float_2x1, 1, 2, int16_t),
+  UNPACK(s32_to_float, 1, 1, int32_t),
+  UNPACK(s32_to_float, 2, 2, int32_t),
+  UNPACK(s32_to_float_2x1, 1, 2, int32_t),
+  UNPACK(f32_to_float, 1, 1, float),
+  UNPACK(f32_to_float, 2, 2, float),
+  UNPACK(f32_to_float_2x1, 1, 2, float),
+  UNPACK(s24_3_to_float, 1, 1, uint8_t[3]),
+  UNPACK(s24_3_to_float, 2, 2, uint8_t[3]),
+  UNPACK(s24_3_to_float_2x1, 1, 2, uint8_t[3]),
+};
+
+#define NELEMS(x) (sizeof(x)/sizeof(x[0]))
+
+/*
+ * The loops from alsa_sink::work_s16/work_s32/work_*_1x2 and
+ * alsa_source::work_s16/work_s32/work_*_2x1 before the kernels replaced
+ * them.  They don't clip, so they're timed on samples within full scale.
+ */
+template <typename sample_t>
+static void
+old_pack(void *dst, const float **in, unsigned int nchan, unsigned int nframes)
+{
+  static const float scale_factor = std::pow(2.0f, 8*sizeof(sample_t)-1) - 1;
+  sample_t *buf = (sample_t *)dst;
+  int bi = 0;
+
+  for(unsigned int i = 0; i < nframes; i++) {
+    for(unsigned int chan = 0; chan < nchan; chan++) {
+      buf[bi++] = (sample_t)(in[chan][i] * scale_factor);
+    }
+  }
+}
+
+template <typename sample_t>
+static void
+old_pack_1x2(void *dst, const float **in, unsigned int nchan, unsigned int nframes)
+{
+  static const float scale_factor = std::pow(2.0f, 8*sizeof(sample_t)-1) - 1;
+  sample_t *buf = (sample_t *)dst;
+  int bi = 0;
+
+  for(unsigned int i = 0; i < nframes; i++) {
+    sample_t t = (sample_t)(in[0][i] * scale_factor);
+    buf[bi++] = t;
+    buf[bi++] = t;
+  }
+}
+
+template <typename sample_t>
+static void
+old_unpack(float **out, const void *src, unsigned int nchan, unsigned int nframes)
+{
+  static const float scale_factor = 1.0 / std::pow(2.0f, 8*sizeof(sample_t)-1);
+  const sample_t *buf = (const sample_t *)src;
+  int bi = 0;
+
+  for(unsigned int i = 0; i < nframes; i++) {
+    for(unsigned int chan = 0; chan < nchan; chan++) {
+      out[chan][i] = (float) buf[bi++] * scale_factor;
+    }
+  }
+}
+
+// the original summed S32 pairs in an int; sum_t keeps that from overflowing
+template <typename sample_t, typename sum_t>
+static void
+old_unpack_2x1(float **out, const void *src, unsigned int nchan, unsigned int nframes)
+{
+  static const float scale_factor = 1.0 / std::pow(2.0f, 8*sizeof(sample_t)-1);
+  const sample_t *buf = (const sample_t *)src;
+  int bi = 0;
+
+  for(unsigned int i = 0; i < nframes; i++) {
+    sum_t t = ((sum_t)buf[bi] + buf[bi+1]) / 2;
+    bi += 2;
+    out[0][i] = (float) t * scale_factor;
+  }
+}
+
+static gri_alsa_convert
+make_baseline()
+{
+  gri_alsa_convert c;
+  memset(&c, 0, sizeof(c));
+  c.name = "baseline";
+  c.float_to_s16 = old_pack<int16_t>;
+  c.float_to_s16_1x2 = old_pack_1x2<int16_t>;
+  c.float_to_s32 = old_pack<int32_t>;
+  c.float_to_s32_1x2 = old_pack_1x2<int32_t>;
+  c.s16_to_float = old_unpack<int16_t>;
+  c.s16_to_float_2x1 = old_unpack_2x1<int16_t, int>;
+  c.s32_to_float = old_unpack<int32_t>;
+  c.s32_to_float_2x1 = old_unpack_2x1<int32_t, int64_t>;
+  return c;
+}
+
+// true if c has the kernel; the baseline lacks the F32 and S24_3 ones
+static bool
+has_kernel(const gri_alsa_convert *c, const struct kernel &k)
+{
+  const char *base = (const char *) c;
+  return *(const gri_alsa_pack_t *) (base + k.offset) != 0;
+}
+
+static void
+run_once(const gri_alsa_convert *c, const kernel &k, buffers &b, unsigned int nframes)
+{
+  const char *base = (const char *) c;
+  if(k.pack) {
+    gri_alsa_pack_t f = *(const gri_alsa_pack_t *) (base + k.offset);
+    f(&b.frames[0], b.in_ptr, k.nchan, nframes);
+  }
+  else {
+    gri_alsa_unpack_t f = *(const gri_alsa_unpack_t *) (base + k.offset);
+    f(b.out_ptr, &b.frames[0], k.nchan, nframes);
+  }
+}
+
+// returns nanoseconds per frame
+static double
+time_kernel(const gri_alsa_convert *c, const kernel &k, buffers &b, unsigned int nframes)
+{
+  unsigned int iterations = std::max(1U, target_frames / nframes);
+
+  run_once(c, k, b, nframes);	// warm up
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(unsigned int i = 0; i < iterations; i++)
+    run_once(c, k, b, nframes);
+  std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  return elapsed.count() / ((double) iterations * nframes);
+}
+
+// compare against the generic output; returns the number of mismatches
+static unsigned int
+check_kernel(const gri_alsa_convert *c, const kernel &k, unsigned int nframes)
+{
+  const gri_alsa_convert *ref = gri_alsa_convert_by_name("generic");
+  buffers a(nframes);
+  buffers b(nframes);
+
+  for(int chan = 0; chan < 2; chan++)
+    b.in[chan] = a.in[chan];
+  // feed the unpack kernels from the generic pack output
+  if(!k.pack) {
+    ref->float_to_s32(&a.frames[0], a.in_ptr, 2, nframes);
+    b.frames = a.frames;
+  }
+
+  run_once(ref, k, a, nframes);
+  run_once(c, k, b, nframes);
+
+  unsigned int nerrors = 0;
+  if(k.pack) {
+    size_t nbytes = nframes * k.hw_nchan * k.sizeof_sample;
+    nerrors = memcmp(&a.frames[0], &b.frames[0], nbytes) != 0;
+  }
+  else {
+    for(unsigned int chan = 0; chan < k.nchan; chan++) {
+      for(unsigned int i = 0; i < nframes; i++) {
+        if(std::fabs(a.out[chan][i] - b.out[chan][i]) > 1e-6f)
+          nerrors++;
+      }
+    }
+  }
+  return nerrors;
+}
+
+int
+main(int argc, char **argv)
+{
+  // 10 ms at 48 kHz, and a typical power of two
+  std::vector<unsigned int> periods;
+  for(int i = 1; i < argc; i++)
+    periods.push_back(atoi(argv[i]));
+  if(periods.empty()) {
+    periods.push_back(480);
+    periods.push_back(1024);
+  }
+
+  const char *names[] = { "generic", "sse2", "avx2", "neon" };
+  const gri_alsa_convert *generic = gri_alsa_convert_by_name("generic");
+  const gri_alsa_convert baseline = make_baseline();
+
+  printf("best available: %s\n", gri_alsa_convert_best()->name);
+  int status = 0;
+
+  for(unsigned int p = 0; p < periods.size(); p++) {
+    unsigned int nframes = periods[p];
+    if(nframes == 0)
+      continue;
+    buffers b(nframes);
+    buffers in_range(nframes, 1.0f);
+
+    printf("\nperiod %u frames (ns/frame, speedup vs baseline, * vs generic)\n", nframes);
+    printf("%-18s %-4s %16s", "kernel", "ch", baseline.name);
+    for(unsigned int n = 0; n < NELEMS(names); n++)
+      if(gri_alsa_convert_by_name(names[n]))
+        printf(" %16s", names[n]);
+    printf("\n");
+
+    for(unsigned int k = 0; k < NELEMS(kernels); k++) {
+      std::string ch = std::to_string(kernels[k].nchan) + ":" +
+        std::to_string(kernels[k].hw_nchan);
+      printf("%-18s %-4s", kernels[k].name, ch.c_str());
+      double scalar = time_kernel(generic, kernels[k], b, nframes);
+      double ref = scalar;
+      const char *mark = "*";
+      if(has_kernel(&baseline, kernels[k])) {
+        ref = time_kernel(&baseline, kernels[k], in_range, nframes);
+        mark = "";
+        printf(" %7.3f         ", ref);
+      }
+      else
+        printf(" %16s", "-");
+
+      for(unsigned int n = 0; n < NELEMS(names); n++) {
+        const gri_alsa_convert *c = gri_alsa_convert_by_name(names[n]);
+        if(!c)
+          continue;
+        double t = (c == generic) ? scalar : time_kernel(c, kernels[k], b, nframes);
+        unsigned int nerrors = check_kernel(c, kernels[k], nframes);
+        printf(" %7.3f (%5.2fx)%s%s", t, ref / t, mark, nerrors ? "!" : "");
+        if(nerrors)
+          status = 1;
+      }
+      printf("\n");
+    }
+  }
+
+  if(status)
+    printf("\n! = output differs from the generic kernel\n");
+  return status;
+}
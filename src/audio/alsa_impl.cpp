@@ -76,7 +76,7 @@ static snd_pcm_format_t format_types[] = {
 };
 
 static unsigned int test_rates[] = {
-  8000, 16000, 22050, 32000, 44100, 48000, 96000, 192000
+  8000, 12000, 16000, 22050, 24000, 32000, 44100, 48000, 96000, 192000
 };
 
 #define NELEMS(x) (sizeof(x)/sizeof(x[0]))
@@ -137,6 +137,20 @@ gri_alsa_dump_hw_params (snd_pcm_t *pcm, snd_pcm_hw_params_t *hwparams, FILE *fp
   fflush (fp);
 }
 
+unsigned
+gri_alsa_format_cost (snd_pcm_format_t format)
+{
+  // Rough cost of carrying a sample between the flowgraph and the
+  // device: conversion work, plus a penalty for throwing away bits.
+  switch (format){
+  case SND_PCM_FORMAT_FLOAT:	return 0;	// straight copy
+  case SND_PCM_FORMAT_S32:	return 2;	// SIMD convert
+  case SND_PCM_FORMAT_S24_3LE:	return 3;	// scalar 3 byte pack
+  case SND_PCM_FORMAT_S16:	return 4;	// SIMD convert, only 16 bits
+  default:			return 100;
+  }
+}
+
 bool
 gri_alsa_pick_acceptable_format (snd_pcm_t *pcm,
 				 snd_pcm_hw_params_t *hwparams,
@@ -147,27 +161,75 @@ gri_alsa_pick_acceptable_format (snd_pcm_t *pcm,
 				 bool verbose)
 {
   int err;
+  int best = -1;
 
-  // pick a format that we like...
+  // pick the cheapest format that we like; ties go to the earlier one
   for (unsigned i = 0; i < nacceptable_formats; i++){
     if (snd_pcm_hw_params_test_format (pcm, hwparams,
-				       acceptable_formats[i]) == 0){
-      err = snd_pcm_hw_params_set_format (pcm, hwparams, acceptable_formats[i]);
+				       acceptable_formats[i]) != 0)
+      continue;
+    if (verbose)
+      fprintf (stdout, "%s[%s]: %s is available, cost %u\n",
+	       error_msg_tag, snd_pcm_name (pcm),
+	       snd_pcm_format_name (acceptable_formats[i]),
+	       gri_alsa_format_cost (acceptable_formats[i]));
+    if (best < 0
+	|| gri_alsa_format_cost (acceptable_formats[i])
+	   < gri_alsa_format_cost (acceptable_formats[best]))
+      best = i;
+  }
+
+  if (best < 0){
+    fprintf (stderr, "%s[%s]: failed to find acceptable format",
+	     error_msg_tag, snd_pcm_name (pcm));
+    return false;
+  }
+
+  err = snd_pcm_hw_params_set_format (pcm, hwparams, acceptable_formats[best]);
+  if (err < 0){
+    fprintf (stderr, "%s[%s]: failed to set format: %s\n",
+	     error_msg_tag, snd_pcm_name (pcm), snd_strerror (err));
+    return false;
+  }
+  if (verbose)
+    fprintf (stdout, "%s[%s]: using %s\n",
+	     error_msg_tag, snd_pcm_name (pcm),
+	     snd_pcm_format_name (acceptable_formats[best]));
+  *selected_format = acceptable_formats[best];
+  return true;
+}
+
+bool
+gri_alsa_pick_acceptable_access (snd_pcm_t *pcm,
+				 snd_pcm_hw_params_t *hwparams,
+				 snd_pcm_access_t acceptable_access[],
+				 unsigned nacceptable_access,
+				 snd_pcm_access_t *selected_access,
+				 const char *error_msg_tag,
+				 bool verbose)
+{
+  int err;
+
+  // pick an access method that we like...
+  for (unsigned i = 0; i < nacceptable_access; i++){
+    if (snd_pcm_hw_params_test_access (pcm, hwparams,
+				       acceptable_access[i]) == 0){
+      err = snd_pcm_hw_params_set_access (pcm, hwparams, acceptable_access[i]);
       if (err < 0){
-	fprintf (stderr, "%s[%s]: failed to set format: %s\n",
+	fprintf (stderr, "%s[%s]: failed to set access: %s\n",
 		 error_msg_tag, snd_pcm_name (pcm), snd_strerror (err));
 	return false;
       }
       if (verbose)
-	fprintf (stdout, "%s[%s]: using %s\n",
+	fprintf (stdout, "%s[%s]: using %s access\n",
 		 error_msg_tag, snd_pcm_name (pcm),
-		 snd_pcm_format_name (acceptable_formats[i]));
-      *selected_format = acceptable_formats[i];
+		 snd_pcm_access_name (acceptable_access[i]));
+      *selected_access = acceptable_access[i];
       return true;
     }
   }
 
-  fprintf (stderr, "%s[%s]: failed to find acceptable format",
+  fprintf (stderr, "%s[%s]: failed to find acceptable access method",
 	   error_msg_tag, snd_pcm_name (pcm));
   return false;
 }
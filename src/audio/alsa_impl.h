@@ -29,6 +29,15 @@ gri_alsa_dump_hw_params (snd_pcm_t *pcm,
 			 snd_pcm_hw_params_t *hwparams,
 			 FILE *fp);
 
+/*
+ * Relative cost of using format for the audio blocks; lower is better.
+ */
+unsigned
+gri_alsa_format_cost (snd_pcm_format_t format);
+
+/*
+ * Set the cheapest of acceptable_formats the device supports.
+ */
 bool
 gri_alsa_pick_acceptable_format (snd_pcm_t *pcm,
 				 snd_pcm_hw_params_t *hwparams,
@@ -38,5 +47,14 @@ gri_alsa_pick_acceptable_format (snd_pcm_t *pcm,
 				 const char *error_msg_tag,
 				 bool verbose);
 
+bool
+gri_alsa_pick_acceptable_access (snd_pcm_t *pcm,
+				 snd_pcm_hw_params_t *hwparams,
+				 snd_pcm_access_t acceptable_access[],
+				 unsigned nacceptable_access,
+				 snd_pcm_access_t *selected_access,
+				 const char *error_msg_tag,
+				 bool verbose);
+
 
 #endif /* INCLUDED_GRI_ALSA_H */
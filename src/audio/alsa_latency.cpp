@@ -0,0 +1,285 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "audio/alsa_latency.h"
+#include "audio/alsa_impl.h"
+#include "application/logger.h"
+#include <gnuradio/prefs.h>
+#include <algorithm>
+#include <cctype>
+#include <thread>
+#include <vector>
+
+using gr::prefs;
+
+static const char *latency_section = "audio_alsa_latency";
+
+// candidate period times, longest first
+static const double probe_period_times[] = {
+  0.040, 0.020, 0.010, 0.005, 0.0025, 0.00125
+};
+
+// stand-in for the flowgraph's work, as a fraction of a period
+static const double probe_load = 0.5;
+
+// this many xruns inside the window means we're underbuffered
+static const unsigned int xrun_limit = 3;
+static const std::chrono::seconds xrun_window(10);
+
+static snd_pcm_format_t probe_formats[] = {
+  SND_PCM_FORMAT_FLOAT,
+  SND_PCM_FORMAT_S32,
+  SND_PCM_FORMAT_S24_3LE,
+  SND_PCM_FORMAT_S16
+};
+
+#define NELEMS(x) (sizeof(x)/sizeof(x[0]))
+
+static const char *
+stream_name (snd_pcm_stream_t stream)
+{
+  return stream == SND_PCM_STREAM_PLAYBACK ? "playback" : "capture";
+}
+
+// prefs keys can't hold the ':' ',' '=' found in device names
+static std::string
+latency_key (const std::string &device, snd_pcm_stream_t stream,
+	     const char *option)
+{
+  std::string key;
+  for (char c : device)
+    key += isalnum ((unsigned char) c) ? (char) tolower (c) : '_';
+  return key + "_" + stream_name (stream) + "_" + option;
+}
+
+std::string
+gri_alsa_device_name (const std::string &device, snd_pcm_stream_t stream)
+{
+  if (!device.empty ())
+    return device;
+  if (stream == SND_PCM_STREAM_PLAYBACK)
+    return prefs::singleton ()->get_string ("audio_alsa",
+					    "default_output_device", "default");
+  return prefs::singleton ()->get_string ("audio_alsa",
+					  "default_input_device", "default");
+}
+
+bool
+gri_alsa_load_latency (const std::string &device,
+		       snd_pcm_stream_t stream,
+		       gri_alsa_latency *latency)
+{
+  prefs *p = prefs::singleton ();
+  std::string period_key = latency_key (device, stream, "period_time");
+  std::string nperiods_key = latency_key (device, stream, "nperiods");
+
+  if (!p->has_option (latency_section, period_key)
+      || !p->has_option (latency_section, nperiods_key))
+    return false;
+
+  latency->period_time = std::max (0.001, p->get_double (latency_section, period_key, 0.010));
+  latency->nperiods = std::max (2L, p->get_long (latency_section, nperiods_key, 4));
+  return true;
+}
+
+void
+gri_alsa_save_latency (const std::string &device,
+		       snd_pcm_stream_t stream,
+		       const gri_alsa_latency &latency)
+{
+  prefs *p = prefs::singleton ();
+  p->set_double (latency_section, latency_key (device, stream, "period_time"),
+		 latency.period_time);
+  p->set_long (latency_section, latency_key (device, stream, "nperiods"),
+	       latency.nperiods);
+  p->save ();
+
+  Logger::info ("[gri_alsa_save_latency] " + device + " " + stream_name (stream)
+		+ ": " + std::to_string (latency.nperiods) + " x "
+		+ std::to_string (latency.period_time * 1e3) + " ms");
+}
+
+/*
+ * Open device, stream for seconds and count the xruns.
+ * Returns -1 if the configuration can't be set.
+ */
+static int
+probe_latency (const std::string &device, snd_pcm_stream_t stream,
+	       unsigned int sampling_rate, double period_time,
+	       unsigned int nperiods, double seconds)
+{
+  snd_pcm_t *pcm;
+  snd_pcm_hw_params_t *hwparams;
+  snd_pcm_sw_params_t *swparams;
+  snd_pcm_format_t format;
+  snd_pcm_uframes_t period_size;
+  unsigned int period_time_us = (unsigned int) (period_time * 1e6);
+  unsigned int nchan;
+  int dir = 0;
+
+  if (snd_pcm_open (&pcm, device.c_str (), stream, 0) < 0)
+    return -1;
+
+  snd_pcm_hw_params_alloca (&hwparams);
+  snd_pcm_sw_params_alloca (&swparams);
+
+  if (snd_pcm_hw_params_any (pcm, hwparams) < 0
+      || snd_pcm_hw_params_set_access (pcm, hwparams,
+				       SND_PCM_ACCESS_RW_INTERLEAVED) < 0
+      || !gri_alsa_pick_acceptable_format (pcm, hwparams, probe_formats,
+					   NELEMS (probe_formats), &format,
+					   "gri_alsa_calibrate_latency", false)
+      || snd_pcm_hw_params_get_channels_min (hwparams, &nchan) < 0
+      || snd_pcm_hw_params_set_channels (pcm, hwparams, nchan) < 0
+      || snd_pcm_hw_params_set_rate_near (pcm, hwparams, &sampling_rate, 0) < 0
+      || snd_pcm_hw_params_set_periods (pcm, hwparams, nperiods, 0) < 0
+      || snd_pcm_hw_params_set_period_time_near (pcm, hwparams,
+						 &period_time_us, &dir) < 0
+      || snd_pcm_hw_params (pcm, hwparams) < 0
+      || snd_pcm_hw_params_get_period_size (hwparams, &period_size, &dir) < 0
+      || snd_pcm_sw_params_current (pcm, swparams) < 0
+      || snd_pcm_sw_params_set_start_threshold (pcm, swparams,
+						nperiods * period_size / 2) < 0
+      || snd_pcm_sw_params (pcm, swparams) < 0
+      || snd_pcm_prepare (pcm) < 0){
+    snd_pcm_close (pcm);
+    return -1;
+  }
+
+  // the device may have rounded the period; sleep against what we got
+  std::chrono::microseconds load ((long) (probe_load * 1e6 * period_size
+					  / sampling_rate));
+  std::vector<char> buffer (snd_pcm_frames_to_bytes (pcm, period_size), 0);
+  long long nframes = (long long) (seconds * sampling_rate);
+  int xruns = 0;
+
+  while (nframes > 0){
+    snd_pcm_sframes_t r;
+    if (stream == SND_PCM_STREAM_PLAYBACK)
+      r = snd_pcm_writei (pcm, &buffer[0], period_size);
+    else
+      r = snd_pcm_readi (pcm, &buffer[0], period_size);
+
+    if (r == -EPIPE){
+      xruns++;
+      snd_pcm_prepare (pcm);
+      continue;
+    }
+    else if (r == -EAGAIN)
+      continue;
+    else if (r < 0){
+      xruns = -1;
+      break;
+    }
+
+    nframes -= r;
+    std::this_thread::sleep_for (load);
+  }
+
+  snd_pcm_drop (pcm);
+  snd_pcm_close (pcm);
+  return xruns;
+}
+
+bool
+gri_alsa_calibrate_latency (const std::string &device,
+			    snd_pcm_stream_t stream,
+			    unsigned int sampling_rate,
+			    double seconds,
+			    gri_alsa_latency *latency)
+{
+  unsigned int nperiods =
+    std::max (2L, prefs::singleton ()->get_long ("audio_alsa", "nperiods", 4));
+  bool found = false;
+
+  for (unsigned i = 0; i < NELEMS (probe_period_times); i++){
+    double period_time = probe_period_times[i];
+    int xruns = probe_latency (device, stream, sampling_rate,
+			       period_time, nperiods, seconds);
+    Logger::info ("[gri_alsa_calibrate_latency] " + device + " "
+		  + stream_name (stream) + ": " + std::to_string (nperiods)
+		  + " x " + std::to_string (period_time * 1e3) + " ms, "
+		  + (xruns < 0 ? std::string ("not supported")
+		     : std::to_string (xruns) + " xruns"));
+
+    if (xruns != 0){
+      if (found)
+	break;		// the previous size was the smallest stable one
+      continue;		// still looking for one that works
+    }
+
+    latency->period_time = period_time;
+    latency->nperiods = nperiods;
+    found = true;
+  }
+
+  if (!found)
+    Logger::warn ("[gri_alsa_calibrate_latency] " + device + " "
+		  + stream_name (stream) + ": no stable configuration found");
+  return found;
+}
+
+int
+gri_alsa_set_nperiods (snd_pcm_t *pcm,
+		       snd_pcm_hw_params_t *hwparams,
+		       snd_pcm_access_t access,
+		       snd_pcm_format_t format,
+		       unsigned int sampling_rate,
+		       unsigned int nchan,
+		       snd_pcm_uframes_t period_size,
+		       unsigned int *nperiods)
+{
+  int err;
+
+  snd_pcm_drop (pcm);
+  if ((err = snd_pcm_hw_free (pcm)) < 0
+      || (err = snd_pcm_hw_params_any (pcm, hwparams)) < 0
+      || (err = snd_pcm_hw_params_set_access (pcm, hwparams, access)) < 0
+      || (err = snd_pcm_hw_params_set_format (pcm, hwparams, format)) < 0
+      || (err = snd_pcm_hw_params_set_channels (pcm, hwparams, nchan)) < 0
+      || (err = snd_pcm_hw_params_set_rate (pcm, hwparams, sampling_rate, 0)) < 0
+      || (err = snd_pcm_hw_params_set_period_size (pcm, hwparams, period_size, 0)) < 0
+      || (err = snd_pcm_hw_params_set_periods_near (pcm, hwparams, nperiods, 0)) < 0
+      || (err = snd_pcm_hw_params (pcm, hwparams)) < 0)
+    return err;
+
+  return snd_pcm_prepare (pcm);
+}
+
+bool
+gri_alsa_xrun_watch::note ()
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now ();
+
+  if (d_count == 0 || now - d_start > xrun_window){
+    d_start = now;
+    d_count = 0;
+  }
+
+  if (++d_count < xrun_limit)
+    return false;
+
+  d_count = 0;
+  return true;
+}
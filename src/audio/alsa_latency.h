@@ -0,0 +1,104 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_ALSA_LATENCY_H
+#define INCLUDED_ALSA_LATENCY_H
+
+#include <alsa/asoundlib.h>
+#include <chrono>
+#include <string>
+
+/*
+ * Per device ALSA period sizing.
+ *
+ * The audio blocks start from the audio_alsa period_time and nperiods
+ * prefs.  A calibration run replaces those with the smallest period that
+ * ran without xruns, saved per device and stream in the
+ * [audio_alsa_latency] section of the GNU Radio config.  If xruns start
+ * anyway the blocks add periods at runtime, from a thread of their own,
+ * and save that instead when they stop.
+ */
+
+struct gri_alsa_latency {
+  double	period_time;	// seconds
+  unsigned	nperiods;
+};
+
+/*
+ * Resolve an empty device name the same way the audio blocks do.
+ */
+std::string
+gri_alsa_device_name (const std::string &device, snd_pcm_stream_t stream);
+
+/*
+ * Fetch the saved configuration for device; false if there isn't one.
+ */
+bool
+gri_alsa_load_latency (const std::string &device,
+		       snd_pcm_stream_t stream,
+		       gri_alsa_latency *latency);
+
+void
+gri_alsa_save_latency (const std::string &device,
+		       snd_pcm_stream_t stream,
+		       const gri_alsa_latency &latency);
+
+/*
+ * Run device at shrinking period sizes for seconds each, and return the
+ * smallest one without xruns.  Each period is followed by a sleep of
+ * half a period to stand in for the flowgraph's own work.
+ */
+bool
+gri_alsa_calibrate_latency (const std::string &device,
+			    snd_pcm_stream_t stream,
+			    unsigned int sampling_rate,
+			    double seconds,
+			    gri_alsa_latency *latency);
+
+/*
+ * Re-apply the h/w params of an open pcm with a new number of periods,
+ * keeping the period size (and so the block's output_multiple).
+ * The pcm is left prepared.  nperiods is updated to what was set.
+ */
+int
+gri_alsa_set_nperiods (snd_pcm_t *pcm,
+		       snd_pcm_hw_params_t *hwparams,
+		       snd_pcm_access_t access,
+		       snd_pcm_format_t format,
+		       unsigned int sampling_rate,
+		       unsigned int nchan,
+		       snd_pcm_uframes_t period_size,
+		       unsigned int *nperiods);
+
+/*
+ * Decides when xruns are frequent enough to need more buffering.
+ */
+class gri_alsa_xrun_watch {
+  std::chrono::steady_clock::time_point	d_start;
+  unsigned int				d_count;
+
+public:
+  gri_alsa_xrun_watch () : d_count(0) {}
+
+  // count an xrun; true if it's time to back off
+  bool note ();
+};
+
+#endif /* INCLUDED_ALSA_LATENCY_H */
@@ -24,6 +24,7 @@
 
 #include "audio/alsa_sink.h"
 #include "audio/alsa_impl.h"
+#include "audio/alsa_latency.h"
 #include "application/logger.h"
 #include <boost/thread.hpp>
 #include <gnuradio/io_signature.h>
@@ -41,11 +42,19 @@ namespace gr {
     static bool CHATTY_DEBUG = true;
 
     static snd_pcm_format_t acceptable_formats[] = {
-      // these are in our preferred order...
+      // picked by gri_alsa_format_cost, not by order
+      SND_PCM_FORMAT_FLOAT,
       SND_PCM_FORMAT_S32,
+      SND_PCM_FORMAT_S24_3LE,
       SND_PCM_FORMAT_S16
     };
 
+    static snd_pcm_access_t acceptable_access[] = {
+      // these are in our preferred order...
+      SND_PCM_ACCESS_MMAP_INTERLEAVED,
+      SND_PCM_ACCESS_RW_INTERLEAVED
+    };
+
 #define NELEMS(x) (sizeof(x)/sizeof(x[0]))
 
     static std::string
@@ -68,6 +77,12 @@ namespace gr {
                       prefs::singleton()->get_long("audio_alsa", "nperiods", 4));
     }
 
+    static bool
+    default_mmap()
+    {
+      return prefs::singleton()->get_bool("audio_alsa", "mmap", true);
+    }
+
     // ----------------------------------------------------------------
 
     alsa_sink::alsa_sink(int sampling_rate,
@@ -83,13 +98,22 @@ namespace gr {
         d_sw_params((snd_pcm_sw_params_t*)(new char[snd_pcm_sw_params_sizeof()])),
         d_nperiods(default_nperiods()),
         d_period_time_us((unsigned int)(default_period_time() * 1e6)),
-        d_period_size(0),
+        d_period_size(0), d_start_threshold(0), d_sizeof_frame(0),
         d_buffer_size_bytes(0), d_buffer(0),
-        d_worker(0), d_special_case_mono_to_stereo(false),
-        d_nunderuns(0), d_nsuspends(0), d_ok_to_block(ok_to_block)
+        d_converter(0), d_mmap(false), d_special_case_mono_to_stereo(false),
+        d_fill(0), d_backoff_wanted(false), d_stopping(false),
+        d_saved_nperiods(0), d_nunderuns(0), d_nsuspends(0), d_ok_to_block(ok_to_block)
     {
       CHATTY_DEBUG = prefs::singleton()->get_bool("audio_alsa", "verbose", false);
 
+      // a calibrated or backed off configuration for this device wins
+      gri_alsa_latency tuned;
+      if(gri_alsa_load_latency(d_device_name, SND_PCM_STREAM_PLAYBACK, &tuned)) {
+        d_nperiods = tuned.nperiods;
+        d_period_time_us = (unsigned int)(tuned.period_time * 1e6);
+        Logger::info("[alsa_sink::alsa_sink] "+d_device_name+": using tuned latency "+std::to_string(d_nperiods)+" x "+std::to_string(d_period_time_us)+" us");
+      }
+
       int error=-1;
       int dir;
 
@@ -136,17 +160,21 @@ namespace gr {
       // fill in portions of the d_hw_params that we know now...
 
       // Specify the access methods we implement
-      // For now, we only handle RW_INTERLEAVED...
-      snd_pcm_access_mask_t *access_mask;
-      snd_pcm_access_mask_t **access_mask_ptr = &access_mask; // FIXME: workaround for compiler warning
-      snd_pcm_access_mask_alloca(access_mask_ptr);
-      snd_pcm_access_mask_none(access_mask);
-      snd_pcm_access_mask_set(access_mask, SND_PCM_ACCESS_RW_INTERLEAVED);
-      // snd_pcm_access_mask_set(access_mask, SND_PCM_ACCESS_RW_NONINTERLEAVED);
-
-      if((error = snd_pcm_hw_params_set_access_mask(d_pcm_handle,
-                                                    d_hw_params, access_mask)) < 0)
-        bail("failed to set access mask", error);
+      // MMAP_INTERLEAVED converts straight into the driver's ring buffer;
+      // RW_INTERLEAVED is the fallback for devices that can't mmap.
+      unsigned int naccess = NELEMS(acceptable_access);
+      snd_pcm_access_t *access = acceptable_access;
+      if(!default_mmap()) {
+        access = &acceptable_access[1];
+        naccess--;
+      }
+      if(!gri_alsa_pick_acceptable_access(d_pcm_handle, d_hw_params,
+                                          access, naccess,
+                                          &d_access,
+                                          "audio_alsa_sink",
+                                          CHATTY_DEBUG))
+        throw std::runtime_error("audio_alsa_sink");
+      d_mmap = (d_access == SND_PCM_ACCESS_MMAP_INTERLEAVED);
 
       // set sample format
       if(!gri_alsa_pick_acceptable_format(d_pcm_handle, d_hw_params,
@@ -201,6 +229,7 @@ namespace gr {
       if(error < 0)
         bail("get_period_size failed", error);
 
+      d_saved_nperiods = d_nperiods;
       set_output_multiple(d_period_size);
     }
 
@@ -240,29 +269,23 @@ namespace gr {
         return false;
       }
 
-      // get current s/w params
-      err = snd_pcm_sw_params_current(d_pcm_handle, d_sw_params);
-      if(err < 0)
-        bail("snd_pcm_sw_params_current", err);
-
-      // Tell the PCM device to wait to start until we've filled
-      // it's buffers half way full. This helps avoid audio underruns.
-
-      err = snd_pcm_sw_params_set_start_threshold(d_pcm_handle,
-                                                  d_sw_params,
-                                                  d_nperiods * d_period_size / 2);
+      err = set_start_threshold();
       if(err < 0)
-        bail("snd_pcm_sw_params_set_start_threshold", err);
+        bail("failed to set s/w params", err);
 
-      // store the s/w params
-      err = snd_pcm_sw_params(d_pcm_handle, d_sw_params);
-      if(err < 0)
-        bail("snd_pcm_sw_params", err);
+      d_sizeof_frame = nchan * snd_pcm_format_size(d_format, 1);
+      d_buffer_size_bytes = d_period_size * d_sizeof_frame;
 
-      d_buffer_size_bytes =
-        d_period_size * nchan * snd_pcm_format_size(d_format, 1);
+      // the bounce buffer is only needed when the ring can't be mapped
+      delete [] d_buffer;
+      d_buffer = 0;
+      if(!d_mmap)
+        d_buffer = new char[d_buffer_size_bytes];
 
-      d_buffer = new char[d_buffer_size_bytes];
+      {
+        std::string pcm_name(snd_pcm_name(d_pcm_handle));
+        Logger::info("[alsa_sink::check_topology] "+pcm_name+": "+snd_pcm_access_name(d_access)+" access, "+snd_pcm_format_name(d_format)+", "+gri_alsa_convert_best()->name+" conversion");
+      }
 
       if(CHATTY_DEBUG) {
         std::string pcm_name(snd_pcm_name(d_pcm_handle));
@@ -273,16 +296,30 @@ namespace gr {
       switch(d_format) {
       case SND_PCM_FORMAT_S16:
         if(special_case)
-          d_worker = &alsa_sink::work_s16_1x2;
+          d_converter = gri_alsa_convert_best()->float_to_s16_1x2;
         else
-          d_worker = &alsa_sink::work_s16;
+          d_converter = gri_alsa_convert_best()->float_to_s16;
         break;
 
       case SND_PCM_FORMAT_S32:
         if(special_case)
-          d_worker = &alsa_sink::work_s32_1x2;
+          d_converter = gri_alsa_convert_best()->float_to_s32_1x2;
+        else
+          d_converter = gri_alsa_convert_best()->float_to_s32;
+        break;
+
+      case SND_PCM_FORMAT_FLOAT:
+        if(special_case)
+          d_converter = gri_alsa_convert_best()->float_to_f32_1x2;
+        else
+          d_converter = gri_alsa_convert_best()->float_to_f32;
+        break;
+
+      case SND_PCM_FORMAT_S24_3LE:
+        if(special_case)
+          d_converter = gri_alsa_convert_best()->float_to_s24_3_1x2;
         else
-          d_worker = &alsa_sink::work_s32;
+          d_converter = gri_alsa_convert_best()->float_to_s24_3;
         break;
 
       default:
@@ -293,6 +330,8 @@ namespace gr {
 
     alsa_sink::~alsa_sink()
     {
+      stop();
+
       if(snd_pcm_state(d_pcm_handle) == SND_PCM_STATE_RUNNING)
         snd_pcm_drop(d_pcm_handle);
 
@@ -309,170 +348,153 @@ namespace gr {
     {
       assert((noutput_items % d_period_size) == 0);
 
-      // this is a call through a pointer to a method...
-      return (this->*d_worker)(noutput_items, input_items, output_items);
-    }
-
-    /*
-     * Work function that deals with float to S16 conversion
-     */
-    int
-    alsa_sink::work_s16(int noutput_items,
-                        gr_vector_const_void_star &input_items,
-                        gr_vector_void_star &output_items)
-    {
-      typedef int16_t sample_t;  // the type of samples we're creating
-      static const float scale_factor = std::pow(2.0f, 16-1) - 1;
-
       unsigned int nchan = input_items.size();
       const float **in = (const float **)&input_items[0];
-      sample_t *buf = (sample_t *)d_buffer;
-      int bi;
       int n;
 
-      unsigned int sizeof_frame = nchan * sizeof(sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
+      // backoff() reconfigures the device between calls, never during one
+      std::lock_guard<std::mutex> lock(d_pcm_mutex);
 
       for(n = 0; n < noutput_items; n += d_period_size) {
-        // process one period of data
-        bi = 0;
-        for(unsigned int i = 0; i < d_period_size; i++) {
-          for (unsigned int chan = 0; chan < nchan; chan++) {
-            buf[bi++] = (sample_t) (in[chan][i] * scale_factor);
-          }
+        if(d_mmap) {
+          // convert in place; write_mmap advances the src pointers
+          if(!write_mmap(in, nchan, d_period_size))
+            return -1; // No fixing this problem.  Say we're done.
+          continue;
         }
 
+        // process one period of data
+        d_converter(d_buffer, in, nchan, d_period_size);
+
         // update src pointers
         for(unsigned int chan = 0; chan < nchan; chan++)
           in[chan] += d_period_size;
 
-        if(!write_buffer (buf, d_period_size, sizeof_frame))
+        if(!write_buffer(d_buffer, d_period_size, d_sizeof_frame))
           return -1; // No fixing this problem.  Say we're done.
       }
 
+      update_fill();
       return n;
     }
 
     /*
-     * Work function that deals with float to S32 conversion
+     * Convert nframes straight into the driver's mmap'd ring buffer.
+     * Advances the src pointers by nframes, whether written or dropped.
      */
-    int
-    alsa_sink::work_s32(int noutput_items,
-                        gr_vector_const_void_star &input_items,
-                        gr_vector_void_star &output_items)
+    bool
+    alsa_sink::write_mmap(const float **in, unsigned int nchan, unsigned nframes)
     {
-      typedef int32_t sample_t; // the type of samples we're creating
-      static const float scale_factor = std::pow(2.0f, 32-1) - 1;
-
-      unsigned int nchan = input_items.size();
-      const float **in = (const float **)&input_items[0];
-      sample_t *buf = (sample_t *)d_buffer;
-      int bi;
-      int n;
-
-      unsigned int sizeof_frame = nchan * sizeof (sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
+      while(nframes > 0) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(d_pcm_handle);
+        if(avail < 0) {
+          if(!recover(avail))
+            return false;
+          continue;  // try again
+        }
 
-      for(n = 0; n < noutput_items; n += d_period_size) {
-        // process one period of data
-        bi = 0;
-        for(unsigned int i = 0; i < d_period_size; i++) {
-          for(unsigned int chan = 0; chan < nchan; chan++) {
-            buf[bi++] = (sample_t)(in[chan][i] * scale_factor);
+        if((snd_pcm_uframes_t)avail < std::min((snd_pcm_uframes_t)nframes, d_period_size)) {
+          // not enough room in the ring yet
+          if(snd_pcm_state(d_pcm_handle) == SND_PCM_STATE_PREPARED) {
+            // the ring is full before the start threshold; kick it off
+            int r = snd_pcm_start(d_pcm_handle);
+            if(r < 0 && !recover(r))
+              return false;
+            continue;
           }
+          if(d_ok_to_block == false) {
+            // drop the rest of this period, but step over it so the
+            // caller's next period starts where it should
+            for(unsigned int chan = 0; chan < nchan; chan++)
+              in[chan] += nframes;
+            break;
+          }
+          int r = snd_pcm_wait(d_pcm_handle, 1000);
+          if(r < 0 && !recover(r))
+            return false;
+          continue;  // try again
         }
 
-        // update src pointers
-        for(unsigned int chan = 0; chan < nchan; chan++)
-          in[chan] += d_period_size;
-
-        if(!write_buffer (buf, d_period_size, sizeof_frame))
-          return -1; // No fixing this problem.  Say we're done.
-      }
-
-      return n;
-    }
-
-    /*
-     * Work function that deals with float to S16 conversion and
-     * mono to stereo kludge.
-     */
-    int
-    alsa_sink::work_s16_1x2(int noutput_items,
-                            gr_vector_const_void_star &input_items,
-                            gr_vector_void_star &output_items)
-    {
-      typedef int16_t sample_t; // the type of samples we're creating
-      static const float scale_factor = std::pow(2.0f, 16-1) - 1;
-
-      assert(input_items.size () == 1);
-      static const unsigned int nchan = 2;
-      const float **in = (const float **)&input_items[0];
-      sample_t *buf = (sample_t *)d_buffer;
-      int bi;
-      int n;
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = nframes;
+        int r = snd_pcm_mmap_begin(d_pcm_handle, &areas, &offset, &frames);
+        if(r < 0) {
+          if(!recover(r))
+            return false;
+          continue;  // try again
+        }
 
-      unsigned int sizeof_frame = nchan * sizeof(sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
+        // interleaved; every channel area shares the first one's base
+        char *dst = (char *)areas[0].addr
+          + areas[0].first / 8 + offset * (areas[0].step / 8);
+        d_converter(dst, in, nchan, frames);
 
-      for(n = 0; n < noutput_items; n += d_period_size) {
-        // process one period of data
-        bi = 0;
-        for(unsigned int i = 0; i < d_period_size; i++) {
-          sample_t t = (sample_t) (in[0][i] * scale_factor);
-          buf[bi++] = t;
-          buf[bi++] = t;
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(d_pcm_handle, offset, frames);
+        if(committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+          if(!recover(committed >= 0 ? -EPIPE : committed))
+            return false;
         }
 
         // update src pointers
-        in[0] += d_period_size;
-
-        if(!write_buffer (buf, d_period_size, sizeof_frame))
-          return -1;	// No fixing this problem.  Say we're done.
+        for(unsigned int chan = 0; chan < nchan; chan++)
+          in[chan] += frames;
+        nframes -= frames;
+
+        // mmap writes don't auto start the stream; do it at the threshold
+        if(snd_pcm_state(d_pcm_handle) == SND_PCM_STATE_PREPARED) {
+          snd_pcm_sframes_t space = snd_pcm_avail_update(d_pcm_handle);
+          snd_pcm_uframes_t buffer_size = d_nperiods * d_period_size;
+          if(space >= 0 && buffer_size - space >= d_start_threshold) {
+            r = snd_pcm_start(d_pcm_handle);
+            if(r < 0 && !recover(r))
+              return false;
+          }
+        }
       }
 
-      return n;
+      return true;
     }
 
     /*
-     * Work function that deals with float to S32 conversion and
-     * mono to stereo kludge.
+     * Recover from an underrun or suspend.  Returns false if we can't.
      */
-    int
-    alsa_sink::work_s32_1x2(int noutput_items,
-                            gr_vector_const_void_star &input_items,
-                            gr_vector_void_star &output_items)
+    bool
+    alsa_sink::recover(int err)
     {
-      typedef int32_t sample_t; // the type of samples we're creating
-      static const float scale_factor = std::pow(2.0f, 32-1) - 1;
-
-      assert(input_items.size () == 1);
-      static unsigned int nchan = 2;
-      const float **in = (const float **)&input_items[0];
-      sample_t *buf = (sample_t*)d_buffer;
-      int bi;
-      int n;
-
-      unsigned int sizeof_frame = nchan * sizeof(sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
-
-      for(n = 0; n < noutput_items; n += d_period_size) {
-        // process one period of data
-        bi = 0;
-        for(unsigned int i = 0; i < d_period_size; i++) {
-          sample_t t = (sample_t)(in[0][i] * scale_factor);
-          buf[bi++] = t;
-          buf[bi++] = t;
+      if(err == -EPIPE) {  // underrun
+        d_nunderuns++;
+        fputs("aU", stderr);
+        if((err = snd_pcm_prepare (d_pcm_handle)) < 0){
+          output_error_msg("snd_pcm_prepare failed. Can't recover from underrun", err);
+          return false;
         }
-
-        // update src pointers
-        in[0] += d_period_size;
-
-        if(!write_buffer (buf, d_period_size, sizeof_frame))
-          return -1; // No fixing this problem.  Say we're done.
+        if(d_xrun_watch.note()) {
+          // too slow to do here; hand it to the backoff thread
+          std::lock_guard<std::mutex> lock(d_backoff_mutex);
+          d_backoff_wanted = true;
+          d_backoff_cond.notify_one();
+        }
+        return true;
+      }
+#ifdef ESTRPIPE
+      else if(err == -ESTRPIPE) {  // h/w is suspended
+        d_nsuspends++;
+        while((err = snd_pcm_resume (d_pcm_handle)) == -EAGAIN)
+          boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        if(err < 0 && (err = snd_pcm_prepare (d_pcm_handle)) < 0) {
+          output_error_msg("failed to resume from suspend", err);
+          return false;
+        }
+        return true;
+      }
+#endif
+      else if(err == -EAGAIN) {
+        return true;
       }
 
-      return n;
+      output_error_msg("mmap transfer failed", err);
+      return false;
     }
 
     bool
@@ -490,12 +512,8 @@ namespace gr {
         }
 
         else if(r == -EPIPE) {  // underrun
-          d_nunderuns++;
-          fputs("aU", stderr);
-          if((r = snd_pcm_prepare (d_pcm_handle)) < 0){
-            output_error_msg("snd_pcm_prepare failed. Can't recover from underrun", r);
+          if(!recover(r))
             return false;
-          }
           continue;  // try again
         }
 #ifdef ESTRPIPE
@@ -521,6 +539,138 @@ namespace gr {
       return true;
     }
 
+    /*
+     * xruns keep coming; add periods (keeping the period size).
+     * Runs on the backoff thread; stop() remembers the bigger buffer.
+     */
+    bool
+    alsa_sink::backoff()
+    {
+      std::lock_guard<std::mutex> lock(d_pcm_mutex);
+      static const unsigned int max_nperiods = 32;
+      if(d_nperiods >= max_nperiods)
+        return true;  // as much as we're willing to buffer
+
+      unsigned int nchan = d_sizeof_frame / snd_pcm_format_size(d_format, 1);
+      unsigned int nperiods =
+        std::min(max_nperiods, d_nperiods + std::max(1U, d_nperiods / 2));
+      int err = gri_alsa_set_nperiods(d_pcm_handle, d_hw_params, d_access,
+                                      d_format, d_sampling_rate, nchan,
+                                      d_period_size, &nperiods);
+      if(err < 0) {
+        output_error_msg("failed to add periods", err);
+        // put the old size back
+        nperiods = d_nperiods;
+        err = gri_alsa_set_nperiods(d_pcm_handle, d_hw_params, d_access,
+                                    d_format, d_sampling_rate, nchan,
+                                    d_period_size, &nperiods);
+        if(err < 0) {
+          output_error_msg("failed to restore periods", err);
+          return false;
+        }
+        return true;
+      }
+      d_nperiods = nperiods;
+
+      // the start threshold scales with the buffer
+      if((err = set_start_threshold()) < 0) {
+        output_error_msg("failed to set s/w params", err);
+        return false;
+      }
+
+      Logger::notice("[alsa_sink::backoff] "+d_device_name+": too many xruns, now "+std::to_string(d_nperiods)+" periods");
+      return true;
+    }
+
+    /*
+     * Waits for recover() to ask for more periods and adds them, so the
+     * work thread never blocks in hw_params.
+     */
+    void
+    alsa_sink::backoff_loop()
+    {
+      std::unique_lock<std::mutex> lock(d_backoff_mutex);
+      while(true) {
+        d_backoff_cond.wait(lock, [this]() { return d_backoff_wanted || d_stopping; });
+        if(d_stopping)
+          break;
+        d_backoff_wanted = false;
+        lock.unlock();
+        if(!backoff())
+          Logger::warn("[alsa_sink::backoff_loop] "+d_device_name+": giving up on backoff");
+        lock.lock();
+      }
+    }
+
+    bool
+    alsa_sink::start()
+    {
+      d_backoff_wanted = false;
+      d_stopping = false;
+      d_backoff_thread = std::thread(&alsa_sink::backoff_loop, this);
+      return true;
+    }
+
+    /*
+     * Stop the backoff thread and, if it added periods, remember the
+     * bigger buffer for next time.
+     */
+    bool
+    alsa_sink::stop()
+    {
+      if(d_backoff_thread.joinable()) {
+        {
+          std::lock_guard<std::mutex> lock(d_backoff_mutex);
+          d_stopping = true;
+          d_backoff_cond.notify_one();
+        }
+        d_backoff_thread.join();
+      }
+
+      if(d_nperiods > d_saved_nperiods) {
+        gri_alsa_latency latency;
+        latency.period_time = (double)d_period_size / d_sampling_rate;
+        latency.nperiods = d_nperiods;
+        gri_alsa_save_latency(d_device_name, SND_PCM_STREAM_PLAYBACK, latency);
+        d_saved_nperiods = d_nperiods;
+      }
+      return true;
+    }
+
+    int
+    alsa_sink::set_start_threshold()
+    {
+      int err;
+
+      // get current s/w params
+      if((err = snd_pcm_sw_params_current(d_pcm_handle, d_sw_params)) < 0)
+        return err;
+
+      // Tell the PCM device to wait to start until we've filled
+      // it's buffers half way full. This helps avoid audio underruns.
+      d_start_threshold = d_nperiods * d_period_size / 2;
+      if((err = snd_pcm_sw_params_set_start_threshold(d_pcm_handle,
+                                                      d_sw_params,
+                                                      d_start_threshold)) < 0)
+        return err;
+
+      // store the s/w params
+      return snd_pcm_sw_params(d_pcm_handle, d_sw_params);
+    }
+
+    /*
+     * Publish how full the ring is for the drift resampler.
+     */
+    void
+    alsa_sink::update_fill()
+    {
+      snd_pcm_sframes_t delay;
+      if(snd_pcm_delay(d_pcm_handle, &delay) < 0)
+        return;
+      float buffer_size = d_nperiods * d_period_size;
+      d_fill = std::min(std::max(delay / buffer_size, 0.0f), 1.0f);
+    }
+
     void
     alsa_sink::output_error_msg (const char *msg, int err)
     {
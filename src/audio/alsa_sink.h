@@ -27,7 +27,13 @@
 
 #include <gnuradio/sync_block.h>
 #include <alsa/asoundlib.h>
+#include "audio/alsa_convert.h"
+#include "audio/alsa_latency.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <stdexcept>
 
 namespace gr {
@@ -46,25 +52,38 @@ namespace gr {
      */
     class alsa_sink : virtual public sync_block 
     {
-      // typedef for pointer to class work method
-      typedef int(alsa_sink::*work_t)(int noutput_items,
-                                      gr_vector_const_void_star &input_items,
-                                      gr_vector_void_star &output_items);
-
       unsigned int         d_sampling_rate;
       std::string          d_device_name;
       snd_pcm_t           *d_pcm_handle;
       snd_pcm_hw_params_t *d_hw_params;
       snd_pcm_sw_params_t *d_sw_params;
       snd_pcm_format_t     d_format;
+      snd_pcm_access_t     d_access;
       unsigned int         d_nperiods;
       unsigned int         d_period_time_us;	// microseconds
       snd_pcm_uframes_t    d_period_size;	// in frames
+      snd_pcm_uframes_t    d_start_threshold;	// in frames
+      unsigned int         d_sizeof_frame;	// bytes per h/w frame
       unsigned int         d_buffer_size_bytes;	// sizeof of d_buffer
       char                *d_buffer;
-      work_t               d_worker;		// the work method to use
+      gri_alsa_pack_t      d_converter;		// the conversion kernel to use
+      bool                 d_mmap;		// write in place into the driver ring
       bool                 d_special_case_mono_to_stereo;
 
+      // frames queued in the ring / ring size, updated every period
+      std::atomic<float>   d_fill;
+
+      // adds periods when xruns come too often; work() only asks, the
+      // device is reconfigured on d_backoff_thread and saved by stop()
+      gri_alsa_xrun_watch  d_xrun_watch;
+      std::mutex           d_pcm_mutex;		// held by work() and backoff()
+      std::mutex           d_backoff_mutex;
+      std::condition_variable d_backoff_cond;
+      bool                 d_backoff_wanted;
+      bool                 d_stopping;
+      std::thread          d_backoff_thread;
+      unsigned int         d_saved_nperiods;	// what prefs hold for the device
+
       // random stats
       int  d_nunderuns;   // count of underruns
       int  d_nsuspends;   // count of suspends
@@ -81,6 +100,16 @@ namespace gr {
 
       bool check_topology(int ninputs, int noutputs);
 
+      bool start();
+      bool stop();
+
+      /*!
+       * \brief fraction of the ALSA ring holding frames, from snd_pcm_delay
+       *
+       * Safe to call from any thread.
+       */
+      float fill_level() const { return d_fill; }
+
       int work(int noutput_items,
                gr_vector_const_void_star &input_items,
                gr_vector_void_star &output_items);
@@ -88,21 +117,13 @@ namespace gr {
     protected:
       bool write_buffer(const void *buffer, unsigned nframes, unsigned sizeof_frame);
 
-      int work_s16(int noutput_items,
-                   gr_vector_const_void_star &input_items,
-                   gr_vector_void_star &output_items);
-
-      int work_s16_1x2(int noutput_items,
-                       gr_vector_const_void_star &input_items,
-                       gr_vector_void_star &output_items);
-
-      int work_s32(int noutput_items,
-                   gr_vector_const_void_star &input_items,
-                   gr_vector_void_star &output_items);
+      bool write_mmap(const float **in, unsigned int nchan, unsigned nframes);
 
-      int work_s32_1x2(int noutput_items,
-                       gr_vector_const_void_star &input_items,
-                       gr_vector_void_star &output_items);
+      bool recover(int err);
+      bool backoff();
+      void backoff_loop();
+      int set_start_threshold();
+      void update_fill();
     };
 
   } /* namespace audio */
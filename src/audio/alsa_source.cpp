@@ -25,11 +25,13 @@
 #include "application/logger.h"
 #include "audio/alsa_source.h"
 #include "audio/alsa_impl.h"
+#include "audio/alsa_latency.h"
 #include <gnuradio/io_signature.h>
 #include <gnuradio/prefs.h>
 #include <stdio.h>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 namespace gr {
   namespace audio {
@@ -37,11 +39,19 @@ namespace gr {
     static bool CHATTY_DEBUG = false;
 
     static snd_pcm_format_t acceptable_formats[] = {
-      // these are in our preferred order...
+      // picked by gri_alsa_format_cost, not by order
+      SND_PCM_FORMAT_FLOAT,
       SND_PCM_FORMAT_S32,
+      SND_PCM_FORMAT_S24_3LE,
       SND_PCM_FORMAT_S16
     };
 
+    static snd_pcm_access_t acceptable_access[] = {
+      // these are in our preferred order...
+      SND_PCM_ACCESS_MMAP_INTERLEAVED,
+      SND_PCM_ACCESS_RW_INTERLEAVED
+    };
+
 #define NELEMS(x) (sizeof(x)/sizeof(x[0]))
 
     static std::string
@@ -66,6 +76,12 @@ namespace gr {
                       prefs::singleton()->get_long("audio_alsa", "nperiods", 4));
     }
 
+    static bool
+    default_mmap()
+    {
+      return prefs::singleton()->get_bool("audio_alsa", "mmap", true);
+    }
+
     // ----------------------------------------------------------------
 
     alsa_source::alsa_source(int sampling_rate,
@@ -81,14 +97,23 @@ namespace gr {
         d_sw_params((snd_pcm_sw_params_t*)(new char[snd_pcm_sw_params_sizeof()])),
         d_nperiods(default_nperiods()),
         d_period_time_us((unsigned int)(default_period_time() * 1e6)),
-        d_period_size(0),
+        d_period_size(0), d_sizeof_frame(0),
         d_buffer_size_bytes(0), d_buffer(0),
-        d_worker(0), d_hw_nchan(0),
+        d_converter(0), d_mmap(false), d_hw_nchan(0),
         d_special_case_stereo_to_mono(false),
-        d_noverruns(0), d_nsuspends(0)
+        d_fill(0), d_backoff_wanted(false), d_stopping(false),
+        d_saved_nperiods(0), d_noverruns(0), d_nsuspends(0)
     {
       CHATTY_DEBUG = prefs::singleton()->get_bool("audio_alsa", "verbose", false);
 
+      // a calibrated or backed off configuration for this device wins
+      gri_alsa_latency tuned;
+      if(gri_alsa_load_latency(d_device_name, SND_PCM_STREAM_CAPTURE, &tuned)) {
+        d_nperiods = tuned.nperiods;
+        d_period_time_us = (unsigned int)(tuned.period_time * 1e6);
+        Logger::info("[alsa_source::alsa_source] "+d_device_name+": using tuned latency "+std::to_string(d_nperiods)+" x "+std::to_string(d_period_time_us)+" us");
+      }
+
       int error;
       int dir;
 
@@ -129,17 +154,21 @@ namespace gr {
       // fill in portions of the d_hw_params that we know now...
 
       // Specify the access methods we implement
-      // For now, we only handle RW_INTERLEAVED...
-      snd_pcm_access_mask_t *access_mask;
-      snd_pcm_access_mask_t **access_mask_ptr = &access_mask; // FIXME: workaround for compiler warning
-      snd_pcm_access_mask_alloca(access_mask_ptr);
-      snd_pcm_access_mask_none(access_mask);
-      snd_pcm_access_mask_set(access_mask, SND_PCM_ACCESS_RW_INTERLEAVED);
-      // snd_pcm_access_mask_set(access_mask, SND_PCM_ACCESS_RW_NONINTERLEAVED);
-
-      if((error = snd_pcm_hw_params_set_access_mask(d_pcm_handle,
-                                                    d_hw_params, access_mask)) < 0)
-        bail("failed to set access mask", error);
+      // MMAP_INTERLEAVED converts straight out of the driver's ring buffer;
+      // RW_INTERLEAVED is the fallback for devices that can't mmap.
+      unsigned int naccess = NELEMS(acceptable_access);
+      snd_pcm_access_t *access = acceptable_access;
+      if(!default_mmap()) {
+        access = &acceptable_access[1];
+        naccess--;
+      }
+      if(!gri_alsa_pick_acceptable_access(d_pcm_handle, d_hw_params,
+                                          access, naccess,
+                                          &d_access,
+                                          "audio_alsa_source",
+                                          CHATTY_DEBUG))
+        throw std::runtime_error("audio_alsa_source");
+      d_mmap = (d_access == SND_PCM_ACCESS_MMAP_INTERLEAVED);
 
       // set sample format
       if(!gri_alsa_pick_acceptable_format(d_pcm_handle, d_hw_params,
@@ -194,6 +223,7 @@ namespace gr {
       if(error < 0)
         bail("get_period_size failed", error);
 
+      d_saved_nperiods = d_nperiods;
       set_output_multiple(d_period_size);
     }
 
@@ -233,10 +263,19 @@ namespace gr {
         return false;
       }
 
-      d_buffer_size_bytes =
-        d_period_size * d_hw_nchan * snd_pcm_format_size(d_format, 1);
+      d_sizeof_frame = d_hw_nchan * snd_pcm_format_size(d_format, 1);
+      d_buffer_size_bytes = d_period_size * d_sizeof_frame;
 
-      d_buffer = new char[d_buffer_size_bytes];
+      // the bounce buffer is only needed when the ring can't be mapped
+      delete [] d_buffer;
+      d_buffer = 0;
+      if(!d_mmap)
+        d_buffer = new char[d_buffer_size_bytes];
+
+      {
+        std::string pcm_name(snd_pcm_name(d_pcm_handle));
+        Logger::info("[alsa_source::check_topology] "+pcm_name+": "+snd_pcm_access_name(d_access)+" access, "+snd_pcm_format_name(d_format)+", "+gri_alsa_convert_best()->name+" conversion");
+      }
 
       if(CHATTY_DEBUG) {
         std::string pcm_name(snd_pcm_name(d_pcm_handle));
@@ -247,16 +286,30 @@ namespace gr {
       switch(d_format) {
       case SND_PCM_FORMAT_S16:
         if(special_case)
-          d_worker = &alsa_source::work_s16_2x1;
+          d_converter = gri_alsa_convert_best()->s16_to_float_2x1;
         else
-          d_worker = &alsa_source::work_s16;
+          d_converter = gri_alsa_convert_best()->s16_to_float;
         break;
 
       case SND_PCM_FORMAT_S32:
         if(special_case)
-          d_worker = &alsa_source::work_s32_2x1;
+          d_converter = gri_alsa_convert_best()->s32_to_float_2x1;
         else
-          d_worker = &alsa_source::work_s32;
+          d_converter = gri_alsa_convert_best()->s32_to_float;
+        break;
+
+      case SND_PCM_FORMAT_FLOAT:
+        if(special_case)
+          d_converter = gri_alsa_convert_best()->f32_to_float_2x1;
+        else
+          d_converter = gri_alsa_convert_best()->f32_to_float;
+        break;
+
+      case SND_PCM_FORMAT_S24_3LE:
+        if(special_case)
+          d_converter = gri_alsa_convert_best()->s24_3_to_float_2x1;
+        else
+          d_converter = gri_alsa_convert_best()->s24_3_to_float;
         break;
 
       default:
@@ -268,6 +321,8 @@ namespace gr {
 
     alsa_source::~alsa_source()
     {
+      stop();
+
       if(snd_pcm_state(d_pcm_handle) == SND_PCM_STATE_RUNNING)
         snd_pcm_drop(d_pcm_handle);
 
@@ -285,159 +340,131 @@ namespace gr {
       assert((noutput_items % d_period_size) == 0);
       assert(noutput_items != 0);
 
-      // this is a call through a pointer to a method...
-      return (this->*d_worker)(noutput_items, input_items, output_items);
-    }
-
-    /*
-     * Work function that deals with float to S16 conversion
-     */
-    int
-    alsa_source::work_s16(int noutput_items,
-                          gr_vector_const_void_star &input_items,
-                          gr_vector_void_star &output_items)
-    {
-      typedef int16_t sample_t; // the type of samples we're creating
-      static const float scale_factor = 1.0 / std::pow(2.0f, 16-1);
-
-      unsigned int nchan = output_items.size ();
+      unsigned int nchan = output_items.size();
       float **out = (float **)&output_items[0];
-      sample_t *buf = (sample_t *)d_buffer;
-      int bi;
 
-      unsigned int sizeof_frame = d_hw_nchan * sizeof (sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
+      // backoff() reconfigures the device between calls, never during one
+      std::lock_guard<std::mutex> lock(d_pcm_mutex);
 
       // To minimize latency, return at most a single period's worth of samples.
       // [We could also read the first one in a blocking mode and subsequent
       //  ones in non-blocking mode, but we'll leave that for later (or never).]
 
-      if(!read_buffer(buf, d_period_size, sizeof_frame))
-        return -1;		// No fixing this problem.  Say we're done.
-
-      // process one period of data
-      bi = 0;
-      for(unsigned int i = 0; i < d_period_size; i++) {
-        for(unsigned int chan = 0; chan < nchan; chan++) {
-          out[chan][i] = (float) buf[bi++] * scale_factor;
-        }
+      if(d_mmap) {
+        if(!read_mmap(out, nchan, d_period_size))
+          return -1;  // No fixing this problem.  Say we're done.
+        update_fill();
+        return d_period_size;
       }
 
-      return d_period_size;
-    }
-
-    /*
-     * Work function that deals with float to S16 conversion
-     * and stereo to mono kludge...
-     */
-    int
-    alsa_source::work_s16_2x1(int noutput_items,
-                              gr_vector_const_void_star &input_items,
-                              gr_vector_void_star &output_items)
-    {
-      typedef int16_t sample_t; // the type of samples we're creating
-      static const float scale_factor = 1.0 / std::pow(2.0f, 16-1);
-
-      float **out = (float**)&output_items[0];
-      sample_t *buf = (sample_t*)d_buffer;
-      int bi;
-
-      assert(output_items.size () == 1);
-
-      unsigned int sizeof_frame = d_hw_nchan * sizeof(sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
-
-      // To minimize latency, return at most a single period's worth of samples.
-      // [We could also read the first one in a blocking mode and subsequent
-      //  ones in non-blocking mode, but we'll leave that for later (or never).]
-      if(!read_buffer (buf, d_period_size, sizeof_frame))
-        return -1;   // No fixing this problem.  Say we're done.
+      if(!read_buffer(d_buffer, d_period_size, d_sizeof_frame))
+        return -1;  // No fixing this problem.  Say we're done.
 
       // process one period of data
-      bi = 0;
-      for(unsigned int i = 0; i < d_period_size; i++) {
-        int t = (buf[bi] + buf[bi+1]) / 2;
-        bi += 2;
-        out[0][i] = (float) t * scale_factor;
-      }
+      d_converter(out, d_buffer, nchan, d_period_size);
 
+      update_fill();
       return d_period_size;
     }
 
     /*
-     * Work function that deals with float to S32 conversion
+     * Convert nframes straight out of the driver's mmap'd ring buffer.
      */
-    int
-    alsa_source::work_s32(int noutput_items,
-                          gr_vector_const_void_star &input_items,
-                          gr_vector_void_star &output_items)
+    bool
+    alsa_source::read_mmap(float **out, unsigned int nchan, unsigned nframes)
     {
-      typedef int32_t sample_t; // the type of samples we're creating
-      static const float scale_factor = 1.0 / std::pow(2.0f, 32-1);
+      // local copy so we can advance the dst pointers
+      std::vector<float *> dst(out, out + nchan);
 
-      unsigned int nchan = output_items.size ();
-      float **out = (float**)&output_items[0];
-      sample_t *buf = (sample_t*)d_buffer;
-      int bi;
+      while(nframes > 0) {
+        if(snd_pcm_state(d_pcm_handle) == SND_PCM_STATE_PREPARED) {
+          // mmap reads don't auto start the stream
+          int r = snd_pcm_start(d_pcm_handle);
+          if(r < 0 && !recover(r))
+            return false;
+        }
 
-      unsigned int sizeof_frame = d_hw_nchan * sizeof(sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(d_pcm_handle);
+        if(avail < 0) {
+          if(!recover(avail))
+            return false;
+          continue;  // try again
+        }
 
-      // To minimize latency, return at most a single period's worth of samples.
-      // [We could also read the first one in a blocking mode and subsequent
-      //  ones in non-blocking mode, but we'll leave that for later (or never).]
+        if(avail == 0) {
+          int r = snd_pcm_wait(d_pcm_handle, 1000);
+          if(r < 0 && !recover(r))
+            return false;
+          continue;  // try again
+        }
 
-      if(!read_buffer(buf, d_period_size, sizeof_frame))
-        return -1;  // No fixing this problem.  Say we're done.
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = nframes;
+        int r = snd_pcm_mmap_begin(d_pcm_handle, &areas, &offset, &frames);
+        if(r < 0) {
+          if(!recover(r))
+            return false;
+          continue;  // try again
+        }
 
-      // process one period of data
-      bi = 0;
-      for(unsigned int i = 0; i < d_period_size; i++) {
-        for(unsigned int chan = 0; chan < nchan; chan++) {
-          out[chan][i] = (float) buf[bi++] * scale_factor;
+        // interleaved; every channel area shares the first one's base
+        const char *src = (const char *)areas[0].addr
+          + areas[0].first / 8 + offset * (areas[0].step / 8);
+        d_converter(&dst[0], src, nchan, frames);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(d_pcm_handle, offset, frames);
+        if(committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+          if(!recover(committed >= 0 ? -EPIPE : committed))
+            return false;
         }
+
+        // update dst pointers
+        for(unsigned int chan = 0; chan < nchan; chan++)
+          dst[chan] += frames;
+        nframes -= frames;
       }
 
-      return d_period_size;
+      return true;
     }
 
     /*
-     * Work function that deals with float to S32 conversion
-     * and stereo to mono kludge...
+     * Recover from an overrun or suspend.  Returns false if we can't.
      */
-    int
-    alsa_source::work_s32_2x1(int noutput_items,
-                              gr_vector_const_void_star &input_items,
-                              gr_vector_void_star &output_items)
+    bool
+    alsa_source::recover(int err)
     {
-      typedef int32_t sample_t; // the type of samples we're creating
-      static const float scale_factor = 1.0 / std::pow(2.0f, 32-1);
-
-      float **out = (float**)&output_items[0];
-      sample_t *buf = (sample_t*)d_buffer;
-      int bi;
-
-      assert(output_items.size () == 1);
-
-      unsigned int sizeof_frame = d_hw_nchan * sizeof(sample_t);
-      assert(d_buffer_size_bytes == d_period_size * sizeof_frame);
-
-      // To minimize latency, return at most a single period's worth of samples.
-      // [We could also read the first one in a blocking mode and subsequent
-      //  ones in non-blocking mode, but we'll leave that for later (or never).]
-
-      if(!read_buffer(buf, d_period_size, sizeof_frame))
-        return -1;  // No fixing this problem.  Say we're done.
-
-      // process one period of data
-      bi = 0;
-      for(unsigned int i = 0; i < d_period_size; i++) {
-        int t = (buf[bi] + buf[bi+1]) / 2;
-        bi += 2;
-        out[0][i] = (float)t * scale_factor;
+      if(err == -EPIPE) {  // overrun
+        d_noverruns++;
+        fputs("aO", stderr);
+        if((err = snd_pcm_prepare (d_pcm_handle)) < 0) {
+          output_error_msg("snd_pcm_prepare failed. Can't recover from overrun", err);
+          return false;
+        }
+        if(d_xrun_watch.note()) {
+          // too slow to do here; hand it to the backoff thread
+          std::lock_guard<std::mutex> lock(d_backoff_mutex);
+          d_backoff_wanted = true;
+          d_backoff_cond.notify_one();
+        }
+        return true;
+      }
+#ifdef ESTRPIPE
+      else if(err == -ESTRPIPE) {  // h/w is suspended
+        d_nsuspends++;
+        if((err = snd_pcm_resume (d_pcm_handle)) < 0) {
+          output_error_msg ("failed to resume from suspend", err);
+          return false;
+        }
+        return true;
+      }
+#endif
+      else if(err == -EAGAIN) {
+        return true;
       }
 
-      return d_period_size;
+      output_error_msg("mmap transfer failed", err);
+      return false;
     }
 
     bool
@@ -451,12 +478,8 @@ namespace gr {
           continue;   // try again
 
         else if(r == -EPIPE) {  // overrun
-          d_noverruns++;
-          fputs("aO", stderr);
-          if((r = snd_pcm_prepare (d_pcm_handle)) < 0) {
-            output_error_msg("snd_pcm_prepare failed. Can't recover from overrun", r);
+          if(!recover(r))
             return false;
-          }
           continue;  // try again
         }
 #ifdef ESTRPIPE
@@ -482,6 +505,110 @@ namespace gr {
       return true;
     }
 
+    /*
+     * xruns keep coming; add periods (keeping the period size).
+     * Runs on the backoff thread; stop() remembers the bigger buffer.
+     */
+    bool
+    alsa_source::backoff()
+    {
+      std::lock_guard<std::mutex> lock(d_pcm_mutex);
+      static const unsigned int max_nperiods = 32;
+      if(d_nperiods >= max_nperiods)
+        return true;  // as much as we're willing to buffer
+
+      unsigned int nchan = d_hw_nchan;
+      unsigned int nperiods =
+        std::min(max_nperiods, d_nperiods + std::max(1U, d_nperiods / 2));
+      int err = gri_alsa_set_nperiods(d_pcm_handle, d_hw_params, d_access,
+                                      d_format, d_sampling_rate, nchan,
+                                      d_period_size, &nperiods);
+      if(err < 0) {
+        output_error_msg("failed to add periods", err);
+        // put the old size back
+        nperiods = d_nperiods;
+        err = gri_alsa_set_nperiods(d_pcm_handle, d_hw_params, d_access,
+                                    d_format, d_sampling_rate, nchan,
+                                    d_period_size, &nperiods);
+        if(err < 0) {
+          output_error_msg("failed to restore periods", err);
+          return false;
+        }
+        return true;
+      }
+      d_nperiods = nperiods;
+      Logger::notice("[alsa_source::backoff] "+d_device_name+": too many xruns, now "+std::to_string(d_nperiods)+" periods");
+      return true;
+    }
+
+    /*
+     * Waits for recover() to ask for more periods and adds them, so the
+     * work thread never blocks in hw_params.
+     */
+    void
+    alsa_source::backoff_loop()
+    {
+      std::unique_lock<std::mutex> lock(d_backoff_mutex);
+      while(true) {
+        d_backoff_cond.wait(lock, [this]() { return d_backoff_wanted || d_stopping; });
+        if(d_stopping)
+          break;
+        d_backoff_wanted = false;
+        lock.unlock();
+        if(!backoff())
+          Logger::warn("[alsa_source::backoff_loop] "+d_device_name+": giving up on backoff");
+        lock.lock();
+      }
+    }
+
+    bool
+    alsa_source::start()
+    {
+      d_backoff_wanted = false;
+      d_stopping = false;
+      d_backoff_thread = std::thread(&alsa_source::backoff_loop, this);
+      return true;
+    }
+
+    /*
+     * Stop the backoff thread and, if it added periods, remember the
+     * bigger buffer for next time.
+     */
+    bool
+    alsa_source::stop()
+    {
+      if(d_backoff_thread.joinable()) {
+        {
+          std::lock_guard<std::mutex> lock(d_backoff_mutex);
+          d_stopping = true;
+          d_backoff_cond.notify_one();
+        }
+        d_backoff_thread.join();
+      }
+
+      if(d_nperiods > d_saved_nperiods) {
+        gri_alsa_latency latency;
+        latency.period_time = (double)d_period_size / d_sampling_rate;
+        latency.nperiods = d_nperiods;
+        gri_alsa_save_latency(d_device_name, SND_PCM_STREAM_CAPTURE, latency);
+        d_saved_nperiods = d_nperiods;
+      }
+      return true;
+    }
+
+    /*
+     * Publish how full the ring is for the drift resampler.
+     */
+    void
+    alsa_source::update_fill()
+    {
+      snd_pcm_sframes_t delay;
+      if(snd_pcm_delay(d_pcm_handle, &delay) < 0)
+        return;
+      float buffer_size = d_nperiods * d_period_size;
+      d_fill = std::min(std::max(delay / buffer_size, 0.0f), 1.0f);
+    }
+
     void
     alsa_source::output_error_msg(const char *msg, int err)
     {
@@ -0,0 +1,158 @@
+/**-------------------------------------------------------------------------
+ * @file drift_resampler_ff.cpp
+ * @brief track the sound card clock against the SDR sample clock
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/drift_resampler_ff.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// cubic interpolation looks at one sample behind and two ahead
+const int drift_resampler_ff::ntaps = 4;
+// the fill level moves a whole period at a time; smooth over ~100 calls
+const float drift_resampler_ff::fill_alpha = 0.01;
+// a fill error of 0.5 asks for 250 ppm straight away
+const double drift_resampler_ff::kp = 500e-6;
+// and the integrator walks the steady state clock offset in slowly
+const double drift_resampler_ff::ki = 0.1e-6;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+drift_resampler_ff::sptr drift_resampler_ff::make(fill_fnc_t fill, float target, double max_ppm)
+{
+    return gnuradio::get_initial_sptr(new drift_resampler_ff(fill, target, max_ppm));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     drift_resampler_ff
+ */
+drift_resampler_ff::drift_resampler_ff(fill_fnc_t fill, float target, double max_ppm)
+    : gr::block("drift_resampler_ff",
+          gr::io_signature::make(1, 1, sizeof(float)),// input_signature
+          gr::io_signature::make(1, 1, sizeof(float))),// output_signature
+      m_fill_fnc(fill),
+      m_target(target),
+      m_max_correction(max_ppm * 1e-6),
+      m_mu(0),
+      m_integral(0),
+      m_ratio(1.0),
+      m_fill(target)
+{
+    Logger::debug("[drift_resampler_ff::drift_resampler_ff] target fill "+std::to_string(m_target)+", max "+std::to_string(max_ppm)+" ppm");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~drift_resampler_ff
+ */
+drift_resampler_ff::~drift_resampler_ff()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_ratio
+ */
+double drift_resampler_ff::get_ratio() const
+{
+    return m_ratio;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_fill
+ */
+float drift_resampler_ff::get_fill() const
+{
+    return m_fill;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     forecast
+ */
+void drift_resampler_ff::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+    ninput_items_required[0] = (int)std::ceil(noutput_items / m_ratio) + ntaps;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     update_ratio
+ */
+void drift_resampler_ff::update_ratio()
+{
+    float fill = m_fill + fill_alpha * (m_fill_fnc() - m_fill);
+    m_fill = fill;
+
+    // too full: make fewer samples per input sample
+    double error = fill - m_target;
+    m_integral = std::min(std::max(m_integral + ki * error, -m_max_correction), m_max_correction);
+    double correction = kp * error + m_integral;
+    correction = std::min(std::max(correction, -m_max_correction), m_max_correction);
+    m_ratio = 1.0 - correction;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     general_work
+ */
+int drift_resampler_ff::general_work(int noutput_items,
+                                     gr_vector_int &ninput_items,
+                                     gr_vector_const_void_star &input_items,
+                                     gr_vector_void_star &output_items)
+{
+    const float *in = (const float *)input_items[0];
+    float *out = (float *)output_items[0];
+
+    update_ratio();
+    const double step = 1.0 / m_ratio;
+
+    int ii = 0;
+    int oo = 0;
+    while(oo < noutput_items && ii + ntaps <= ninput_items[0])
+    {
+        // Catmull-Rom between in[ii+1] and in[ii+2]
+        const float *x = in + ii;
+        float mu = (float)m_mu;
+        out[oo++] = x[1] + 0.5f * mu * (x[2] - x[0] +
+                    mu * (2.0f * x[0] - 5.0f * x[1] + 4.0f * x[2] - x[3] +
+                    mu * (3.0f * (x[1] - x[2]) + x[3] - x[0])));
+
+        m_mu += step;
+        int whole = (int)m_mu;
+        ii += whole;
+        m_mu -= whole;
+    }
+
+    consume_each(ii);
+    return oo;
+}
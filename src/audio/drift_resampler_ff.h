@@ -0,0 +1,115 @@
+/**-------------------------------------------------------------------------
+ * @file drift_resampler_ff.h
+ * @brief track the sound card clock against the SDR sample clock
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __DRIFT_RESAMPLER_FF_H__
+#define __DRIFT_RESAMPLER_FF_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/block.h>
+#include <atomic>
+#include <functional>
+
+class drift_resampler_ff;
+
+/**
+ * Fractional resampler that sits next to an ALSA block and nudges its
+ * ratio a few ppm at a time so the ALSA ring stays at a target fill level.
+ * Without it the sound card and SDR clocks slowly walk apart until the
+ * ring under or overruns.
+ *
+ * The same sign works on both sides: when the ring is too full, make
+ * fewer output samples per input sample.  For playback that feeds the
+ * card less; for capture that drains the card faster.
+ */
+class drift_resampler_ff : public gr::block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the drift resampler */
+    typedef boost::shared_ptr<drift_resampler_ff> sptr;
+
+    /** returns the ALSA ring fill level between 0 and 1 */
+    typedef std::function<float(void)> fill_fnc_t;
+
+    static sptr make(fill_fnc_t fill, float target = 0.5, double max_ppm = 1000);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param fill - reads the ALSA ring fill level
+     * @param target - fill level to hold
+     * @param max_ppm - limit on the ratio correction
+     */
+    drift_resampler_ff(fill_fnc_t fill, float target, double max_ppm);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~drift_resampler_ff();
+
+    /** @brief output samples per input sample right now
+     *
+     * @return double
+     */
+    double get_ratio() const;
+
+    /** @brief smoothed fill level the loop is acting on
+     *
+     * @return float
+     */
+    float get_fill() const;
+
+    void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+    int general_work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+
+private:
+    static const int ntaps;
+    static const float fill_alpha;
+    static const double kp;
+    static const double ki;
+    fill_fnc_t m_fill_fnc;
+    float m_target;
+    double m_max_correction;
+    double m_mu;           // fractional input position
+    double m_integral;
+    std::atomic<double> m_ratio;
+    std::atomic<float> m_fill;
+
+    /** @brief run the control loop once
+     *
+     * @return Void.
+     */
+    void update_ratio();
+};
+
+#endif /* __DRIFT_RESAMPLER_FF_H__ */
@@ -0,0 +1,252 @@
+/**-------------------------------------------------------------------------
+ * @file jitter_buffer.cpp
+ * @brief reorder and time the playout of network audio
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/jitter_buffer.h"
+#include <algorithm>
+#include <cmath>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// a timestamp this far from the play position means a new stream
+static const double restart_seconds = 10.0;
+// RFC 3550 smoothing for the jitter, also used for the delay
+static const double smoothing = 1.0 / 16.0;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     jitter_buffer
+ */
+jitter_buffer::jitter_buffer(double rate, double min_delay, double max_delay)
+    : m_rate(rate),
+      m_min_delay(min_delay),
+      m_max_delay(max_delay),
+      m_playing(false),
+      m_play_pos(0),
+      m_started(false),
+      m_base_seq(0),
+      m_max_seq(0),
+      m_seq_received(0),
+      m_lost_before(0),
+      m_end_ts(0),
+      m_transit(0),
+      m_stats()
+{
+    m_stats.target = min_delay;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~jitter_buffer
+ */
+jitter_buffer::~jitter_buffer()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     restart
+ */
+void jitter_buffer::restart()
+{
+    m_packets.clear();
+    m_playing = false;
+    m_started = false;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     queued
+ */
+uint64_t jitter_buffer::queued() const
+{
+    if(m_packets.empty())
+    {
+        return 0;
+    }
+    auto last = m_packets.rbegin();
+    uint64_t end = last->first + last->second.size();
+    uint64_t start = m_playing ? m_play_pos : m_packets.begin()->first;
+    return end > start ? end - start : 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     insert
+ */
+void jitter_buffer::insert(const udp_audio_header_t &header, const float *samples, uint64_t arrival)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t ts = header.timestamp;
+    uint64_t far = (uint64_t)(m_rate * restart_seconds);
+    if(m_started && (ts + far < m_end_ts || ts > m_end_ts + far))
+    {
+        restart();
+    }
+
+    // loss from the sequence numbers, as in RFC 3550 A.3
+    if(!m_started)
+    {
+        m_started = true;
+        m_base_seq = header.seq;
+        m_max_seq = header.seq;
+        m_seq_received = 0;
+        m_lost_before = m_stats.lost;
+        m_end_ts = ts;
+        m_transit = arrival * 1e-9 - ts / m_rate;
+    }
+    int32_t ahead = (int32_t)(header.seq - (uint32_t)m_max_seq);
+    if(ahead > 0)
+    {
+        m_max_seq += ahead;
+    }
+    m_stats.received++;
+    m_seq_received++;
+    uint64_t expected = m_max_seq - m_base_seq + 1;
+    m_stats.lost = m_lost_before + (expected > m_seq_received ? expected - m_seq_received : 0);
+    m_end_ts = std::max(m_end_ts, ts + header.nsamples);
+
+    // interarrival jitter, RFC 3550 A.8
+    double transit = arrival * 1e-9 - ts / m_rate;
+    m_stats.jitter += (std::fabs(transit - m_transit) - m_stats.jitter) * smoothing;
+    m_transit = transit;
+    m_stats.target = std::min(std::max(m_min_delay + 4 * m_stats.jitter, m_min_delay), m_max_delay);
+
+    double delay = ((double)arrival - (double)header.send_time) * 1e-9;
+    m_stats.delay += (delay - m_stats.delay) * smoothing;
+    m_stats.max_delay = std::max(m_stats.max_delay, delay);
+
+    if(m_playing && ts + header.nsamples <= m_play_pos)
+    {
+        m_stats.late++;
+        return;
+    }
+    if(m_packets.count(ts))
+    {
+        m_stats.duplicate++;
+        return;
+    }
+    m_packets[ts].assign(samples, samples + header.nsamples);
+
+    // nobody is reading; don't grow without bound.  Keep the newest audio
+    // and move the play position past what goes.
+    uint64_t limit = (uint64_t)(2 * m_max_delay * m_rate);
+    if(queued() > limit)
+    {
+        auto last = m_packets.rbegin();
+        uint64_t keep = last->first + last->second.size() - limit;
+        uint64_t from = m_playing ? m_play_pos : m_packets.begin()->first;
+        m_stats.dropped += keep - from;
+        if(m_playing)
+        {
+            m_play_pos = keep;
+        }
+        while(m_packets.begin()->first + m_packets.begin()->second.size() <= keep)
+        {
+            m_packets.erase(m_packets.begin());
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read
+ */
+void jitter_buffer::read(float *out, size_t nsamples)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(!m_playing)
+    {
+        if(m_packets.empty() || queued() < m_stats.target * m_rate)
+        {
+            std::fill(out, out + nsamples, 0.0f);
+            m_stats.depth = queued() / m_rate;
+            return;
+        }
+        m_playing = true;
+        m_play_pos = m_packets.begin()->first;
+    }
+
+    size_t done = 0;
+    while(done < nsamples)
+    {
+        auto it = m_packets.begin();
+        if(it == m_packets.end())
+        {
+            // ran dry; wait for the target depth again
+            m_playing = false;
+            m_stats.rebuffers++;
+            std::fill(out + done, out + nsamples, 0.0f);
+            break;
+        }
+
+        uint64_t start = it->first;
+        const std::vector<float> &packet = it->second;
+        if(start + packet.size() <= m_play_pos)
+        {
+            m_packets.erase(it);
+            continue;
+        }
+
+        if(start > m_play_pos)
+        {
+            // a hole where a lost packet should be
+            size_t gap = std::min((size_t)(start - m_play_pos), nsamples - done);
+            std::fill(out + done, out + done + gap, 0.0f);
+            m_stats.concealed += gap;
+            m_play_pos += gap;
+            done += gap;
+            continue;
+        }
+
+        size_t offset = m_play_pos - start;
+        size_t n = std::min(packet.size() - offset, nsamples - done);
+        std::copy(packet.begin() + offset, packet.begin() + offset + n, out + done);
+        m_play_pos += n;
+        done += n;
+    }
+
+    // holding twice what we need; skip the extra
+    uint64_t target = (uint64_t)(m_stats.target * m_rate);
+    if(m_playing && queued() > 2 * target)
+    {
+        uint64_t skip = queued() - target;
+        m_play_pos += skip;
+        m_stats.dropped += skip;
+    }
+    m_stats.depth = queued() / m_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_stats
+ */
+jitter_buffer::stats_t jitter_buffer::get_stats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
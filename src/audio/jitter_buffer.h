@@ -0,0 +1,134 @@
+/**-------------------------------------------------------------------------
+ * @file jitter_buffer.h
+ * @brief reorder and time the playout of network audio
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __JITTER_BUFFER_H__
+#define __JITTER_BUFFER_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/udp_audio.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * Receive side buffer for a udp_audio stream.  Packets go in from the
+ * network thread in any order; samples come out at the flowgraph's pace,
+ * placed by their timestamps.  Missing audio is played as silence.
+ *
+ * The depth adapts to the network: the buffer aims for min_delay plus
+ * four times the RFC 3550 interarrival jitter, waits for that much before
+ * it starts playing, and skips ahead when it holds twice that.  The skip
+ * also soaks up the difference between the sender's clock and ours.
+ */
+class jitter_buffer
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    struct {
+        uint64_t received;      // packets
+        uint64_t lost;          // packets never seen, by sequence number
+        uint64_t late;          // packets that missed their playout time
+        uint64_t duplicate;     // packets seen twice
+        uint64_t concealed;     // samples of silence played for lost audio
+        uint64_t dropped;       // samples skipped to shrink the buffer
+        uint64_t rebuffers;     // times the buffer ran dry while playing
+        double delay;           // seconds from send to arrival, smoothed
+        double max_delay;
+        double jitter;          // seconds
+        double depth;           // seconds of audio queued
+        double target;          // seconds of audio the buffer aims for
+    } typedef stats_t;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Constructor
+     *
+     * @param rate - sample rate
+     * @param min_delay - smallest target depth, in seconds
+     * @param max_delay - largest target depth, in seconds
+     */
+    jitter_buffer(double rate, double min_delay = 0.02, double max_delay = 0.5);
+
+    /** @brief Deconstructor
+     *
+     */
+    ~jitter_buffer();
+
+    /** @brief add a packet
+     *
+     * @param header - the packet header
+     * @param samples - header.nsamples samples
+     * @param arrival - receive time, ns since the epoch
+     * @return Void.
+     */
+    void insert(const udp_audio_header_t &header, const float *samples, uint64_t arrival);
+
+    /** @brief take the next nsamples, padded with silence
+     *
+     * @param out - where to put them
+     * @param nsamples - number wanted
+     * @return Void.
+     */
+    void read(float *out, size_t nsamples);
+
+    /** @brief counters and measurements
+     *
+     * @return stats_t
+     */
+    stats_t get_stats();
+
+private:
+    std::mutex m_mutex;
+    std::map<uint64_t, std::vector<float>> m_packets; // by timestamp
+    double m_rate;
+    double m_min_delay;
+    double m_max_delay;
+    bool m_playing;
+    uint64_t m_play_pos;    // timestamp of the next sample out
+    bool m_started;         // a packet has been seen
+    uint64_t m_base_seq;    // extended sequence numbers
+    uint64_t m_max_seq;
+    uint64_t m_seq_received;    // packets since m_base_seq
+    uint64_t m_lost_before;     // lost in earlier streams
+    uint64_t m_end_ts;      // end of the newest audio seen
+    double m_transit;       // for the jitter estimate
+    stats_t m_stats;
+
+    /** @brief forget the stream, it went away or restarted
+     *
+     * @return Void.
+     */
+    void restart();
+
+    /** @brief samples queued from the play position
+     *
+     * @return uint64_t
+     */
+    uint64_t queued() const;
+};
+
+#endif /* __JITTER_BUFFER_H__ */
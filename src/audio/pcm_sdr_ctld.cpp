@@ -0,0 +1,390 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * ALSA ioplug PCM that reads and writes sdr_ctld's shared memory audio
+ * rings, so WSJT-X and friends can use sdr_ctld without snd-aloop.
+ * Capture reads the RX ring, playback writes the TX ring.  Samples are
+ * converted straight between the ring and the application's buffer.
+ *
+ * ~/.asoundrc:
+ *
+ *   pcm.sdr_ctld {
+ *     type sdr_ctld
+ *     name "default"	# sdr_ctld -o shm:default -i shm:default
+ *     latency_ms 100	# capture audio older than this is dropped
+ *     hint { show on description "sdr_ctld shared memory audio" }
+ *   }
+ *
+ * There is no hardware clock here; the poll descriptor is a timer that
+ * ticks once a period, and the SDR sample clock paces the rings.
+ */
+
+#include "audio/alsa_convert.h"
+#include "audio/shm_audio_ring.h"
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_external.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+struct snd_pcm_sdr_ctld {
+  snd_pcm_ioplug_t	io;
+  shm_audio_ring	ring;
+  int			timer_fd;
+  snd_pcm_uframes_t	max_frames;	// capture backlog limit
+  snd_pcm_uframes_t	exposed;	// capture: frames offered so far
+  snd_pcm_uframes_t	transferred;	// frames through transfer()
+  unsigned int		frame_bytes;
+  gri_alsa_pack_t	pack;		// capture: ring -> application
+  gri_alsa_unpack_t	unpack;		// playback: application -> ring
+};
+
+static const unsigned int access_list[] = {
+  SND_PCM_ACCESS_RW_INTERLEAVED
+};
+
+static const unsigned int format_list[] = {
+  SND_PCM_FORMAT_FLOAT,
+  SND_PCM_FORMAT_S32,
+  SND_PCM_FORMAT_S24_3LE,
+  SND_PCM_FORMAT_S16
+};
+
+#define NELEMS(x) (sizeof(x)/sizeof(x[0]))
+
+static int
+set_timer (snd_pcm_sdr_ctld *pcm, bool run)
+{
+  snd_pcm_ioplug_t *io = &pcm->io;
+  struct itimerspec ts;
+  memset (&ts, 0, sizeof (ts));
+
+  if (run){
+    long long ns = (long long) io->period_size * 1000000000LL / io->rate;
+    ts.it_value.tv_sec = ns / 1000000000LL;
+    ts.it_value.tv_nsec = ns % 1000000000LL;
+    ts.it_interval = ts.it_value;
+  }
+
+  if (timerfd_settime (pcm->timer_fd, 0, &ts, 0) < 0)
+    return -errno;
+  return 0;
+}
+
+static int
+sdr_ctld_start (snd_pcm_ioplug_t *io)
+{
+  return set_timer ((snd_pcm_sdr_ctld *) io->private_data, true);
+}
+
+static int
+sdr_ctld_stop (snd_pcm_ioplug_t *io)
+{
+  return set_timer ((snd_pcm_sdr_ctld *) io->private_data, false);
+}
+
+static int
+sdr_ctld_prepare (snd_pcm_ioplug_t *io)
+{
+  snd_pcm_sdr_ctld *pcm = (snd_pcm_sdr_ctld *) io->private_data;
+
+  // whatever queued up while we weren't reading is stale
+  if (io->stream == SND_PCM_STREAM_CAPTURE)
+    pcm->ring.trim (0);
+
+  pcm->exposed = 0;
+  pcm->transferred = 0;
+  return 0;
+}
+
+/*
+ * Returns the hardware position within the buffer.  For capture that is
+ * what we've offered to the application; for playback it is what
+ * sdr_ctld has taken out of the ring.
+ */
+static snd_pcm_sframes_t
+sdr_ctld_pointer (snd_pcm_ioplug_t *io)
+{
+  snd_pcm_sdr_ctld *pcm = (snd_pcm_sdr_ctld *) io->private_data;
+
+  if (io->stream == SND_PCM_STREAM_PLAYBACK){
+    // the ring may still hold a previous client's frames; we can't trim
+    // them from the writer's side, so the pointer waits until they drain
+    snd_pcm_uframes_t pending = std::min ((snd_pcm_uframes_t) pcm->ring.readable (),
+					  pcm->transferred);
+    return (pcm->transferred - pending) % io->buffer_size;
+  }
+
+  // the offered frames are the oldest in the ring, so once the backlog
+  // passes max_frames they are the ones skipped and the application reads
+  // newer frames in their place; never trim below the offered count, so
+  // the ring still holds as many frames as the pointer has promised
+  snd_pcm_uframes_t offered = pcm->exposed - pcm->transferred;
+  pcm->ring.trim (std::max (pcm->max_frames, offered));
+
+  snd_pcm_uframes_t target = std::min ((snd_pcm_uframes_t) pcm->ring.readable (),
+				       io->buffer_size);
+  // a whole buffer in one step would read as no movement at all
+  snd_pcm_uframes_t advance = std::min (target - offered, io->buffer_size - 1);
+  pcm->exposed += advance;
+  return pcm->exposed % io->buffer_size;
+}
+
+static snd_pcm_sframes_t
+sdr_ctld_transfer (snd_pcm_ioplug_t *io,
+		   const snd_pcm_channel_area_t *areas,
+		   snd_pcm_uframes_t offset,
+		   snd_pcm_uframes_t size)
+{
+  snd_pcm_sdr_ctld *pcm = (snd_pcm_sdr_ctld *) io->private_data;
+  // interleaved; every channel area shares the first one's base
+  char *buf = (char *) areas[0].addr
+    + areas[0].first / 8 + offset * (areas[0].step / 8);
+  size_t done = 0;
+
+  if (io->stream == SND_PCM_STREAM_CAPTURE){
+    pcm->ring.note_latency ();
+    while (done < size){
+      size_t n = size - done;
+      const float *src = pcm->ring.read_ptr (&n);
+      if (n == 0)
+	break;
+      pcm->pack (buf + done * pcm->frame_bytes, &src, 1, n);
+      pcm->ring.read_commit (n);
+      done += n;
+    }
+    if (done < size)
+      pcm->ring.get_header ()->underruns.fetch_add (size - done);
+  }
+  else {
+    while (done < size){
+      size_t n = size - done;
+      float *dst = pcm->ring.write_ptr (&n);
+      if (n == 0)
+	break;
+      pcm->unpack (&dst, buf + done * pcm->frame_bytes, 1, n);
+      pcm->ring.write_commit (n);
+      done += n;
+    }
+    if (done < size)
+      pcm->ring.get_header ()->overruns.fetch_add (size - done);
+  }
+
+  pcm->transferred += size;
+  return size;
+}
+
+static int
+sdr_ctld_hw_params (snd_pcm_ioplug_t *io, snd_pcm_hw_params_t *params)
+{
+  snd_pcm_sdr_ctld *pcm = (snd_pcm_sdr_ctld *) io->private_data;
+  const gri_alsa_convert *convert = gri_alsa_convert_best ();
+  bool stereo = io->channels == 2;
+
+  switch (io->format){
+  case SND_PCM_FORMAT_FLOAT:
+    pcm->pack = stereo ? convert->float_to_f32_1x2 : convert->float_to_f32;
+    pcm->unpack = stereo ? convert->f32_to_float_2x1 : convert->f32_to_float;
+    break;
+  case SND_PCM_FORMAT_S32:
+    pcm->pack = stereo ? convert->float_to_s32_1x2 : convert->float_to_s32;
+    pcm->unpack = stereo ? convert->s32_to_float_2x1 : convert->s32_to_float;
+    break;
+  case SND_PCM_FORMAT_S24_3LE:
+    pcm->pack = stereo ? convert->float_to_s24_3_1x2 : convert->float_to_s24_3;
+    pcm->unpack = stereo ? convert->s24_3_to_float_2x1 : convert->s24_3_to_float;
+    break;
+  case SND_PCM_FORMAT_S16:
+    pcm->pack = stereo ? convert->float_to_s16_1x2 : convert->float_to_s16;
+    pcm->unpack = stereo ? convert->s16_to_float_2x1 : convert->s16_to_float;
+    break;
+  default:
+    return -EINVAL;
+  }
+
+  pcm->frame_bytes = snd_pcm_format_physical_width (io->format) / 8 * io->channels;
+  return 0;
+}
+
+static int
+sdr_ctld_poll_revents (snd_pcm_ioplug_t *io, struct pollfd *pfd,
+		       unsigned int nfds, unsigned short *revents)
+{
+  snd_pcm_sdr_ctld *pcm = (snd_pcm_sdr_ctld *) io->private_data;
+  uint64_t expirations;
+
+  // just clear the timer; the rings decide whether we're ready
+  if (read (pcm->timer_fd, &expirations, sizeof (expirations)) < 0
+      && errno != EAGAIN)
+    return -errno;
+
+  *revents = 0;
+  if (io->stream == SND_PCM_STREAM_CAPTURE){
+    if (pcm->ring.readable () >= io->period_size)
+      *revents = POLLIN;
+  }
+  else if (io->buffer_size - pcm->ring.readable () >= io->period_size)
+    *revents = POLLOUT;
+  return 0;
+}
+
+static int
+sdr_ctld_close (snd_pcm_ioplug_t *io)
+{
+  snd_pcm_sdr_ctld *pcm = (snd_pcm_sdr_ctld *) io->private_data;
+
+  close (pcm->timer_fd);
+  delete pcm;
+  return 0;
+}
+
+static snd_pcm_ioplug_callback_t *
+sdr_ctld_callback ()
+{
+  static snd_pcm_ioplug_callback_t callback;
+
+  // no designated initializers in C++11
+  if (!callback.pointer){
+    callback.start = sdr_ctld_start;
+    callback.stop = sdr_ctld_stop;
+    callback.transfer = sdr_ctld_transfer;
+    callback.close = sdr_ctld_close;
+    callback.hw_params = sdr_ctld_hw_params;
+    callback.prepare = sdr_ctld_prepare;
+    callback.poll_revents = sdr_ctld_poll_revents;
+    callback.pointer = sdr_ctld_pointer;
+  }
+  return &callback;
+}
+
+static int
+set_hw_constraints (snd_pcm_sdr_ctld *pcm)
+{
+  snd_pcm_ioplug_t *io = &pcm->io;
+  unsigned int rate = pcm->ring.get_rate ();
+  // keep a whole buffer of the largest frame inside the ring
+  unsigned int max_bytes = pcm->ring.get_capacity () * 4;
+  int err;
+
+  if ((err = snd_pcm_ioplug_set_param_list (io, SND_PCM_IOPLUG_HW_ACCESS,
+					    NELEMS (access_list), access_list)) < 0
+      || (err = snd_pcm_ioplug_set_param_list (io, SND_PCM_IOPLUG_HW_FORMAT,
+					       NELEMS (format_list), format_list)) < 0
+      || (err = snd_pcm_ioplug_set_param_minmax (io, SND_PCM_IOPLUG_HW_CHANNELS,
+						 1, 2)) < 0
+      || (err = snd_pcm_ioplug_set_param_minmax (io, SND_PCM_IOPLUG_HW_RATE,
+						 rate, rate)) < 0
+      || (err = snd_pcm_ioplug_set_param_minmax (io, SND_PCM_IOPLUG_HW_PERIOD_BYTES,
+						 64, max_bytes / 2)) < 0
+      || (err = snd_pcm_ioplug_set_param_minmax (io, SND_PCM_IOPLUG_HW_PERIODS,
+						 2, 64)) < 0
+      || (err = snd_pcm_ioplug_set_param_minmax (io, SND_PCM_IOPLUG_HW_BUFFER_BYTES,
+						 128, max_bytes)) < 0)
+    return err;
+  return 0;
+}
+
+extern "C" {
+
+SND_PCM_PLUGIN_DEFINE_FUNC(sdr_ctld)
+{
+  snd_config_iterator_t i, next;
+  const char *ring_name = "default";
+  long latency_ms = 100;
+  int err;
+
+  snd_config_for_each (i, next, conf){
+    snd_config_t *n = snd_config_iterator_entry (i);
+    const char *id;
+    if (snd_config_get_id (n, &id) < 0)
+      continue;
+    if (snd_pcm_conf_generic_id (id))
+      continue;
+    if (strcmp (id, "name") == 0){
+      if (snd_config_get_string (n, &ring_name) < 0){
+	SNDERR ("Invalid type for %s", id);
+	return -EINVAL;
+      }
+      continue;
+    }
+    if (strcmp (id, "latency_ms") == 0){
+      if (snd_config_get_integer (n, &latency_ms) < 0 || latency_ms <= 0){
+	SNDERR ("Invalid value for %s", id);
+	return -EINVAL;
+      }
+      continue;
+    }
+    SNDERR ("Unknown field %s", id);
+    return -EINVAL;
+  }
+
+  snd_pcm_sdr_ctld *pcm = new snd_pcm_sdr_ctld ();
+  shm_audio_ring::direction_t dir = stream == SND_PCM_STREAM_CAPTURE
+    ? shm_audio_ring::RX : shm_audio_ring::TX;
+  std::string shm_name = shm_audio_ring::shm_name (ring_name, dir);
+
+  if ((err = pcm->ring.attach (shm_name)) < 0){
+    SNDERR ("%s: %s; is sdr_ctld running with shm:%s?",
+	    shm_name.c_str (), strerror (-err), ring_name);
+    delete pcm;
+    return err;
+  }
+
+  pcm->timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (pcm->timer_fd < 0){
+    err = -errno;
+    delete pcm;
+    return err;
+  }
+
+  pcm->max_frames = latency_ms * pcm->ring.get_rate () / 1000;
+
+  pcm->io.version = SND_PCM_IOPLUG_VERSION;
+  pcm->io.name = "sdr_ctld shared memory audio";
+  pcm->io.mmap_rw = 0;
+  pcm->io.poll_fd = pcm->timer_fd;
+  pcm->io.poll_events = POLLIN;
+  pcm->io.callback = sdr_ctld_callback ();
+  pcm->io.private_data = pcm;
+
+  if ((err = snd_pcm_ioplug_create (&pcm->io, name, stream, mode)) < 0){
+    close (pcm->timer_fd);
+    delete pcm;
+    return err;
+  }
+
+  // from here on closing the pcm frees everything
+  if ((err = set_hw_constraints (pcm)) < 0){
+    snd_pcm_ioplug_delete (&pcm->io);
+    return err;
+  }
+
+  *pcmp = pcm->io.pcm;
+  return 0;
+}
+
+SND_PCM_PLUGIN_SYMBOL(sdr_ctld);
+
+}
@@ -0,0 +1,377 @@
+/**-------------------------------------------------------------------------
+ * @file sdr_audio_bridge.cpp
+ * @brief the decoder host's end of sdr_ctld's network audio
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+
+/*
+ * Runs on the host with WSJT-X and stands in for sdr_ctld's shm: audio.
+ * The receive stream from "-o udp:" goes through a jitter buffer into the
+ * RX shared memory ring, and whatever WSJT-X writes into the TX ring goes
+ * out as a stream for "-i udp:".  WSJT-X opens the rings through the
+ * sdr_ctld ALSA plugin, exactly as it would on the radio host.
+ *
+ * Both directions move a packet every 10 ms by this host's clock.  The
+ * receive stream's loss, delay and jitter are printed every -s seconds
+ * and on exit.
+ *
+ * Like the plugin, this doesn't need GNU Radio or the Logger.
+ *
+ * usage: sdr_audio_bridge -r [host:]port [-t host:port] [-n name]
+ *                         [-A rate] [-d max_delay] [-s seconds]
+ */
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/alsa_convert.h"
+#include "audio/jitter_buffer.h"
+#include "audio/shm_audio_ring.h"
+#include "audio/udp_audio.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <getopt.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// audio per packet, and per pass of the main loop
+static const double packet_seconds = 0.01;
+// how often the receive thread checks for a signal
+static const int poll_ms = 100;
+// the rings hold a second; the plugin trims RX to its own latency
+static const double ring_seconds = 1.0;
+// queue this much TX audio before starting a burst
+static const double start_seconds = 0.02;
+
+static std::atomic<bool> running(true);
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     on_signal
+ */
+static void on_signal(int)
+{
+    running = false;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     print_usage
+ */
+static void print_usage(FILE *f, const char *program)
+{
+    fprintf(f, "usage: %s -r [host:]port [-t host:port] [-n name] [-A rate] [-d max_delay] [-s seconds]\n"
+               "  -r  receive sdr_ctld's \"-o udp:\" stream on [host:]port\n"
+               "  -t  send WSJT-X's transmit audio to sdr_ctld's \"-i udp:\" port\n"
+               "  -n  shared memory ring name, as in sdr_ctld's shm:[name] (default: default)\n"
+               "  -A  audio rate, as sdr_ctld's -A (default: 48000)\n"
+               "  -d  largest jitter buffer depth in seconds (default: 0.5)\n"
+               "  -s  print the receive statistics this often, 0 for only at exit (default: 10)\n",
+            program);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     report
+ */
+static void report(const jitter_buffer::stats_t &rx, uint64_t tx_sent, uint64_t tx_errors)
+{
+    uint64_t expected = rx.received + rx.lost;
+    double loss = expected ? 100.0 * rx.lost / expected : 0.0;
+    fprintf(stderr, "rx: received %llu, lost %llu (%.2f%%), late %llu, duplicate %llu"
+                    ", delay %.1f ms (max %.1f), jitter %.2f ms, depth %.1f ms (target %.1f)"
+                    ", concealed %llu, dropped %llu, rebuffers %llu; tx: sent %llu, errors %llu\n",
+            (unsigned long long)rx.received, (unsigned long long)rx.lost, loss,
+            (unsigned long long)rx.late, (unsigned long long)rx.duplicate,
+            rx.delay * 1e3, rx.max_delay * 1e3, rx.jitter * 1e3,
+            rx.depth * 1e3, rx.target * 1e3,
+            (unsigned long long)rx.concealed, (unsigned long long)rx.dropped,
+            (unsigned long long)rx.rebuffers,
+            (unsigned long long)tx_sent, (unsigned long long)tx_errors);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     receive
+ */
+static void receive(int sock, uint32_t rate, jitter_buffer *jitter)
+{
+    gri_alsa_unpack_t converter = gri_alsa_convert_best()->s16_to_float;
+    uint8_t packet[udp_audio_header_size + udp_audio_max_samples * sizeof(int16_t)];
+    float samples[udp_audio_max_samples];
+    bool warned = false;
+
+    while(running)
+    {
+        ssize_t len = recv(sock, packet, sizeof(packet), 0);
+        if(len < 0)
+        {
+            // timed out, or interrupted; check running
+            continue;
+        }
+        uint64_t arrival = udp_audio_now();
+
+        udp_audio_header_t header;
+        if(!udp_audio_unpack_header(packet, len, &header))
+        {
+            continue;
+        }
+        if(header.rate != rate)
+        {
+            if(!warned)
+            {
+                fprintf(stderr, "receive stream is %u Hz, expected %u; use -A\n", header.rate, rate);
+            }
+            warned = true;
+            continue;
+        }
+
+        udp_audio_swap_s16(packet + udp_audio_header_size, header.nsamples);
+        float *out = samples;
+        converter(&out, packet + udp_audio_header_size, 1, header.nsamples);
+        jitter->insert(header, samples, arrival);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     open_rx_socket
+ */
+static int open_rx_socket(const std::string &addr)
+{
+    sockaddr_in sa;
+    if(!udp_audio_parse_address(addr, &sa))
+    {
+        fprintf(stderr, "expected -r [host:]port, not %s\n", addr.c_str());
+        return -1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int opt = 1;
+    struct timeval tv = { 0, poll_ms * 1000 };
+    if(sock < 0 ||
+       0 != setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+       0 != setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) ||
+       0 > bind(sock, (sockaddr *)&sa, sizeof(sa)))
+    {
+        fprintf(stderr, "udp:%s: %s\n", addr.c_str(), strerror(errno));
+        if(sock >= 0)
+        {
+            close(sock);
+        }
+        return -1;
+    }
+    return sock;
+}
+
+/*------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    std::string rx_addr;
+    std::string tx_addr;
+    std::string name = "default";
+    double rate = 48000;
+    double max_delay = 0.5;
+    double report_seconds = 10;
+
+    const char *const short_options = "hr:t:n:A:d:s:";
+    const struct option long_options[] = {
+        { "help",       0, NULL, 'h' },
+        { "rx",         1, NULL, 'r' },
+        { "tx",         1, NULL, 't' },
+        { "name",       1, NULL, 'n' },
+        { "audio-rate", 1, NULL, 'A' },
+        { "max-delay",  1, NULL, 'd' },
+        { "stats",      1, NULL, 's' },
+        { NULL,         0, NULL, 0 }
+    };
+
+    int next_option;
+    while(-1 != (next_option = getopt_long(argc, argv, short_options, long_options, NULL)))
+    {
+        switch(next_option)
+        {
+        case 'r':
+            rx_addr = optarg;
+            break;
+        case 't':
+            tx_addr = optarg;
+            break;
+        case 'n':
+            name = optarg;
+            break;
+        case 'A':
+            rate = atof(optarg);
+            break;
+        case 'd':
+            max_delay = atof(optarg);
+            break;
+        case 's':
+            report_seconds = atof(optarg);
+            break;
+        case 'h':
+            print_usage(stdout, argv[0]);
+            return 0;
+        default:
+            print_usage(stderr, argv[0]);
+            return 1;
+        }
+    }
+    if(rx_addr.empty() || rate <= 0 || max_delay <= 0)
+    {
+        print_usage(stderr, argv[0]);
+        return 1;
+    }
+
+    size_t packet_samples = std::min((size_t)(rate * packet_seconds), udp_audio_max_samples);
+
+    int rx_sock = open_rx_socket(rx_addr);
+    if(rx_sock < 0)
+    {
+        return 1;
+    }
+
+    int tx_sock = -1;
+    sockaddr_in tx_sa;
+    if(!tx_addr.empty())
+    {
+        if(!udp_audio_parse_address(tx_addr, &tx_sa) || tx_sa.sin_addr.s_addr == htonl(INADDR_ANY))
+        {
+            fprintf(stderr, "expected -t host:port, not %s\n", tx_addr.c_str());
+            return 1;
+        }
+        tx_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if(tx_sock < 0)
+        {
+            fprintf(stderr, "socket: %s\n", strerror(errno));
+            return 1;
+        }
+    }
+
+    shm_audio_ring rx_ring;
+    shm_audio_ring tx_ring;
+    std::string rx_name = shm_audio_ring::shm_name(name, shm_audio_ring::RX);
+    std::string tx_name = shm_audio_ring::shm_name(name, shm_audio_ring::TX);
+    int err = rx_ring.create(rx_name, (uint32_t)rate, (uint32_t)(rate * ring_seconds));
+    if(err < 0)
+    {
+        fprintf(stderr, "%s: %s\n", rx_name.c_str(), strerror(-err));
+        return 1;
+    }
+    if(tx_sock >= 0 && (err = tx_ring.create(tx_name, (uint32_t)rate, (uint32_t)(rate * ring_seconds))) < 0)
+    {
+        fprintf(stderr, "%s: %s\n", tx_name.c_str(), strerror(-err));
+        return 1;
+    }
+    fprintf(stderr, "RX audio from udp:%s on %s%s\n", rx_addr.c_str(), rx_name.c_str(),
+            tx_sock >= 0 ? (", TX audio from "+tx_name+" to udp:"+tx_addr).c_str() : "");
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    jitter_buffer jitter(rate, 2 * packet_seconds, max_delay);
+    std::thread receiver(receive, rx_sock, (uint32_t)rate, &jitter);
+
+    gri_alsa_pack_t converter = gri_alsa_convert_best()->float_to_s16;
+    std::vector<float> samples(packet_samples);
+    std::vector<uint8_t> packet(udp_audio_header_size + packet_samples * sizeof(int16_t));
+    udp_audio_header_t header = { (uint16_t)packet_samples, 0, (uint32_t)rate, 0, 0 };
+    size_t start_frames = (size_t)(rate * start_seconds);
+    bool tx_running = false;
+    uint64_t tx_sent = 0;
+    uint64_t tx_errors = 0;
+    uint64_t passes = 0;
+    uint64_t report_passes = (uint64_t)(report_seconds / packet_seconds);
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long step_ns = (long)(packet_samples * 1e9 / rate);
+    while(running)
+    {
+        next.tv_nsec += step_ns;
+        if(next.tv_nsec >= 1000000000L)
+        {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        // receive: the jitter buffer pads what hasn't arrived with silence
+        jitter.read(&samples[0], packet_samples);
+        rx_ring.write(&samples[0], packet_samples);
+
+        // transmit: silence between bursts keeps the timestamps in step
+        if(tx_sock >= 0)
+        {
+            size_t nread = 0;
+            if(tx_running || tx_ring.readable() >= start_frames)
+            {
+                tx_running = true;
+                nread = tx_ring.read(&samples[0], packet_samples);
+            }
+            if(nread < packet_samples)
+            {
+                tx_running = false;
+                std::fill(samples.begin() + nread, samples.end(), 0.0f);
+            }
+
+            header.send_time = udp_audio_now();
+            udp_audio_pack_header(header, &packet[0]);
+            const float *in = &samples[0];
+            converter(&packet[udp_audio_header_size], &in, 1, packet_samples);
+            udp_audio_swap_s16(&packet[udp_audio_header_size], packet_samples);
+            if(sendto(tx_sock, &packet[0], packet.size(), MSG_DONTWAIT, (sockaddr *)&tx_sa, sizeof(tx_sa)) < 0)
+            {
+                tx_errors++;
+            }
+            else
+            {
+                tx_sent++;
+            }
+            header.seq++;
+            header.timestamp += packet_samples;
+        }
+
+        if(report_passes && 0 == ++passes % report_passes)
+        {
+            report(jitter.get_stats(), tx_sent, tx_errors);
+        }
+    }
+
+    receiver.join();
+    report(jitter.get_stats(), tx_sent, tx_errors);
+    close(rx_sock);
+    if(tx_sock >= 0)
+    {
+        close(tx_sock);
+    }
+    return 0;
+}
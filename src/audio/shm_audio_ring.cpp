@@ -0,0 +1,370 @@
+/**-------------------------------------------------------------------------
+ * @file shm_audio_ring.cpp
+ * @brief single producer, single consumer audio ring in shared memory
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/shm_audio_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// both processes map the same counters; they must not hide a lock
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shm_audio_ring needs lock free 64 bit atomics");
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+const uint32_t shm_audio_ring::magic = 0x73644152; // "RAds"
+const uint32_t shm_audio_ring::version = 1;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     shm_audio_ring
+ */
+shm_audio_ring::shm_audio_ring()
+    : m_header(nullptr),
+      m_data(nullptr),
+      m_size(0),
+      m_owner(false),
+      m_rate(0),
+      m_capacity(0)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~shm_audio_ring
+ */
+shm_audio_ring::~shm_audio_ring()
+{
+    close();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     shm_name
+ */
+std::string shm_audio_ring::shm_name(const std::string &name, direction_t dir)
+{
+    // shm names are one path component
+    std::string clean = name.empty() ? "default" : name;
+    std::replace(clean.begin(), clean.end(), '/', '_');
+    return "/sdr_ctld." + clean + (dir == RX ? ".rx" : ".tx");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     create
+ */
+int shm_audio_ring::create(const std::string &shm_name, uint32_t rate, uint32_t min_frames)
+{
+    close();
+
+    uint32_t capacity = 1;
+    while(capacity < min_frames)
+    {
+        capacity <<= 1;
+    }
+
+    // a ring left by a crashed run may be the wrong size; start over
+    shm_unlink(shm_name.c_str());
+    // the decoder writes TX audio here, so only our user and group may open it
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+    if(fd < 0)
+    {
+        return -errno;
+    }
+    // the umask may have taken the group bits away
+    fchmod(fd, 0660);
+
+    size_t size = sizeof(header_t) + capacity * sizeof(float);
+    if(ftruncate(fd, size) < 0)
+    {
+        int err = errno;
+        ::close(fd);
+        shm_unlink(shm_name.c_str());
+        return -err;
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED)
+    {
+        int err = errno;
+        shm_unlink(shm_name.c_str());
+        return -err;
+    }
+
+    m_header = new (addr) header_t;
+    m_header->rate = rate;
+    m_header->capacity = capacity;
+    m_header->write_pos = 0;
+    m_header->read_pos = 0;
+    m_header->overruns = 0;
+    m_header->underruns = 0;
+    m_header->skips = 0;
+    m_header->latency_us = 0;
+    m_header->max_latency_us = 0;
+    m_header->version = version;
+    // publish last so attach() never sees a half built header
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = magic;
+
+    m_data = (float *)(m_header + 1);
+    m_size = size;
+    m_name = shm_name;
+    m_owner = true;
+    m_rate = rate;
+    m_capacity = capacity;
+    return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     attach
+ */
+int shm_audio_ring::attach(const std::string &shm_name)
+{
+    close();
+
+    int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+    if(fd < 0)
+    {
+        return -errno;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(header_t))
+    {
+        ::close(fd);
+        return -EINVAL;
+    }
+
+    size_t size = st.st_size;
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED)
+    {
+        return -errno;
+    }
+
+    header_t *header = (header_t *)addr;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // the other side can write the header at any time; take the geometry
+    // once, check it, and never read it from the ring again
+    uint32_t rate = header->rate;
+    uint32_t capacity = header->capacity;
+    if(header->magic != magic || header->version != version ||
+       0 == rate || 0 == capacity || 0 != (capacity & (capacity - 1)) ||
+       sizeof(header_t) + (size_t)capacity * sizeof(float) > size)
+    {
+        munmap(addr, size);
+        return -EPROTO;
+    }
+
+    m_header = header;
+    m_rate = rate;
+    m_capacity = capacity;
+    m_data = (float *)(m_header + 1);
+    m_size = size;
+    m_name = shm_name;
+    m_owner = false;
+    return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     close
+ */
+void shm_audio_ring::close()
+{
+    if(m_header != nullptr)
+    {
+        munmap(m_header, m_size);
+        if(m_owner)
+        {
+            shm_unlink(m_name.c_str());
+        }
+    }
+    m_header = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_owner = false;
+    m_rate = 0;
+    m_capacity = 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     writable
+ */
+size_t shm_audio_ring::writable() const
+{
+    uint64_t wr = m_header->write_pos.load(std::memory_order_relaxed);
+    uint64_t rd = m_header->read_pos.load(std::memory_order_acquire);
+    // a reader that moved read_pos past write_pos, or too far back, gets nothing
+    uint64_t queued = wr - rd;
+    return queued > m_capacity ? 0 : m_capacity - (size_t)queued;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     write_ptr
+ */
+float *shm_audio_ring::write_ptr(size_t *nframes)
+{
+    uint64_t wr = m_header->write_pos.load(std::memory_order_relaxed);
+    size_t index = wr & (m_capacity - 1);
+    *nframes = std::min(std::min(*nframes, writable()), (size_t)m_capacity - index);
+    return m_data + index;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     write_commit
+ */
+void shm_audio_ring::write_commit(size_t nframes)
+{
+    m_header->write_pos.fetch_add(nframes, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     write
+ */
+size_t shm_audio_ring::write(const float *in, size_t nframes)
+{
+    size_t done = 0;
+    // at most twice, once on each side of the wrap
+    while(done < nframes)
+    {
+        size_t n = nframes - done;
+        float *dst = write_ptr(&n);
+        if(n == 0)
+        {
+            break;
+        }
+        memcpy(dst, in + done, n * sizeof(float));
+        write_commit(n);
+        done += n;
+    }
+
+    if(done < nframes)
+    {
+        m_header->overruns.fetch_add(nframes - done, std::memory_order_relaxed);
+    }
+    return done;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     readable
+ */
+size_t shm_audio_ring::readable() const
+{
+    uint64_t wr = m_header->write_pos.load(std::memory_order_acquire);
+    uint64_t rd = m_header->read_pos.load(std::memory_order_relaxed);
+    return (size_t)std::min<uint64_t>(wr - rd, m_capacity);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read_ptr
+ */
+const float *shm_audio_ring::read_ptr(size_t *nframes)
+{
+    uint64_t rd = m_header->read_pos.load(std::memory_order_relaxed);
+    size_t index = rd & (m_capacity - 1);
+    *nframes = std::min(std::min(*nframes, readable()), (size_t)m_capacity - index);
+    return m_data + index;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read_commit
+ */
+void shm_audio_ring::read_commit(size_t nframes)
+{
+    m_header->read_pos.fetch_add(nframes, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read
+ */
+size_t shm_audio_ring::read(float *out, size_t nframes)
+{
+    note_latency();
+
+    size_t done = 0;
+    while(done < nframes)
+    {
+        size_t n = nframes - done;
+        const float *src = read_ptr(&n);
+        if(n == 0)
+        {
+            break;
+        }
+        memcpy(out + done, src, n * sizeof(float));
+        read_commit(n);
+        done += n;
+    }
+    return done;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     trim
+ */
+size_t shm_audio_ring::trim(size_t max_frames)
+{
+    size_t queued = readable();
+    if(queued <= max_frames)
+    {
+        return 0;
+    }
+
+    size_t drop = queued - max_frames;
+    read_commit(drop);
+    m_header->skips.fetch_add(drop, std::memory_order_relaxed);
+    return drop;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     note_latency
+ */
+void shm_audio_ring::note_latency()
+{
+    uint32_t latency_us = (uint32_t)(readable() * 1000000ull / m_rate);
+    m_header->latency_us.store(latency_us, std::memory_order_relaxed);
+    if(latency_us > m_header->max_latency_us.load(std::memory_order_relaxed))
+    {
+        m_header->max_latency_us.store(latency_us, std::memory_order_relaxed);
+    }
+}
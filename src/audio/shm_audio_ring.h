@@ -0,0 +1,208 @@
+/**-------------------------------------------------------------------------
+ * @file shm_audio_ring.h
+ * @brief single producer, single consumer audio ring in shared memory
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SHM_AUDIO_RING_H__
+#define __SHM_AUDIO_RING_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Mono float audio ring in a POSIX shared memory object.  sdr_ctld
+ * creates one ring per direction and the ALSA plugin (pcm_sdr_ctld.cpp)
+ * attaches to it, so samples cross between the processes with a copy in
+ * and a copy out and no trip through the kernel.
+ *
+ * The writer only moves write_pos and the reader only moves read_pos.
+ * Neither side blocks: a full ring drops the newest samples (overrun),
+ * and the reader may drop the oldest to keep its latency bounded (skip).
+ *
+ * The ring is open to sdr_ctld's user and group only.  The rate and
+ * capacity are copied out of the header at create() or attach() and the
+ * positions are clamped to the capacity, so a bad header can't move a
+ * copy outside the ring.
+ *
+ * This file is built into both sdr_ctld and the ALSA plugin, so it must
+ * not depend on the Logger or GNU Radio.
+ */
+class shm_audio_ring
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    static const uint32_t magic;
+    static const uint32_t version;
+
+    /** which way the audio goes, from sdr_ctld's side */
+    enum {
+        RX = 0,     // sdr_ctld writes, the decoder reads
+        TX = 1      // the decoder writes, sdr_ctld reads
+    } typedef direction_t;
+
+    /** lives at the start of the shared memory, the samples follow */
+    struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t rate;
+        uint32_t capacity;                  // frames, a power of two
+        alignas(64) std::atomic<uint64_t> write_pos;
+        alignas(64) std::atomic<uint64_t> read_pos;
+        alignas(64) std::atomic<uint64_t> overruns;  // frames the writer dropped
+        std::atomic<uint64_t> underruns;    // frames the reader padded
+        std::atomic<uint64_t> skips;        // frames the reader dropped
+        std::atomic<uint32_t> latency_us;   // queued ahead of the last read
+        std::atomic<uint32_t> max_latency_us;
+    } typedef header_t;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Constructor
+     *
+     */
+    shm_audio_ring();
+
+    /** @brief Deconstructor, unmaps and removes the ring if we created it
+     *
+     */
+    ~shm_audio_ring();
+
+    /** @brief name of the shared memory object for a ring
+     *
+     * @param name - the part after "shm:" in the device name
+     * @param dir - direction of the audio
+     * @return std::string - ex: "/sdr_ctld.default.rx"
+     */
+    static std::string shm_name(const std::string &name, direction_t dir);
+
+    /** @brief create (or take over) the ring
+     *
+     * @param shm_name - name from shm_name()
+     * @param rate - sample rate
+     * @param min_frames - rounded up to a power of two
+     * @return int - 0 or -errno
+     */
+    int create(const std::string &shm_name, uint32_t rate, uint32_t min_frames);
+
+    /** @brief attach to a ring made by create()
+     *
+     * @param shm_name - name from shm_name()
+     * @return int - 0 or -errno
+     */
+    int attach(const std::string &shm_name);
+
+    /** @brief unmap, and remove the ring if we created it
+     *
+     * @return Void.
+     */
+    void close();
+
+    bool is_open() const { return m_header != nullptr; }
+    uint32_t get_rate() const { return m_rate; }
+    uint32_t get_capacity() const { return m_capacity; }
+    header_t *get_header() const { return m_header; }
+
+    /** @brief frames that can be written without overrunning
+     *
+     * @return size_t
+     */
+    size_t writable() const;
+
+    /** @brief contiguous space at the write position
+     *
+     * @param nframes - in: frames wanted, out: frames available
+     * @return float* - where to put them
+     */
+    float *write_ptr(size_t *nframes);
+
+    /** @brief publish frames put at write_ptr()
+     *
+     * @param nframes - frames written
+     * @return Void.
+     */
+    void write_commit(size_t nframes);
+
+    /** @brief copy in as much as fits; the rest counts as an overrun
+     *
+     * @param in - samples
+     * @param nframes - number of samples
+     * @return size_t - frames written
+     */
+    size_t write(const float *in, size_t nframes);
+
+    /** @brief frames waiting to be read
+     *
+     * @return size_t
+     */
+    size_t readable() const;
+
+    /** @brief contiguous frames at the read position
+     *
+     * @param nframes - in: frames wanted, out: frames available
+     * @return const float* - where they are
+     */
+    const float *read_ptr(size_t *nframes);
+
+    /** @brief release frames taken from read_ptr()
+     *
+     * @param nframes - frames read
+     * @return Void.
+     */
+    void read_commit(size_t nframes);
+
+    /** @brief copy out up to nframes, measuring the latency as we go
+     *
+     * @param out - samples
+     * @param nframes - number of samples wanted
+     * @return size_t - frames read
+     */
+    size_t read(float *out, size_t nframes);
+
+    /** @brief drop the oldest frames so no more than max_frames are queued
+     *
+     * @param max_frames - queue limit
+     * @return size_t - frames dropped
+     */
+    size_t trim(size_t max_frames);
+
+    /** @brief record how far behind the reader is, before a read
+     *
+     * @return Void.
+     */
+    void note_latency();
+
+private:
+    header_t *m_header;
+    float *m_data;
+    size_t m_size;          // bytes mapped
+    std::string m_name;
+    bool m_owner;
+    uint32_t m_rate;
+    uint32_t m_capacity;    // a power of two
+};
+
+#endif /* __SHM_AUDIO_RING_H__ */
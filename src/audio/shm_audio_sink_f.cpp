@@ -0,0 +1,148 @@
+/**-------------------------------------------------------------------------
+ * @file shm_audio_sink_f.cpp
+ * @brief send RX audio to the shared memory ring
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/shm_audio_sink_f.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <cstring>
+#include <stdexcept>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// a second of audio; the plugin trims it to its own latency
+static const double ring_seconds = 1.0;
+// log the ring statistics this often, in seconds of audio
+static const double report_seconds = 10.0;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+shm_audio_sink_f::sptr shm_audio_sink_f::make(const std::string &name, double rate)
+{
+    return gnuradio::get_initial_sptr(new shm_audio_sink_f(name, rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     shm_audio_sink_f
+ */
+shm_audio_sink_f::shm_audio_sink_f(const std::string &name, double rate)
+    : gr::sync_block("shm_audio_sink_f",
+          gr::io_signature::make(1, 1, sizeof(float)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_report_at(0),
+      m_read_pos(0)
+{
+    std::string shm_name = shm_audio_ring::shm_name(name, shm_audio_ring::RX);
+    int err = m_ring.create(shm_name, (uint32_t)rate, (uint32_t)(rate * ring_seconds));
+    if(err < 0)
+    {
+        Logger::crit("[shm_audio_sink_f::shm_audio_sink_f] "+shm_name+": "+strerror(-err));
+        throw std::runtime_error("shm_audio_sink_f");
+    }
+    m_report_at = (uint64_t)(rate * report_seconds);
+    Logger::info("[shm_audio_sink_f::shm_audio_sink_f] RX audio on "+shm_name+", "+std::to_string(m_ring.get_capacity())+" frames");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~shm_audio_sink_f
+ */
+shm_audio_sink_f::~shm_audio_sink_f()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_latency
+ */
+double shm_audio_sink_f::get_latency() const
+{
+    return m_ring.get_header()->latency_us.load() * 1e-6;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool shm_audio_sink_f::stop()
+{
+    report(true);
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     report
+ */
+void shm_audio_sink_f::report(bool always)
+{
+    shm_audio_ring::header_t *h = m_ring.get_header();
+    uint64_t read_pos = h->read_pos.load();
+    bool reading = read_pos != m_read_pos;
+    m_read_pos = read_pos;
+
+    // an unread ring overruns all the time; that's not news
+    if(!reading && !always)
+    {
+        return;
+    }
+
+    std::string stats = "latency "+std::to_string(h->latency_us.load() / 1000.0)+" ms"
+        +", max "+std::to_string(h->max_latency_us.load() / 1000.0)+" ms"
+        +", overruns "+std::to_string(h->overruns.load())
+        +", skips "+std::to_string(h->skips.load());
+    if(always)
+    {
+        Logger::info("[shm_audio_sink_f::report] "+stats);
+    }
+    else
+    {
+        Logger::debug("[shm_audio_sink_f::report] "+stats);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int shm_audio_sink_f::work(int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items)
+{
+    const float *in = (const float *)input_items[0];
+
+    m_ring.write(in, noutput_items);
+
+    if(m_ring.get_header()->write_pos.load() >= m_report_at)
+    {
+        m_report_at += (uint64_t)(m_ring.get_rate() * report_seconds);
+        report(false);
+    }
+
+    return noutput_items;
+}
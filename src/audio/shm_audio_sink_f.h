@@ -0,0 +1,93 @@
+/**-------------------------------------------------------------------------
+ * @file shm_audio_sink_f.h
+ * @brief send RX audio to the shared memory ring
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SHM_AUDIO_SINK_F_H__
+#define __SHM_AUDIO_SINK_F_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/shm_audio_ring.h"
+#include <gnuradio/sync_block.h>
+
+class shm_audio_sink_f;
+
+/**
+ * Writes the receiver's audio into a shared memory ring for the
+ * sdr_ctld ALSA plugin, in place of the ALSA sink and loopback device.
+ * The SDR sample clock paces both ends, so no drift resampler is needed.
+ * Never blocks the receiver; if nobody is reading the ring just fills
+ * and the newest samples are dropped.
+ */
+class shm_audio_sink_f : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the shared memory sink */
+    typedef boost::shared_ptr<shm_audio_sink_f> sptr;
+
+    static sptr make(const std::string &name, double rate);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param name - ring name, the part after "shm:"
+     * @param rate - audio rate
+     */
+    shm_audio_sink_f(const std::string &name, double rate);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~shm_audio_sink_f();
+
+    /** @brief latency the plugin saw on its last read
+     *
+     * @return double - seconds
+     */
+    double get_latency() const;
+
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    shm_audio_ring m_ring;
+    uint64_t m_report_at;   // write_pos of the next stats report
+    uint64_t m_read_pos;    // read_pos at the last report
+
+    /** @brief log the ring statistics if the plugin is reading
+     *
+     * @param always - log even if nothing went wrong
+     * @return Void.
+     */
+    void report(bool always);
+};
+
+#endif /* __SHM_AUDIO_SINK_F_H__ */
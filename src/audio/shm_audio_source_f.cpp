@@ -0,0 +1,136 @@
+/**-------------------------------------------------------------------------
+ * @file shm_audio_source_f.cpp
+ * @brief take TX audio from the shared memory ring
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/shm_audio_source_f.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// room for the decoder to write ahead
+static const double ring_seconds = 1.0;
+// queue this much before starting a burst
+static const double start_seconds = 0.02;
+// hand out audio in pieces this big, so a gap costs at most this much
+static const double chunk_seconds = 0.01;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+shm_audio_source_f::sptr shm_audio_source_f::make(const std::string &name, double rate, double max_latency)
+{
+    return gnuradio::get_initial_sptr(new shm_audio_source_f(name, rate, max_latency));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     shm_audio_source_f
+ */
+shm_audio_source_f::shm_audio_source_f(const std::string &name, double rate, double max_latency)
+    : gr::sync_block("shm_audio_source_f",
+          gr::io_signature::make(0, 0, 0),// input_signature
+          gr::io_signature::make(1, 1, sizeof(float))),// output_signature
+      m_max_frames((size_t)(rate * max_latency)),
+      m_start_frames((size_t)(rate * start_seconds)),
+      m_running(false)
+{
+    std::string shm_name = shm_audio_ring::shm_name(name, shm_audio_ring::TX);
+    int err = m_ring.create(shm_name, (uint32_t)rate, (uint32_t)(rate * ring_seconds));
+    if(err < 0)
+    {
+        Logger::crit("[shm_audio_source_f::shm_audio_source_f] "+shm_name+": "+strerror(-err));
+        throw std::runtime_error("shm_audio_source_f");
+    }
+    set_max_noutput_items((int)(rate * chunk_seconds));
+    Logger::info("[shm_audio_source_f::shm_audio_source_f] TX audio on "+shm_name+", "+std::to_string(m_ring.get_capacity())+" frames");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~shm_audio_source_f
+ */
+shm_audio_source_f::~shm_audio_source_f()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_latency
+ */
+double shm_audio_source_f::get_latency() const
+{
+    return m_ring.get_header()->latency_us.load() * 1e-6;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool shm_audio_source_f::stop()
+{
+    shm_audio_ring::header_t *h = m_ring.get_header();
+    Logger::info("[shm_audio_source_f::stop] latency "+std::to_string(h->latency_us.load() / 1000.0)+" ms"
+        +", max "+std::to_string(h->max_latency_us.load() / 1000.0)+" ms"
+        +", underruns "+std::to_string(h->underruns.load())
+        +", skips "+std::to_string(h->skips.load()));
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int shm_audio_source_f::work(int noutput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items)
+{
+    float *out = (float *)output_items[0];
+
+    m_ring.trim(m_max_frames);
+    size_t nread = 0;
+    if(m_running || m_ring.readable() >= m_start_frames)
+    {
+        m_running = true;
+        nread = m_ring.read(out, noutput_items);
+    }
+
+    if(nread < (size_t)noutput_items)
+    {
+        // the end of a burst counts too; the count is of padded frames
+        if(m_running)
+        {
+            m_ring.get_header()->underruns.fetch_add(noutput_items - nread);
+        }
+        m_running = false;
+        std::fill(out + nread, out + noutput_items, 0.0f);
+    }
+
+    return noutput_items;
+}
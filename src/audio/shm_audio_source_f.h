@@ -0,0 +1,87 @@
+/**-------------------------------------------------------------------------
+ * @file shm_audio_source_f.h
+ * @brief take TX audio from the shared memory ring
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SHM_AUDIO_SOURCE_F_H__
+#define __SHM_AUDIO_SOURCE_F_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/shm_audio_ring.h"
+#include <gnuradio/sync_block.h>
+
+class shm_audio_source_f;
+
+/**
+ * Reads the audio the sdr_ctld ALSA plugin writes for transmit.  The SDR
+ * sink paces the transmitter, so when the ring is empty this makes
+ * silence instead of waiting.  A new burst is held back until a little
+ * audio has queued up, which rides out the decoder's write jitter.
+ */
+class shm_audio_source_f : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the shared memory source */
+    typedef boost::shared_ptr<shm_audio_source_f> sptr;
+
+    static sptr make(const std::string &name, double rate, double max_latency = 0.1);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param name - ring name, the part after "shm:"
+     * @param rate - audio rate
+     * @param max_latency - older audio than this is dropped, in seconds
+     */
+    shm_audio_source_f(const std::string &name, double rate, double max_latency);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~shm_audio_source_f();
+
+    /** @brief latency on the last read
+     *
+     * @return double - seconds
+     */
+    double get_latency() const;
+
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    shm_audio_ring m_ring;
+    size_t m_max_frames;    // trim the ring to this
+    size_t m_start_frames;  // queued audio needed to start a burst
+    bool m_running;
+};
+
+#endif /* __SHM_AUDIO_SOURCE_F_H__ */
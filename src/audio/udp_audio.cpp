@@ -0,0 +1,176 @@
+/**-------------------------------------------------------------------------
+ * @file udp_audio.cpp
+ * @brief packet format of the network audio streams
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/udp_audio.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+static const uint32_t magic = 0x53445241; // "SDRA"
+static const uint8_t version = 1;
+static const uint8_t format_s16le = 1;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_be
+ */
+static void put_be(uint8_t *buf, uint64_t value, int nbytes)
+{
+    for(int i = nbytes - 1; i >= 0; i--)
+    {
+        buf[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_be
+ */
+static uint64_t get_be(const uint8_t *buf, int nbytes)
+{
+    uint64_t value = 0;
+    for(int i = 0; i < nbytes; i++)
+    {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_pack_header
+ */
+void udp_audio_pack_header(const udp_audio_header_t &header, uint8_t *buf)
+{
+    put_be(buf, magic, 4);
+    buf[4] = version;
+    buf[5] = format_s16le;
+    put_be(buf + 6, header.nsamples, 2);
+    put_be(buf + 8, header.seq, 4);
+    put_be(buf + 12, header.rate, 4);
+    put_be(buf + 16, header.timestamp, 8);
+    put_be(buf + 24, header.send_time, 8);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_unpack_header
+ */
+bool udp_audio_unpack_header(const uint8_t *buf, size_t len, udp_audio_header_t *header)
+{
+    if(len < udp_audio_header_size || get_be(buf, 4) != magic ||
+       buf[4] != version || buf[5] != format_s16le)
+    {
+        return false;
+    }
+
+    header->nsamples = (uint16_t)get_be(buf + 6, 2);
+    header->seq = (uint32_t)get_be(buf + 8, 4);
+    header->rate = (uint32_t)get_be(buf + 12, 4);
+    header->timestamp = get_be(buf + 16, 8);
+    header->send_time = get_be(buf + 24, 8);
+
+    return header->nsamples <= udp_audio_max_samples &&
+           len >= udp_audio_header_size + header->nsamples * sizeof(int16_t);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_swap_s16
+ */
+void udp_audio_swap_s16(uint8_t *buf, size_t nsamples)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for(size_t i = 0; i < nsamples; i++)
+    {
+        std::swap(buf[2 * i], buf[2 * i + 1]);
+    }
+#else
+    (void)buf;
+    (void)nsamples;
+#endif
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_parse_address
+ */
+bool udp_audio_parse_address(const std::string &addr, sockaddr_in *sa)
+{
+    memset(sa, 0, sizeof(*sa));
+    sa->sin_family = AF_INET;
+    sa->sin_addr.s_addr = htonl(INADDR_ANY);
+
+    std::string host;
+    std::string port = addr;
+    std::size_t colon = addr.rfind(':');
+    if(colon != std::string::npos)
+    {
+        host = addr.substr(0, colon);
+        port = addr.substr(colon + 1);
+    }
+
+    char *end = nullptr;
+    long port_num = strtol(port.c_str(), &end, 10);
+    if(port.empty() || *end != '\0' || port_num < 1 || port_num > 65535)
+    {
+        return false;
+    }
+    sa->sin_port = htons((uint16_t)port_num);
+
+    if(!host.empty())
+    {
+        struct addrinfo hints;
+        struct addrinfo *res = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        if(getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr)
+        {
+            return false;
+        }
+        sa->sin_addr = ((sockaddr_in *)res->ai_addr)->sin_addr;
+        freeaddrinfo(res);
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_now
+ */
+uint64_t udp_audio_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
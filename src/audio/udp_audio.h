@@ -0,0 +1,111 @@
+/**-------------------------------------------------------------------------
+ * @file udp_audio.h
+ * @brief packet format of the network audio streams
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __UDP_AUDIO_H__
+#define __UDP_AUDIO_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <netinet/in.h>
+
+/*
+ * Each UDP datagram is a 32 byte header followed by mono signed 16 bit
+ * little endian samples.  The header is in network byte order:
+ *
+ *   offset  size  field
+ *        0     4  magic, "SDRA"
+ *        4     1  version, 1
+ *        5     1  format, 1 = S16_LE
+ *        6     2  number of samples
+ *        8     4  sequence number, +1 per packet
+ *       12     4  sample rate
+ *       16     8  timestamp, in samples, of the first sample
+ *       24     8  send time, ns since the epoch (CLOCK_REALTIME)
+ *
+ * The receiver orders and times playout by the timestamp, counts loss
+ * by the sequence number, and measures delay from the send time, which
+ * is only meaningful if both hosts run NTP.
+ */
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+struct {
+    uint16_t nsamples;
+    uint32_t seq;
+    uint32_t rate;
+    uint64_t timestamp;
+    uint64_t send_time;     // ns
+} typedef udp_audio_header_t;
+
+/** bytes in a header on the wire */
+const size_t udp_audio_header_size = 32;
+/** most samples in a packet; the largest that fits a 1500 byte MTU */
+const size_t udp_audio_max_samples = 720;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+/** @brief write a header to the start of a packet
+ *
+ * @param header - fields to write
+ * @param buf - at least udp_audio_header_size bytes
+ * @return Void.
+ */
+void udp_audio_pack_header(const udp_audio_header_t &header, uint8_t *buf);
+
+/** @brief check and read the header of a received packet
+ *
+ * @param buf - the packet
+ * @param len - bytes received
+ * @param header - the fields read
+ * @return bool - false if this isn't one of our packets
+ */
+bool udp_audio_unpack_header(const uint8_t *buf, size_t len, udp_audio_header_t *header);
+
+/** @brief swap native S16 samples to S16_LE, or back; a no-op on little
+ *  endian hosts
+ *
+ * @param buf - the samples, in place
+ * @param nsamples - how many
+ * @return Void.
+ */
+void udp_audio_swap_s16(uint8_t *buf, size_t nsamples);
+
+/** @brief parse "host:port" or "port"
+ *
+ * @param addr - the part after "udp:"
+ * @param sa - filled in; host defaults to INADDR_ANY
+ * @return bool - false if it doesn't parse or the host isn't found
+ */
+bool udp_audio_parse_address(const std::string &addr, sockaddr_in *sa);
+
+/** @brief CLOCK_REALTIME in ns
+ *
+ * @return uint64_t
+ */
+uint64_t udp_audio_now();
+
+#endif /* __UDP_AUDIO_H__ */
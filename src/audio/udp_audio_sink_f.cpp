@@ -0,0 +1,186 @@
+/**-------------------------------------------------------------------------
+ * @file udp_audio_sink_f.cpp
+ * @brief send RX audio over the network
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/udp_audio_sink_f.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// audio per packet
+static const double packet_seconds = 0.01;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+udp_audio_sink_f::sptr udp_audio_sink_f::make(const std::string &addr, double rate)
+{
+    return gnuradio::get_initial_sptr(new udp_audio_sink_f(addr, rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_sink_f
+ */
+udp_audio_sink_f::udp_audio_sink_f(const std::string &addr, double rate)
+    : gr::sync_block("udp_audio_sink_f",
+          gr::io_signature::make(1, 1, sizeof(float)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_sock(-1),
+      m_rate((uint32_t)rate),
+      m_packet_samples(std::min((size_t)(rate * packet_seconds), udp_audio_max_samples)),
+      m_seq(0),
+      m_timestamp(0),
+      m_last_errno(0),
+      m_converter(gri_alsa_convert_best()->float_to_s16),
+      m_sent(0),
+      m_send_errors(0)
+{
+    if(!udp_audio_parse_address(addr, &m_addr) || m_addr.sin_addr.s_addr == htonl(INADDR_ANY))
+    {
+        Logger::crit("[udp_audio_sink_f::udp_audio_sink_f] expected udp:host:port, not udp:"+addr);
+        throw std::runtime_error("udp_audio_sink_f");
+    }
+
+    m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if(m_sock < 0)
+    {
+        Logger::crit("[udp_audio_sink_f::udp_audio_sink_f] socket: "+std::string(strerror(errno)));
+        throw std::runtime_error("udp_audio_sink_f");
+    }
+
+    m_samples.reserve(m_packet_samples);
+    m_packet.resize(udp_audio_header_size + m_packet_samples * sizeof(int16_t));
+    Logger::info("[udp_audio_sink_f::udp_audio_sink_f] RX audio to udp:"+addr+", "+std::to_string(m_packet_samples)+" samples per packet");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~udp_audio_sink_f
+ */
+udp_audio_sink_f::~udp_audio_sink_f()
+{
+    if(m_sock >= 0)
+    {
+        close(m_sock);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_sent
+ */
+uint64_t udp_audio_sink_f::get_sent() const
+{
+    return m_sent;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_send_errors
+ */
+uint64_t udp_audio_sink_f::get_send_errors() const
+{
+    return m_send_errors;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool udp_audio_sink_f::stop()
+{
+    Logger::info("[udp_audio_sink_f::stop] sent "+std::to_string(m_sent)+" packets, "+std::to_string(m_send_errors)+" send errors");
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     send_packet
+ */
+void udp_audio_sink_f::send_packet()
+{
+    udp_audio_header_t header;
+    header.nsamples = (uint16_t)m_samples.size();
+    header.seq = m_seq++;
+    header.rate = m_rate;
+    header.timestamp = m_timestamp;
+    header.send_time = udp_audio_now();
+    m_timestamp += m_samples.size();
+
+    udp_audio_pack_header(header, &m_packet[0]);
+    const float *in = &m_samples[0];
+    m_converter(&m_packet[udp_audio_header_size], &in, 1, m_samples.size());
+    // the s16 kernel writes native order; the wire is S16_LE
+    udp_audio_swap_s16(&m_packet[udp_audio_header_size], m_samples.size());
+    m_samples.clear();
+
+    size_t len = udp_audio_header_size + header.nsamples * sizeof(int16_t);
+    if(sendto(m_sock, &m_packet[0], len, MSG_DONTWAIT, (sockaddr *)&m_addr, sizeof(m_addr)) < 0)
+    {
+        m_send_errors++;
+        // say so once, not a hundred times a second
+        if(errno != m_last_errno)
+        {
+            Logger::warn("[udp_audio_sink_f::send_packet] "+std::string(strerror(errno)));
+        }
+        m_last_errno = errno;
+        return;
+    }
+    m_last_errno = 0;
+    m_sent++;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int udp_audio_sink_f::work(int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items)
+{
+    const float *in = (const float *)input_items[0];
+
+    for(int i = 0; i < noutput_items; )
+    {
+        size_t n = std::min(m_packet_samples - m_samples.size(), (size_t)(noutput_items - i));
+        m_samples.insert(m_samples.end(), in + i, in + i + n);
+        i += n;
+        if(m_samples.size() == m_packet_samples)
+        {
+            send_packet();
+        }
+    }
+
+    return noutput_items;
+}
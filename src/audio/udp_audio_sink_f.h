@@ -0,0 +1,108 @@
+/**-------------------------------------------------------------------------
+ * @file udp_audio_sink_f.h
+ * @brief send RX audio over the network
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __UDP_AUDIO_SINK_F_H__
+#define __UDP_AUDIO_SINK_F_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/alsa_convert.h"
+#include "audio/udp_audio.h"
+#include <gnuradio/sync_block.h>
+#include <atomic>
+#include <vector>
+
+class udp_audio_sink_f;
+
+/**
+ * Sends the receiver's audio as udp_audio packets to a fixed host and
+ * port, which may be a multicast group.  Sends never block the
+ * receiver; a packet the socket won't take counts as a send error.
+ */
+class udp_audio_sink_f : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the network sink */
+    typedef boost::shared_ptr<udp_audio_sink_f> sptr;
+
+    static sptr make(const std::string &addr, double rate);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param addr - "host:port", the part after "udp:"
+     * @param rate - audio rate
+     */
+    udp_audio_sink_f(const std::string &addr, double rate);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~udp_audio_sink_f();
+
+    /** @brief packets sent so far
+     *
+     * @return uint64_t
+     */
+    uint64_t get_sent() const;
+
+    /** @brief packets the socket refused
+     *
+     * @return uint64_t
+     */
+    uint64_t get_send_errors() const;
+
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    int m_sock;
+    sockaddr_in m_addr;
+    uint32_t m_rate;
+    size_t m_packet_samples;
+    std::vector<float> m_samples;   // the packet being filled
+    std::vector<uint8_t> m_packet;
+    uint32_t m_seq;
+    uint64_t m_timestamp;
+    int m_last_errno;
+    gri_alsa_pack_t m_converter;
+    std::atomic<uint64_t> m_sent;
+    std::atomic<uint64_t> m_send_errors;
+
+    /** @brief send the samples gathered so far
+     *
+     * @return Void.
+     */
+    void send_packet();
+};
+
+#endif /* __UDP_AUDIO_SINK_F_H__ */
@@ -0,0 +1,202 @@
+/**-------------------------------------------------------------------------
+ * @file udp_audio_source_f.cpp
+ * @brief take TX audio from the network
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/udp_audio_source_f.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// how often the receive thread checks for stop()
+static const int poll_ms = 100;
+// hand out audio in pieces this big, so a gap costs at most this much
+static const double chunk_seconds = 0.01;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+udp_audio_source_f::sptr udp_audio_source_f::make(const std::string &addr, double rate, double max_delay)
+{
+    return gnuradio::get_initial_sptr(new udp_audio_source_f(addr, rate, max_delay));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     udp_audio_source_f
+ */
+udp_audio_source_f::udp_audio_source_f(const std::string &addr, double rate, double max_delay)
+    : gr::sync_block("udp_audio_source_f",
+          gr::io_signature::make(0, 0, 0),// input_signature
+          gr::io_signature::make(1, 1, sizeof(float))),// output_signature
+      m_sock(-1),
+      m_rate((uint32_t)rate),
+      m_jitter(rate, 2 * chunk_seconds, max_delay),
+      m_converter(gri_alsa_convert_best()->s16_to_float),
+      m_running(false)
+{
+    sockaddr_in sa;
+    if(!udp_audio_parse_address(addr, &sa))
+    {
+        Logger::crit("[udp_audio_source_f::udp_audio_source_f] expected udp:[host:]port, not udp:"+addr);
+        throw std::runtime_error("udp_audio_source_f");
+    }
+
+    m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int opt = 1;
+    struct timeval tv = { 0, poll_ms * 1000 };
+    if(m_sock < 0 ||
+       0 != setsockopt(m_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+       0 != setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) ||
+       0 > bind(m_sock, (sockaddr *)&sa, sizeof(sa)))
+    {
+        Logger::crit("[udp_audio_source_f::udp_audio_source_f] udp:"+addr+": "+std::string(strerror(errno)));
+        if(m_sock >= 0)
+        {
+            close(m_sock);
+        }
+        throw std::runtime_error("udp_audio_source_f");
+    }
+
+    set_max_noutput_items((int)(rate * chunk_seconds));
+    Logger::info("[udp_audio_source_f::udp_audio_source_f] TX audio from udp:"+addr);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~udp_audio_source_f
+ */
+udp_audio_source_f::~udp_audio_source_f()
+{
+    stop();
+    close(m_sock);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_stats
+ */
+jitter_buffer::stats_t udp_audio_source_f::get_stats()
+{
+    return m_jitter.get_stats();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     start
+ */
+bool udp_audio_source_f::start()
+{
+    if(!m_running)
+    {
+        m_running = true;
+        m_thread = std::thread(&udp_audio_source_f::receive, this);
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool udp_audio_source_f::stop()
+{
+    if(m_running)
+    {
+        m_running = false;
+        m_thread.join();
+
+        jitter_buffer::stats_t stats = m_jitter.get_stats();
+        Logger::info("[udp_audio_source_f::stop] received "+std::to_string(stats.received)
+            +", lost "+std::to_string(stats.lost)
+            +", late "+std::to_string(stats.late)
+            +", delay "+std::to_string(stats.delay * 1e3)+" ms"
+            +", jitter "+std::to_string(stats.jitter * 1e3)+" ms");
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     receive
+ */
+void udp_audio_source_f::receive()
+{
+    uint8_t packet[udp_audio_header_size + udp_audio_max_samples * sizeof(int16_t)];
+    float samples[udp_audio_max_samples];
+    bool warned = false;
+
+    while(m_running)
+    {
+        ssize_t len = recv(m_sock, packet, sizeof(packet), 0);
+        if(len < 0)
+        {
+            // timed out, or interrupted; check m_running
+            continue;
+        }
+        uint64_t arrival = udp_audio_now();
+
+        udp_audio_header_t header;
+        if(!udp_audio_unpack_header(packet, len, &header))
+        {
+            continue;
+        }
+        if(header.rate != m_rate)
+        {
+            if(!warned)
+            {
+                Logger::warn("[udp_audio_source_f::receive] stream is "+std::to_string(header.rate)+" Hz, expected "+std::to_string(m_rate));
+            }
+            warned = true;
+            continue;
+        }
+
+        // the wire is S16_LE; the s16 kernel reads native order
+        udp_audio_swap_s16(packet + udp_audio_header_size, header.nsamples);
+        float *out = samples;
+        m_converter(&out, packet + udp_audio_header_size, 1, header.nsamples);
+        m_jitter.insert(header, samples, arrival);
+    }
+    Logger::debug("[udp_audio_source_f::receive] exiting thread.");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int udp_audio_source_f::work(int noutput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items)
+{
+    float *out = (float *)output_items[0];
+    m_jitter.read(out, noutput_items);
+    return noutput_items;
+}
@@ -0,0 +1,99 @@
+/**-------------------------------------------------------------------------
+ * @file udp_audio_source_f.h
+ * @brief take TX audio from the network
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __UDP_AUDIO_SOURCE_F_H__
+#define __UDP_AUDIO_SOURCE_F_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "audio/alsa_convert.h"
+#include "audio/jitter_buffer.h"
+#include <gnuradio/sync_block.h>
+#include <atomic>
+#include <thread>
+
+class udp_audio_source_f;
+
+/**
+ * Listens for udp_audio packets and plays them out through a
+ * jitter_buffer.  A thread does the receiving so arrival times are
+ * measured when the packets land, not when the flowgraph gets around to
+ * them.  The SDR sink paces the output; with no stream this makes silence.
+ */
+class udp_audio_source_f : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the network source */
+    typedef boost::shared_ptr<udp_audio_source_f> sptr;
+
+    static sptr make(const std::string &addr, double rate, double max_delay = 0.5);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param addr - "[host:]port" to listen on, the part after "udp:"
+     * @param rate - audio rate
+     * @param max_delay - most the jitter buffer will hold, in seconds
+     */
+    udp_audio_source_f(const std::string &addr, double rate, double max_delay);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~udp_audio_source_f();
+
+    /** @brief loss, delay and jitter buffer counters
+     *
+     * @return jitter_buffer::stats_t
+     */
+    jitter_buffer::stats_t get_stats();
+
+    bool start();
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    int m_sock;
+    uint32_t m_rate;
+    jitter_buffer m_jitter;
+    gri_alsa_unpack_t m_converter;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    /** @brief receive thread; feeds the jitter buffer until stop()
+     *
+     * @return Void.
+     */
+    void receive();
+};
+
+#endif /* __UDP_AUDIO_SOURCE_F_H__ */
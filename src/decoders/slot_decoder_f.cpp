@@ -0,0 +1,537 @@
+/**-------------------------------------------------------------------------
+ * @file slot_decoder_f.cpp
+ * @brief decode FT8 or WSPR from the receiver audio, slot by UTC slot
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "decoders/slot_decoder_f.h"
+#include "sdr/sample_time.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <gnuradio/filter/firdes.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <stdexcept>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// jt9 and wsprd take 12 kHz
+static const double decode_rate = 12000.0;
+static const int decode_threads = 2;
+// slots waiting beyond this are dropped, oldest first
+static const size_t max_jobs = 4;
+// decodes kept for get_decodes(), oldest dropped first
+static const size_t max_decodes = 1000;
+// samples more than this off the clock start the slots over
+static const double resync_seconds = 1.0;
+// how fast the slot clock follows the system clock, per work() call
+static const double clock_gain = 0.001;
+// an rx_time further than this from the count is a gap in the audio
+static const double gap_seconds = 0.01;
+// the decoders want some headroom; the receiver has no AGC
+static const double target_rms = 2000.0;
+static const std::chrono::seconds heartbeat_interval(15);
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     write_wav
+ */
+static bool write_wav(const std::string &path, const std::vector<int16_t> &pcm)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if(nullptr == f)
+    {
+        return false;
+    }
+    // 16 bit mono, 12 kHz
+    uint32_t data = pcm.size() * sizeof(int16_t);
+    uint32_t rate = (uint32_t)decode_rate;
+    uint8_t header[44];
+    auto put32 = [&header](int at, uint32_t v){ for(int i = 0; i < 4; i++) header[at + i] = v >> (8 * i); };
+    auto put16 = [&header](int at, uint16_t v){ header[at] = v; header[at + 1] = v >> 8; };
+    memcpy(header, "RIFF", 4);
+    put32(4, 36 + data);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1);               // PCM
+    put16(22, 1);               // mono
+    put32(24, rate);
+    put32(28, rate * sizeof(int16_t));
+    put16(32, sizeof(int16_t));
+    put16(34, 16);
+    memcpy(header + 36, "data", 4);
+    put32(40, data);
+    bool ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+              fwrite(&pcm[0], sizeof(int16_t), pcm.size(), f) == pcm.size();
+    return (0 == fclose(f)) && ok;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     remove_entry
+ */
+static int remove_entry(const char *path, const struct stat *, int, struct FTW *)
+{
+    if(0 != remove(path))
+    {
+        // keep going; the rest of the directory can still go
+        Logger::warn("[slot_decoder_f::~slot_decoder_f] could not remove "+std::string(path)+": "+strerror(errno));
+    }
+    return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+slot_decoder_f::sptr slot_decoder_f::make(slot_mode_t mode, double rate, const std::string &udp)
+{
+    return gnuradio::get_initial_sptr(new slot_decoder_f(mode, rate, udp));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     slot_decoder_f
+ */
+slot_decoder_f::slot_decoder_f(slot_mode_t mode, double rate, const std::string &udp)
+    : gr::sync_block("slot_decoder_f",
+          gr::io_signature::make(1, 1, sizeof(float)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_mode(mode),
+      m_rate(rate),
+      m_period(mode == FT8 ? 15 : 120),
+      m_slot_samples((size_t)(m_period * rate)),
+      m_decim((int)std::lround(rate / decode_rate)),
+      m_next_time(0),
+      m_tagged(false),
+      m_slot_start(0),
+      m_spoiled(false),
+      m_dial(0),
+      m_transmitting(false),
+      m_quit(false),
+      m_busy(0)
+{
+    if(m_decim < 1 || m_decim * decode_rate != rate)
+    {
+        Logger::crit("[slot_decoder_f::slot_decoder_f] the audio rate must be a multiple of 12000, not "+std::to_string(rate));
+        throw std::runtime_error("slot_decoder_f");
+    }
+    m_taps = (1 == m_decim) ? std::vector<float>(1, 1.0f)
+                            : gr::filter::firdes::low_pass(1.0, rate, 5000.0, 1000.0);
+    m_samples.reserve(m_slot_samples);
+
+    char dir[] = "/tmp/sdr_ctld-XXXXXX";
+    if(nullptr == mkdtemp(dir))
+    {
+        Logger::crit("[slot_decoder_f::slot_decoder_f] mkdtemp: "+std::string(strerror(errno)));
+        throw std::runtime_error("slot_decoder_f");
+    }
+    m_dir = dir;
+    if(!udp.empty())
+    {
+        m_udp.reset(new wsjtx_udp(udp, "sdr_ctld-"+mode_name(mode)));
+    }
+
+    for(int i = 0; i < decode_threads; i++)
+    {
+        m_workers.push_back(std::thread(&slot_decoder_f::worker, this, i));
+    }
+    Logger::info("[slot_decoder_f::slot_decoder_f] "+mode_name(mode)+" slots of "+std::to_string(m_period)
+        +" s, "+std::to_string(decode_threads)+" decode threads in "+m_dir);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~slot_decoder_f
+ */
+slot_decoder_f::~slot_decoder_f()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_quit = true;
+    }
+    m_cond.notify_all();
+    for(std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+    if(0 != nftw(m_dir.c_str(), remove_entry, 8, FTW_DEPTH | FTW_PHYS))
+    {
+        Logger::warn("[slot_decoder_f::~slot_decoder_f] could not clean up "+m_dir+": "+strerror(errno));
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     mode_name
+ */
+std::string slot_decoder_f::mode_name(slot_mode_t mode)
+{
+    return (mode == FT8) ? "FT8" : "WSPR";
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_dial
+ */
+void slot_decoder_f::set_dial(double freq)
+{
+    if(freq != m_dial.exchange(freq))
+    {
+        m_spoiled = true;
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_transmitting
+ */
+void slot_decoder_f::set_transmitting(bool on)
+{
+    m_transmitting = on;
+    if(on)
+    {
+        m_spoiled = true;
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_decodes
+ */
+std::vector<slot_decoder_f::decode_t> slot_decoder_f::get_decodes()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<decode_t> decodes;
+    decodes.swap(m_decodes);
+    return decodes;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     heartbeat
+ */
+void slot_decoder_f::heartbeat()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(nullptr == m_udp || now - m_last_heartbeat < heartbeat_interval)
+    {
+        return;
+    }
+    m_last_heartbeat = now;
+    m_udp->heartbeat();
+    m_udp->status((uint64_t)std::llround(m_dial.load()), mode_name(m_mode), m_period, m_transmitting, m_busy > 0);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int slot_decoder_f::work(int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items)
+{
+    const float *in = (const float *)input_items[0];
+
+    // the SDR's rx_time, carried down through the decimators, is when the
+    // samples were taken; a jump in it is samples lost on the way
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + noutput_items, Sample_Time::RX_TIME);
+    double tagged = 0;
+    if(!tags.empty() && Sample_Time::from_pmt(tags.back().value, &tagged))
+    {
+        double first = tagged - (tags.back().offset - nitems_read(0)) / m_rate;
+        if(std::abs(first - m_next_time) > gap_seconds)
+        {
+            m_spoiled = true;
+        }
+        m_next_time = first;
+        m_tagged = true;
+    }
+    else if(!m_tagged)
+    {
+        // no time on the stream; the last sample arrived about now, so the
+        // clock follows that slowly and starts over if samples went
+        // missing or piled up
+        double first = Sample_Time::now() - noutput_items / m_rate;
+        if(0 == m_next_time || std::abs(first - m_next_time) > resync_seconds)
+        {
+            m_next_time = first;
+            m_spoiled = true;
+        }
+        else
+        {
+            m_next_time += clock_gain * (first - m_next_time);
+        }
+    }
+    if(m_spoiled.exchange(false) || m_transmitting)
+    {
+        // wait for the next slot
+        m_slot_start = 0;
+        m_samples.clear();
+    }
+
+    int i = 0;
+    while(!m_transmitting && i < noutput_items)
+    {
+        if(0 == m_slot_start)
+        {
+            double t = m_next_time + i / m_rate;
+            uint64_t boundary = (uint64_t)std::ceil(t / m_period) * m_period;
+            int64_t skip = std::llround((boundary - t) * m_rate);
+            if(skip >= noutput_items - i)
+            {
+                break;
+            }
+            i += skip;
+            m_slot_start = boundary;
+        }
+
+        size_t n = std::min(m_slot_samples - m_samples.size(), (size_t)(noutput_items - i));
+        m_samples.insert(m_samples.end(), in + i, in + i + n);
+        i += n;
+        if(m_samples.size() < m_slot_samples)
+        {
+            break;
+        }
+
+        slot_t slot;
+        slot.start = m_slot_start;
+        slot.dial = m_dial;
+        slot.samples.swap(m_samples);
+        m_samples.reserve(m_slot_samples);
+        m_slot_start += m_period;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if(m_jobs.size() >= max_jobs)
+            {
+                Logger::warn("[slot_decoder_f::work] "+mode_name(m_mode)+" decodes are behind, dropped a slot");
+                m_jobs.pop_front();
+            }
+            m_jobs.push_back(std::move(slot));
+        }
+        m_cond.notify_one();
+    }
+    m_next_time += noutput_items / m_rate;
+    return noutput_items;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     worker
+ */
+void slot_decoder_f::worker(int index)
+{
+    // jt9 keeps files in its directory; two at once must not share one
+    std::string dir = m_dir + "/" + std::to_string(index);
+    if(mkdir(dir.c_str(), 0700) < 0)
+    {
+        Logger::crit("[slot_decoder_f::worker] "+dir+": "+std::string(strerror(errno)));
+        return;
+    }
+    while(true)
+    {
+        slot_t slot;
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_cond.wait(lock, [this]{ return m_quit || !m_jobs.empty(); });
+            if(m_quit)
+            {
+                return;
+            }
+            slot = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        m_busy++;
+        decode(slot, dir);
+        m_busy--;
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     decode
+ */
+void slot_decoder_f::decode(const slot_t &slot, const std::string &dir)
+{
+    // both name the slot's time from the file name
+    time_t start = (time_t)slot.start;
+    struct tm utc;
+    gmtime_r(&start, &utc);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), (m_mode == FT8) ? "%y%m%d_%H%M%S" : "%y%m%d_%H%M", &utc);
+    std::string wav = dir + "/" + stamp + ".wav";
+    if(!write_wav(wav, to_12k(slot.samples)))
+    {
+        Logger::warn("[slot_decoder_f::decode] "+wav+": "+std::string(strerror(errno)));
+        return;
+    }
+
+    char cmd[512];
+    if(m_mode == FT8)
+    {
+        snprintf(cmd, sizeof(cmd), "jt9 -8 -d 3 -a %s -t %s %s 2>&1", dir.c_str(), dir.c_str(), wav.c_str());
+    }
+    else
+    {
+        snprintf(cmd, sizeof(cmd), "wsprd -a %s -f %.6f %s 2>&1", dir.c_str(), slot.dial / 1e6, wav.c_str());
+    }
+    FILE *out = popen(cmd, "r");
+    if(nullptr == out)
+    {
+        Logger::warn("[slot_decoder_f::decode] popen: "+std::string(strerror(errno)));
+        unlink(wav.c_str());
+        return;
+    }
+
+    uint32_t ms = (uint32_t)(slot.start % 86400) * 1000;
+    int count = 0;
+    char line[256];
+    while(nullptr != fgets(line, sizeof(line), out))
+    {
+        decode_t decode;
+        if(!parse(line, slot, &decode))
+        {
+            continue;
+        }
+        count++;
+        if(nullptr != m_udp && m_mode == FT8)
+        {
+            m_udp->decode(ms, decode.snr, decode.dt, (uint32_t)std::lround(decode.freq - slot.dial), "~", decode.message);
+        }
+        else if(nullptr != m_udp)
+        {
+            // call, grid if there is one, and power in dBm
+            std::istringstream fields(decode.message);
+            std::vector<std::string> words;
+            std::string word;
+            while(fields >> word)
+            {
+                words.push_back(word);
+            }
+            m_udp->wspr_decode(ms, decode.snr, decode.dt, (uint64_t)std::llround(decode.freq), decode.drift,
+                words[0], (3 == words.size()) ? words[1] : "", std::atoi(words.back().c_str()));
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_decodes.push_back(decode);
+        if(m_decodes.size() > max_decodes)
+        {
+            m_decodes.erase(m_decodes.begin());
+        }
+    }
+    int status = pclose(out);
+    unlink(wav.c_str());
+    if(0 != status)
+    {
+        Logger::warn("[slot_decoder_f::decode] "+std::string((m_mode == FT8) ? "jt9" : "wsprd")
+            +" failed ("+std::to_string(WEXITSTATUS(status))+"); is WSJT-X installed?");
+    }
+    Logger::debug("[slot_decoder_f::decode] "+std::string(stamp)+" "+mode_name(m_mode)+": "+std::to_string(count)+" decodes");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     to_12k
+ */
+std::vector<int16_t> slot_decoder_f::to_12k(const std::vector<float> &samples)
+{
+    double sum = 0;
+    for(float s : samples)
+    {
+        sum += s * s;
+    }
+    double rms = std::sqrt(sum / std::max((size_t)1, samples.size()));
+    float gain = (rms > 0) ? (float)(target_rms / rms) : 0.0f;
+
+    std::vector<int16_t> pcm(samples.size() / m_decim);
+    for(size_t k = 0; k < pcm.size(); k++)
+    {
+        size_t c = k * m_decim;
+        float acc = 0;
+        size_t ntaps = std::min(m_taps.size(), c + 1);
+        for(size_t j = 0; j < ntaps; j++)
+        {
+            acc += m_taps[j] * samples[c - j];
+        }
+        float v = std::max(-32768.0f, std::min(32767.0f, acc * gain));
+        pcm[k] = (int16_t)std::lrint(v);
+    }
+    return pcm;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     parse
+ */
+bool slot_decoder_f::parse(const std::string &line, const slot_t &slot, decode_t *out)
+{
+    std::istringstream in(line);
+    std::string utc;
+    out->slot = slot.start;
+    out->mode = mode_name(m_mode);
+    out->drift = 0;
+    if(m_mode == FT8)
+    {
+        // jt9: hhmmss snr dt df ~  message, maybe followed by a marker
+        // such as "a2" after two or more spaces
+        double df = 0;
+        std::string tilde;
+        if(!(in >> utc >> out->snr >> out->dt >> df >> tilde) || tilde != "~")
+        {
+            return false;
+        }
+        out->freq = slot.dial + df;
+    }
+    else
+    {
+        // wsprd: hhmm snr dt MHz drift message
+        double mhz = 0;
+        if(!(in >> utc >> out->snr >> out->dt >> mhz >> out->drift))
+        {
+            return false;
+        }
+        out->freq = mhz * 1e6;
+    }
+
+    std::string message;
+    std::getline(in, message);
+    size_t begin = message.find_first_not_of(" \t");
+    if(begin == std::string::npos)
+    {
+        return false;
+    }
+    message = message.substr(begin);
+    message = message.substr(0, message.find("  "));
+    message = message.substr(0, message.find_last_not_of(" \t\r\n") + 1);
+    out->message = message;
+    return !message.empty();
+}
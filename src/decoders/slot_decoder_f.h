@@ -0,0 +1,208 @@
+/**-------------------------------------------------------------------------
+ * @file slot_decoder_f.h
+ * @brief decode FT8 or WSPR from the receiver audio, slot by UTC slot
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SLOT_DECODER_F_H__
+#define __SLOT_DECODER_F_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "decoders/wsjtx_udp.h"
+#include <gnuradio/sync_block.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class slot_decoder_f;
+
+/**
+ * Cuts the receiver audio into UTC slots, 15 s for FT8 and 2 minutes
+ * for WSPR, and decodes each one on a pool of threads of its own, so
+ * the decoders need no sound card and no audio routing.
+ *
+ * The decoding itself is WSJT-X's: each slot goes to jt9 or wsprd as a
+ * 12 kHz WAV in a scratch directory, and their output is parsed.  The
+ * decodes are kept for get_decodes() and, with a UDP address, sent as
+ * WSJT-X messages.
+ *
+ * The slot times come from the SDR's rx_time tags, or from the system
+ * clock as the samples arrive when the stream has none; either way the
+ * host must keep UTC with NTP.  A slot the dial moved or PTT was on
+ * during, or that lost samples, is dropped.
+ */
+class slot_decoder_f : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the slot decoder */
+    typedef boost::shared_ptr<slot_decoder_f> sptr;
+
+    enum {
+        FT8 = 0,
+        WSPR = 1
+    } typedef slot_mode_t;
+
+    /** a decoded message */
+    struct {
+        uint64_t slot;          // UTC seconds at the slot start
+        std::string mode;       // "FT8" or "WSPR"
+        int snr;                // dB in 2500 Hz
+        double dt;              // seconds off the slot start
+        double freq;            // RF frequency in Hz
+        int drift;              // Hz per minute, WSPR only
+        std::string message;
+    } typedef decode_t;
+
+    static sptr make(slot_mode_t mode, double rate, const std::string &udp);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor, starts the decode threads
+     *
+     * @param mode - FT8 or WSPR
+     * @param rate - audio rate, a multiple of 12000
+     * @param udp - "host:port" for WSJT-X messages, or empty
+     */
+    slot_decoder_f(slot_mode_t mode, double rate, const std::string &udp);
+
+public:
+    /** @brief Deconstructor, waits for decodes in progress
+     *
+     */
+    ~slot_decoder_f();
+
+    /** @brief "FT8" or "WSPR"
+     *
+     * @param mode - FT8 or WSPR
+     * @return std::string
+     */
+    static std::string mode_name(slot_mode_t mode);
+
+    /** @brief the dial frequency; drops the slot being filled
+     *
+     * @param freq - dial frequency in Hz
+     * @return Void.
+     */
+    void set_dial(double freq);
+
+    /** @brief PTT; keying drops the slot being filled
+     *
+     * @param on - true while transmitting
+     * @return Void.
+     */
+    void set_transmitting(bool on);
+
+    /** @brief take the decodes made since the last call
+     *
+     * @return std::vector<decode_t>
+     */
+    std::vector<decode_t> get_decodes();
+
+    /** @brief send the WSJT-X heartbeat and status if they're due
+     *
+     * @return Void.
+     */
+    void heartbeat();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    /** a slot's audio waiting for a decode thread */
+    struct {
+        uint64_t start;         // UTC seconds
+        double dial;
+        std::vector<float> samples;
+    } typedef slot_t;
+
+    slot_mode_t m_mode;
+    double m_rate;
+    int m_period;                       // seconds per slot
+    size_t m_slot_samples;
+    std::vector<float> m_taps;          // low pass ahead of 12 kHz
+    int m_decim;
+
+    // filled by work()
+    double m_next_time;                 // UTC of the next sample, 0 before any
+    bool m_tagged;                      // the stream has carried rx_time
+    uint64_t m_slot_start;              // 0 until the next slot starts
+    std::vector<float> m_samples;
+    std::atomic<bool> m_spoiled;
+    std::atomic<double> m_dial;
+    std::atomic<bool> m_transmitting;
+
+    // the decode threads
+    std::string m_dir;                  // scratch directory
+    std::vector<std::thread> m_workers;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::deque<slot_t> m_jobs;
+    std::vector<decode_t> m_decodes;
+    bool m_quit;
+    std::atomic<int> m_busy;            // slots being decoded
+
+    std::unique_ptr<wsjtx_udp> m_udp;
+    std::chrono::steady_clock::time_point m_last_heartbeat;
+
+    /** @brief a decode thread
+     *
+     * @param index - names its scratch directory
+     * @return Void.
+     */
+    void worker(int index);
+
+    /** @brief decode one slot with jt9 or wsprd
+     *
+     * @param slot - the slot
+     * @param dir - scratch directory of this thread
+     * @return Void.
+     */
+    void decode(const slot_t &slot, const std::string &dir);
+
+    /** @brief filter and decimate to 12 kHz, scaled to 16 bits
+     *
+     * @param samples - audio at m_rate
+     * @return std::vector<int16_t>
+     */
+    std::vector<int16_t> to_12k(const std::vector<float> &samples);
+
+    /** @brief parse a line of jt9 or wsprd output
+     *
+     * @param line - the line
+     * @param slot - the slot it came from
+     * @param out - the decode
+     * @return bool - false if it isn't a decode
+     */
+    bool parse(const std::string &line, const slot_t &slot, decode_t *out);
+};
+
+#endif /* __SLOT_DECODER_F_H__ */
@@ -0,0 +1,245 @@
+/**-------------------------------------------------------------------------
+ * @file wsjtx_udp.cpp
+ * @brief WSJT-X UDP messages, so loggers can take our decodes
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "decoders/wsjtx_udp.h"
+#include "application/logger.h"
+#include "audio/udp_audio.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+const uint32_t wsjtx_udp::magic = 0xadbccbda;
+const uint32_t wsjtx_udp::schema = 2;
+// sent in the heartbeat as the highest schema we understand
+static const uint32_t max_schema = 3;
+// "not applicable" for the 32 bit fields of a status
+static const uint32_t not_applicable = 0xffffffff;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     wsjtx_udp
+ */
+wsjtx_udp::wsjtx_udp(const std::string &addr, const std::string &id)
+    : m_sock(-1),
+      m_id(id)
+{
+    if(!udp_audio_parse_address(addr, &m_addr) || m_addr.sin_addr.s_addr == htonl(INADDR_ANY))
+    {
+        Logger::crit("[wsjtx_udp::wsjtx_udp] expected host:port, not "+addr);
+        throw std::runtime_error("wsjtx_udp");
+    }
+    m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if(m_sock < 0)
+    {
+        Logger::crit("[wsjtx_udp::wsjtx_udp] socket: "+std::string(strerror(errno)));
+        throw std::runtime_error("wsjtx_udp");
+    }
+    Logger::info("[wsjtx_udp::wsjtx_udp] "+id+" decodes to "+addr);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~wsjtx_udp
+ */
+wsjtx_udp::~wsjtx_udp()
+{
+    if(m_sock >= 0)
+    {
+        close(m_sock);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     heartbeat
+ */
+void wsjtx_udp::heartbeat()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    begin(HEARTBEAT);
+    put_u32(max_schema);
+    put_utf8("sdr_ctld");
+    put_utf8("");
+    send();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     status
+ */
+void wsjtx_udp::status(uint64_t dial, const std::string &mode, uint32_t period, bool transmitting, bool decoding)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    begin(STATUS);
+    put_u64(dial);
+    put_utf8(mode);
+    put_utf8("");               // DX call
+    put_utf8("");               // report
+    put_utf8(mode);             // TX mode
+    put_bool(false);            // TX enabled
+    put_bool(transmitting);
+    put_bool(decoding);
+    put_u32(0);                 // RX DF
+    put_u32(0);                 // TX DF
+    put_utf8("");               // DE call
+    put_utf8("");               // DE grid
+    put_utf8("");               // DX grid
+    put_bool(false);            // TX watchdog
+    put_utf8("");               // sub-mode
+    put_bool(false);            // fast mode
+    m_msg.push_back(0);         // special operation mode, none
+    put_u32(not_applicable);    // frequency tolerance
+    put_u32(period);
+    put_utf8("sdr_ctld");       // configuration name
+    put_utf8("");               // TX message
+    send();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     decode
+ */
+void wsjtx_udp::decode(uint32_t ms, int snr, double dt, uint32_t df, const std::string &mode, const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    begin(DECODE);
+    put_bool(true);             // new, not a replay of old ones
+    put_u32(ms);
+    put_u32((uint32_t)snr);
+    put_double(dt);
+    put_u32(df);
+    put_utf8(mode);
+    put_utf8(message);
+    put_bool(false);            // low confidence
+    put_bool(false);            // off air
+    send();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     wspr_decode
+ */
+void wsjtx_udp::wspr_decode(uint32_t ms, int snr, double dt, uint64_t freq, int drift,
+                            const std::string &call, const std::string &grid, int power)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    begin(WSPR_DECODE);
+    put_bool(true);
+    put_u32(ms);
+    put_u32((uint32_t)snr);
+    put_double(dt);
+    put_u64(freq);
+    put_u32((uint32_t)drift);
+    put_utf8(call);
+    put_utf8(grid);
+    put_u32((uint32_t)power);
+    put_bool(false);            // off air
+    send();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     begin
+ */
+void wsjtx_udp::begin(message_t type)
+{
+    m_msg.clear();
+    put_u32(magic);
+    put_u32(schema);
+    put_u32(type);
+    put_utf8(m_id);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_u32
+ */
+void wsjtx_udp::put_u32(uint32_t v)
+{
+    m_msg.push_back(v >> 24);
+    m_msg.push_back(v >> 16);
+    m_msg.push_back(v >> 8);
+    m_msg.push_back(v);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_u64
+ */
+void wsjtx_udp::put_u64(uint64_t v)
+{
+    put_u32((uint32_t)(v >> 32));
+    put_u32((uint32_t)v);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_bool
+ */
+void wsjtx_udp::put_bool(bool v)
+{
+    m_msg.push_back(v ? 1 : 0);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_double
+ */
+void wsjtx_udp::put_double(double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u64(bits);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_utf8
+ */
+void wsjtx_udp::put_utf8(const std::string &s)
+{
+    put_u32((uint32_t)s.size());
+    m_msg.insert(m_msg.end(), s.begin(), s.end());
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     send
+ */
+void wsjtx_udp::send()
+{
+    // a logger that isn't running just misses them
+    if(sendto(m_sock, &m_msg[0], m_msg.size(), MSG_DONTWAIT, (sockaddr *)&m_addr, sizeof(m_addr)) < 0 &&
+       errno != ECONNREFUSED)
+    {
+        Logger::debug("[wsjtx_udp::send] "+std::string(strerror(errno)));
+    }
+}
@@ -0,0 +1,135 @@
+/**-------------------------------------------------------------------------
+ * @file wsjtx_udp.h
+ * @brief WSJT-X UDP messages, so loggers can take our decodes
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __WSJTX_UDP_H__
+#define __WSJTX_UDP_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * Sends decodes the way WSJT-X does on its UDP port (see NetworkMessage.hpp
+ * in WSJT-X), so GridTracker, JTAlert and the like log them as if they
+ * came from WSJT-X.  Every message is a QDataStream: big endian integers,
+ * doubles for floats, and UTF-8 strings after a 32 bit length.
+ *
+ * Only the outgoing messages a logger needs are sent; nothing is read
+ * back, so the replies loggers send are ignored.
+ */
+class wsjtx_udp
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    static const uint32_t magic;
+    static const uint32_t schema;
+
+    enum {
+        HEARTBEAT = 0,
+        STATUS = 1,
+        DECODE = 2,
+        WSPR_DECODE = 10
+    } typedef message_t;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Constructor
+     *
+     * @param addr - "host:port", WSJT-X's default is 127.0.0.1:2237
+     * @param id - the instance name loggers show, ex: "sdr_ctld-FT8"
+     */
+    wsjtx_udp(const std::string &addr, const std::string &id);
+
+    /** @brief Deconstructor
+     *
+     */
+    ~wsjtx_udp();
+
+    /** @brief say we're here; loggers drop an instance without them
+     *
+     * @return Void.
+     */
+    void heartbeat();
+
+    /** @brief the dial and mode
+     *
+     * @param dial - dial frequency in Hz
+     * @param mode - ex: "FT8"
+     * @param period - slot length in seconds
+     * @param transmitting - PTT is on
+     * @param decoding - a slot is being decoded
+     * @return Void.
+     */
+    void status(uint64_t dial, const std::string &mode, uint32_t period, bool transmitting, bool decoding);
+
+    /** @brief one FT8 decode
+     *
+     * @param ms - slot start, ms since UTC midnight
+     * @param snr - dB in 2500 Hz
+     * @param dt - seconds from the slot start
+     * @param df - audio frequency in Hz
+     * @param mode - WSJT-X's mode character, "~" for FT8
+     * @param message - ex: "CQ K1ABC FN42"
+     * @return Void.
+     */
+    void decode(uint32_t ms, int snr, double dt, uint32_t df, const std::string &mode, const std::string &message);
+
+    /** @brief one WSPR decode
+     *
+     * @param ms - slot start, ms since UTC midnight
+     * @param snr - dB in 2500 Hz
+     * @param dt - seconds from the slot start
+     * @param freq - RF frequency in Hz
+     * @param drift - Hz per minute
+     * @param call - callsign
+     * @param grid - locator
+     * @param power - dBm
+     * @return Void.
+     */
+    void wspr_decode(uint32_t ms, int snr, double dt, uint64_t freq, int drift,
+                     const std::string &call, const std::string &grid, int power);
+
+private:
+    int m_sock;
+    sockaddr_in m_addr;
+    std::string m_id;
+    // the decode threads and the command loop both send
+    std::mutex m_lock;
+    std::vector<uint8_t> m_msg;
+
+    void begin(message_t type);
+    void put_u32(uint32_t v);
+    void put_u64(uint64_t v);
+    void put_bool(bool v);
+    void put_double(double v);
+    void put_utf8(const std::string &s);
+    void send();
+};
+
+#endif /* __WSJTX_UDP_H__ */
@@ -0,0 +1,185 @@
+/**-------------------------------------------------------------------------
+ * @file iq_replay_c.cpp
+ * @brief plays a window of the I & Q ring
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "receivers/iq_replay_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// made per work() call, in seconds; short enough to stop a replay quickly
+static const double chunk_time = 0.01;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+iq_replay_c::sptr iq_replay_c::make(iq_ring_c::sptr ring, bool realtime)
+{
+    return gnuradio::get_initial_sptr(new iq_replay_c(ring, realtime));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     iq_replay_c
+ */
+iq_replay_c::iq_replay_c(iq_ring_c::sptr ring, bool realtime)
+    : gr::sync_block("iq_replay_c",
+          gr::io_signature::make(0, 0, 0),// input_signature
+          gr::io_signature::make(1, 1, sizeof(gr_complex))),// output_signature
+      m_ring(ring),
+      m_realtime(realtime),
+      m_pos(0),
+      m_end(0),
+      m_rot(1, 0),
+      m_phase(1, 0),
+      m_produced(0)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~iq_replay_c
+ */
+iq_replay_c::~iq_replay_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     replay
+ */
+bool iq_replay_c::replay(uint64_t start, uint64_t n, double offset)
+{
+    if(0 == n || start < m_ring->get_oldest() || start + n > m_ring->get_write_pos())
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_pos = start;
+    m_end = start + n;
+    m_rot = std::polar(1.0f, (float)(-2.0 * M_PI * offset / m_ring->get_rate()));
+    m_phase = gr_complex(1, 0);
+    Logger::info("[iq_replay_c::replay] "+std::to_string(n / m_ring->get_rate())+" s from "
+        +std::to_string((m_ring->get_write_pos() - start) / m_ring->get_rate())+" s ago");
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop_replay
+ */
+void iq_replay_c::stop_replay()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_pos = m_end;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     is_replaying
+ */
+bool iq_replay_c::is_replaying()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_pos < m_end;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int iq_replay_c::work(int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items)
+{
+    gr_complex *out = (gr_complex *)output_items[0];
+    double rate = m_ring->get_rate();
+    int chunk = std::max(1, (int)(rate * chunk_time));
+    noutput_items = std::min(noutput_items, chunk);
+
+    if(m_realtime)
+    {
+        if(0 == m_produced)
+        {
+            m_epoch = std::chrono::steady_clock::now();
+        }
+        double ahead = m_produced / rate
+            - std::chrono::duration<double>(std::chrono::steady_clock::now() - m_epoch).count();
+        if(ahead > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(ahead));
+        }
+        m_produced += noutput_items;
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    if(m_pos >= m_end)
+    {
+        lock.unlock();
+        if(m_realtime)
+        {
+            std::fill(out, out + noutput_items, gr_complex(0, 0));
+            return noutput_items;
+        }
+        // nothing to play; look again shortly
+        std::this_thread::sleep_for(std::chrono::duration<double>(chunk_time));
+        return 0;
+    }
+
+    int n = (int)std::min((uint64_t)noutput_items, m_end - m_pos);
+    if(!m_ring->read(m_pos, out, n))
+    {
+        // a replay ahead of the ring's oldest sample can only fall behind
+        Logger::warn("[iq_replay_c::work] the ring overwrote the rest of the replay");
+        m_pos = m_end;
+        std::fill(out, out + n, gr_complex(0, 0));
+        return n;
+    }
+    if(m_rot != gr_complex(1, 0))
+    {
+        for(int i = 0; i < n; i++)
+        {
+            out[i] *= m_phase;
+            m_phase *= m_rot;
+        }
+        m_phase /= std::abs(m_phase);
+    }
+    m_pos += n;
+    if(m_pos >= m_end)
+    {
+        Logger::info("[iq_replay_c::work] replay done");
+    }
+    if(m_realtime && n < noutput_items)
+    {
+        std::fill(out + n, out + noutput_items, gr_complex(0, 0));
+        return noutput_items;
+    }
+    return n;
+}
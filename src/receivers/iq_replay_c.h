@@ -0,0 +1,112 @@
+/**-------------------------------------------------------------------------
+ * @file iq_replay_c.h
+ * @brief plays a window of the I & Q ring
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __IQ_REPLAY_C_H__
+#define __IQ_REPLAY_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "receivers/iq_ring_c.h"
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+class iq_replay_c;
+
+/**
+ * Plays a window of an iq_ring_c into a receiver of its own, shifted in
+ * frequency if asked.  In real time it is paced to the ring's rate and
+ * gives zeros between replays, so a sound card or a decoder hears a
+ * steady stream.  Otherwise a replay goes as fast as it is taken and
+ * nothing comes out between them, which suits a file.
+ */
+class iq_replay_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the replay source */
+    typedef boost::shared_ptr<iq_replay_c> sptr;
+
+    static sptr make(iq_ring_c::sptr ring, bool realtime);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param ring - where the samples are kept
+     * @param realtime - pace to the ring's rate, with zeros between replays
+     */
+    iq_replay_c(iq_ring_c::sptr ring, bool realtime);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~iq_replay_c();
+
+    /** @brief play samples [start, start + n), replacing any replay
+     *
+     * @param start - sample number in the ring
+     * @param n - number of samples
+     * @param offset - Hz to move the samples down by
+     * @return bool - false if the ring doesn't hold them all
+     */
+    bool replay(uint64_t start, uint64_t n, double offset);
+
+    /** @brief drop the rest of the replay
+     *
+     * @return Void.
+     */
+    void stop_replay();
+
+    /** @brief true while a replay plays
+     *
+     * @return bool
+     */
+    bool is_replaying();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    iq_ring_c::sptr m_ring;
+    bool m_realtime;
+
+    // the replay; set from the command thread, played in work()
+    std::mutex m_lock;
+    uint64_t m_pos;
+    uint64_t m_end;
+    gr_complex m_rot;
+    gr_complex m_phase;
+
+    std::chrono::steady_clock::time_point m_epoch;
+    uint64_t m_produced;                // since m_epoch
+};
+
+#endif /* __IQ_REPLAY_C_H__ */
@@ -0,0 +1,153 @@
+/**-------------------------------------------------------------------------
+ * @file iq_ring_c.cpp
+ * @brief keeps the last seconds of receiver I & Q in memory
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "receivers/iq_ring_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cstring>
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+iq_ring_c::sptr iq_ring_c::make(double rate, double seconds)
+{
+    return gnuradio::get_initial_sptr(new iq_ring_c(rate, seconds));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     iq_ring_c
+ */
+iq_ring_c::iq_ring_c(double rate, double seconds)
+    : gr::sync_block("iq_ring_c",
+          gr::io_signature::make(1, 1, sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_rate(rate),
+      m_write_pos(0),
+      m_writing(0)
+{
+    size_t capacity = 1;
+    while(capacity < rate * seconds)
+    {
+        capacity <<= 1;
+    }
+    // touch every page now, not in the flowgraph thread
+    m_data.assign(capacity, gr_complex(0, 0));
+    m_mask = capacity - 1;
+    Logger::info("[iq_ring_c::iq_ring_c] "+std::to_string(capacity / rate)+" s at "+std::to_string(rate)
+        +" Hz, "+std::to_string(capacity * sizeof(gr_complex) >> 20)+" MiB");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~iq_ring_c
+ */
+iq_ring_c::~iq_ring_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_rate
+ */
+double iq_ring_c::get_rate()
+{
+    return m_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_write_pos
+ */
+uint64_t iq_ring_c::get_write_pos()
+{
+    return m_write_pos.load(std::memory_order_acquire);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_oldest
+ */
+uint64_t iq_ring_c::get_oldest()
+{
+    uint64_t writing = m_writing.load(std::memory_order_acquire);
+    return (writing > m_data.size()) ? writing - m_data.size() : 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read
+ */
+bool iq_ring_c::read(uint64_t start, gr_complex *out, size_t n)
+{
+    if(start + n > get_write_pos() || start < get_oldest())
+    {
+        return false;
+    }
+    size_t done = 0;
+    // at most twice, once on each side of the wrap
+    while(done < n)
+    {
+        size_t index = (start + done) & m_mask;
+        size_t count = std::min(n - done, m_data.size() - index);
+        memcpy(out + done, &m_data[index], count * sizeof(gr_complex));
+        done += count;
+    }
+    // if the writer got to any of it while we copied, the copy is torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return start >= get_oldest();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int iq_ring_c::work(int noutput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items)
+{
+    const gr_complex *in = (const gr_complex *)input_items[0];
+    // never more than the ring holds; the rest would only overwrite itself
+    size_t n = std::min((size_t)noutput_items, m_data.size());
+    const gr_complex *src = in + (noutput_items - n);
+
+    uint64_t pos = m_write_pos.load(std::memory_order_relaxed) + (noutput_items - n);
+    // warn readers first, then overwrite
+    m_writing.store(pos + n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t done = 0;
+    while(done < n)
+    {
+        size_t index = (pos + done) & m_mask;
+        size_t count = std::min(n - done, m_data.size() - index);
+        memcpy(&m_data[index], src + done, count * sizeof(gr_complex));
+        done += count;
+    }
+    m_write_pos.store(pos + n, std::memory_order_release);
+    return noutput_items;
+}
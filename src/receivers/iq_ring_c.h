@@ -0,0 +1,114 @@
+/**-------------------------------------------------------------------------
+ * @file iq_ring_c.h
+ * @brief keeps the last seconds of receiver I & Q in memory
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __IQ_RING_C_H__
+#define __IQ_RING_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class iq_ring_c;
+
+/**
+ * A time shift buffer: the last seconds of I & Q, overwritten as it
+ * goes, so a missed slot can be heard again.  The samples are addressed
+ * by their count since the flowgraph started.
+ *
+ * The flowgraph thread is the only writer and never waits.  Readers copy
+ * without a lock and check afterwards that the writer didn't lap them,
+ * so a replay can never slow the live receiver.
+ */
+class iq_ring_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the I & Q ring */
+    typedef boost::shared_ptr<iq_ring_c> sptr;
+
+    static sptr make(double rate, double seconds);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param rate - sample rate
+     * @param seconds - how much to keep, rounded up to a power of two samples
+     */
+    iq_ring_c(double rate, double seconds);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~iq_ring_c();
+
+    /** @brief sample rate
+     *
+     * @return double
+     */
+    double get_rate();
+
+    /** @brief the count of samples written, the next one's number
+     *
+     * @return uint64_t
+     */
+    uint64_t get_write_pos();
+
+    /** @brief the oldest sample still held
+     *
+     * @return uint64_t
+     */
+    uint64_t get_oldest();
+
+    /** @brief copy out samples [start, start + n)
+     *
+     * @param start - sample number
+     * @param out - destination
+     * @param n - number of samples
+     * @return bool - false if any were not written yet or overwritten
+     */
+    bool read(uint64_t start, gr_complex *out, size_t n);
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    double m_rate;
+    std::vector<gr_complex> m_data;
+    size_t m_mask;                      // capacity - 1, a power of two
+    // published after the samples are in
+    std::atomic<uint64_t> m_write_pos;
+    // published before the writer overwrites anything, up to here
+    std::atomic<uint64_t> m_writing;
+};
+
+#endif /* __IQ_RING_C_H__ */
@@ -0,0 +1,448 @@
+/**-------------------------------------------------------------------------
+ * @file iq_server_c.cpp
+ * @brief serve receiver I & Q over TCP, rtl_tcp or native
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "receivers/iq_server_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// a client may fall this far behind before it loses samples
+static const double queue_seconds = 1.0;
+// rtl_tcp's dongle info: an R820T and its 29 gains
+static const uint32_t rtl_tuner_r820t = 5;
+static const uint32_t rtl_gain_count = 29;
+static const uint32_t native_version = 1;
+static const uint32_t native_ci16_le = 1;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_be32
+ */
+static void put_be32(std::vector<uint8_t> *buf, uint32_t v)
+{
+    buf->push_back(v >> 24);
+    buf->push_back(v >> 16);
+    buf->push_back(v >> 8);
+    buf->push_back(v);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     put_le32
+ */
+static void put_le32(std::vector<uint8_t> *buf, uint32_t v)
+{
+    buf->push_back(v);
+    buf->push_back(v >> 8);
+    buf->push_back(v >> 16);
+    buf->push_back(v >> 24);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+iq_server_c::sptr iq_server_c::make(int port, double rate, protocol_t protocol)
+{
+    return gnuradio::get_initial_sptr(new iq_server_c(port, rate, protocol));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     iq_server_c
+ */
+iq_server_c::iq_server_c(int port, double rate, protocol_t protocol)
+    : gr::sync_block("iq_server_c",
+          gr::io_signature::make(1, 1, sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_port(port),
+      m_rate(rate),
+      m_protocol(protocol),
+      m_max_queued(std::max((size_t)(rate * queue_seconds) * (protocol == RTL_TCP ? 2 : 4), (size_t)65536)),
+      m_listen(-1),
+      m_wake(-1),
+      m_running(false),
+      m_nclients(0)
+{
+    m_listen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    m_wake = eventfd(0, EFD_NONBLOCK);
+    if(m_listen < 0 || m_wake < 0)
+    {
+        Logger::crit("[iq_server_c::iq_server_c] socket: "+std::string(strerror(errno)));
+        throw std::runtime_error("iq_server_c");
+    }
+    int opt = 1;
+    setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if(bind(m_listen, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(m_listen, 4) < 0)
+    {
+        Logger::crit("[iq_server_c::iq_server_c] port "+std::to_string(port)+": "+std::string(strerror(errno)));
+        throw std::runtime_error("iq_server_c");
+    }
+    Logger::info("[iq_server_c::iq_server_c] "+std::string(protocol == RTL_TCP ? "rtl_tcp" : "native")
+        +" I & Q on port "+std::to_string(port)+" at "+std::to_string(rate)+" Hz");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~iq_server_c
+ */
+iq_server_c::~iq_server_c()
+{
+    stop();
+    if(m_listen >= 0)
+    {
+        close(m_listen);
+    }
+    if(m_wake >= 0)
+    {
+        close(m_wake);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     start
+ */
+bool iq_server_c::start()
+{
+    m_running = true;
+    m_thread = std::thread(&iq_server_c::serve, this);
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool iq_server_c::stop()
+{
+    if(!m_thread.joinable())
+    {
+        return true;
+    }
+    m_running = false;
+    uint64_t one = 1;
+    if(write(m_wake, &one, sizeof(one)) < 0)
+    {
+        Logger::warn("[iq_server_c::stop] eventfd: "+std::string(strerror(errno)));
+    }
+    m_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    for(std::unique_ptr<client_t> &client : m_clients)
+    {
+        close(client->fd);
+    }
+    m_clients.clear();
+    m_nclients = 0;
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int iq_server_c::work(int noutput_items,
+                      gr_vector_const_void_star &input_items,
+                      gr_vector_void_star &output_items)
+{
+    if(0 == m_nclients.load(std::memory_order_relaxed))
+    {
+        return noutput_items;
+    }
+
+    // converted once, whatever the number of clients
+    const float *in = (const float *)input_items[0];
+    size_t nvalues = 2 * noutput_items;
+    std::shared_ptr<std::vector<uint8_t>> chunk = std::make_shared<std::vector<uint8_t>>();
+    if(m_protocol == RTL_TCP)
+    {
+        chunk->resize(nvalues);
+        uint8_t *out = &(*chunk)[0];
+        for(size_t i = 0; i < nvalues; i++)
+        {
+            float v = std::max(0.0f, std::min(255.0f, in[i] * 127.5f + 127.5f));
+            out[i] = (uint8_t)std::lrint(v);
+        }
+    }
+    else
+    {
+        chunk->resize(2 * nvalues);
+        uint8_t *out = &(*chunk)[0];
+        for(size_t i = 0; i < nvalues; i++)
+        {
+            float v = std::max(-32768.0f, std::min(32767.0f, in[i] * 32767.0f));
+            int16_t s = (int16_t)std::lrint(v);
+            out[2 * i] = s & 0xff;
+            out[2 * i + 1] = (s >> 8) & 0xff;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        for(std::unique_ptr<client_t> &client : m_clients)
+        {
+            client->queue.push_back(chunk);
+            client->queued += chunk->size();
+            // drop the oldest, but not the one being sent
+            while(client->queued > m_max_queued && client->queue.size() > 1)
+            {
+                size_t size = client->queue[1]->size();
+                client->queue.erase(client->queue.begin() + 1);
+                client->queued -= size;
+                client->dropped += size;
+            }
+        }
+    }
+    uint64_t one = 1;
+    if(write(m_wake, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        Logger::warn("[iq_server_c::work] eventfd: "+std::string(strerror(errno)));
+    }
+    return noutput_items;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     serve
+ */
+void iq_server_c::serve()
+{
+    std::vector<pollfd> fds;
+    std::vector<client_t *> polled;
+    while(m_running)
+    {
+        fds.clear();
+        polled.clear();
+        fds.push_back({ m_listen, POLLIN, 0 });
+        fds.push_back({ m_wake, POLLIN, 0 });
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            for(std::unique_ptr<client_t> &client : m_clients)
+            {
+                bool pending = client->header_sent < client->header.size() || !client->queue.empty();
+                fds.push_back({ client->fd, (short)(POLLIN | (pending ? POLLOUT : 0)), 0 });
+                polled.push_back(client.get());
+            }
+        }
+
+        if(poll(&fds[0], fds.size(), -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            Logger::crit("[iq_server_c::serve] poll: "+std::string(strerror(errno)));
+            break;
+        }
+
+        if(fds[1].revents & POLLIN)
+        {
+            uint64_t count;
+            if(read(m_wake, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            {
+                Logger::warn("[iq_server_c::serve] eventfd: "+std::string(strerror(errno)));
+            }
+        }
+        // the ones that wrote to the queues since are taken on the next pass
+        for(size_t i = 0; i < polled.size(); i++)
+        {
+            client_t *client = polled[i];
+            short revents = fds[i + 2].revents;
+            bool alive = !(revents & (POLLERR | POLLHUP | POLLNVAL));
+            if(alive && (revents & POLLIN))
+            {
+                alive = read_client(client);
+            }
+            if(alive && (revents & POLLOUT))
+            {
+                alive = send_client(client);
+            }
+            if(!alive)
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                Logger::info("[iq_server_c::serve] port "+std::to_string(m_port)+": "+client->name
+                    +" left, "+std::to_string(client->dropped)+" bytes dropped");
+                close(client->fd);
+                m_clients.erase(std::find_if(m_clients.begin(), m_clients.end(),
+                    [client](const std::unique_ptr<client_t> &c){ return c.get() == client; }));
+                m_nclients = m_clients.size();
+            }
+        }
+        if(fds[0].revents & POLLIN)
+        {
+            accept_client();
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     accept_client
+ */
+void iq_server_c::accept_client()
+{
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd = accept4(m_listen, (sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(fd < 0)
+    {
+        if(errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            Logger::warn("[iq_server_c::accept_client] accept: "+std::string(strerror(errno)));
+        }
+        return;
+    }
+
+    std::unique_ptr<client_t> client(new client_t);
+    client->fd = fd;
+    char host[INET_ADDRSTRLEN] = "";
+    inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+    client->name = std::string(host)+":"+std::to_string(ntohs(addr.sin_port));
+    if(m_protocol == RTL_TCP)
+    {
+        client->header = { 'R', 'T', 'L', '0' };
+        put_be32(&client->header, rtl_tuner_r820t);
+        put_be32(&client->header, rtl_gain_count);
+    }
+    else
+    {
+        client->header = { 'S', 'C', 'I', 'Q' };
+        put_le32(&client->header, native_version);
+        put_le32(&client->header, (uint32_t)m_rate);
+        put_le32(&client->header, native_ci16_le);
+    }
+    client->header_sent = 0;
+    client->queued = 0;
+    client->offset = 0;
+    client->dropped = 0;
+    client->cmd_len = 0;
+    Logger::info("[iq_server_c::accept_client] port "+std::to_string(m_port)+": "+client->name);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_clients.push_back(std::move(client));
+    m_nclients = m_clients.size();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read_client
+ */
+bool iq_server_c::read_client(client_t *client)
+{
+    uint8_t buf[256];
+    ssize_t n = recv(client->fd, buf, sizeof(buf), 0);
+    if(n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        return false;
+    }
+    if(m_protocol != RTL_TCP)
+    {
+        return true;
+    }
+    // rtl_tcp commands are a byte and a big endian 32 bit parameter;
+    // the stream is fixed, so they're only logged
+    for(ssize_t i = 0; i < n; i++)
+    {
+        client->cmd[client->cmd_len++] = buf[i];
+        if(client->cmd_len == sizeof(client->cmd))
+        {
+            uint32_t param = ((uint32_t)client->cmd[1] << 24) | ((uint32_t)client->cmd[2] << 16)
+                | ((uint32_t)client->cmd[3] << 8) | client->cmd[4];
+            Logger::debug("[iq_server_c::read_client] "+client->name+": ignored command "
+                +std::to_string(client->cmd[0])+" "+std::to_string(param));
+            client->cmd_len = 0;
+        }
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     send_client
+ */
+bool iq_server_c::send_client(client_t *client)
+{
+    while(client->header_sent < client->header.size())
+    {
+        ssize_t n = send(client->fd, &client->header[client->header_sent],
+            client->header.size() - client->header_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client->header_sent += n;
+    }
+
+    while(true)
+    {
+        // work() never drops the front chunk, so it can be sent unlocked
+        chunk_t chunk;
+        size_t offset;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if(client->queue.empty())
+            {
+                return true;
+            }
+            chunk = client->queue.front();
+            offset = client->offset;
+        }
+
+        ssize_t n = send(client->fd, &(*chunk)[offset], chunk->size() - offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        client->offset += n;
+        if(client->offset == chunk->size())
+        {
+            client->queue.pop_front();
+            client->queued -= chunk->size();
+            client->offset = 0;
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/**-------------------------------------------------------------------------
+ * @file iq_server_c.h
+ * @brief serve receiver I & Q over TCP, rtl_tcp or native
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __IQ_SERVER_C_H__
+#define __IQ_SERVER_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class iq_server_c;
+
+/**
+ * Streams I & Q to any number of TCP clients, so skimmers and decoders
+ * can share the SDR with sdr_ctld.
+ *
+ * RTL_TCP speaks the rtl_tcp protocol: a 12 byte "RTL0" header, then
+ * unsigned 8 bit I & Q.  The clients' tuning commands are read and
+ * ignored; the stream is what the receiver tap gives.  NATIVE sends a
+ * 16 byte header, "SCIQ", version, sample rate and format, all little
+ * endian, then 16 bit I & Q, which keeps the dynamic range of a wide tap.
+ *
+ * work() converts each call's samples once and queues the same chunk for
+ * every client.  A thread of its own does the sends.  A client that
+ * can't keep up has its oldest chunks dropped, so it never holds up the
+ * receiver or the other clients.
+ */
+class iq_server_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the I & Q server */
+    typedef boost::shared_ptr<iq_server_c> sptr;
+
+    /** what goes over the wire */
+    enum {
+        RTL_TCP = 0,    // rtl_tcp, unsigned 8 bit
+        NATIVE = 1      // 16 bit little endian
+    } typedef protocol_t;
+
+    static sptr make(int port, double rate, protocol_t protocol);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor, opens the listening socket
+     *
+     * @param port - TCP port
+     * @param rate - sample rate
+     * @param protocol - RTL_TCP or NATIVE
+     */
+    iq_server_c(int port, double rate, protocol_t protocol);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~iq_server_c();
+
+    bool start();
+
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    typedef std::shared_ptr<const std::vector<uint8_t>> chunk_t;
+
+    struct {
+        int fd;
+        std::string name;               // address:port
+        std::vector<uint8_t> header;    // sent before any samples
+        size_t header_sent;
+        std::deque<chunk_t> queue;
+        size_t queued;                  // bytes in queue
+        size_t offset;                  // bytes of queue.front() sent
+        uint64_t dropped;               // bytes dropped
+        uint8_t cmd[5];                 // rtl_tcp command being read
+        size_t cmd_len;
+    } typedef client_t;
+
+    int m_port;
+    double m_rate;
+    protocol_t m_protocol;
+    size_t m_max_queued;                // bytes per client
+    int m_listen;
+    int m_wake;                         // eventfd; data queued or stopping
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<int> m_nclients;
+
+    // work() queues and the thread sends
+    std::mutex m_lock;
+    std::vector<std::unique_ptr<client_t>> m_clients;
+
+    /** @brief the thread: accept, read commands, send
+     *
+     * @return Void.
+     */
+    void serve();
+
+    /** @brief take a new client off the listening socket
+     *
+     * @return Void.
+     */
+    void accept_client();
+
+    /** @brief read what a client sent
+     *
+     * @param client - the client
+     * @return bool - false if it went away
+     */
+    bool read_client(client_t *client);
+
+    /** @brief send as much of a client's queue as the socket takes
+     *
+     * @param client - the client
+     * @return bool - false if it went away
+     */
+    bool send_client(client_t *client);
+};
+
+#endif /* __IQ_SERVER_C_H__ */
@@ -31,16 +31,15 @@
 /*--------------------------------------------------------------------------
  * Type Definitions
  * -----------------------------------------------------------------------*/
-const int polyphase_resamp_filter::filter_size = 32;
 
 /*--------------------------------------------------------------------------
  * Function:
  *     make_polyphase_resamp_filter
  *
  */
-polyphase_resamp_filter::sptr polyphase_resamp_filter::make(float input_rate, float audio_rate, double low, double high, double tw)
+polyphase_resamp_filter::sptr polyphase_resamp_filter::make(float input_rate, float audio_rate, double low, double high, double tw, bool sc16, bool wide_tap)
 {
-    return gnuradio::get_initial_sptr(new polyphase_resamp_filter(input_rate, audio_rate, low, high, tw));
+    return gnuradio::get_initial_sptr(new polyphase_resamp_filter(input_rate, audio_rate, low, high, tw, sc16, wide_tap));
 }
 
 /*--------------------------------------------------------------------------
@@ -50,10 +49,10 @@ polyphase_resamp_filter::sptr polyphase_resamp_filter::make(float input_rate, fl
  *  Remarks:
  *     see prototype in polyphase_resamp_filter.h
  */
-polyphase_resamp_filter::polyphase_resamp_filter(float input_rate, float audio_rate, double low, double high, double tw)
+polyphase_resamp_filter::polyphase_resamp_filter(float input_rate, float audio_rate, double low, double high, double tw, bool sc16, bool wide_tap)
     : gr::hier_block2("polyphase_resamp_filter",//const std::string &name
-           gr::io_signature::make(1,1,sizeof(gr_complex)),//input_signature
-           gr::io_signature::make(1,1,sizeof(gr_complex)))//output_signature
+           gr::io_signature::make(1,1,sc16 ? 2*sizeof(int16_t) : sizeof(gr_complex)),//input_signature
+           gr::io_signature::make(1,2,sizeof(gr_complex)))//output_signature
 {
     m_input_rate = input_rate;
     int quad_rate = int(m_input_rate);
@@ -63,19 +62,69 @@ polyphase_resamp_filter::polyphase_resamp_filter(float input_rate, float audio_r
         Logger::crit("[polyphase_resamp_filter::polyphase_resamp_filter] quad_rate must be an integer multiple of audio_rate."+std::to_string(quad_rate)+" % "+std::to_string(m_audio_rate));
         throw "error in quad_rate";
     }
-    float decim_factor = get_decim_factor(quad_rate, m_audio_rate);
-    Logger::debug("[polyphase_resamp_filter::polyphase_resamp_filter] input_rate:"+std::to_string(input_rate)+", audio_rate:"+std::to_string(audio_rate)+",  quad_rate:"+std::to_string(quad_rate)+",  decim_factor:"+std::to_string(decim_factor));
+    std::vector<int> stages = Receiver_Util::get_rate_stages(quad_rate / m_audio_rate);
+    Logger::debug("[polyphase_resamp_filter::polyphase_resamp_filter] input_rate:"+std::to_string(input_rate)+", audio_rate:"+std::to_string(audio_rate)+",  quad_rate:"+std::to_string(quad_rate)+",  stages:"+std::to_string(stages.size()));
 
-    // do the I & Q resample with a pfb_arb_resampler_ccf
-    std::vector<float> resamp_taps = get_resamp_filter_taps(decim_factor, polyphase_resamp_filter::filter_size);
-    m_resamp_filter = gr::filter::pfb_arb_resampler_ccf::make(decim_factor,resamp_taps, polyphase_resamp_filter::filter_size);
+    if(sc16 && stages.empty())
+    {
+        Logger::crit("[polyphase_resamp_filter::polyphase_resamp_filter] sc16 needs at least one decimation stage.");
+        throw "error in quad_rate";
+    }
+
+    // decimate the I & Q down to audio_rate, a stage at a time
+    double rate = quad_rate;
+    for(size_t i = 0; i < stages.size(); i++)
+    {
+        // the first stage is also output 1, which a ring or an I & Q
+        // server may use all of
+        bool clean = (i + 1 == stages.size()) || (wide_tap && 0 == i);
+        std::vector<float> taps = get_decim_taps(rate, stages[i], clean);
+        Logger::debug("[polyphase_resamp_filter::polyphase_resamp_filter] decimation "+std::to_string(stages[i])+"  number of taps: "+std::to_string(taps.size()));
+        if(sc16 && 0 == i)
+        {
+            m_xlating = xlating_decim_sc16_c::make(stages[i], taps, 0.0, rate);
+        }
+        else
+        {
+            m_decimators.push_back(gr::filter::fir_filter_ccf::make(stages[i], taps));
+        }
+        rate /= stages[i];
+    }
     // do a complex fir filter with complex_band_pass taps
     std::vector<gr_complex> filter_taps = get_fir_filter_taps( m_audio_rate, low, high, tw);
     m_filter = gr::filter::fir_filter_ccc::make(1, filter_taps);
 
-    connect( self(), 0, m_resamp_filter, 0);
-    connect( m_resamp_filter, 0, m_filter, 0); 
+    gr::basic_block_sptr last = self();
+    if( nullptr != m_xlating )
+    {
+        connect( last, 0, m_xlating, 0);
+        last = m_xlating;
+    }
+    for(gr::filter::fir_filter_ccf::sptr decimator : m_decimators)
+    {
+        connect( last, 0, decimator, 0);
+        last = decimator;
+    }
+    connect( last, 0, m_filter, 0);
     connect( m_filter, 0, self(), 0);
+    // output 1 is the first stage's, for anything that wants the wider view
+    m_tap_rate = quad_rate;
+    m_tap_width = m_audio_rate;
+    if( nullptr != m_xlating )
+    {
+        connect( m_xlating, 0, self(), 1);
+        m_tap_rate /= stages[0];
+    }
+    else if( !m_decimators.empty() )
+    {
+        connect( m_decimators[0], 0, self(), 1);
+        m_tap_rate /= stages[0];
+    }
+    if( !stages.empty() && (wide_tap || 1 == stages.size()) )
+    {
+        // the clean design's passband, see get_decim_taps
+        m_tap_width = 0.6 * m_tap_rate;
+    }
 }
 
 /*--------------------------------------------------------------------------
@@ -104,36 +153,51 @@ void polyphase_resamp_filter::set_filter(double low, double high, double tw)
 
 /*--------------------------------------------------------------------------
  * Function:
- *     get_decim_factor
- *
- *  Remarks:
- *     see prototype in polyphase_resamp_filter.h
+ *     set_offset
  */
-float polyphase_resamp_filter::get_decim_factor(int quad_rate, int audio_rate)
+void polyphase_resamp_filter::set_offset(double offset)
 {
-    bool do_decim = (audio_rate != quad_rate);
-    float audio = (float)audio_rate;
-    float quad = (float)quad_rate;
-    float decim_factor = 1;
-    if(do_decim)
+    if( nullptr != m_xlating )
     {
-        decim_factor = audio / quad;
+        m_xlating->set_center_freq(offset);
     }
-    return decim_factor;
 }
 
 /*--------------------------------------------------------------------------
  * Function:
- *     get_resamp_filter_taps
+ *     get_tap_rate
+ */
+double polyphase_resamp_filter::get_tap_rate()
+{
+    return m_tap_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_tap_width
+ */
+double polyphase_resamp_filter::get_tap_width()
+{
+    return m_tap_width;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_decim_taps
  *
  *  Remarks:
  *     see prototype in polyphase_resamp_filter.h
  */
-std::vector<float> polyphase_resamp_filter::get_resamp_filter_taps(float decim_factor, unsigned int size)
+std::vector<float> polyphase_resamp_filter::get_decim_taps(double in_rate, int decim, bool clean)
 {
-    double cutoff = decim_factor > 1.0 ? 0.4 : 0.4*decim_factor;
-    double tw = decim_factor > 1.0 ? 0.2 : 0.2*decim_factor;
-    return gr::filter::firdes::low_pass(size,size,cutoff,tw);
+    double out_rate = in_rate / decim;
+    if(clean)
+    {
+        // nothing may alias into the output; flat to +/- 0.3*out_rate
+        return gr::filter::firdes::low_pass(1.0, in_rate, 0.4*out_rate, 0.2*out_rate);
+    }
+    // only what folds onto +/- audio_rate/2 matters, the later stages take the rest
+    return gr::filter::firdes::low_pass(1.0, in_rate, 0.5*out_rate, out_rate - m_audio_rate);
 }
 
 /*--------------------------------------------------------------------------
@@ -156,3 +220,18 @@ std::vector<gr_complex> polyphase_resamp_filter::get_fir_filter_taps(double samp
     return gr::filter::firdes::complex_band_pass(1.0, sample_freq, low, high, transition_width);
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> polyphase_resamp_filter::get_blocks()
+{
+    std::vector<gr::block_sptr> blocks;
+    if( nullptr != m_xlating )
+    {
+        blocks.push_back(m_xlating);
+    }
+    blocks.insert(blocks.end(), m_decimators.begin(), m_decimators.end());
+    blocks.push_back(m_filter);
+    return blocks;
+}
@@ -26,8 +26,9 @@
  * Include Files
  * -----------------------------------------------------------------------*/
 #include <gnuradio/hier_block2.h>
-#include <gnuradio/filter/pfb_arb_resampler_ccf.h>
+#include <gnuradio/filter/fir_filter_ccf.h>
 #include <gnuradio/filter/fir_filter_ccc.h>
+#include "receivers/xlating_decim_sc16_c.h"
 #include <vector>
 #include <gnuradio/gr_complex.h>
 
@@ -39,11 +40,18 @@ public:
 /*--------------------------------------------------------------------------
  * Type Definitions
  * -----------------------------------------------------------------------*/
-    /** shared pointer to functional block to down sample received data */
+    /** shared pointer to functional block to down sample received data
+     *
+     * The decimation runs in stages from Receiver_Util::get_rate_stages;
+     * GNU Radio's decimating FIR only computes the outputs it keeps, so
+     * each stage is a polyphase filter.  With sc16 the input is 16 bit
+     * I & Q and the first stage is an xlating_decim_sc16_c, which also
+     * does the tuning.
+     */
     typedef boost::shared_ptr<polyphase_resamp_filter> sptr;
 
     /** pointer to a functional block to down sample received data */
-    static sptr make(float input_rate, float audio_rate, double low, double high, double tw);
+    static sptr make(float input_rate, float audio_rate, double low, double high, double tw, bool sc16 = false, bool wide_tap = false);
 
 
 /*--------------------------------------------------------------------------
@@ -57,8 +65,11 @@ protected:
      * @param low - this is the low frequency of the bandpass filter
      * @param high - high frequency of the bandpass filter
      * @param tw - transition width of the bandpass fitler
+     * @param sc16 - true if the input is 16 bit I & Q pairs
+     * @param wide_tap - keep all of output 1 free of aliases, not just
+     *                   the audio band the later stages keep
      */
-    polyphase_resamp_filter(float input_rate, float audio_rate, double low, double high, double tw);
+    polyphase_resamp_filter(float input_rate, float audio_rate, double low, double high, double tw, bool sc16, bool wide_tap);
 
 public:
     /** @brief Deconstructor
@@ -75,28 +86,51 @@ public:
      */
     void set_filter(double low, double high, double tw);
 
+    /** @brief tune the sc16 first stage; the float path has a rotator
+     *         in front instead
+     *
+     * @param offset - frequency in Hz relative to the SDR's
+     * @return Void.
+     */
+    void set_offset(double offset);
+
+    /** @brief sample rate of output 1, the first decimation stage's
+     *
+     * @return double
+     */
+    double get_tap_rate();
+
+    /** @brief the width of output 1 that is flat and free of aliases;
+     *         the audio rate unless it was made wide_tap
+     *
+     * @return double - Hz, centered on the SDR frequency
+     */
+    double get_tap_width();
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
 private:
-    static const int filter_size;
     float m_input_rate;
     int m_audio_rate;
-    gr::filter::pfb_arb_resampler_ccf::sptr m_resamp_filter;
+    double m_tap_rate;
+    double m_tap_width;
+    xlating_decim_sc16_c::sptr m_xlating;
+    std::vector<gr::filter::fir_filter_ccf::sptr> m_decimators;
     gr::filter::fir_filter_ccc::sptr m_filter;
 
-    /** @brief return the decimation factor
-     *
-     * @param int quad_rate
-     * @param int audio_rate
-     * @return float
-     */
-    float get_decim_factor(int quad_rate, int audio_rate);
-
-    /** @brief get the taps for the resamp filter
+    /** @brief get the taps for one decimation stage
      *
-     * @param float - result of get_decim_factor function
-     * @param unsigned int - filter size
+     * @param double in_rate - input rate of the stage
+     * @param int decim - decimation of the stage
+     * @param bool clean - true if the stage's whole output is used: the
+     *                     one that makes audio_rate, or a wide tap
      * @return std::vector<float>
      */
-    std::vector<float> get_resamp_filter_taps(float decim_factor, unsigned int size);
+    std::vector<float> get_decim_taps(double in_rate, int decim, bool clean);
 
     /** @brief return the taps for the fir filter
      *
@@ -24,6 +24,7 @@
  * Include Files
  * -----------------------------------------------------------------------*/
 #include "receivers/receiver_util.h"
+#include <algorithm>
 
 const float Receiver_Util::PREF_QUAD_RATE = 250000.0;
 const float Receiver_Util::PREF_AUDIO_RATE = 125000.0;
@@ -32,6 +33,9 @@ const std::string Receiver_Util::STR_LSB = "LSB";
 const std::string Receiver_Util::STR_USB = "USB";
 const std::string Receiver_Util::STR_Invalid = "Invalid";
 
+// longest stage; above this the filters get long for what they save
+static const int max_stage = 9;
+
 /*--------------------------------------------------------------------------
  * Function:
  *     is_ratio_valid
@@ -41,3 +45,37 @@ bool Receiver_Util::is_ratio_valid(float input_rate, float audio_rate)
     return (0 == (int(input_rate) % int(audio_rate)));
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_rate_stages
+ */
+std::vector<int> Receiver_Util::get_rate_stages(int factor)
+{
+    // prime factors, largest first
+    std::vector<int> primes;
+    for(int p = 2; p <= factor; p++)
+    {
+        while(0 == (factor % p))
+        {
+            primes.push_back(p);
+            factor /= p;
+        }
+    }
+    std::reverse(primes.begin(), primes.end());
+
+    // pack them into stages as large as max_stage allows
+    std::vector<int> stages;
+    for(int p : primes)
+    {
+        if(stages.empty() || stages.back() * p > max_stage)
+        {
+            stages.push_back(p);
+        }
+        else
+        {
+            stages.back() *= p;
+        }
+    }
+    std::sort(stages.begin(), stages.end(), std::greater<int>());
+    return stages;
+}
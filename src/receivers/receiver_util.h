@@ -26,6 +26,7 @@
  * Include Files
  * -----------------------------------------------------------------------*/
 #include <string>
+#include <vector>
 
 class Receiver_Util
 {
@@ -70,6 +71,17 @@ public:
      */
     static bool is_ratio_valid(float input_rate, float audio_rate);
 
+    /** @brief split a rate change into stages of at most max_stage each
+     *
+     * Largest stages first, the order to decimate in; interpolate in the
+     * reverse order.  Each stage's filter only has to protect the final
+     * band, so a few short filters cost less than one long one.
+     *
+     * @param factor - the whole decimation or interpolation factor
+     * @return std::vector<int> - stage factors; empty for factor 1
+     */
+    static std::vector<int> get_rate_stages(int factor);
+
 private:
     /** @brief Constructor
      *
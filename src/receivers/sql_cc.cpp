@@ -95,3 +95,11 @@ double sql_cc::get_sql_level(void)
     return m_sql_level;
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> sql_cc::get_blocks()
+{
+    return { m_sql };
+}
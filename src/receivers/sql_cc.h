@@ -27,6 +27,7 @@
  * -----------------------------------------------------------------------*/
 #include <gnuradio/hier_block2.h>
 #include <gnuradio/analog/simple_squelch_cc.h>
+#include <vector>
 
 class sql_cc;
 
@@ -70,6 +71,12 @@ public:
      */
     double get_sql_level(void);
 
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
 private:
     double m_sql_level;
     gr::analog::simple_squelch_cc::sptr m_sql;
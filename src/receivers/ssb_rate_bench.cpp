@@ -0,0 +1,154 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Benchmark for the audio rate: the CPU the receive and transmit chains
+ * take at 48, 24 and 12 kHz audio, against the LimeSDR rates.
+ *
+ * Each case pushes seconds of noise through ssbrx or ssbtx into a null
+ * sink as fast as it goes, and reports CPU seconds per second of
+ * signal.  The "decoder" rows time the 4:1 decimation WSJT-X and JS8Call
+ * do on 48 kHz input before decoding, the cost the far end saves when
+ * it is handed 12 kHz.
+ *
+ * usage: ssb_rate_bench [seconds]
+ */
+
+#include "receivers/ssbrx.h"
+#include "transmitters/ssbtx.h"
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/head.h>
+#include <gnuradio/blocks/null_sink.h>
+#include <gnuradio/blocks/vector_source_c.h>
+#include <gnuradio/blocks/vector_source_f.h>
+#include <gnuradio/filter/fir_filter_fff.h>
+#include <gnuradio/filter/firdes.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+// LimeSDR-Mini and LimeSDR-USB sample rates, see Flow_Chart
+static const double input_rates[] = { 27 * 48000.0, 32 * 48000.0 };
+static const double audio_rates[] = { 48000.0, 24000.0, 12000.0 };
+
+#define NELEMS(x) (sizeof(x)/sizeof(x[0]))
+
+static double
+cpu_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// run tb to completion; returns CPU seconds per second of signal
+static double
+time_flowgraph(gr::top_block_sptr tb, double seconds)
+{
+  double start = cpu_seconds();
+  tb->run();
+  return (cpu_seconds() - start) / seconds;
+}
+
+static double
+bench_rx(double input_rate, double audio_rate, double seconds)
+{
+  std::vector<gr_complex> noise(65536);
+  for(unsigned int i = 0; i < noise.size(); i++)
+    noise[i] = gr_complex(2.0f * rand() / RAND_MAX - 1.0f,
+                          2.0f * rand() / RAND_MAX - 1.0f);
+
+  gr::top_block_sptr tb = gr::make_top_block("ssb_rate_bench");
+  gr::blocks::vector_source_c::sptr src = gr::blocks::vector_source_c::make(noise, true);
+  gr::blocks::head::sptr head = gr::blocks::head::make(sizeof(gr_complex),
+                                                       (unsigned long long) (input_rate * seconds));
+  ssbrx::sptr rx = ssbrx::make(input_rate, audio_rate);
+  gr::blocks::null_sink::sptr sink = gr::blocks::null_sink::make(sizeof(float));
+  tb->connect(src, 0, head, 0);
+  tb->connect(head, 0, rx, 0);
+  tb->connect(rx, 0, sink, 0);
+  return time_flowgraph(tb, seconds);
+}
+
+static double
+bench_tx(double input_rate, double audio_rate, double seconds)
+{
+  std::vector<float> noise(65536);
+  for(unsigned int i = 0; i < noise.size(); i++)
+    noise[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+
+  gr::top_block_sptr tb = gr::make_top_block("ssb_rate_bench");
+  gr::blocks::vector_source_f::sptr src = gr::blocks::vector_source_f::make(noise, true);
+  gr::blocks::head::sptr head = gr::blocks::head::make(sizeof(float),
+                                                       (unsigned long long) (audio_rate * seconds));
+  ssbtx::sptr tx = ssbtx::make(input_rate, audio_rate);
+  tx->ptt_on();
+  gr::blocks::null_sink::sptr sink = gr::blocks::null_sink::make(sizeof(gr_complex));
+  tb->connect(src, 0, head, 0);
+  tb->connect(head, 0, tx, 0);
+  tb->connect(tx, 0, sink, 0);
+  return time_flowgraph(tb, seconds);
+}
+
+// what the decoder spends getting 48 kHz down to 12 kHz
+static double
+bench_decoder(double seconds)
+{
+  const double rate = 48000.0;
+  std::vector<float> noise(65536);
+  for(unsigned int i = 0; i < noise.size(); i++)
+    noise[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+
+  gr::top_block_sptr tb = gr::make_top_block("ssb_rate_bench");
+  gr::blocks::vector_source_f::sptr src = gr::blocks::vector_source_f::make(noise, true);
+  gr::blocks::head::sptr head = gr::blocks::head::make(sizeof(float),
+                                                       (unsigned long long) (rate * seconds));
+  std::vector<float> taps = gr::filter::firdes::low_pass_2(1.0, rate, 5000.0, 1000.0, 60);
+  gr::filter::fir_filter_fff::sptr decim = gr::filter::fir_filter_fff::make(4, taps);
+  gr::blocks::null_sink::sptr sink = gr::blocks::null_sink::make(sizeof(float));
+  tb->connect(src, 0, head, 0);
+  tb->connect(head, 0, decim, 0);
+  tb->connect(decim, 0, sink, 0);
+  return time_flowgraph(tb, seconds);
+}
+
+int
+main(int argc, char **argv)
+{
+  double seconds = argc > 1 ? atof(argv[1]) : 20.0;
+  if(seconds <= 0) {
+    fprintf(stderr, "usage: %s [seconds]\n", argv[0]);
+    return 1;
+  }
+
+  printf("CPU seconds per second of signal, %g s per case\n", seconds);
+  printf("%-10s %-10s %10s %10s\n", "input", "audio", "ssbrx", "ssbtx");
+  for(unsigned int i = 0; i < NELEMS(input_rates); i++) {
+    for(unsigned int a = 0; a < NELEMS(audio_rates); a++) {
+      double rx = bench_rx(input_rates[i], audio_rates[a], seconds);
+      double tx = bench_tx(input_rates[i], audio_rates[a], seconds);
+      printf("%-10.0f %-10.0f %10.4f %10.4f\n", input_rates[i], audio_rates[a], rx, tx);
+    }
+  }
+
+  printf("\ndecoder 48000 -> 12000 resample: %.4f\n", bench_decoder(seconds));
+  return 0;
+}
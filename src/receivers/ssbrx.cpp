@@ -37,32 +37,37 @@
  * Function:
  *     make_ssbrx
  */
-ssbrx::sptr ssbrx::make(float input_rate, float audio_rate)
+ssbrx::sptr ssbrx::make(float input_rate, float audio_rate, bool sc16, bool wide_tap)
 {
-    return gnuradio::get_initial_sptr(new ssbrx(input_rate, audio_rate));
+    return gnuradio::get_initial_sptr(new ssbrx(input_rate, audio_rate, sc16, wide_tap));
 }
 
 /*--------------------------------------------------------------------------
  * Function:
  *     ssbrx
  */
-ssbrx::ssbrx(float input_rate, float audio_rate)
+ssbrx::ssbrx(float input_rate, float audio_rate, bool sc16, bool wide_tap)
     : gr::hier_block2("ssbrx",
-            gr::io_signature::make(1,1,sizeof(gr_complex)),
-            gr::io_signature::make(1,1,sizeof(float)))
+            gr::io_signature::make(1,1,sc16 ? 2*sizeof(int16_t) : sizeof(gr_complex)),
+            gr::io_signature::make3(1,3,sizeof(float),sizeof(gr_complex),sizeof(gr_complex))),
+      m_audio_rate(audio_rate)
 {
     // reduce the data rate from input_rate down to audio_rate
-    m_resamp_filter = polyphase_resamp_filter::make(input_rate, audio_rate, -5000.0, 5000.0, 1000.0);
+    m_resamp_filter = polyphase_resamp_filter::make(input_rate, audio_rate, -5000.0, 5000.0, 1000.0, sc16, wide_tap);
     // do the squelch using simple squelch_cc
     m_sql = sql_cc::make();
     // do demod
     m_demod = gr::blocks::complex_to_real::make(1);
 
+    // the SDR's rx_time tags ride along; each decimator scales their offsets
     connect( self(), 0, m_resamp_filter, 0);
     connect( m_resamp_filter, 0, m_sql, 0);
     connect( m_sql, 0, m_demod, 0);
     connect( m_demod, 0, self(), 0);
-    
+    // output 1 is the I & Q after the first decimation stage
+    connect( m_resamp_filter, 1, self(), 1);
+    // output 2 is the filtered I & Q at the audio rate, before the squelch
+    connect( m_resamp_filter, 0, self(), 2);
 }
 
 /*--------------------------------------------------------------------------
@@ -82,6 +87,15 @@ void ssbrx::set_filter(double low, double high, double tw)
     m_resamp_filter->set_filter(low, high, tw);
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_offset
+ */
+void ssbrx::set_offset(double offset)
+{
+    m_resamp_filter->set_offset(offset);
+}
+
 /*--------------------------------------------------------------------------
  * Function:
  *     set_sql_level
@@ -100,3 +114,44 @@ double ssbrx::get_sql_level(void)
     return m_sql->get_sql_level();
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_tap_rate
+ */
+double ssbrx::get_tap_rate(void)
+{
+    return m_resamp_filter->get_tap_rate();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_tap_width
+ */
+double ssbrx::get_tap_width(void)
+{
+    return m_resamp_filter->get_tap_width();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_audio_rate
+ */
+double ssbrx::get_audio_rate(void)
+{
+    return m_audio_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> ssbrx::get_blocks()
+{
+    std::vector<gr::block_sptr> blocks = m_resamp_filter->get_blocks();
+    for( gr::block_sptr block : m_sql->get_blocks() )
+    {
+        blocks.push_back(block);
+    }
+    blocks.push_back(m_demod);
+    return blocks;
+}
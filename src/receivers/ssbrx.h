@@ -42,7 +42,7 @@ public:
     typedef boost::shared_ptr<ssbrx> sptr;
 
     /** returns a single sideband receiver */
-    static sptr make(float input_rate, float audio_rate);
+    static sptr make(float input_rate, float audio_rate, bool sc16 = false, bool wide_tap = false);
 
 /*--------------------------------------------------------------------------
  * Function Definitions
@@ -52,8 +52,10 @@ protected:
      *
      * @param input_rate - data rate of the receiver
      * @param audio_rate - data rate out to audio
+     * @param sc16 - true if the input is 16 bit I & Q pairs
+     * @param wide_tap - keep all of output 1 free of aliases
      */
-    ssbrx(float input_rate, float audio_rate);
+    ssbrx(float input_rate, float audio_rate, bool sc16, bool wide_tap);
 
 public:
     /** @brief Deconstructor
@@ -70,6 +72,13 @@ public:
      */
     void set_filter(double low, double high, double tw);
 
+    /** @brief tune an sc16 receiver, see polyphase_resamp_filter
+     *
+     * @param offset - frequency in Hz relative to the SDR's
+     * @return Void.
+     */
+    void set_offset(double offset);
+
     /** @brief sets the sql level
      *
      * @param level_db - level in db
@@ -83,10 +92,36 @@ public:
      */
     double get_sql_level(void);
 
+    /** @brief sample rate of output 1, the I & Q after the first
+     *         decimation stage
+     *
+     * @return double
+     */
+    double get_tap_rate(void);
+
+    /** @brief the width of output 1 that is flat and free of aliases
+     *
+     * @return double - Hz, centered on the SDR frequency
+     */
+    double get_tap_width(void);
+
+    /** @brief sample rate of output 2, the filtered I & Q
+     *
+     * @return double
+     */
+    double get_audio_rate(void);
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
 private:
     polyphase_resamp_filter::sptr m_resamp_filter;
     sql_cc::sptr m_sql;
     gr::blocks::complex_to_real::sptr m_demod;
+    double m_audio_rate;
 
 };
 
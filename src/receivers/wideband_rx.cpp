@@ -0,0 +1,184 @@
+/**-------------------------------------------------------------------------
+ * @file wideband_rx.cpp
+ * @brief receive several single side band slices from one wideband stream
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "receivers/wideband_rx.h"
+#include "receivers/receiver_util.h"
+#include "application/logger.h"
+#include <gnuradio/filter/firdes.h>
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/io_signature.h>
+#include <cmath>
+#include <stdexcept>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// widest signal either side of a slice's dial that must pass untouched
+static const double slice_band = 5000.0;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+wideband_rx::sptr wideband_rx::make(float input_rate, float audio_rate, float channel_spacing, size_t nslices)
+{
+    return gnuradio::get_initial_sptr(new wideband_rx(input_rate, audio_rate, channel_spacing, nslices));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     wideband_rx
+ */
+wideband_rx::wideband_rx(float input_rate, float audio_rate, float channel_spacing, size_t nslices)
+    : gr::hier_block2("wideband_rx",
+            gr::io_signature::make(1,1,sizeof(gr_complex)),
+            gr::io_signature::make(nslices,nslices,sizeof(float)))
+{
+    m_input_rate = input_rate;
+    m_channel_spacing = channel_spacing;
+    if(!Receiver_Util::is_ratio_valid(input_rate, channel_spacing))
+    {
+        Logger::crit("[wideband_rx::wideband_rx] input_rate must be an integer multiple of the channel spacing."+std::to_string(input_rate)+" % "+std::to_string(channel_spacing));
+        throw std::runtime_error("wideband_rx");
+    }
+    m_nchannels = int(input_rate / channel_spacing);
+
+    // oversample so a signal between two channels is whole in the nearer
+    // one; the filter bank needs the oversample to divide the channels
+    int oversample = 2;
+    while(0 != (m_nchannels % oversample))
+    {
+        oversample++;
+    }
+    m_channel_rate = channel_spacing * oversample;
+    Logger::debug("[wideband_rx::wideband_rx] channels:"+std::to_string(m_nchannels)+", channel_rate:"+std::to_string(m_channel_rate)+", slices:"+std::to_string(nslices));
+
+    std::vector<float> taps = get_channel_taps();
+    Logger::debug("[wideband_rx::wideband_rx] number of taps: "+std::to_string(taps.size()));
+    m_channelizer = gr::filter::pfb_channelizer_ccf::make(m_nchannels, taps, oversample);
+
+    connect( self(), 0, m_channelizer, 0);
+    for(size_t i = 0; i < nslices; i++)
+    {
+        m_rotators.push_back(gr::blocks::rotator_cc::make(0.0));
+        m_receivers.push_back(ssbrx::make(m_channel_rate, audio_rate));
+        m_channel_map.push_back(0);
+        m_offsets.push_back(0.0);
+
+        connect( m_channelizer, i, m_rotators[i], 0);
+        connect( m_rotators[i], 0, m_receivers[i], 0);
+        connect( m_receivers[i], 0, self(), i);
+    }
+    m_channelizer->set_channel_map(m_channel_map);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~wideband_rx
+ */
+wideband_rx::~wideband_rx()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_offset
+ */
+bool wideband_rx::set_offset(size_t slice, double offset)
+{
+    if(slice >= m_receivers.size() || std::abs(offset) > get_max_offset())
+    {
+        return false;
+    }
+
+    // channel 0 is centered on the SDR frequency, the negative ones wrap
+    int channel = (int)std::lround(offset / m_channel_spacing);
+    double residual = offset - channel * m_channel_spacing;
+    m_channel_map[slice] = (channel + m_nchannels) % m_nchannels;
+    m_channelizer->set_channel_map(m_channel_map);
+    m_rotators[slice]->set_phase_inc(-2.0 * M_PI * residual / m_channel_rate);
+    m_offsets[slice] = offset;
+    Logger::debug("[wideband_rx::set_offset] slice "+std::to_string(slice)+": channel "+std::to_string(channel)+", residual "+std::to_string(residual));
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_offset
+ */
+double wideband_rx::get_offset(size_t slice)
+{
+    return m_offsets.at(slice);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_max_offset
+ */
+double wideband_rx::get_max_offset()
+{
+    // stay clear of the channel at half the SDR rate, it is both signs
+    return (m_nchannels - 1) / 2 * m_channel_spacing + m_channel_spacing / 2 - slice_band;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_receiver
+ */
+ssbrx::sptr wideband_rx::get_receiver(size_t slice)
+{
+    return m_receivers.at(slice);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> wideband_rx::get_blocks()
+{
+    std::vector<gr::block_sptr> blocks = { m_channelizer };
+    for(size_t i = 0; i < m_receivers.size(); i++)
+    {
+        blocks.push_back(m_rotators[i]);
+        for(gr::block_sptr block : m_receivers[i]->get_blocks())
+        {
+            blocks.push_back(block);
+        }
+    }
+    return blocks;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_channel_taps
+ */
+std::vector<float> wideband_rx::get_channel_taps()
+{
+    // a slice is up to half a spacing off center, plus its own band
+    double pass = m_channel_spacing / 2 + slice_band;
+    // anything past this folds back inside pass at the channel rate
+    double stop = m_channel_rate - pass;
+    return gr::filter::firdes::low_pass_2(1.0, m_input_rate, (pass + stop) / 2, stop - pass, 70);
+}
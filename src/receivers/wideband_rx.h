@@ -0,0 +1,127 @@
+/**-------------------------------------------------------------------------
+ * @file wideband_rx.h
+ * @brief receive several single side band slices from one wideband stream
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __WIDEBAND_RX_H__
+#define __WIDEBAND_RX_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/hier_block2.h>
+#include <gnuradio/filter/pfb_channelizer_ccf.h>
+#include <gnuradio/blocks/rotator_cc.h>
+#include "receivers/ssbrx.h"
+#include <vector>
+
+/**
+ * A polyphase filter bank splits the SDR stream into channels spaced
+ * channel_spacing apart.  Each slice takes the channel nearest its
+ * offset, a rotator moves the rest of the way, and its own ssbrx makes
+ * the audio.  The filter bank costs one FFT per channel_spacing worth of
+ * input however many slices there are, and each slice's ssbrx runs at
+ * the channel rate instead of the SDR rate.
+ *
+ * Output i is slice i's audio.
+ */
+class wideband_rx : public gr::hier_block2
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the wideband receiver */
+    typedef boost::shared_ptr<wideband_rx> sptr;
+
+    /** returns a wideband receiver */
+    static sptr make(float input_rate, float audio_rate, float channel_spacing, size_t nslices);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param input_rate - data rate from the SDR
+     * @param audio_rate - data rate out to audio
+     * @param channel_spacing - must divide input_rate
+     * @param nslices - number of outputs
+     */
+    wideband_rx(float input_rate, float audio_rate, float channel_spacing, size_t nslices);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~wideband_rx();
+
+    /** @brief tune a slice
+     *
+     * @param slice - output number
+     * @param offset - from the SDR center frequency in Hz
+     * @return bool - false if offset is outside the stream
+     */
+    bool set_offset(size_t slice, double offset);
+
+    /** @brief get a slice's offset from the SDR center frequency
+     *
+     * @param slice - output number
+     * @return double
+     */
+    double get_offset(size_t slice);
+
+    /** @brief the largest offset set_offset() takes
+     *
+     * @return double
+     */
+    double get_max_offset();
+
+    /** @brief the receiver of a slice
+     *
+     * @param slice - output number
+     * @return ssbrx::sptr
+     */
+    ssbrx::sptr get_receiver(size_t slice);
+
+    /** @brief the GNU Radio blocks inside, the filter bank first
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
+private:
+    float m_input_rate;
+    float m_channel_spacing;
+    float m_channel_rate;
+    int m_nchannels;
+    gr::filter::pfb_channelizer_ccf::sptr m_channelizer;
+    std::vector<gr::blocks::rotator_cc::sptr> m_rotators;
+    std::vector<ssbrx::sptr> m_receivers;
+    std::vector<int> m_channel_map;
+    std::vector<double> m_offsets;
+
+    /** @brief get the taps for the filter bank's prototype filter
+     *
+     * @return std::vector<float>
+     */
+    std::vector<float> get_channel_taps();
+};
+
+#endif /* __WIDEBAND_RX_H__ */
@@ -0,0 +1,316 @@
+/**-------------------------------------------------------------------------
+ * @file xlating_decim_sc16_c.cpp
+ * @brief first decimation stage straight from 16 bit I & Q
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "receivers/xlating_decim_sc16_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define XLATING_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define XLATING_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// |hr| + |hi| <= sqrt(2) |h|, so sum(|h|) * sqrt(2) * 32768 stays under 2^31
+static const double max_tap_sum = 46000.0;
+// renormalize the rotator this often, in outputs
+static const int phase_renorm = 512;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     generic_dot
+ */
+static void generic_dot(const int16_t *x, const int16_t *a, const int16_t *b,
+                        size_t n, int32_t *re, int32_t *im)
+{
+    int32_t sum_re = 0;
+    int32_t sum_im = 0;
+    for(size_t k = 0; k < 2 * n; k++)
+    {
+        sum_re += (int32_t)a[k] * x[k];
+        sum_im += (int32_t)b[k] * x[k];
+    }
+    *re += sum_re;
+    *im += sum_im;
+}
+
+#if defined(__SSE2__)
+/*--------------------------------------------------------------------------
+ * Function:
+ *     sse2_dot
+ */
+static inline int32_t sse2_hsum(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+static void sse2_dot(const int16_t *x, const int16_t *a, const int16_t *b,
+                     size_t n, int32_t *re, int32_t *im)
+{
+    // four complex samples a step
+    size_t body = n & ~(size_t)3;
+    __m128i sum_re = _mm_setzero_si128();
+    __m128i sum_im = _mm_setzero_si128();
+    for(size_t k = 0; k < 2 * body; k += 8)
+    {
+        __m128i xv = _mm_loadu_si128((const __m128i *)(x + k));
+        sum_re = _mm_add_epi32(sum_re, _mm_madd_epi16(xv, _mm_loadu_si128((const __m128i *)(a + k))));
+        sum_im = _mm_add_epi32(sum_im, _mm_madd_epi16(xv, _mm_loadu_si128((const __m128i *)(b + k))));
+    }
+    *re += sse2_hsum(sum_re);
+    *im += sse2_hsum(sum_im);
+    generic_dot(x + 2 * body, a + 2 * body, b + 2 * body, n - body, re, im);
+}
+#endif
+
+#if defined(XLATING_HAVE_AVX2)
+/*--------------------------------------------------------------------------
+ * Function:
+ *     avx2_dot
+ */
+#define AVX2 __attribute__((target("avx2")))
+
+static AVX2 inline int32_t avx2_hsum(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+static AVX2 void avx2_dot(const int16_t *x, const int16_t *a, const int16_t *b,
+                          size_t n, int32_t *re, int32_t *im)
+{
+    // eight complex samples a step
+    size_t body = n & ~(size_t)7;
+    __m256i sum_re = _mm256_setzero_si256();
+    __m256i sum_im = _mm256_setzero_si256();
+    for(size_t k = 0; k < 2 * body; k += 16)
+    {
+        __m256i xv = _mm256_loadu_si256((const __m256i *)(x + k));
+        sum_re = _mm256_add_epi32(sum_re, _mm256_madd_epi16(xv, _mm256_loadu_si256((const __m256i *)(a + k))));
+        sum_im = _mm256_add_epi32(sum_im, _mm256_madd_epi16(xv, _mm256_loadu_si256((const __m256i *)(b + k))));
+    }
+    *re += avx2_hsum(sum_re);
+    *im += avx2_hsum(sum_im);
+    generic_dot(x + 2 * body, a + 2 * body, b + 2 * body, n - body, re, im);
+}
+#endif
+
+#if defined(XLATING_HAVE_NEON)
+/*--------------------------------------------------------------------------
+ * Function:
+ *     neon_dot
+ */
+static void neon_dot(const int16_t *x, const int16_t *a, const int16_t *b,
+                     size_t n, int32_t *re, int32_t *im)
+{
+    // four complex samples a step; the pairs are summed at the end
+    size_t body = n & ~(size_t)3;
+    int32x4_t sum_re = vdupq_n_s32(0);
+    int32x4_t sum_im = vdupq_n_s32(0);
+    for(size_t k = 0; k < 2 * body; k += 8)
+    {
+        int16x8_t xv = vld1q_s16(x + k);
+        int16x8_t av = vld1q_s16(a + k);
+        int16x8_t bv = vld1q_s16(b + k);
+        sum_re = vmlal_s16(sum_re, vget_low_s16(xv), vget_low_s16(av));
+        sum_re = vmlal_high_s16(sum_re, xv, av);
+        sum_im = vmlal_s16(sum_im, vget_low_s16(xv), vget_low_s16(bv));
+        sum_im = vmlal_high_s16(sum_im, xv, bv);
+    }
+    *re += vaddvq_s32(sum_re);
+    *im += vaddvq_s32(sum_im);
+    generic_dot(x + 2 * body, a + 2 * body, b + 2 * body, n - body, re, im);
+}
+#endif
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     pick_dot
+ */
+static xlating_decim_sc16_c::dot_t pick_dot(std::string *name)
+{
+#if defined(XLATING_HAVE_AVX2)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        *name = "avx2";
+        return &avx2_dot;
+    }
+#endif
+#if defined(__SSE2__)
+    *name = "sse2";
+    return &sse2_dot;
+#elif defined(XLATING_HAVE_NEON)
+    *name = "neon";
+    return &neon_dot;
+#else
+    *name = "generic";
+    return &generic_dot;
+#endif
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+xlating_decim_sc16_c::sptr xlating_decim_sc16_c::make(int decim, const std::vector<float> &taps, double offset, double rate)
+{
+    return gnuradio::get_initial_sptr(new xlating_decim_sc16_c(decim, taps, offset, rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     xlating_decim_sc16_c
+ */
+xlating_decim_sc16_c::xlating_decim_sc16_c(int decim, const std::vector<float> &taps, double offset, double rate)
+    : gr::sync_decimator("xlating_decim_sc16_c",
+          gr::io_signature::make(1, 1, 2 * sizeof(int16_t)),// input_signature
+          gr::io_signature::make(1, 1, sizeof(gr_complex)),// output_signature
+          decim),
+      m_proto(taps),
+      m_rate(rate),
+      m_phase(1, 0)
+{
+    std::string name;
+    m_dot = pick_dot(&name);
+    m_gain = make_taps(offset, &m_a, &m_b);
+    m_phase_inc = std::polar(1.0f, (float)(-2.0 * M_PI * offset * decim / m_rate));
+    set_history(m_proto.size());
+    Logger::debug("[xlating_decim_sc16_c::xlating_decim_sc16_c] "+std::to_string(m_proto.size())+" taps, decimation "
+        +std::to_string(decim)+", "+name);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~xlating_decim_sc16_c
+ */
+xlating_decim_sc16_c::~xlating_decim_sc16_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make_taps
+ */
+float xlating_decim_sc16_c::make_taps(double offset, std::vector<int16_t> *a, std::vector<int16_t> *b)
+{
+    size_t ntaps = m_proto.size();
+    std::vector<gr_complex> ctaps(ntaps);
+    double max_abs = 0;
+    double sum_abs = 0;
+    for(size_t k = 0; k < ntaps; k++)
+    {
+        // the same band pass as freq_xlating_fir_filter_ccf
+        ctaps[k] = m_proto[k] * std::polar(1.0f, (float)(2.0 * M_PI * offset * k / m_rate));
+        max_abs = std::max(max_abs, (double)std::max(std::abs(ctaps[k].real()), std::abs(ctaps[k].imag())));
+        sum_abs += std::abs(ctaps[k]);
+    }
+    double scale = 32767.0;
+    if(max_abs > 0)
+    {
+        scale = std::min(32767.0 / max_abs, max_tap_sum / sum_abs);
+    }
+
+    a->resize(2 * ntaps);
+    b->resize(2 * ntaps);
+    for(size_t k = 0; k < ntaps; k++)
+    {
+        // reversed, so the dot product walks the input forwards
+        gr_complex tap = ctaps[ntaps - 1 - k];
+        int16_t hr = (int16_t)std::lrint(tap.real() * scale);
+        int16_t hi = (int16_t)std::lrint(tap.imag() * scale);
+        (*a)[2 * k] = hr;
+        (*a)[2 * k + 1] = -hi;
+        (*b)[2 * k] = hi;
+        (*b)[2 * k + 1] = hr;
+    }
+    return (float)(1.0 / (scale * 32768.0));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_center_freq
+ */
+void xlating_decim_sc16_c::set_center_freq(double offset)
+{
+    // the taps are made here, not in the flowgraph thread
+    std::vector<int16_t> a;
+    std::vector<int16_t> b;
+    float gain = make_taps(offset, &a, &b);
+    gr_complex phase_inc = std::polar(1.0f, (float)(-2.0 * M_PI * offset * decimation() / m_rate));
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_a.swap(a);
+    m_b.swap(b);
+    m_gain = gain;
+    m_phase_inc = phase_inc;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int xlating_decim_sc16_c::work(int noutput_items,
+                               gr_vector_const_void_star &input_items,
+                               gr_vector_void_star &output_items)
+{
+    const int16_t *in = (const int16_t *)input_items[0];
+    gr_complex *out = (gr_complex *)output_items[0];
+    size_t ntaps = m_proto.size();
+    size_t step = 2 * decimation();
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    for(int i = 0; i < noutput_items; i++)
+    {
+        int32_t re = 0;
+        int32_t im = 0;
+        m_dot(in + i * step, &m_a[0], &m_b[0], ntaps, &re, &im);
+        out[i] = gr_complex(re * m_gain, im * m_gain) * m_phase;
+        m_phase *= m_phase_inc;
+        if(0 == i % phase_renorm)
+        {
+            m_phase /= std::abs(m_phase);
+        }
+    }
+    return noutput_items;
+}
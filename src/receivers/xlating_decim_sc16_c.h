@@ -0,0 +1,116 @@
+/**-------------------------------------------------------------------------
+ * @file xlating_decim_sc16_c.h
+ * @brief first decimation stage straight from 16 bit I & Q
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __XLATING_DECIM_SC16_C_H__
+#define __XLATING_DECIM_SC16_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_decimator.h>
+#include <gnuradio/gr_complex.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class xlating_decim_sc16_c;
+
+/**
+ * The first decimation stage for an SDR that streams 16 bit I & Q.  The
+ * low pass is moved up to the VFO's offset and quantized to 16 bits, so
+ * the filter runs on the integers as they come off the USB, and only
+ * the decimated samples are made into gr_complex.  It replaces both the
+ * rotator and the first fir_filter_ccf of the float path.
+ *
+ * Each complex tap is kept as the two pairs (hr, -hi) and (hi, hr),
+ * which line up with an (i, q) pair for pmaddwd and its NEON
+ * equivalent.  The taps are scaled so no sum of products can overflow
+ * 32 bits.
+ */
+class xlating_decim_sc16_c : public gr::sync_decimator
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the sc16 first stage */
+    typedef boost::shared_ptr<xlating_decim_sc16_c> sptr;
+
+    static sptr make(int decim, const std::vector<float> &taps, double offset, double rate);
+
+    /** dot product of n complex samples with the two tap pair arrays */
+    typedef void (*dot_t)(const int16_t *x, const int16_t *a, const int16_t *b,
+                          size_t n, int32_t *re, int32_t *im);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param decim - decimation
+     * @param taps - real low pass taps
+     * @param offset - frequency to move down to 0 Hz
+     * @param rate - input sample rate
+     */
+    xlating_decim_sc16_c(int decim, const std::vector<float> &taps, double offset, double rate);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~xlating_decim_sc16_c();
+
+    /** @brief move the pass band to a new offset
+     *
+     * @param offset - frequency in Hz relative to the SDR's
+     * @return Void.
+     */
+    void set_center_freq(double offset);
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    std::vector<float> m_proto;         // the low pass, before it is moved
+    double m_rate;
+    dot_t m_dot;
+
+    // swapped in whole by set_center_freq
+    std::mutex m_lock;
+    std::vector<int16_t> m_a;           // (hr, -hi) per tap, reversed
+    std::vector<int16_t> m_b;           // (hi, hr) per tap, reversed
+    float m_gain;                       // back to full scale 1.0
+    gr_complex m_phase;
+    gr_complex m_phase_inc;
+
+    /** @brief rotate, reverse and quantize the taps for an offset
+     *
+     * @param offset - frequency in Hz
+     * @param a - out: the (hr, -hi) pairs
+     * @param b - out: the (hi, hr) pairs
+     * @return float - what the integer sums are to be multiplied by
+     */
+    float make_taps(double offset, std::vector<int16_t> *a, std::vector<int16_t> *b);
+};
+
+#endif /* __XLATING_DECIM_SC16_C_H__ */
@@ -0,0 +1,234 @@
+/**-------------------------------------------------------------------------
+ * @file iq_correct_c.cpp
+ * @brief track and remove the DC offset and I & Q imbalance of the SDR
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/iq_correct_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// one sample in this many feeds the estimates
+static const int stats_decim = 16;
+// time constant of the estimates in seconds
+static const double tracking_time = 1.0;
+static const float sc16_scale = 32768.0f;
+// beyond these the estimate is not trusted
+static const float max_phase = 0.3f;
+static const float max_gain = 1.5f;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+iq_correct_c::sptr iq_correct_c::make(double rate, bool sc16)
+{
+    return gnuradio::get_initial_sptr(new iq_correct_c(rate, sc16));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     iq_correct_c
+ */
+iq_correct_c::iq_correct_c(double rate, bool sc16)
+    : gr::sync_block("iq_correct_c",
+          gr::io_signature::make(1, 1, sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(1, 1, sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex))),// output_signature
+      m_sc16(sc16),
+      m_alpha((float)(stats_decim / (tracking_time * rate))),
+      m_enabled(true),
+      m_reset(false),
+      m_nstats(0),
+      m_skip(0),
+      m_dc(0, 0),
+      m_ii(0),
+      m_qq(0),
+      m_iq(0)
+{
+    m_coeffs.dc = gr_complex(0, 0);
+    m_coeffs.phase = 0;
+    m_coeffs.gain = 1;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~iq_correct_c
+ */
+iq_correct_c::~iq_correct_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_enabled
+ */
+void iq_correct_c::set_enabled(bool enable)
+{
+    m_enabled.store(enable, std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_enabled
+ */
+bool iq_correct_c::get_enabled()
+{
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_coeffs
+ */
+iq_correct_c::coeffs_t iq_correct_c::get_coeffs()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_coeffs;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     reset
+ */
+void iq_correct_c::reset()
+{
+    // work() does it, it owns the estimates
+    m_reset.store(true, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     update
+ */
+void iq_correct_c::update(gr_complex x)
+{
+    // a plain mean until there is a time constant's worth
+    m_nstats++;
+    float alpha = std::max(m_alpha, 1.0f / m_nstats);
+    m_dc += alpha * (x - m_dc);
+    x -= m_dc;
+    m_ii += alpha * (x.real() * x.real() - m_ii);
+    m_qq += alpha * (x.imag() * x.imag() - m_qq);
+    m_iq += alpha * (x.real() * x.imag() - m_iq);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int iq_correct_c::work(int noutput_items,
+                       gr_vector_const_void_star &input_items,
+                       gr_vector_void_star &output_items)
+{
+    if(m_reset.exchange(false, std::memory_order_acquire))
+    {
+        m_nstats = 0;
+        m_dc = gr_complex(0, 0);
+        m_ii = m_qq = m_iq = 0;
+    }
+
+    // correct with what the last call found
+    gr_complex dc = m_coeffs.dc;
+    float phase = m_coeffs.phase;
+    float gain = m_coeffs.gain;
+    bool enabled = m_enabled.load(std::memory_order_relaxed);
+
+    if(m_sc16)
+    {
+        const int16_t *in = (const int16_t *)input_items[0];
+        int16_t *out = (int16_t *)output_items[0];
+        for(int i = m_skip; i < noutput_items; i += stats_decim)
+        {
+            update(gr_complex(in[2 * i], in[2 * i + 1]) / sc16_scale);
+        }
+        if(enabled)
+        {
+            float dc_i = dc.real() * sc16_scale;
+            float dc_q = dc.imag() * sc16_scale;
+            for(int i = 0; i < 2 * noutput_items; i += 2)
+            {
+                float x_i = in[i] - dc_i;
+                float x_q = gain * (in[i + 1] - dc_q - phase * x_i);
+                out[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, std::nearbyint(x_i)));
+                out[i + 1] = (int16_t)std::max(-32768.0f, std::min(32767.0f, std::nearbyint(x_q)));
+            }
+        }
+        else if(in != out)
+        {
+            std::copy(in, in + 2 * noutput_items, out);
+        }
+    }
+    else
+    {
+        const gr_complex *in = (const gr_complex *)input_items[0];
+        gr_complex *out = (gr_complex *)output_items[0];
+        for(int i = m_skip; i < noutput_items; i += stats_decim)
+        {
+            update(in[i]);
+        }
+        if(enabled)
+        {
+            for(int i = 0; i < noutput_items; i++)
+            {
+                gr_complex x = in[i] - dc;
+                out[i] = gr_complex(x.real(), gain * (x.imag() - phase * x.real()));
+            }
+        }
+        else
+        {
+            std::copy(in, in + noutput_items, out);
+        }
+    }
+    // where the decimated tap picks up in the next call
+    m_skip = (m_skip - noutput_items) % stats_decim;
+    if(m_skip < 0)
+    {
+        m_skip += stats_decim;
+    }
+
+    // Gram-Schmidt: take I's share out of Q, then give Q I's power
+    coeffs_t coeffs;
+    coeffs.dc = m_dc;
+    coeffs.phase = 0;
+    coeffs.gain = 1;
+    if(m_ii > 0)
+    {
+        float phase_est = m_iq / m_ii;
+        float q_power = m_qq - phase_est * m_iq;
+        float gain_est = (q_power > 0) ? std::sqrt(m_ii / q_power) : 0;
+        // a real mixer is off by a few percent; more means the signal
+        // itself isn't circular, not that the mixer got worse
+        if(std::abs(phase_est) < max_phase && gain_est > 1 / max_gain && gain_est < max_gain)
+        {
+            coeffs.phase = phase_est;
+            coeffs.gain = gain_est;
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_coeffs = coeffs;
+    return noutput_items;
+}
@@ -0,0 +1,139 @@
+/**-------------------------------------------------------------------------
+ * @file iq_correct_c.h
+ * @brief track and remove the DC offset and I & Q imbalance of the SDR
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __IQ_CORRECT_C_H__
+#define __IQ_CORRECT_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+class iq_correct_c;
+
+/**
+ * Takes the LO leakage (the DC spike) and the mixer's I & Q imbalance
+ * (the image) out of the SDR stream, tracking them as the temperature
+ * and tuning change.  The Lime's calibrate() is only done once.
+ *
+ * The estimates come from one sample in stats_decim: a running mean for
+ * the DC, and the I*I, Q*Q and I*Q averages for a Gram-Schmidt balance,
+ * Q' = gain * (Q - phase * I).  Every sample gets the correction, which
+ * is a subtract and two multiplies; the coefficients are updated once a
+ * work call.
+ *
+ * With sc16 the samples stay 16 bit I & Q pairs on both sides.
+ */
+class iq_correct_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the I & Q corrector */
+    typedef boost::shared_ptr<iq_correct_c> sptr;
+
+    static sptr make(double rate, bool sc16 = false);
+
+    /** the correction being applied, for monitoring */
+    struct {
+        gr_complex dc;          // full scale 1.0
+        float phase;            // Q's share of I, sin of the phase error
+        float gain;             // I's amplitude over Q's
+    } typedef coeffs_t;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param rate - sample rate
+     * @param sc16 - true if the samples are 16 bit I & Q pairs
+     */
+    iq_correct_c(double rate, bool sc16);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~iq_correct_c();
+
+    /** @brief turn the correction on or off; the tracking carries on
+     *
+     * @param enable - true to correct
+     * @return Void.
+     */
+    void set_enabled(bool enable);
+
+    /** @brief true if the samples are being corrected
+     *
+     * @return bool
+     */
+    bool get_enabled();
+
+    /** @brief the current correction
+     *
+     * @return coeffs_t
+     */
+    coeffs_t get_coeffs();
+
+    /** @brief start the estimates over, ex: after the LO moves
+     *
+     * @return Void.
+     */
+    void reset();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    bool m_sc16;
+    float m_alpha;                      // per statistics sample
+    std::atomic<bool> m_enabled;
+    std::atomic<bool> m_reset;
+
+    // the estimates, only touched by work()
+    uint64_t m_nstats;                  // since the last reset
+    int m_skip;                         // samples to the next statistics sample
+    gr_complex m_dc;
+    float m_ii;
+    float m_qq;
+    float m_iq;
+
+    // published at the end of each work call
+    std::mutex m_lock;
+    coeffs_t m_coeffs;
+
+    /** @brief fold one sample into the estimates
+     *
+     * @param x - the sample, full scale 1.0
+     * @return Void.
+     */
+    void update(gr_complex x);
+};
+
+#endif /* __IQ_CORRECT_C_H__ */
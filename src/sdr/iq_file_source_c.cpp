@@ -0,0 +1,280 @@
+/**-------------------------------------------------------------------------
+ * @file iq_file_source_c.cpp
+ * @brief play a memory mapped IQ recording
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/iq_file_source_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// paced output runs this far ahead of the clock at most, in seconds
+static const double pace_ahead = 0.01;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+iq_file_source_c::sptr iq_file_source_c::make(const std::string &path, format_t format, double rate,
+                                              const std::vector<capture_t> &captures, bool realtime, bool loop)
+{
+    return gnuradio::get_initial_sptr(new iq_file_source_c(path, format, rate, captures, realtime, loop));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     iq_file_source_c
+ */
+iq_file_source_c::iq_file_source_c(const std::string &path, format_t format, double rate,
+                                   const std::vector<capture_t> &captures, bool realtime, bool loop)
+    : gr::sync_block("iq_file_source_c",
+          gr::io_signature::make(0, 0, 0),// input_signature
+          gr::io_signature::make(1, 1, sizeof(gr_complex))),// output_signature
+      m_data(nullptr),
+      m_size(0),
+      m_format(format),
+      m_rate(rate),
+      m_captures(captures),
+      m_realtime(realtime),
+      m_loop(loop),
+      m_at_end(false),
+      m_pos(0),
+      m_seek(-1),
+      m_center_freq(captures.empty() ? 0 : captures[0].freq),
+      m_phase(1, 0),
+      m_produced(0)
+{
+    m_sample_size = (m_format == CI16) ? 2 * sizeof(int16_t) : sizeof(gr_complex);
+    if(m_captures.empty() || 0 != m_captures[0].sample_start)
+    {
+        capture_t capture = { 0, m_center_freq };
+        m_captures.insert(m_captures.begin(), capture);
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) < 0 || (size_t)st.st_size < m_sample_size)
+    {
+        Logger::crit("[iq_file_source_c::iq_file_source_c] "+path+": "+(fd < 0 ? strerror(errno) : "too short"));
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        throw std::runtime_error("iq_file_source_c");
+    }
+    m_size = st.st_size;
+    void *addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+    {
+        Logger::crit("[iq_file_source_c::iq_file_source_c] "+path+": "+strerror(errno));
+        throw std::runtime_error("iq_file_source_c");
+    }
+    // read ahead hard, and drop the pages behind
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+    m_data = (const char *)addr;
+    m_nsamples = m_size / m_sample_size;
+    Logger::info("[iq_file_source_c::iq_file_source_c] "+path+": "+std::to_string(m_nsamples)+" samples, "
+        +std::to_string(m_nsamples / m_rate)+" s, "+std::to_string(m_captures.size())+" captures");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~iq_file_source_c
+ */
+iq_file_source_c::~iq_file_source_c()
+{
+    munmap((void *)m_data, m_size);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_center_frequency
+ */
+void iq_file_source_c::set_center_frequency(double freq)
+{
+    m_center_freq = freq;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     seek
+ */
+bool iq_file_source_c::seek(uint64_t sample)
+{
+    if(sample >= m_nsamples)
+    {
+        return false;
+    }
+    // work() picks it up, so a seek never lands mid call
+    m_seek = (int64_t)sample;
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_position
+ */
+uint64_t iq_file_source_c::get_position()
+{
+    return m_pos;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_nsamples
+ */
+uint64_t iq_file_source_c::get_nsamples()
+{
+    return m_nsamples;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     pace
+ */
+int iq_file_source_c::pace(int noutput_items)
+{
+    double ahead = m_produced / m_rate
+        - std::chrono::duration<double>(std::chrono::steady_clock::now() - m_epoch).count();
+    if(ahead > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(ahead));
+    }
+    return std::min(noutput_items, std::max(1, (int)(m_rate * pace_ahead)));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     convert
+ */
+void iq_file_source_c::convert(uint64_t pos, size_t n, gr_complex *out)
+{
+    const char *in = m_data + pos * m_sample_size;
+    if(m_format == CF32)
+    {
+        memcpy(out, in, n * sizeof(gr_complex));
+        return;
+    }
+    const int16_t *iq = (const int16_t *)in;
+    const float scale = 1.0f / 32768.0f;
+    for(size_t i = 0; i < n; i++)
+    {
+        out[i] = gr_complex(iq[2*i] * scale, iq[2*i+1] * scale);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int iq_file_source_c::work(int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items)
+{
+    gr_complex *out = (gr_complex *)output_items[0];
+
+    int64_t seek = m_seek.exchange(-1);
+    if(seek >= 0 || 0 == m_produced)
+    {
+        if(seek >= 0)
+        {
+            m_pos = seek;
+            m_at_end = false;
+        }
+        m_epoch = std::chrono::steady_clock::now();
+        m_produced = 0;
+    }
+    if(m_realtime)
+    {
+        noutput_items = pace(noutput_items);
+    }
+
+    int done = 0;
+    while(done < noutput_items)
+    {
+        uint64_t pos = m_pos;
+        if(pos >= m_nsamples)
+        {
+            if(m_loop)
+            {
+                m_pos = 0;
+                continue;
+            }
+            if(!m_at_end)
+            {
+                Logger::info("[iq_file_source_c::work] end of the recording");
+                m_at_end = true;
+            }
+            if(!m_realtime)
+            {
+                // unpaced zeros would spin a core and fill any file sink;
+                // the receive chain ends with the recording
+                return done > 0 ? done : WORK_DONE;
+            }
+            // hold at the end until a seek
+            std::fill(out + done, out + noutput_items, gr_complex(0, 0));
+            done = noutput_items;
+            break;
+        }
+
+        // up to the end, or to where the recorded frequency changes
+        capture_t key = { pos, 0 };
+        auto next = std::upper_bound(m_captures.begin(), m_captures.end(), key,
+            [](const capture_t &a, const capture_t &b) { return a.sample_start < b.sample_start; });
+        const capture_t &capture = *(next - 1);
+        uint64_t end = (next == m_captures.end()) ? m_nsamples : next->sample_start;
+        size_t n = std::min((uint64_t)(noutput_items - done), end - pos);
+        convert(pos, n, out + done);
+
+        // recorded at capture.freq, heard as if the SDR were at m_center_freq
+        double shift = capture.freq - m_center_freq;
+        if(0 != shift)
+        {
+            gr_complex rot = std::polar(1.0f, (float)(2.0 * M_PI * shift / m_rate));
+            for(size_t i = 0; i < n; i++)
+            {
+                out[done + i] *= m_phase;
+                m_phase *= rot;
+            }
+            m_phase /= std::abs(m_phase);
+        }
+
+        m_pos = pos + n;
+        done += n;
+    }
+    m_produced += done;
+    return done;
+}
@@ -0,0 +1,161 @@
+/**-------------------------------------------------------------------------
+ * @file iq_file_source_c.h
+ * @brief play a memory mapped IQ recording
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __IQ_FILE_SOURCE_C_H__
+#define __IQ_FILE_SOURCE_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class iq_file_source_c;
+
+/**
+ * Plays an IQ recording from a memory mapping, so reading it is a page
+ * fault and a copy and seeking is free.  The output is paced to the
+ * sample rate, or as fast as the receivers take it.
+ *
+ * The recording can be moved in frequency, as if the SDR had been
+ * retuned: each capture's recorded frequency is shifted to the center
+ * frequency set here.  At the end it loops; otherwise paced playback
+ * gives zeros until a seek and unpaced playback is done.
+ */
+class iq_file_source_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the IQ file source */
+    typedef boost::shared_ptr<iq_file_source_c> sptr;
+
+    /** sample formats, by their SigMF datatype */
+    enum {
+        CF32 = 0,   // cf32_le, float I and Q
+        CI16 = 1    // ci16_le, int16 I and Q, as the LimeSDR sends them
+    } typedef format_t;
+
+    /** where the recorded frequency changes */
+    struct {
+        uint64_t sample_start;
+        double freq;
+    } typedef capture_t;
+
+    static sptr make(const std::string &path, format_t format, double rate,
+                     const std::vector<capture_t> &captures, bool realtime, bool loop);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param path - the samples
+     * @param format - CF32 or CI16
+     * @param rate - sample rate
+     * @param captures - recorded frequencies, the first at sample 0
+     * @param realtime - pace the output to the sample rate
+     * @param loop - start over at the end
+     */
+    iq_file_source_c(const std::string &path, format_t format, double rate,
+                     const std::vector<capture_t> &captures, bool realtime, bool loop);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~iq_file_source_c();
+
+    /** @brief move the recording as if the SDR were tuned to freq
+     *
+     * @param freq - Hz
+     * @return Void.
+     */
+    void set_center_frequency(double freq);
+
+    /** @brief continue from a sample
+     *
+     * @param sample - from the start of the recording
+     * @return bool - false past the end
+     */
+    bool seek(uint64_t sample);
+
+    /** @brief the next sample to be played
+     *
+     * @return uint64_t
+     */
+    uint64_t get_position();
+
+    /** @brief length of the recording
+     *
+     * @return uint64_t - samples
+     */
+    uint64_t get_nsamples();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    const char *m_data;
+    size_t m_size;                      // bytes mapped
+    size_t m_sample_size;
+    uint64_t m_nsamples;
+    format_t m_format;
+    double m_rate;
+    std::vector<capture_t> m_captures;
+    bool m_realtime;
+    bool m_loop;
+    bool m_at_end;
+
+    std::atomic<uint64_t> m_pos;
+    std::atomic<int64_t> m_seek;        // -1 when no seek is waiting
+    std::atomic<double> m_center_freq;
+    gr_complex m_phase;
+
+    std::chrono::steady_clock::time_point m_epoch;
+    uint64_t m_produced;                // since m_epoch
+
+    /** @brief wait until the output is due, when paced
+     *
+     * @param noutput_items - the most the scheduler takes
+     * @return int - how many to make now
+     */
+    int pace(int noutput_items);
+
+    /** @brief copy samples out of the mapping as gr_complex
+     *
+     * @param pos - first sample
+     * @param n - number of samples
+     * @param out - destination
+     * @return Void.
+     */
+    void convert(uint64_t pos, size_t n, gr_complex *out);
+};
+
+#endif /* __IQ_FILE_SOURCE_C_H__ */
@@ -0,0 +1,452 @@
+/**-------------------------------------------------------------------------
+ * @file iq_recorder_c.cpp
+ * @brief record the SDR samples to disk as SigMF
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/iq_recorder_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// large writes keep O_DIRECT near the disk's streaming rate
+const size_t iq_recorder_c::buffer_size = 4 << 20;
+// about 6 seconds of a LimeSDR-Mini stream the disk may fall behind by
+const size_t iq_recorder_c::nbuffers = 16;
+// O_DIRECT wants the memory, offset and length in whole blocks
+const size_t iq_recorder_c::alignment = 4096;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+iq_recorder_c::sptr iq_recorder_c::make(bool sc16)
+{
+    return gnuradio::get_initial_sptr(new iq_recorder_c(sc16));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     iq_recorder_c
+ */
+iq_recorder_c::iq_recorder_c(bool sc16)
+    : gr::sync_block("iq_recorder_c",
+          gr::io_signature::make(1, 1, sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_recording(false),
+      m_closing(false),
+      m_fd(-1),
+      m_direct(false),
+      m_item_size(sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),
+      m_rate(0),
+      m_nsamples(0),
+      m_dropped(0),
+      m_written(0),
+      m_write_error(false)
+{
+    m_fill.data = nullptr;
+    m_fill.bytes = 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~iq_recorder_c
+ */
+iq_recorder_c::~iq_recorder_c()
+{
+    stop_recording();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     start_recording
+ */
+bool iq_recorder_c::start_recording(const std::string &base, double rate, double freq, const std::string &hw)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_recording)
+    {
+        Logger::warn("[iq_recorder_c::start_recording] already recording to "+m_base);
+        return false;
+    }
+
+    std::string path = base + ".sigmf-data";
+    m_direct = true;
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if(m_fd < 0 && errno == EINVAL)
+    {
+        // tmpfs and a few others don't take O_DIRECT
+        m_direct = false;
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if(m_fd < 0)
+    {
+        Logger::warn("[iq_recorder_c::start_recording] "+path+": "+strerror(errno));
+        return false;
+    }
+
+    for(size_t i = 0; i < nbuffers; i++)
+    {
+        void *buffer = nullptr;
+        if(0 != posix_memalign(&buffer, alignment, buffer_size))
+        {
+            break;
+        }
+        m_buffers.push_back((char *)buffer);
+    }
+    if(m_buffers.size() < 2)
+    {
+        Logger::warn("[iq_recorder_c::start_recording] out of memory for the buffers");
+        for(char *buffer : m_buffers)
+        {
+            free(buffer);
+        }
+        m_buffers.clear();
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    m_free = m_buffers;
+    m_full.clear();
+    m_fill.data = nullptr;
+    m_fill.bytes = 0;
+
+    m_base = base;
+    m_rate = rate;
+    m_hw = hw;
+    m_nsamples = 0;
+    m_dropped = 0;
+    m_written = 0;
+    m_write_error = false;
+    m_captures.clear();
+    m_gaps.clear();
+    capture_t capture = { 0, freq, get_datetime() };
+    m_captures.push_back(capture);
+
+    m_closing = false;
+    m_writer = std::thread(&iq_recorder_c::writer_loop, this);
+    m_recording = true;
+    Logger::info("[iq_recorder_c::start_recording] recording to "+path+(m_direct ? "" : " without O_DIRECT"));
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop_recording
+ */
+void iq_recorder_c::stop_recording()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_recording)
+        {
+            return;
+        }
+        m_recording = false;
+        if(nullptr != m_fill.data)
+        {
+            m_full.push_back(m_fill);
+            m_fill.data = nullptr;
+        }
+        m_closing = true;
+    }
+    m_cond.notify_one();
+    m_writer.join();
+
+    if(m_write_error)
+    {
+        // samples queued behind the failed write never reached the file
+        uint64_t nsamples = m_written / m_item_size;
+        Logger::warn("[iq_recorder_c::stop_recording] "+m_base+": "+std::to_string(m_nsamples - nsamples)
+            +" samples lost to the write error");
+        m_nsamples = nsamples;
+        while(m_captures.size() > 1 && m_captures.back().sample_start > m_nsamples)
+        {
+            m_captures.pop_back();
+        }
+        while(!m_gaps.empty() && m_gaps.back().sample_start > m_nsamples)
+        {
+            m_gaps.pop_back();
+        }
+    }
+    if((m_direct || m_write_error) && 0 != ftruncate(m_fd, m_written))
+    {
+        Logger::warn("[iq_recorder_c::stop_recording] could not trim the padding: "+std::string(strerror(errno)));
+    }
+    close(m_fd);
+    m_fd = -1;
+    for(char *buffer : m_buffers)
+    {
+        free(buffer);
+    }
+    m_buffers.clear();
+    m_free.clear();
+
+    write_meta();
+    Logger::info("[iq_recorder_c::stop_recording] "+m_base+": "+std::to_string(m_nsamples)+" samples, "
+        +std::to_string(m_dropped)+" dropped, "+std::to_string(m_captures.size())+" captures");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_frequency
+ */
+void iq_recorder_c::set_frequency(double freq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_recording || m_write_error)
+    {
+        return;
+    }
+    if(m_captures.back().sample_start == m_nsamples)
+    {
+        // nothing was recorded at the old frequency
+        m_captures.back().freq = freq;
+        return;
+    }
+    capture_t capture = { m_nsamples, freq, get_datetime() };
+    m_captures.push_back(capture);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     is_recording
+ */
+bool iq_recorder_c::is_recording()
+{
+    return m_recording;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_path
+ */
+std::string iq_recorder_c::get_path()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recording ? m_base + ".sigmf-data" : "";
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool iq_recorder_c::stop()
+{
+    stop_recording();
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int iq_recorder_c::work(int noutput_items,
+                        gr_vector_const_void_star &input_items,
+                        gr_vector_void_star &output_items)
+{
+    if(!m_recording.load(std::memory_order_acquire))
+    {
+        return noutput_items;
+    }
+
+    const char *in = (const char *)input_items[0];
+    size_t bytes = noutput_items * m_item_size;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // after a write error nothing more reaches the file, so stop counting
+    while(m_recording && !m_write_error && bytes > 0)
+    {
+        if(nullptr == m_fill.data)
+        {
+            if(m_free.empty())
+            {
+                // the disk is behind; drop rather than hold up the receiver
+                uint64_t n = bytes / m_item_size;
+                if(m_gaps.empty() || m_gaps.back().sample_start != m_nsamples)
+                {
+                    gap_t gap = { m_nsamples, 0 };
+                    m_gaps.push_back(gap);
+                }
+                m_gaps.back().dropped += n;
+                m_dropped += n;
+                break;
+            }
+            m_fill.data = m_free.back();
+            m_fill.bytes = 0;
+            m_free.pop_back();
+        }
+
+        size_t n = std::min(bytes, buffer_size - m_fill.bytes);
+        memcpy(m_fill.data + m_fill.bytes, in, n);
+        m_fill.bytes += n;
+        m_nsamples += n / m_item_size;
+        in += n;
+        bytes -= n;
+
+        if(m_fill.bytes == buffer_size)
+        {
+            m_full.push_back(m_fill);
+            m_fill.data = nullptr;
+            m_cond.notify_one();
+        }
+    }
+    return noutput_items;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     writer_loop
+ */
+void iq_recorder_c::writer_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_cond.wait(lock, [this]() { return !m_full.empty() || m_closing; });
+        if(m_full.empty())
+        {
+            // closing, and everything is on the disk
+            break;
+        }
+        buffer_t buffer = m_full.front();
+        m_full.pop_front();
+        lock.unlock();
+
+        // only the last buffer is short; pad it to a block, ftruncate cuts it back
+        size_t bytes = buffer.bytes;
+        if(m_direct && 0 != (bytes % alignment))
+        {
+            bytes += alignment - bytes % alignment;
+            memset(buffer.data + buffer.bytes, 0, bytes - buffer.bytes);
+        }
+        size_t done = 0;
+        bool failed = m_write_error;
+        while(!failed && done < bytes)
+        {
+            ssize_t n = write(m_fd, buffer.data + done, bytes - done);
+            if(n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(n <= 0)
+            {
+                Logger::crit("[iq_recorder_c::writer_loop] "+m_base+": "+strerror(n < 0 ? errno : ENOSPC));
+                failed = true;
+                break;
+            }
+            done += n;
+        }
+
+        lock.lock();
+        if(failed)
+        {
+            m_write_error = true;
+        }
+        else
+        {
+            m_written += buffer.bytes;
+        }
+        m_free.push_back(buffer.data);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     write_meta
+ */
+void iq_recorder_c::write_meta()
+{
+    std::string hw;
+    for(char c : m_hw)
+    {
+        if(c == '"' || c == '\\')
+        {
+            hw += '\\';
+        }
+        hw += c;
+    }
+
+    std::string path = m_base + ".sigmf-meta";
+    std::ofstream meta(path);
+    meta << "{\n"
+         << "    \"global\": {\n"
+         << "        \"core:datatype\": \"" << (m_item_size == sizeof(gr_complex) ? "cf32_le" : "ci16_le") << "\",\n"
+         << "        \"core:sample_rate\": " << std::to_string(m_rate) << ",\n"
+         << "        \"core:version\": \"1.0.0\",\n"
+         << "        \"core:hw\": \"" << hw << "\",\n";
+    if(m_write_error)
+    {
+        meta << "        \"core:description\": \"truncated by a write error\",\n";
+    }
+    meta << "        \"core:recorder\": \"sdr_ctld\"\n"
+         << "    },\n"
+         << "    \"captures\": [";
+    for(size_t i = 0; i < m_captures.size(); i++)
+    {
+        meta << (i ? "," : "") << "\n        {"
+             << " \"core:sample_start\": " << m_captures[i].sample_start << ","
+             << " \"core:frequency\": " << std::to_string(m_captures[i].freq) << ","
+             << " \"core:datetime\": \"" << m_captures[i].datetime << "\" }";
+    }
+    meta << "\n    ],\n"
+         << "    \"annotations\": [";
+    for(size_t i = 0; i < m_gaps.size(); i++)
+    {
+        meta << (i ? "," : "") << "\n        {"
+             << " \"core:sample_start\": " << m_gaps[i].sample_start << ","
+             << " \"core:comment\": \"" << m_gaps[i].dropped << " samples dropped before this one\" }";
+    }
+    meta << "\n    ]\n"
+         << "}\n";
+    if(!meta)
+    {
+        Logger::warn("[iq_recorder_c::write_meta] could not write "+path);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_datetime
+ */
+std::string iq_recorder_c::get_datetime()
+{
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    time_t secs = std::chrono::system_clock::to_time_t(now);
+    long ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    struct tm utc;
+    gmtime_r(&secs, &utc);
+    char buf[40];
+    size_t len = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(buf + len, sizeof(buf) - len, ".%03ldZ", ms);
+    return std::string(buf);
+}
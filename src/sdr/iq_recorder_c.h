@@ -0,0 +1,186 @@
+/**-------------------------------------------------------------------------
+ * @file iq_recorder_c.h
+ * @brief record the SDR samples to disk as SigMF
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __IQ_RECORDER_C_H__
+#define __IQ_RECORDER_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class iq_recorder_c;
+
+/**
+ * A tap on the SDR source that, while recording, writes the samples to
+ * <base>.sigmf-data as cf32_le, or ci16_le for an sc16 SDR stream, and
+ * the metadata to <base>.sigmf-meta.
+ *
+ * work() only copies into large aligned buffers; a writer thread of its
+ * own hands the full ones to the disk with O_DIRECT, so the page cache
+ * isn't churned and a slow disk never holds up the receiver.  If every
+ * buffer is waiting on the disk the samples are dropped, counted, and
+ * marked with an annotation.  Each SDR frequency change starts a new
+ * SigMF capture segment.
+ */
+class iq_recorder_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the IQ recorder */
+    typedef boost::shared_ptr<iq_recorder_c> sptr;
+
+    static sptr make(bool sc16 = false);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param sc16 - true if the samples are 16 bit I & Q pairs
+     */
+    iq_recorder_c(bool sc16);
+
+public:
+    /** @brief Deconstructor, finishes a recording
+     *
+     */
+    ~iq_recorder_c();
+
+    /** @brief open the files and start recording
+     *
+     * @param base - path without the .sigmf-data or .sigmf-meta
+     * @param rate - sample rate
+     * @param freq - SDR center frequency
+     * @param hw - description of the SDR, ex: its serial number
+     * @return bool - false if already recording or the file can't be made
+     */
+    bool start_recording(const std::string &base, double rate, double freq, const std::string &hw);
+
+    /** @brief write out what is buffered, then the metadata
+     *
+     * @return Void.
+     */
+    void stop_recording();
+
+    /** @brief start a new capture segment at the current sample
+     *
+     * @param freq - the new SDR center frequency
+     * @return Void.
+     */
+    void set_frequency(double freq);
+
+    /** @brief true between start_recording() and stop_recording()
+     *
+     * @return bool
+     */
+    bool is_recording();
+
+    /** @brief path of the recording's data file, empty if not recording
+     *
+     * @return std::string
+     */
+    std::string get_path();
+
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    struct {
+        uint64_t sample_start;
+        double freq;
+        std::string datetime;
+    } typedef capture_t;
+
+    /** where samples were dropped, in file samples */
+    struct {
+        uint64_t sample_start;
+        uint64_t dropped;
+    } typedef gap_t;
+
+    struct {
+        char *data;
+        size_t bytes;
+    } typedef buffer_t;
+
+    static const size_t buffer_size;
+    static const size_t nbuffers;
+    static const size_t alignment;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_writer;
+    std::atomic<bool> m_recording;
+    bool m_closing;
+
+    std::vector<char *> m_buffers;      // every buffer, to free them
+    std::vector<char *> m_free;
+    std::deque<buffer_t> m_full;
+    buffer_t m_fill;                    // data is null while none is free
+
+    int m_fd;
+    bool m_direct;
+    std::string m_base;
+    size_t m_item_size;
+    double m_rate;
+    std::string m_hw;
+    uint64_t m_nsamples;                // samples in the file
+    uint64_t m_dropped;
+    uint64_t m_written;                 // bytes the writer wrote
+    bool m_write_error;
+    std::vector<capture_t> m_captures;
+    std::vector<gap_t> m_gaps;
+
+    /** @brief write full buffers until stop_recording()
+     *
+     * @return Void.
+     */
+    void writer_loop();
+
+    /** @brief write the .sigmf-meta file
+     *
+     * @return Void.
+     */
+    void write_meta();
+
+    /** @brief the time now as a SigMF datetime
+     *
+     * @return std::string - ex: 2019-06-01T12:00:00.000Z
+     */
+    static std::string get_datetime();
+};
+
+#endif /* __IQ_RECORDER_C_H__ */
@@ -0,0 +1,264 @@
+/**-------------------------------------------------------------------------
+ * @file limey_device.cpp
+ * @brief a LimeSuite device shared by the sc16 source and sink
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/limey_device.h"
+#include "sdr/limey_device_list.h"
+#include "application/logger.h"
+#include <cmath>
+#include <stdexcept>
+
+/*-------------------------------------------------------------------------
+ * Type Definitions
+ * ----------------------------------------------------------------------*/
+std::mutex Limey_Device::s_lock;
+std::map<std::string, std::weak_ptr<Limey_Device>> Limey_Device::s_devices;
+
+// antenna paths; LNAW and the low TX band cover HF and 6m
+static const size_t rx_path_lnaw = 3;
+static const size_t tx_path_band1 = 1;
+static const size_t tx_path_band2 = 2;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     open
+ */
+Limey_Device::sptr Limey_Device::open(const std::string &serial)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    sptr device = s_devices[serial].lock();
+    if( nullptr != device )
+    {
+        return device;
+    }
+
+    int count = LMS_GetDeviceList(NULL);
+    std::unique_ptr<lms_info_str_t[]> list(new lms_info_str_t[count > 0 ? count : 1]);
+    if( count <= 0 || LMS_GetDeviceList(list.get()) < 0 )
+    {
+        Logger::crit("[Limey_Device::open] no LimeSDR: "+std::string(LMS_GetLastErrorMessage()));
+        throw std::runtime_error("Limey_Device");
+    }
+    for( int i = 0; i < count; i++ )
+    {
+        lms_info_str_t &info = list[i];
+        std::string info_str(info);
+        if( std::string::npos == info_str.find("serial="+serial) )
+        {
+            continue;
+        }
+        lms_device_t *handle = nullptr;
+        if( LMS_Open(&handle, info, NULL) < 0 || LMS_Init(handle) < 0 )
+        {
+            Logger::crit("[Limey_Device::open] "+serial+": "+std::string(LMS_GetLastErrorMessage()));
+            if( nullptr != handle )
+            {
+                LMS_Close(handle);
+            }
+            throw std::runtime_error("Limey_Device");
+        }
+        device = sptr(new Limey_Device(serial, info_str, handle));
+        s_devices[serial] = device;
+        return device;
+    }
+    Logger::crit("[Limey_Device::open] SDR not found: '"+serial+"'");
+    throw std::runtime_error("Limey_Device");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     Limey_Device
+ */
+Limey_Device::Limey_Device(const std::string &serial, const std::string &info, lms_device_t *device)
+    : m_serial(serial),
+      m_is_mini(std::string::npos != info.find("Mini")),
+      m_device(device),
+      m_rate(0),
+      m_time_stamp(0),
+      m_time_utc(0)
+{
+    Logger::info("[Limey_Device::Limey_Device] opened "+info);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~Limey_Device
+ */
+Limey_Device::~Limey_Device()
+{
+    LMS_Close(m_device);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_device
+ */
+lms_device_t *Limey_Device::get_device()
+{
+    return m_device;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     fail
+ */
+bool Limey_Device::fail(const std::string &what)
+{
+    Logger::warn("[Limey_Device] "+m_serial+" "+what+": "+std::string(LMS_GetLastErrorMessage()));
+    return false;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_sample_rate
+ */
+bool Limey_Device::set_sample_rate(double rate)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    // oversampling left to LimeSuite, as gr-limesdr does by default
+    if( LMS_SetSampleRate(m_device, rate, 0) < 0 )
+    {
+        return fail("LMS_SetSampleRate");
+    }
+    m_rate = rate;
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_sample_rate
+ */
+double Limey_Device::get_sample_rate()
+{
+    return m_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     configure
+ */
+bool Limey_Device::configure(bool tx, size_t chan, unsigned gain_db, double digital_bw)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    // what gr-limesdr's automatic antenna picks at these frequencies
+    size_t path = !tx ? rx_path_lnaw : (m_is_mini ? tx_path_band2 : tx_path_band1);
+    if( LMS_EnableChannel(m_device, tx, chan, true) < 0 )
+    {
+        return fail("LMS_EnableChannel");
+    }
+    if( LMS_SetAntenna(m_device, tx, chan, path) < 0 )
+    {
+        return fail("LMS_SetAntenna");
+    }
+    if( LMS_SetGaindB(m_device, tx, chan, gain_db) < 0 )
+    {
+        return fail("LMS_SetGaindB");
+    }
+    if( LMS_SetGFIRLPF(m_device, tx, chan, true, digital_bw) < 0 )
+    {
+        return fail("LMS_SetGFIRLPF");
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     calibrate
+ */
+bool Limey_Device::calibrate(bool tx, size_t chan, double bandw)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if( LMS_Calibrate(m_device, tx, chan, bandw, 0) < 0 )
+    {
+        return fail("LMS_Calibrate");
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     tune
+ */
+bool Limey_Device::tune(bool tx, size_t chan, double freq, double min_freq)
+{
+    if( freq < min_freq )
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    double lo = freq;
+    double bandw = 5000000;
+    if( Limey_Device_List::oscillator > freq )
+    {
+        // the LO can't go this low; park it and move the rest with the NCO
+        lo = Limey_Device_List::oscillator;
+        float_type nco[LMS_NCO_VAL_COUNT] = {};
+        nco[0] = lo - freq;
+        bandw = nco[0] * 2;
+        if( LMS_SetNCOFrequency(m_device, tx, chan, nco, 0) < 0 ||
+            LMS_SetNCOIndex(m_device, tx, chan, 0, !tx) < 0 )
+        {
+            return fail("NCO");
+        }
+    }
+    else if( LMS_SetNCOIndex(m_device, tx, chan, -1, false) < 0 )
+    {
+        return fail("LMS_SetNCOIndex");
+    }
+    if( LMS_SetLPFBW(m_device, tx, chan, bandw) < 0 )
+    {
+        return fail("LMS_SetLPFBW");
+    }
+    if( LMS_SetLOFrequency(m_device, tx, chan, lo) < 0 )
+    {
+        return fail("LMS_SetLOFrequency");
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_time
+ */
+void Limey_Device::set_time(uint64_t timestamp, double utc)
+{
+    std::lock_guard<std::mutex> lock(m_time_lock);
+    m_time_stamp = timestamp;
+    m_time_utc = utc;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_timestamp
+ */
+bool Limey_Device::get_timestamp(double utc, uint64_t *timestamp)
+{
+    std::lock_guard<std::mutex> lock(m_time_lock);
+    if( 0 == m_time_utc || 0 == m_rate )
+    {
+        return false;
+    }
+    *timestamp = m_time_stamp + (int64_t)std::llround((utc - m_time_utc) * m_rate);
+    return true;
+}
@@ -0,0 +1,162 @@
+/**-------------------------------------------------------------------------
+ * @file limey_device.h
+ * @brief a LimeSuite device shared by the sc16 source and sink
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __LIMEY_DEVICE_H__
+#define __LIMEY_DEVICE_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <lime/LimeSuite.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * One open LimeSDR, driven through LimeSuite directly for the sc16
+ * streams that gr-limesdr doesn't offer.  The source and the sink open it
+ * by serial and share it; it closes when the last of them goes.
+ */
+class Limey_Device
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    typedef std::shared_ptr<Limey_Device> sptr;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief open and initialize the LimeSDR, or share it if it is open
+     *
+     * @param serial - the serial number of the LimeSDR
+     * @return sptr
+     */
+    static sptr open(const std::string &serial);
+
+    /** @brief Deconstructor, closes the device
+     *
+     */
+    ~Limey_Device();
+
+    /** @brief the LimeSuite handle, for the streams
+     *
+     * @return lms_device_t*
+     */
+    lms_device_t *get_device();
+
+    /** @brief set the sample rate of both directions
+     *
+     * @param rate - samples per second
+     * @return bool - false if LimeSuite refused it
+     */
+    bool set_sample_rate(double rate);
+
+    /** @brief the sample rate last set
+     *
+     * @return double - samples per second, 0 if never set
+     */
+    double get_sample_rate();
+
+    /** @brief enable a channel and set it up the way gr-limesdr is set up
+     *         for the cf32 blocks
+     *
+     * @param tx - LMS_CH_TX or LMS_CH_RX
+     * @param chan - channel
+     * @param gain_db - combined gain
+     * @param digital_bw - GFIR low pass bandwidth in Hz
+     * @return bool - false if any step failed
+     */
+    bool configure(bool tx, size_t chan, unsigned gain_db, double digital_bw);
+
+    /** @brief calibrate a channel at its current frequency
+     *
+     * @param tx - LMS_CH_TX or LMS_CH_RX
+     * @param chan - channel
+     * @param bandw - calibration bandwidth in Hz
+     * @return bool
+     */
+    bool calibrate(bool tx, size_t chan, double bandw);
+
+    /** @brief tune a channel, with the NCO below the oscillator frequency
+     *
+     * @param tx - LMS_CH_TX or LMS_CH_RX
+     * @param chan - channel
+     * @param freq - Hz
+     * @param min_freq - the minimum center frequency with no seg fault
+     * @return bool - false if freq is out of range or LimeSuite refused it
+     */
+    bool tune(bool tx, size_t chan, double freq, double min_freq);
+
+    /** @brief tie the sample counter to UTC, from the receive stream
+     *
+     * Both directions count on the same clock, so this is what a
+     * transmit time is turned into a timestamp with.
+     *
+     * @param timestamp - LimeSuite's sample counter
+     * @param utc - the time of that sample
+     * @return Void.
+     */
+    void set_time(uint64_t timestamp, double utc);
+
+    /** @brief the sample counter at a time
+     *
+     * @param utc - seconds since the epoch
+     * @param timestamp - LimeSuite's sample counter
+     * @return bool - false until the receive stream has set the time
+     */
+    bool get_timestamp(double utc, uint64_t *timestamp);
+
+private:
+    /** @brief Constructor
+     *
+     * @param serial - the serial number of the LimeSDR
+     * @param info - LimeSuite's description of it
+     * @param device - the open handle
+     */
+    Limey_Device(const std::string &serial, const std::string &info, lms_device_t *device);
+
+    /** @brief log LimeSuite's last error
+     *
+     * @param what - the call that failed
+     * @return bool - always false
+     */
+    bool fail(const std::string &what);
+
+    std::string m_serial;
+    bool m_is_mini;
+    lms_device_t *m_device;
+    // LimeSuite calls on one device aren't safe from two threads
+    std::mutex m_lock;
+    double m_rate;
+    // the stream threads meet here, clear of the slow LimeSuite calls
+    std::mutex m_time_lock;
+    uint64_t m_time_stamp;
+    double m_time_utc;          // 0 until set_time()
+
+    static std::mutex s_lock;
+    static std::map<std::string, std::weak_ptr<Limey_Device>> s_devices;
+};
+
+#endif /* __LIMEY_DEVICE_H__ */
@@ -28,29 +28,45 @@
 #include <gnuradio/io_signature.h>
 #include "application/utility.h"
 #include "application/logger.h"
+#include "application/realtime.h"
 
 /*--------------------------------------------------------------------------
  * Function:
  *     make_Limey_Sink_c
  */
-Limey_Sink_c::sptr Limey_Sink_c::make( std::string serial, double freq, double input_rate, double min_freq  )
+Limey_Sink_c::sptr Limey_Sink_c::make( std::string serial, double freq, double input_rate, double min_freq, bool sc16 )
 {
-    return gnuradio::get_initial_sptr(new Limey_Sink_c(serial, freq, input_rate, min_freq));
+    return gnuradio::get_initial_sptr(new Limey_Sink_c(serial, freq, input_rate, min_freq, sc16));
 }
 
 /*--------------------------------------------------------------------------
  * Function:
  *     Limey_Sink_c 
  */
-Limey_Sink_c::Limey_Sink_c( std::string serial, double freq, double input_rate, double min_freq )
-    : gr::hier_block2("Lime SDR Sink",//const std::string &name
-          gr::io_signature::make(1,1,sizeof(gr_complex)),//input_signature
-          gr::io_signature::make(0, 0, 0)),// output_signatur
+Limey_Sink_c::Limey_Sink_c( std::string serial, double freq, double input_rate, double min_freq, bool sc16 )
+    : Sdr_Sink_c("Lime SDR Sink", sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),//const std::string &name
     m_min_freq(min_freq)
 {
     int pa_path_mini = 255;// None(0), BAND1(1), BAND(2), NONE(3), AUTO(255)
     m_chan = 0;// LMS_CH_0
 
+    if( sc16 )
+    {
+        // the same set up as gr-limesdr's below, through LimeSuite
+        m_device = Limey_Device::open(serial);
+        if( !m_device->set_sample_rate(input_rate) ||
+            !m_device->configure(LMS_CH_TX, m_chan, 60, 500000) ||
+            !this->set_center_frequency(freq) ||
+            !m_device->calibrate(LMS_CH_TX, m_chan, 5000000) )
+        {
+            Logger::crit("[Limey_Sink_c::Limey_Sink_c] could not set up the Lime SDR for sc16. ");
+            throw "could not set up the Lime SDR for sc16.";
+        }
+        m_limey_sc16 = limey_sink_sc16::make(m_device, m_chan);
+        connect(self(), 0, m_limey_sc16, 0);
+        return;
+    }
+
     m_limey_c_sptr= gr::limesdr::sink::make(
             serial, //std::string serial
             m_chan, // channel mode selelct 
@@ -89,7 +105,15 @@ Limey_Sink_c::~Limey_Sink_c()
 bool Limey_Sink_c::set_center_frequency(double freq)
 {
     bool rval = false;
-    if( Limey_Device_List::oscillator <= freq )
+    if( nullptr != m_device )
+    {
+        rval = m_device->tune(LMS_CH_TX, m_chan, freq, m_min_freq);
+        if( rval )
+        {
+            m_center_freq = freq;
+        }
+    }
+    else if( Limey_Device_List::oscillator <= freq )
     {
         m_limey_c_sptr->set_nco(0, m_chan); //set nco to off
         m_limey_c_sptr->set_bandwidth(5000000, m_chan); //set analog bandwidth
@@ -120,3 +144,29 @@ double Limey_Sink_c::get_center_frequency()
     return m_center_freq;
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_thread_priority
+ */
+void Limey_Sink_c::set_thread_priority(int priority)
+{
+    if( nullptr != m_limey_sc16 )
+    {
+        Realtime::set_fifo(m_limey_sc16, priority);
+        return;
+    }
+    Realtime::set_fifo(m_limey_c_sptr, priority);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> Limey_Sink_c::get_blocks()
+{
+    if( nullptr != m_limey_sc16 )
+    {
+        return { m_limey_sc16 };
+    }
+    return { m_limey_c_sptr };
+}
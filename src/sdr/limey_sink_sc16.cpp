@@ -0,0 +1,204 @@
+/**-------------------------------------------------------------------------
+ * @file limey_sink_sc16.cpp
+ * @brief streams sc16 samples to or from a LimeSDR through LimeSuite
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/limey_sink_sc16.h"
+#include "sdr/sample_time.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <cstring>
+#include <vector>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// LimeSuite waits this long for samples before giving up on a call, in ms
+static const unsigned stream_timeout = 1000;
+// a packet takes about this long to get from LimeSuite to the FPGA, in s
+static const double usb_latency = 0.005;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+limey_sink_sc16::sptr limey_sink_sc16::make(Limey_Device::sptr device, size_t chan)
+{
+    return gnuradio::get_initial_sptr(new limey_sink_sc16(device, chan));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     limey_sink_sc16
+ */
+limey_sink_sc16::limey_sink_sc16(Limey_Device::sptr device, size_t chan)
+    : gr::sync_block("limey_sink_sc16",
+          gr::io_signature::make(1, 1, 2 * sizeof(int16_t)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_device(device),
+      m_chan(chan),
+      m_streaming(false)
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~limey_sink_sc16
+ */
+limey_sink_sc16::~limey_sink_sc16()
+{
+    stop();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     start
+ */
+bool limey_sink_sc16::start()
+{
+    m_stream.isTx = LMS_CH_TX;
+    m_stream.channel = m_chan;
+    // 0 lets LimeSuite size the FIFO for the sample rate
+    m_stream.fifoSize = 0;
+    m_stream.throughputVsLatency = 0.5;
+    m_stream.dataFmt = lms_stream_t::LMS_FMT_I16;
+    if( LMS_SetupStream(m_device->get_device(), &m_stream) < 0 || LMS_StartStream(&m_stream) < 0 )
+    {
+        Logger::crit("[limey_sink_sc16::start] "+std::string(LMS_GetLastErrorMessage()));
+        return false;
+    }
+    m_streaming = true;
+    m_last_check = std::chrono::steady_clock::now();
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool limey_sink_sc16::stop()
+{
+    if( m_streaming )
+    {
+        LMS_StopStream(&m_stream);
+        LMS_DestroyStream(m_device->get_device(), &m_stream);
+        m_streaming = false;
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     check_status
+ */
+void limey_sink_sc16::check_status()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if( now - m_last_check < std::chrono::seconds(1) )
+    {
+        return;
+    }
+    m_last_check = now;
+    lms_stream_status_t status;
+    if( LMS_GetStreamStatus(&m_stream, &status) < 0 )
+    {
+        return;
+    }
+    if( 0 != status.overrun || 0 != status.underrun || 0 != status.droppedPackets )
+    {
+        Logger::warn("[limey_sink_sc16::check_status] overruns "+std::to_string(status.overrun)
+            +", underruns "+std::to_string(status.underrun)+", dropped packets "+std::to_string(status.droppedPackets));
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int limey_sink_sc16::work(int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items)
+{
+    lms_stream_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    int nitems = noutput_items;
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + noutput_items, Sample_Time::TX_TIME);
+    if( !tags.empty() )
+    {
+        uint64_t offset = tags[0].offset - nitems_read(0);
+        if( 0 < offset )
+        {
+            // up to the burst, in packets of its own; it starts the next send
+            nitems = (int)offset;
+            meta.flushPartialPacket = true;
+        }
+        else
+        {
+            set_timestamp(tags[0].value, &meta);
+            if( 1 < tags.size() )
+            {
+                nitems = (int)(tags[1].offset - nitems_read(0));
+            }
+        }
+    }
+    int n = LMS_SendStream(&m_stream, input_items[0], nitems, &meta, stream_timeout);
+    if( n < 0 )
+    {
+        Logger::crit("[limey_sink_sc16::work] "+std::string(LMS_GetLastErrorMessage()));
+        return WORK_DONE;
+    }
+    check_status();
+    return n;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_timestamp
+ */
+bool limey_sink_sc16::set_timestamp(const pmt::pmt_t &value, lms_stream_meta_t *meta)
+{
+    double utc = 0;
+    uint64_t timestamp = 0;
+    lms_stream_status_t status;
+    if( !Sample_Time::from_pmt(value, &utc) || !m_device->get_timestamp(utc, &timestamp) ||
+        LMS_GetStreamStatus(&m_stream, &status) < 0 )
+    {
+        Logger::debug("[limey_sink_sc16::set_timestamp] no time on the device, sent as it comes");
+        return false;
+    }
+
+    // what is queued goes out first; a timestamp before that is past
+    uint64_t earliest = status.timestamp + status.fifoFilledCount +
+                        (uint64_t)(usb_latency * m_device->get_sample_rate());
+    if( timestamp < earliest )
+    {
+        Logger::warn("[limey_sink_sc16::set_timestamp] "+std::to_string((earliest - timestamp) / m_device->get_sample_rate())
+            +" s behind the queue, sent as it comes");
+        return false;
+    }
+    meta->timestamp = timestamp;
+    meta->waitForTimestamp = true;
+    return true;
+}
@@ -0,0 +1,110 @@
+/**-------------------------------------------------------------------------
+ * @file limey_sink_sc16.h
+ * @brief streams sc16 samples to or from a LimeSDR through LimeSuite
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __LIMEY_SINK_SC16_H__
+#define __LIMEY_SINK_SC16_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/limey_device.h"
+#include <gnuradio/sync_block.h>
+#include <pmt/pmt.h>
+#include <chrono>
+#include <cstdint>
+
+class limey_sink_sc16;
+
+/**
+ * The LimeSDR's transmit stream, taking 16 bit I & Q pairs as they go
+ * onto the USB.
+ *
+ * A "tx_time" tag sends its sample with a timestamp, turned from UTC with
+ * the time the receive stream set on the device, so the LimeSDR holds it
+ * until then.  A time already behind what is queued is sent as it comes.
+ */
+class limey_sink_sc16 : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the sc16 sink */
+    typedef boost::shared_ptr<limey_sink_sc16> sptr;
+
+    static sptr make(Limey_Device::sptr device, size_t chan);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param device - the open LimeSDR
+     * @param chan - channel
+     */
+    limey_sink_sc16(Limey_Device::sptr device, size_t chan);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~limey_sink_sc16();
+
+    /** @brief set up and start the transmit stream
+     *
+     * @return bool
+     */
+    bool start();
+
+    /** @brief stop and tear down the transmit stream
+     *
+     * @return bool
+     */
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    Limey_Device::sptr m_device;
+    size_t m_chan;
+    lms_stream_t m_stream;
+    bool m_streaming;
+    std::chrono::steady_clock::time_point m_last_check;
+
+    /** @brief log what the stream lost since the last look, once a second
+     *
+     * @return Void.
+     */
+    void check_status();
+
+    /** @brief stamp a send with a tx_time, if there is still time
+     *
+     * @param value - the tag's value
+     * @param meta - gets the timestamp
+     * @return bool - false if the sample goes as it comes
+     */
+    bool set_timestamp(const pmt::pmt_t &value, lms_stream_meta_t *meta);
+};
+
+#endif /* __LIMEY_SINK_SC16_H__ */
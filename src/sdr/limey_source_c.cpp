@@ -28,6 +28,7 @@
 #include <gnuradio/io_signature.h>
 #include "application/utility.h"
 #include "application/logger.h"
+#include "application/realtime.h"
 
 /*--------------------------------------------------------------------------
  * Function:
@@ -36,24 +37,39 @@
  *  Remarks:
  *     see prototype in limey_source_c.h
  */
-Limey_Source_c::sptr Limey_Source_c::make( std::string serial, double freq, double input_rate, double min_freq )
+Limey_Source_c::sptr Limey_Source_c::make( std::string serial, double freq, double input_rate, double min_freq, bool sc16 )
 {
-    return gnuradio::get_initial_sptr(new Limey_Source_c(serial, freq, input_rate, min_freq));
+    return gnuradio::get_initial_sptr(new Limey_Source_c(serial, freq, input_rate, min_freq, sc16));
 }
 
 /*--------------------------------------------------------------------------
  * Function:
  *     Limey_Source_c 
  */
-Limey_Source_c::Limey_Source_c( std::string serial, double freq, double input_rate, double min_freq  )
-    : gr::hier_block2("Lime SDR Source",//const std::string &name
-          gr::io_signature::make(0, 0, 0),//input_signature
-          gr::io_signature::make(1,1,sizeof(gr_complex))),// output_signatur
+Limey_Source_c::Limey_Source_c( std::string serial, double freq, double input_rate, double min_freq, bool sc16 )
+    : Sdr_Source_c("Lime SDR Source", sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),//const std::string &name
     m_min_freq(min_freq)
 {
     int pa_path_mini = 255;// None(0), high(1), low(2), wide(3), AUTO(255)
     m_chan = 0;// LMS_CH_0
 
+    if( sc16 )
+    {
+        // the same set up as gr-limesdr's below, through LimeSuite
+        m_device = Limey_Device::open(serial);
+        if( !m_device->set_sample_rate(input_rate) ||
+            !m_device->configure(LMS_CH_RX, m_chan, 69, 500000) ||
+            !this->set_center_frequency(freq) ||
+            !m_device->calibrate(LMS_CH_RX, m_chan, 5000000) )
+        {
+            Logger::crit("[Limey_Source_c::Limey_Source_c] could not set up the Lime SDR for sc16. ");
+            throw "could not set up the Lime SDR for sc16.";
+        }
+        m_limey_sc16 = limey_source_sc16::make(m_device, m_chan);
+        connect(m_limey_sc16, 0, self(), 0);
+        return;
+    }
+
     m_limey_c_sptr= gr::limesdr::source::make(
             serial, //std::string serial
             m_chan, // channel mode selelct (SISO): A(1), B(2), (A+B)MIMO(3)
@@ -73,7 +89,10 @@ Limey_Source_c::Limey_Source_c( std::string serial, double freq, double input_ra
         Logger::crit("[Limey_Source_c::Limey_Source_c] pointer to Lime SDR sink is NULL. ");
         throw "pointer to Lime SDR sink is NULL.";
     }
-    connect(m_limey_c_sptr, 0, self(), 0);
+    // gr-limesdr gives no time; the sc16 source stamps from the counter
+    m_tagger = rx_time_tagger::make(sizeof(gr_complex), input_rate);
+    connect(m_limey_c_sptr, 0, m_tagger, 0);
+    connect(m_tagger, 0, self(), 0);
 }
 
 /*--------------------------------------------------------------------------
@@ -91,7 +110,15 @@ Limey_Source_c::~Limey_Source_c()
 bool Limey_Source_c::set_center_frequency(double freq)
 {
     bool rval = false;
-    if( Limey_Device_List::oscillator <= freq ) 
+    if( nullptr != m_device )
+    {
+        rval = m_device->tune(LMS_CH_RX, m_chan, freq, m_min_freq);
+        if( rval )
+        {
+            m_center_freq = freq;
+        }
+    }
+    else if( Limey_Device_List::oscillator <= freq ) 
     {
         //set nco to off
         m_limey_c_sptr->set_nco(0, m_chan); 
@@ -125,3 +152,29 @@ double Limey_Source_c::get_center_frequency()
     return m_center_freq;
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_thread_priority
+ */
+void Limey_Source_c::set_thread_priority(int priority)
+{
+    if( nullptr != m_limey_sc16 )
+    {
+        Realtime::set_fifo(m_limey_sc16, priority);
+        return;
+    }
+    Realtime::set_fifo(m_limey_c_sptr, priority);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> Limey_Source_c::get_blocks()
+{
+    if( nullptr != m_limey_sc16 )
+    {
+        return { m_limey_sc16 };
+    }
+    return { m_limey_c_sptr, m_tagger };
+}
@@ -25,12 +25,15 @@
 /*--------------------------------------------------------------------------
  * Include Files
  * -----------------------------------------------------------------------*/
-#include <gnuradio/hier_block2.h>
+#include "sdr/sdr_source_c.h"
 #include <limesdr/source.h>
 #include <string>
+#include <vector>
 #include "sdr/limey_device_list.h"
+#include "sdr/limey_source_sc16.h"
+#include "sdr/rx_time_tagger.h"
 
-class Limey_Source_c : public gr::hier_block2
+class Limey_Source_c : public Sdr_Source_c
 {
 public:
 /*--------------------------------------------------------------------------
@@ -38,7 +41,7 @@ public:
  * -----------------------------------------------------------------------*/
     typedef boost::shared_ptr<Limey_Source_c> sptr;
 
-    static sptr make(std::string serial, double freq = 60000000, double input_rate = 1000000, double min_freq = Limey_Device_List::oscillator );
+    static sptr make(std::string serial, double freq = 60000000, double input_rate = 1000000, double min_freq = Limey_Device_List::oscillator, bool sc16 = false );
 
 protected:
     /** @brief Constructor
@@ -47,8 +50,9 @@ protected:
      * @param freq - frequency set in Hz
      * @param input_rate - sample rate in Msps
      * @param min_freq - the minimum center frequency with no seg fault
+     * @param sc16 - output 16 bit I & Q straight from LimeSuite, not gr_complex
      */
-    Limey_Source_c( std::string serial, double freq, double input_rate, double min_freq );
+    Limey_Source_c( std::string serial, double freq, double input_rate, double min_freq, bool sc16 );
 
 public:
 /*--------------------------------------------------------------------------
@@ -73,8 +77,27 @@ public:
      */
     double get_center_frequency();
 
+    /** @brief Run the LimeSDR block's thread SCHED_FIFO
+     *
+     * Call once the flowgraph is running; the thread must exist.
+     *
+     * @param priority - real-time priority
+     * @return Void.
+     */
+    void set_thread_priority(int priority);
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
 private:
     gr::limesdr::source::sptr m_limey_c_sptr;
+    rx_time_tagger::sptr m_tagger;
+    // with sc16 these replace gr-limesdr, which only does gr_complex
+    Limey_Device::sptr m_device;
+    limey_source_sc16::sptr m_limey_sc16;
     size_t m_chan;
     double m_center_freq;
     double m_min_freq;
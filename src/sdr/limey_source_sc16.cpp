@@ -0,0 +1,185 @@
+/**-------------------------------------------------------------------------
+ * @file limey_source_sc16.cpp
+ * @brief streams sc16 samples to or from a LimeSDR through LimeSuite
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/limey_source_sc16.h"
+#include "sdr/sample_time.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <cstring>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// LimeSuite waits this long for samples before giving up on a call, in ms
+static const unsigned stream_timeout = 1000;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+limey_source_sc16::sptr limey_source_sc16::make(Limey_Device::sptr device, size_t chan)
+{
+    return gnuradio::get_initial_sptr(new limey_source_sc16(device, chan));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     limey_source_sc16
+ */
+limey_source_sc16::limey_source_sc16(Limey_Device::sptr device, size_t chan)
+    : gr::sync_block("limey_source_sc16",
+          gr::io_signature::make(0, 0, 0),// input_signature
+          gr::io_signature::make(1, 1, 2 * sizeof(int16_t))),// output_signature
+      m_device(device),
+      m_chan(chan),
+      m_streaming(false),
+      m_timed(false),
+      m_epoch_stamp(0),
+      m_epoch_utc(0),
+      m_next_stamp(0)
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~limey_source_sc16
+ */
+limey_source_sc16::~limey_source_sc16()
+{
+    stop();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     start
+ */
+bool limey_source_sc16::start()
+{
+    m_stream.isTx = LMS_CH_RX;
+    m_stream.channel = m_chan;
+    // 0 lets LimeSuite size the FIFO for the sample rate
+    m_stream.fifoSize = 0;
+    m_stream.throughputVsLatency = 0.5;
+    m_stream.dataFmt = lms_stream_t::LMS_FMT_I16;
+    if( LMS_SetupStream(m_device->get_device(), &m_stream) < 0 || LMS_StartStream(&m_stream) < 0 )
+    {
+        Logger::crit("[limey_source_sc16::start] "+std::string(LMS_GetLastErrorMessage()));
+        return false;
+    }
+    m_streaming = true;
+    m_timed = false;
+    m_last_check = std::chrono::steady_clock::now();
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop
+ */
+bool limey_source_sc16::stop()
+{
+    if( m_streaming )
+    {
+        LMS_StopStream(&m_stream);
+        LMS_DestroyStream(m_device->get_device(), &m_stream);
+        m_streaming = false;
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     check_status
+ */
+void limey_source_sc16::check_status()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if( now - m_last_check < std::chrono::seconds(1) )
+    {
+        return;
+    }
+    m_last_check = now;
+    lms_stream_status_t status;
+    if( LMS_GetStreamStatus(&m_stream, &status) < 0 )
+    {
+        return;
+    }
+    if( 0 != status.overrun || 0 != status.underrun || 0 != status.droppedPackets )
+    {
+        Logger::warn("[limey_source_sc16::check_status] overruns "+std::to_string(status.overrun)
+            +", underruns "+std::to_string(status.underrun)+", dropped packets "+std::to_string(status.droppedPackets));
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int limey_source_sc16::work(int noutput_items,
+                           gr_vector_const_void_star &input_items,
+                           gr_vector_void_star &output_items)
+{
+    lms_stream_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    int n = LMS_RecvStream(&m_stream, output_items[0], noutput_items, &meta, stream_timeout);
+    if( n < 0 )
+    {
+        Logger::crit("[limey_source_sc16::work] "+std::string(LMS_GetLastErrorMessage()));
+        return WORK_DONE;
+    }
+    if( 0 < n )
+    {
+        stamp(meta.timestamp, n);
+    }
+    check_status();
+    return n;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stamp
+ */
+void limey_source_sc16::stamp(uint64_t timestamp, int nitems)
+{
+    double rate = m_device->get_sample_rate();
+    if( !m_timed )
+    {
+        // the last sample arrived about now
+        m_epoch_utc = Sample_Time::now() - nitems / rate;
+        m_epoch_stamp = timestamp;
+        m_device->set_time(m_epoch_stamp, m_epoch_utc);
+        add_item_tag(0, nitems_written(0), Sample_Time::RX_TIME, Sample_Time::to_pmt(m_epoch_utc));
+        m_timed = true;
+    }
+    else if( timestamp != m_next_stamp )
+    {
+        int64_t lost = (int64_t)(timestamp - m_next_stamp);
+        Logger::debug("[limey_source_sc16::stamp] the counter jumped "+std::to_string(lost)+" samples");
+        double utc = m_epoch_utc + (int64_t)(timestamp - m_epoch_stamp) / rate;
+        add_item_tag(0, nitems_written(0), Sample_Time::RX_TIME, Sample_Time::to_pmt(utc));
+    }
+    m_next_stamp = timestamp + nitems;
+}
@@ -0,0 +1,114 @@
+/**-------------------------------------------------------------------------
+ * @file limey_source_sc16.h
+ * @brief streams sc16 samples to or from a LimeSDR through LimeSuite
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __LIMEY_SOURCE_SC16_H__
+#define __LIMEY_SOURCE_SC16_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/limey_device.h"
+#include <gnuradio/sync_block.h>
+#include <chrono>
+#include <cstdint>
+
+class limey_source_sc16;
+
+/**
+ * The LimeSDR's receive stream as the 16 bit I & Q pairs it comes off
+ * the USB in, half the bytes of gr_complex.  Nothing is converted here;
+ * the first decimation stage takes the integers as they are.
+ *
+ * The stream carries "rx_time" tags from LimeSuite's sample counter: the
+ * counter is tied to the system clock when the stream starts, and a jump
+ * in it, samples the USB lost, is tagged again with the time it says.
+ */
+class limey_source_sc16 : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the sc16 source */
+    typedef boost::shared_ptr<limey_source_sc16> sptr;
+
+    static sptr make(Limey_Device::sptr device, size_t chan);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param device - the open LimeSDR
+     * @param chan - channel
+     */
+    limey_source_sc16(Limey_Device::sptr device, size_t chan);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~limey_source_sc16();
+
+    /** @brief set up and start the receive stream
+     *
+     * @return bool
+     */
+    bool start();
+
+    /** @brief stop and tear down the receive stream
+     *
+     * @return bool
+     */
+    bool stop();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    Limey_Device::sptr m_device;
+    size_t m_chan;
+    lms_stream_t m_stream;
+    bool m_streaming;
+    std::chrono::steady_clock::time_point m_last_check;
+    bool m_timed;               // false until the first samples are stamped
+    uint64_t m_epoch_stamp;     // the counter at m_epoch_utc
+    double m_epoch_utc;
+    uint64_t m_next_stamp;      // the counter expected next
+
+    /** @brief tag samples with their time, where the counter says to
+     *
+     * @param timestamp - the counter at the first sample
+     * @param nitems - samples received
+     * @return Void.
+     */
+    void stamp(uint64_t timestamp, int nitems);
+
+    /** @brief log what the stream lost since the last look, once a second
+     *
+     * @return Void.
+     */
+    void check_status();
+};
+
+#endif /* __LIMEY_SOURCE_SC16_H__ */
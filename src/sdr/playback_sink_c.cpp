@@ -0,0 +1,94 @@
+/**-------------------------------------------------------------------------
+ * @file playback_sink_c.cpp
+ * @brief takes the TX stream in place of the Lime SDR during playback
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/playback_sink_c.h"
+#include <gnuradio/gr_complex.h>
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+Playback_Sink_c::sptr Playback_Sink_c::make( double freq, double input_rate )
+{
+    return gnuradio::get_initial_sptr(new Playback_Sink_c(freq, input_rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     Playback_Sink_c
+ */
+Playback_Sink_c::Playback_Sink_c( double freq, double input_rate )
+    : Sdr_Sink_c("Playback Sink"),//const std::string &name
+    m_center_freq(freq)
+{
+    m_throttle = gr::blocks::throttle::make(sizeof(gr_complex), input_rate);
+    m_null_sink = gr::blocks::null_sink::make(sizeof(gr_complex));
+    connect(self(), 0, m_throttle, 0);
+    connect(m_throttle, 0, m_null_sink, 0);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~Playback_Sink_c
+ */
+Playback_Sink_c::~Playback_Sink_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_center_frequency
+ */
+bool Playback_Sink_c::set_center_frequency(double freq)
+{
+    m_center_freq = freq;
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_center_frequency
+ */
+double Playback_Sink_c::get_center_frequency()
+{
+    return m_center_freq;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_thread_priority
+ */
+void Playback_Sink_c::set_thread_priority(int priority)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> Playback_Sink_c::get_blocks()
+{
+    return { m_throttle, m_null_sink };
+}
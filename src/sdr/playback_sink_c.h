@@ -0,0 +1,97 @@
+/**-------------------------------------------------------------------------
+ * @file playback_sink_c.h
+ * @brief takes the TX stream in place of the Lime SDR during playback
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __PLAYBACK_SINK_C_H__
+#define __PLAYBACK_SINK_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/sdr_sink_c.h"
+#include <gnuradio/blocks/null_sink.h>
+#include <gnuradio/blocks/throttle.h>
+#include <vector>
+
+/**
+ * Stands in for the LimeSDR sink while a recording plays.  The TX stream
+ * is taken at the sample rate and dropped, so the transmitter behaves as
+ * it would on the air.
+ */
+class Playback_Sink_c : public Sdr_Sink_c
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    typedef boost::shared_ptr<Playback_Sink_c> sptr;
+
+    static sptr make(double freq, double input_rate);
+
+protected:
+    /** @brief Constructor
+     *
+     * @param freq - frequency set in Hz
+     * @param input_rate - sample rate
+     */
+    Playback_Sink_c( double freq, double input_rate );
+
+public:
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Deconstructor
+     *
+     */
+    ~Playback_Sink_c();
+
+    /** @brief Set center frequency
+     *
+     * @param freq - Frequency to set in Hz
+     * @return bool - always true
+     */
+    bool set_center_frequency(double freq);
+
+    /** @brief Get center frequency
+     *
+     * @return double - the center frequency
+     */
+    double get_center_frequency();
+
+    /** @brief nothing to do, playback has no device thread
+     *
+     * @param priority - real-time priority
+     * @return Void.
+     */
+    void set_thread_priority(int priority);
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
+private:
+    gr::blocks::throttle::sptr m_throttle;
+    gr::blocks::null_sink::sptr m_null_sink;
+    double m_center_freq;
+};
+
+#endif /* __PLAYBACK_SINK_C_H__ */
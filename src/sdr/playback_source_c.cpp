@@ -0,0 +1,293 @@
+/**-------------------------------------------------------------------------
+ * @file playback_source_c.cpp
+ * @brief plays a SigMF recording in place of the Lime SDR
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/playback_source_c.h"
+#include "application/logger.h"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+static const std::string data_ext = ".sigmf-data";
+static const std::string meta_ext = ".sigmf-meta";
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ends_with
+ */
+static bool ends_with(const std::string &s, const std::string &suffix)
+{
+    return s.size() >= suffix.size() && 0 == s.compare(s.size() - suffix.size(), suffix.size(), suffix);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     json_value
+ *
+ *  Remarks:
+ *     the text after "key": in json, from pos on; enough for SigMF, whose
+ *     keys are unique within an object
+ */
+static bool json_value(const std::string &json, const std::string &key, size_t pos, size_t end, std::string *value)
+{
+    size_t at = json.find("\"" + key + "\"", pos);
+    if(at == std::string::npos || at >= end)
+    {
+        return false;
+    }
+    at = json.find(':', at);
+    if(at == std::string::npos || at >= end)
+    {
+        return false;
+    }
+    at = json.find_first_not_of(" \t\r\n", at + 1);
+    if(at == std::string::npos)
+    {
+        return false;
+    }
+    if(json[at] == '"')
+    {
+        size_t close = json.find('"', at + 1);
+        *value = json.substr(at + 1, close - at - 1);
+    }
+    else
+    {
+        size_t close = json.find_first_of(",}] \t\r\n", at);
+        *value = json.substr(at, close - at);
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+Playback_Source_c::sptr Playback_Source_c::make( const std::string &path, bool realtime, bool loop )
+{
+    return gnuradio::get_initial_sptr(new Playback_Source_c(path, realtime, loop));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     Playback_Source_c
+ */
+Playback_Source_c::Playback_Source_c( const std::string &path, bool realtime, bool loop )
+    : Sdr_Source_c("Playback Source"),//const std::string &name
+    m_rate(0),
+    m_center_freq(0)
+{
+    std::string base = path;
+    if(ends_with(base, data_ext) || ends_with(base, meta_ext))
+    {
+        base.erase(base.size() - data_ext.size());
+    }
+
+    iq_file_source_c::format_t format;
+    if(!read_meta(base + meta_ext, &format))
+    {
+        throw std::runtime_error("Playback_Source_c");
+    }
+    m_center_freq = m_captures[0].freq;
+
+    m_file = iq_file_source_c::make(base + data_ext, format, m_rate, m_captures, realtime, loop);
+    connect(m_file, 0, self(), 0);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~Playback_Source_c
+ */
+Playback_Source_c::~Playback_Source_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read_meta
+ */
+bool Playback_Source_c::read_meta(const std::string &path, iq_file_source_c::format_t *format)
+{
+    std::ifstream in(path);
+    if(!in)
+    {
+        Logger::crit("[Playback_Source_c::read_meta] can't open "+path);
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string json = ss.str();
+
+    std::string datatype, rate;
+    if(!json_value(json, "core:datatype", 0, json.size(), &datatype) ||
+       !json_value(json, "core:sample_rate", 0, json.size(), &rate))
+    {
+        Logger::crit("[Playback_Source_c::read_meta] "+path+": no core:datatype or core:sample_rate");
+        return false;
+    }
+    if(datatype == "cf32_le")
+    {
+        *format = iq_file_source_c::CF32;
+    }
+    else if(datatype == "ci16_le")
+    {
+        *format = iq_file_source_c::CI16;
+    }
+    else
+    {
+        Logger::crit("[Playback_Source_c::read_meta] "+path+": "+datatype+" is not supported, only cf32_le and ci16_le");
+        return false;
+    }
+    m_rate = atof(rate.c_str());
+    if(m_rate <= 0)
+    {
+        Logger::crit("[Playback_Source_c::read_meta] "+path+": bad core:sample_rate "+rate);
+        return false;
+    }
+
+    // each {...} in "captures": [...]
+    size_t at = json.find("\"captures\"");
+    size_t end = (at == std::string::npos) ? at : json.find(']', at);
+    while(at != std::string::npos && at < end)
+    {
+        size_t open = json.find('{', at);
+        if(open == std::string::npos || open > end)
+        {
+            break;
+        }
+        size_t close = json.find('}', open);
+        std::string start, freq;
+        if(json_value(json, "core:frequency", open, close, &freq))
+        {
+            iq_file_source_c::capture_t capture = { 0, atof(freq.c_str()) };
+            if(json_value(json, "core:sample_start", open, close, &start))
+            {
+                capture.sample_start = strtoull(start.c_str(), nullptr, 10);
+            }
+            m_captures.push_back(capture);
+        }
+        at = close;
+    }
+    if(m_captures.empty())
+    {
+        Logger::crit("[Playback_Source_c::read_meta] "+path+": no capture has a core:frequency");
+        return false;
+    }
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_center_frequency
+ */
+bool Playback_Source_c::set_center_frequency(double freq)
+{
+    // anything further out was never recorded
+    if(std::abs(freq - m_captures[0].freq) > m_rate / 2)
+    {
+        return false;
+    }
+    m_center_freq = freq;
+    m_file->set_center_frequency(freq);
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_center_frequency
+ */
+double Playback_Source_c::get_center_frequency()
+{
+    return m_center_freq;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_thread_priority
+ */
+void Playback_Source_c::set_thread_priority(int priority)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> Playback_Source_c::get_blocks()
+{
+    return { m_file };
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_rate
+ */
+double Playback_Source_c::get_rate()
+{
+    return m_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_recorded_frequency
+ */
+double Playback_Source_c::get_recorded_frequency()
+{
+    return m_captures[0].freq;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     seek
+ */
+bool Playback_Source_c::seek(double seconds)
+{
+    if(seconds < 0)
+    {
+        return false;
+    }
+    return m_file->seek((uint64_t)(seconds * m_rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_position
+ */
+double Playback_Source_c::get_position()
+{
+    return m_file->get_position() / m_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_duration
+ */
+double Playback_Source_c::get_duration()
+{
+    return m_file->get_nsamples() / m_rate;
+}
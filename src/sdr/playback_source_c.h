@@ -0,0 +1,138 @@
+/**-------------------------------------------------------------------------
+ * @file playback_source_c.h
+ * @brief plays a SigMF recording in place of the Lime SDR
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __PLAYBACK_SOURCE_C_H__
+#define __PLAYBACK_SOURCE_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/sdr_source_c.h"
+#include "sdr/iq_file_source_c.h"
+#include <string>
+#include <vector>
+
+/**
+ * Stands in for the LimeSDR source with a SigMF recording, such as one
+ * made by \start_recording.  The receivers are tuned within the recorded
+ * span as if it were live.
+ */
+class Playback_Source_c : public Sdr_Source_c
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    typedef boost::shared_ptr<Playback_Source_c> sptr;
+
+    static sptr make(const std::string &path, bool realtime = true, bool loop = false);
+
+protected:
+    /** @brief Constructor
+     *
+     * @param path - the recording, with or without .sigmf-data/.sigmf-meta
+     * @param realtime - pace to the sample rate, else as fast as it's taken
+     * @param loop - start over at the end
+     */
+    Playback_Source_c( const std::string &path, bool realtime, bool loop );
+
+public:
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Deconstructor
+     *
+     */
+    ~Playback_Source_c();
+
+    /** @brief Set center frequency
+     *
+     * @param freq - Frequency to set in Hz
+     * @return bool - true if freq is within the recorded span
+     */
+    bool set_center_frequency(double freq);
+
+    /** @brief Get center frequency
+     *
+     * @return double - the center frequency
+     */
+    double get_center_frequency();
+
+    /** @brief nothing to do, playback has no device thread
+     *
+     * @param priority - real-time priority
+     * @return Void.
+     */
+    void set_thread_priority(int priority);
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
+    /** @brief sample rate of the recording
+     *
+     * @return double
+     */
+    double get_rate();
+
+    /** @brief the frequency of the first capture
+     *
+     * @return double - Hz
+     */
+    double get_recorded_frequency();
+
+    /** @brief continue from a point in the recording
+     *
+     * @param seconds - from the start
+     * @return bool - false past the end
+     */
+    bool seek(double seconds);
+
+    /** @brief where the playback is
+     *
+     * @return double - seconds from the start
+     */
+    double get_position();
+
+    /** @brief length of the recording
+     *
+     * @return double - seconds
+     */
+    double get_duration();
+
+private:
+    iq_file_source_c::sptr m_file;
+    double m_rate;
+    double m_center_freq;
+    std::vector<iq_file_source_c::capture_t> m_captures;
+
+    /** @brief read the parts of the .sigmf-meta we use
+     *
+     * @param path - the .sigmf-meta file
+     * @param format - out: sample format
+     * @return bool - false if it can't be played
+     */
+    bool read_meta(const std::string &path, iq_file_source_c::format_t *format);
+};
+
+#endif /* __PLAYBACK_SOURCE_C_H__ */
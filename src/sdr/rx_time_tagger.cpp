@@ -0,0 +1,137 @@
+/**-------------------------------------------------------------------------
+ * @file rx_time_tagger.cpp
+ * @brief stamps a receive stream with the host clock
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/rx_time_tagger.h"
+#include "sdr/sample_time.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// well past the arrival jitter of a USB SDR, well short of an FT8 symbol
+const double rx_time_tagger::resync_seconds = 0.1;
+// how long the least error is looked for before it is believed
+const double rx_time_tagger::window_seconds = 1.0;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+rx_time_tagger::sptr rx_time_tagger::make(size_t item_size, double rate)
+{
+    return gnuradio::get_initial_sptr(new rx_time_tagger(item_size, rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     rx_time_tagger
+ */
+rx_time_tagger::rx_time_tagger(size_t item_size, double rate)
+    : gr::sync_block("rx_time_tagger",
+          gr::io_signature::make(1, 1, item_size),// input_signature
+          gr::io_signature::make(1, 1, item_size)),// output_signature
+      m_item_size(item_size),
+      m_rate(rate),
+      m_epoch(0),
+      m_epoch_item(0),
+      m_window_item(0),
+      m_min_error(0)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~rx_time_tagger
+ */
+rx_time_tagger::~rx_time_tagger()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     start
+ */
+bool rx_time_tagger::start()
+{
+    m_epoch = 0;
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int rx_time_tagger::work(int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items)
+{
+    std::memcpy(output_items[0], input_items[0], noutput_items * m_item_size);
+
+    // the last sample arrived about now, or later if the thread was held up
+    uint64_t first = nitems_written(0);
+    double clock = Sample_Time::now() - noutput_items / m_rate;
+    if( 0 == m_epoch )
+    {
+        stamp(first, clock);
+        return noutput_items;
+    }
+
+    // the clock is never early, so the least error over a window is the
+    // one to believe
+    double count = m_epoch + (first - m_epoch_item) / m_rate;
+    m_min_error = std::min(m_min_error, clock - count);
+    if( (first - m_window_item) / m_rate >= window_seconds )
+    {
+        if( std::abs(m_min_error) > resync_seconds )
+        {
+            stamp(first, count + m_min_error);
+        }
+        m_window_item = first;
+        m_min_error = std::numeric_limits<double>::max();
+    }
+    return noutput_items;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stamp
+ */
+void rx_time_tagger::stamp(uint64_t item, double utc)
+{
+    if( 0 != m_epoch )
+    {
+        Logger::debug("[rx_time_tagger::stamp] "+std::to_string(utc - (m_epoch + (item - m_epoch_item) / m_rate))+" s off the count");
+    }
+    m_epoch = utc;
+    m_epoch_item = item;
+    m_window_item = item;
+    m_min_error = std::numeric_limits<double>::max();
+    add_item_tag(0, item, Sample_Time::RX_TIME, Sample_Time::to_pmt(utc));
+}
@@ -0,0 +1,100 @@
+/**-------------------------------------------------------------------------
+ * @file rx_time_tagger.h
+ * @brief stamps a receive stream with the host clock
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __RX_TIME_TAGGER_H__
+#define __RX_TIME_TAGGER_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+
+class rx_time_tagger;
+
+/**
+ * Puts "rx_time" tags on a stream from an SDR that gives no time of its
+ * own (gr-limesdr's source).  The first sample is stamped with the system
+ * clock when it arrived; after that the time is counted in samples.  The
+ * clock is only ever late, so over each second the least difference
+ * between it and the count is taken; past resync_seconds, because samples
+ * were lost or the clocks drifted, the stream is stamped again.
+ *
+ * The stamps are late by the USB and driver buffering, a few ms and
+ * steady, which is well inside what FT8 or WSPR care about.
+ */
+class rx_time_tagger : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the tagger */
+    typedef boost::shared_ptr<rx_time_tagger> sptr;
+
+    static sptr make(size_t item_size, double rate);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param item_size - bytes per sample
+     * @param rate - sample rate
+     */
+    rx_time_tagger(size_t item_size, double rate);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~rx_time_tagger();
+
+    /** @brief stamp the next sample again, as after a restart
+     *
+     * @return bool
+     */
+    bool start();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    static const double resync_seconds;
+    static const double window_seconds;
+    size_t m_item_size;
+    double m_rate;
+    double m_epoch;             // UTC of sample m_epoch_item, 0 before any
+    uint64_t m_epoch_item;
+    uint64_t m_window_item;     // first sample of the error window
+    double m_min_error;         // least clock - count in the window
+
+    /** @brief tag a sample and count from it
+     *
+     * @param item - absolute sample number
+     * @param utc - its time
+     * @return Void.
+     */
+    void stamp(uint64_t item, double utc);
+};
+
+#endif /* __RX_TIME_TAGGER_H__ */
@@ -0,0 +1,68 @@
+/**-------------------------------------------------------------------------
+ * @file sample_time.cpp
+ * @brief UTC time stamps on the sample streams
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/sample_time.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+const pmt::pmt_t Sample_Time::RX_TIME = pmt::string_to_symbol("rx_time");
+const pmt::pmt_t Sample_Time::TX_TIME = pmt::string_to_symbol("tx_time");
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     now
+ */
+double Sample_Time::now()
+{
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     to_pmt
+ */
+pmt::pmt_t Sample_Time::to_pmt(double utc)
+{
+    double secs = std::floor(utc);
+    return pmt::make_tuple(pmt::from_uint64((uint64_t)secs), pmt::from_double(utc - secs));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     from_pmt
+ */
+bool Sample_Time::from_pmt(const pmt::pmt_t &value, double *utc)
+{
+    if( !pmt::is_tuple(value) || 2 != pmt::length(value) )
+    {
+        return false;
+    }
+    *utc = pmt::to_uint64(pmt::tuple_ref(value, 0)) + pmt::to_double(pmt::tuple_ref(value, 1));
+    return true;
+}
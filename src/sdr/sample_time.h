@@ -0,0 +1,74 @@
+/**-------------------------------------------------------------------------
+ * @file sample_time.h
+ * @brief UTC time stamps on the sample streams
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SAMPLE_TIME_H__
+#define __SAMPLE_TIME_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <pmt/pmt.h>
+
+/**
+ * The stream tags that carry UTC with the samples, in UHD's form so
+ * GNU Radio's own blocks understand them: the value is a tuple of whole
+ * seconds (uint64) and the fraction (double).
+ *
+ * The SDR source puts "rx_time" on its first sample and again after any
+ * it lost.  The decimators carry the tags down to the audio with their
+ * offsets scaled.  The transmitter puts "tx_time" on the first sample of
+ * a scheduled burst.
+ */
+class Sample_Time
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    static const pmt::pmt_t RX_TIME;    /**< "rx_time" */
+    static const pmt::pmt_t TX_TIME;    /**< "tx_time" */
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief the system clock as UTC seconds
+     *
+     * @return double
+     */
+    static double now();
+
+    /** @brief a time as a tag value
+     *
+     * @param utc - seconds since the epoch
+     * @return pmt::pmt_t - (uint64 seconds, double fraction)
+     */
+    static pmt::pmt_t to_pmt(double utc);
+
+    /** @brief a tag value as a time
+     *
+     * @param value - from to_pmt()
+     * @param utc - seconds since the epoch
+     * @return bool - false if value is not a time
+     */
+    static bool from_pmt(const pmt::pmt_t &value, double *utc);
+};
+
+#endif /* __SAMPLE_TIME_H__ */
@@ -0,0 +1,245 @@
+/**-------------------------------------------------------------------------
+ * @file scan_power_c.cpp
+ * @brief channel power of a list of offsets in the SDR stream
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/scan_power_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <gnuradio/fft/window.h>
+#include <algorithm>
+#include <cmath>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// at least this many bins across a channel, so its edges are sharp
+static const int bins_per_channel = 8;
+static const int min_fft_size = 64;
+static const int max_fft_size = 65536;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+scan_power_c::sptr scan_power_c::make(double rate, bool sc16)
+{
+    return gnuradio::get_initial_sptr(new scan_power_c(rate, sc16));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     scan_power_c
+ */
+scan_power_c::scan_power_c(double rate, bool sc16)
+    : gr::sync_block("scan_power_c",
+          gr::io_signature::make(1, 1, sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_rate(rate),
+      m_sc16(sc16),
+      m_state(IDLE),
+      m_fft_size(0),
+      m_norm(0),
+      m_fill(0),
+      m_skip(0),
+      m_nffts(0),
+      m_dwell_ffts(0)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~scan_power_c
+ */
+scan_power_c::~scan_power_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     measure
+ */
+void scan_power_c::measure(const std::vector<double> &offsets, double bandwidth, double dwell, double settle)
+{
+    int fft_size = min_fft_size;
+    while(fft_size < max_fft_size && m_rate / fft_size > bandwidth / bins_per_channel)
+    {
+        fft_size <<= 1;
+    }
+
+    // planning is slow, so it's done here and only when the size changes
+    std::unique_ptr<gr::fft::fft_complex> fft;
+    std::vector<float> window;
+    if(fft_size != m_fft_size)
+    {
+        fft.reset(new gr::fft::fft_complex(fft_size, true, 1));
+        window = gr::fft::window::blackman_harris(fft_size);
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if(nullptr != fft)
+    {
+        m_fft = std::move(fft);
+        m_window = window;
+        m_fft_size = fft_size;
+        m_power.assign(fft_size, 0.0f);
+    }
+
+    // Parseval: the power of all the bins over N * sum(w^2) is the
+    // mean |x|^2, so a channel's bins give its share of it
+    double sum = 0;
+    for(float w : m_window)
+    {
+        sum += w * w;
+    }
+    double full_scale = m_sc16 ? 32768.0 : 1.0;
+    m_dwell_ffts = std::max(1, (int)std::lround(dwell * m_rate / m_fft_size));
+    m_norm = (float)(1.0 / (m_fft_size * sum * full_scale * full_scale * m_dwell_ffts));
+
+    double bin_width = m_rate / m_fft_size;
+    m_channels.clear();
+    for(double offset : offsets)
+    {
+        int low = (int)std::ceil((offset - bandwidth / 2) / bin_width);
+        int high = (int)std::floor((offset + bandwidth / 2) / bin_width);
+        channel_t channel;
+        // the FFT has 0 Hz first and the negative frequencies last
+        channel.first = ((low % m_fft_size) + m_fft_size) % m_fft_size;
+        channel.count = std::max(1, std::min(high - low + 1, m_fft_size));
+        m_channels.push_back(channel);
+    }
+
+    std::fill(m_power.begin(), m_power.end(), 0.0f);
+    m_fill = 0;
+    m_skip = (int64_t)(settle * m_rate);
+    m_nffts = m_dwell_ffts;
+    m_state = SETTLE;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_powers
+ */
+bool scan_power_c::get_powers(std::vector<float> *powers)
+{
+    if(DONE != m_state)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    *powers = m_powers;
+    m_state = IDLE;
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     cancel
+ */
+void scan_power_c::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_state = IDLE;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int scan_power_c::work(int noutput_items,
+                       gr_vector_const_void_star &input_items,
+                       gr_vector_void_star &output_items)
+{
+    // between spans, and when there's no scan, the samples go by untouched
+    int state = m_state.load(std::memory_order_acquire);
+    if(SETTLE != state && DWELL != state)
+    {
+        return noutput_items;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    int i = 0;
+    while(i < noutput_items && (SETTLE == m_state || DWELL == m_state))
+    {
+        if(m_skip > 0)
+        {
+            int n = (int)std::min<int64_t>(m_skip, noutput_items - i);
+            m_skip -= n;
+            i += n;
+            continue;
+        }
+        m_state = DWELL;
+
+        // window the samples on the way into the FFT input
+        int n = std::min(m_fft_size - m_fill, noutput_items - i);
+        gr_complex *dst = m_fft->get_inbuf() + m_fill;
+        const float *w = &m_window[m_fill];
+        if(m_sc16)
+        {
+            const int16_t *in = (const int16_t *)input_items[0] + 2 * i;
+            for(int k = 0; k < n; k++)
+            {
+                dst[k] = gr_complex(in[2 * k] * w[k], in[2 * k + 1] * w[k]);
+            }
+        }
+        else
+        {
+            const gr_complex *in = (const gr_complex *)input_items[0] + i;
+            for(int k = 0; k < n; k++)
+            {
+                dst[k] = in[k] * w[k];
+            }
+        }
+        m_fill += n;
+        i += n;
+        if(m_fill < m_fft_size)
+        {
+            break;
+        }
+
+        m_fft->execute();
+        const gr_complex *out = m_fft->get_outbuf();
+        for(int k = 0; k < m_fft_size; k++)
+        {
+            m_power[k] += std::norm(out[k]);
+        }
+        m_fill = 0;
+        if(--m_nffts > 0)
+        {
+            continue;
+        }
+
+        m_powers.clear();
+        for(const channel_t &channel : m_channels)
+        {
+            double power = 0;
+            for(int k = 0; k < channel.count; k++)
+            {
+                power += m_power[(channel.first + k) % m_fft_size];
+            }
+            m_powers.push_back(10.0f * std::log10((float)(power * m_norm) + 1e-20f));
+        }
+        m_state.store(DONE, std::memory_order_release);
+    }
+    return noutput_items;
+}
@@ -0,0 +1,135 @@
+/**-------------------------------------------------------------------------
+ * @file scan_power_c.h
+ * @brief channel power of a list of offsets in the SDR stream
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SCAN_POWER_C_H__
+#define __SCAN_POWER_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/fft/fft.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class scan_power_c;
+
+/**
+ * Measures the power in a list of channels of the SDR stream, for the
+ * band scan.  Tuning to a channel is picking its FFT bins, so every
+ * channel inside the SDR's span comes from the same dwell, and only a
+ * new span needs the SDR to move.
+ *
+ * Idle until measure(); then it lets settle seconds go by, sums the
+ * power of back to back FFTs over dwell seconds, and leaves the power
+ * of each channel in dBFS for get_powers().
+ */
+class scan_power_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the scan power block */
+    typedef boost::shared_ptr<scan_power_c> sptr;
+
+    static sptr make(double rate, bool sc16 = false);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param rate - sample rate
+     * @param sc16 - true if the samples are 16 bit I & Q pairs
+     */
+    scan_power_c(double rate, bool sc16);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~scan_power_c();
+
+    /** @brief start a measurement, replacing any in progress
+     *
+     * @param offsets - channel centers in Hz from the SDR frequency
+     * @param bandwidth - width of every channel in Hz
+     * @param dwell - seconds of samples to average
+     * @param settle - seconds of samples to pass over first, after the SDR moved
+     * @return Void.
+     */
+    void measure(const std::vector<double> &offsets, double bandwidth, double dwell, double settle);
+
+    /** @brief take the result of the last measure()
+     *
+     * @param powers - set to the power of each channel in dBFS
+     * @return bool - false until the measurement is done
+     */
+    bool get_powers(std::vector<float> *powers);
+
+    /** @brief drop a measurement in progress
+     *
+     * @return Void.
+     */
+    void cancel();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    enum {
+        IDLE,
+        SETTLE,
+        DWELL,
+        DONE
+    } typedef state_t;
+
+    /** the FFT bins of a channel, which may wrap past the last */
+    struct {
+        int first;
+        int count;
+    } typedef channel_t;
+
+    double m_rate;
+    bool m_sc16;
+    std::atomic<int> m_state;           // state_t
+    // the rest is set by measure() and used by work(), under m_lock
+    std::mutex m_lock;
+    std::unique_ptr<gr::fft::fft_complex> m_fft;
+    int m_fft_size;
+    std::vector<float> m_window;
+    std::vector<float> m_power;         // sum of |X|^2 over the dwell
+    float m_norm;                       // makes channel power relative to full scale
+    std::vector<channel_t> m_channels;
+    std::vector<float> m_powers;        // dBFS per channel, when DONE
+    int m_fill;                         // samples in the FFT input
+    int64_t m_skip;                     // samples left to settle
+    int m_nffts;                        // FFTs left in the dwell
+    int m_dwell_ffts;
+};
+
+#endif /* __SCAN_POWER_C_H__ */
@@ -0,0 +1,96 @@
+/**-------------------------------------------------------------------------
+ * @file sdr_source_c.h
+ * @brief what the flow chart needs from an SDR source
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SDR_SOURCE_C_H__
+#define __SDR_SOURCE_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/hier_block2.h>
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/io_signature.h>
+#include <string>
+#include <vector>
+
+/**
+ * Feeds the receivers: the LimeSDR, or a stand in for it when a recording
+ * is played back.
+ */
+class Sdr_Source_c : public gr::hier_block2
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    typedef boost::shared_ptr<Sdr_Source_c> sptr;
+
+protected:
+    /** @brief Constructor
+     *
+     * @param name - block name
+     * @param item_size - gr_complex, or two int16_t for sc16
+     */
+    Sdr_Source_c( const std::string &name, size_t item_size = sizeof(gr_complex) )
+        : gr::hier_block2(name, gr::io_signature::make(0, 0, 0),
+                          gr::io_signature::make(1, 1, item_size))
+    {
+    }
+
+public:
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Deconstructor
+     *
+     */
+    virtual ~Sdr_Source_c() {}
+
+    /** @brief Set center frequency
+     *
+     * @param freq - Frequency to set in Hz
+     * @return bool - return true if freq is valid
+     */
+    virtual bool set_center_frequency(double freq) = 0;
+
+    /** @brief Get center frequency
+     *
+     * @return double - the center frequency
+     */
+    virtual double get_center_frequency() = 0;
+
+    /** @brief Run the device block's thread SCHED_FIFO
+     *
+     * Call once the flowgraph is running; the thread must exist.
+     *
+     * @param priority - real-time priority
+     * @return Void.
+     */
+    virtual void set_thread_priority(int priority) = 0;
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    virtual std::vector<gr::block_sptr> get_blocks() = 0;
+};
+
+#endif /* __SDR_SOURCE_C_H__ */
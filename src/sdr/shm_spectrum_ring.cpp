@@ -0,0 +1,281 @@
+/**-------------------------------------------------------------------------
+ * @file shm_spectrum_ring.cpp
+ * @brief spectrum frames in shared memory for any number of local viewers
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/shm_spectrum_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the viewers map the same counters; they must not hide a lock
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shm_spectrum_ring needs lock free 64 bit atomics");
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+const uint32_t shm_spectrum_ring::magic = 0x73644646; // "FFds"
+const uint32_t shm_spectrum_ring::version = 1;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     shm_spectrum_ring
+ */
+shm_spectrum_ring::shm_spectrum_ring()
+    : m_header(nullptr),
+      m_size(0),
+      m_owner(false),
+      m_writing(0)
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~shm_spectrum_ring
+ */
+shm_spectrum_ring::~shm_spectrum_ring()
+{
+    close();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     shm_name
+ */
+std::string shm_spectrum_ring::shm_name(const std::string &name)
+{
+    // shm names are one path component
+    std::string clean = name.empty() ? "default" : name;
+    std::replace(clean.begin(), clean.end(), '/', '_');
+    return "/sdr_ctld." + clean + ".fft";
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     create
+ */
+int shm_spectrum_ring::create(const std::string &shm_name, uint32_t fft_size, uint32_t min_frames, double rate, uint32_t averaged)
+{
+    close();
+
+    uint32_t capacity = 1;
+    while(capacity < min_frames)
+    {
+        capacity <<= 1;
+    }
+    // a cache line per slot header, so a viewer's reads don't share one
+    // with the writer's next slot
+    size_t slot_size = (sizeof(frame_t) + fft_size * sizeof(float) + 63) & ~(size_t)63;
+    size_t header_size = (sizeof(header_t) + 63) & ~(size_t)63;
+
+    // a ring left by a crashed run may be the wrong size; start over
+    shm_unlink(shm_name.c_str());
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if(fd < 0)
+    {
+        return -errno;
+    }
+    // the umask may have taken the group and other read bits away
+    fchmod(fd, 0644);
+
+    size_t size = header_size + capacity * slot_size;
+    if(ftruncate(fd, size) < 0)
+    {
+        int err = errno;
+        ::close(fd);
+        shm_unlink(shm_name.c_str());
+        return -err;
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED)
+    {
+        int err = errno;
+        shm_unlink(shm_name.c_str());
+        return -err;
+    }
+
+    m_header = new (addr) header_t;
+    m_header->fft_size = fft_size;
+    m_header->capacity = capacity;
+    m_header->slot_size = slot_size;
+    m_header->averaged = averaged;
+    m_header->rate = rate;
+    m_header->write_seq = 0;
+    m_size = size;
+    for(uint32_t i = 0; i < capacity; i++)
+    {
+        new (slot(i)) frame_t;
+        slot(i)->seq = 0;
+    }
+    m_header->version = version;
+    // publish last so attach() never sees a half built header
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = magic;
+
+    m_name = shm_name;
+    m_owner = true;
+    m_writing = 0;
+    return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     attach
+ */
+int shm_spectrum_ring::attach(const std::string &shm_name)
+{
+    close();
+
+    int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+    {
+        return -errno;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(header_t))
+    {
+        ::close(fd);
+        return -EINVAL;
+    }
+
+    size_t size = st.st_size;
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED)
+    {
+        return -errno;
+    }
+
+    header_t *header = (header_t *)addr;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t header_size = (sizeof(header_t) + 63) & ~(size_t)63;
+    if(header->magic != magic || header->version != version ||
+       header->slot_size < sizeof(frame_t) + header->fft_size * sizeof(float) ||
+       header_size + (size_t)header->capacity * header->slot_size > size)
+    {
+        munmap(addr, size);
+        return -EPROTO;
+    }
+
+    m_header = header;
+    m_size = size;
+    m_name = shm_name;
+    m_owner = false;
+    return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     close
+ */
+void shm_spectrum_ring::close()
+{
+    if(m_header != nullptr)
+    {
+        munmap(m_header, m_size);
+        if(m_owner)
+        {
+            shm_unlink(m_name.c_str());
+        }
+    }
+    m_header = nullptr;
+    m_size = 0;
+    m_owner = false;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     slot
+ */
+shm_spectrum_ring::frame_t *shm_spectrum_ring::slot(uint64_t n) const
+{
+    size_t header_size = (sizeof(header_t) + 63) & ~(size_t)63;
+    size_t index = n & (m_header->capacity - 1);
+    return (frame_t *)((char *)m_header + header_size + index * m_header->slot_size);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     begin_frame
+ */
+float *shm_spectrum_ring::begin_frame(double freq, uint64_t time_ns)
+{
+    frame_t *frame = slot(m_writing);
+    // warn readers first, then overwrite
+    frame->seq.store(2 * m_writing + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    frame->freq = freq;
+    frame->time_ns = time_ns;
+    return (float *)(frame + 1);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     end_frame
+ */
+void shm_spectrum_ring::end_frame()
+{
+    slot(m_writing)->seq.store(2 * m_writing + 2, std::memory_order_release);
+    m_writing++;
+    m_header->write_seq.store(m_writing, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_write_seq
+ */
+uint64_t shm_spectrum_ring::get_write_seq() const
+{
+    return m_header->write_seq.load(std::memory_order_acquire);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     read_frame
+ */
+bool shm_spectrum_ring::read_frame(uint64_t n, frame_t *frame, float *bins) const
+{
+    const frame_t *src = slot(n);
+    uint64_t seq = src->seq.load(std::memory_order_acquire);
+    if(seq != 2 * n + 2)
+    {
+        return false;
+    }
+    if(frame != nullptr)
+    {
+        frame->freq = src->freq;
+        frame->time_ns = src->time_ns;
+    }
+    memcpy(bins, src + 1, m_header->fft_size * sizeof(float));
+    // if the writer got to the slot while we copied, the copy is torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return src->seq.load(std::memory_order_relaxed) == seq;
+}
@@ -0,0 +1,161 @@
+/**-------------------------------------------------------------------------
+ * @file shm_spectrum_ring.h
+ * @brief spectrum frames in shared memory for any number of local viewers
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SHM_SPECTRUM_RING_H__
+#define __SHM_SPECTRUM_RING_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Power spectrum frames in a POSIX shared memory object.  sdr_ctld
+ * writes each frame once, straight into its slot, and any number of
+ * panadapters and waterfalls map the object read only and copy out what
+ * they want; sdr_ctld does nothing per viewer and never waits on one.
+ *
+ * Each slot carries a sequence number that is odd while the slot is
+ * written.  A viewer reads it before and after copying a frame, and
+ * keeps the copy only if it didn't change, so a viewer that falls a
+ * whole ring behind just sees the frame it wanted is gone.
+ *
+ * This file must not depend on the Logger or GNU Radio, so a viewer can
+ * build it on its own.
+ */
+class shm_spectrum_ring
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    static const uint32_t magic;
+    static const uint32_t version;
+
+    /** lives at the start of the shared memory, the slots follow */
+    struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t fft_size;                  // bins per frame
+        uint32_t capacity;                  // slots, a power of two
+        uint32_t slot_size;                 // bytes from one slot to the next
+        uint32_t averaged;                  // FFTs in each frame
+        double rate;                        // sample rate, the span of a frame
+        alignas(64) std::atomic<uint64_t> write_seq;  // frames published
+    } typedef header_t;
+
+    /** starts each slot, the bins follow */
+    struct {
+        std::atomic<uint64_t> seq;          // 2n + 1 while frame n is written, then 2n + 2
+        double freq;                        // SDR center frequency in Hz
+        uint64_t time_ns;                   // UTC of the last sample, ns since 1970
+    } typedef frame_t;
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+    /** @brief Constructor
+     *
+     */
+    shm_spectrum_ring();
+
+    /** @brief Deconstructor, unmaps and removes the ring if we created it
+     *
+     */
+    ~shm_spectrum_ring();
+
+    /** @brief name of the shared memory object for a ring
+     *
+     * @param name - ex: "default"
+     * @return std::string - ex: "/sdr_ctld.default.fft"
+     */
+    static std::string shm_name(const std::string &name);
+
+    /** @brief create (or take over) the ring
+     *
+     * @param shm_name - name from shm_name()
+     * @param fft_size - bins per frame
+     * @param min_frames - slots, rounded up to a power of two
+     * @param rate - sample rate
+     * @param averaged - FFTs in each frame
+     * @return int - 0 or -errno
+     */
+    int create(const std::string &shm_name, uint32_t fft_size, uint32_t min_frames, double rate, uint32_t averaged);
+
+    /** @brief map a ring made by create(), read only
+     *
+     * @param shm_name - name from shm_name()
+     * @return int - 0 or -errno
+     */
+    int attach(const std::string &shm_name);
+
+    /** @brief unmap, and remove the ring if we created it
+     *
+     * @return Void.
+     */
+    void close();
+
+    bool is_open() const { return m_header != nullptr; }
+    const header_t *get_header() const { return m_header; }
+
+    /** @brief start the next frame; the writer fills in the bins
+     *
+     * @param freq - SDR center frequency
+     * @param time_ns - UTC of the last sample
+     * @return float* - fft_size bins, lowest frequency first
+     */
+    float *begin_frame(double freq, uint64_t time_ns);
+
+    /** @brief publish the frame from begin_frame()
+     *
+     * @return Void.
+     */
+    void end_frame();
+
+    /** @brief the count of frames published, the next one's number
+     *
+     * @return uint64_t
+     */
+    uint64_t get_write_seq() const;
+
+    /** @brief copy out frame n
+     *
+     * @param n - frame number, ex: get_write_seq() - 1 for the newest
+     * @param frame - out: the frame's frequency and time; may be null
+     * @param bins - out: fft_size bins in dB
+     * @return bool - false if frame n is not written yet or was overwritten
+     */
+    bool read_frame(uint64_t n, frame_t *frame, float *bins) const;
+
+private:
+    header_t *m_header;
+    size_t m_size;          // bytes mapped
+    std::string m_name;
+    bool m_owner;
+    uint64_t m_writing;     // the writer's frame number
+
+    frame_t *slot(uint64_t n) const;
+};
+
+#endif /* __SHM_SPECTRUM_RING_H__ */
@@ -0,0 +1,199 @@
+/**-------------------------------------------------------------------------
+ * @file spectrum_tap_c.cpp
+ * @brief windowed FFT of the SDR stream for panadapters
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/spectrum_tap_c.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <gnuradio/fft/window.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// a viewer that is this many frames behind has lost one
+static const uint32_t ring_frames = 32;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+spectrum_tap_c::sptr spectrum_tap_c::make(double rate, int fft_size, int average, int decimation, const std::string &name, bool sc16)
+{
+    return gnuradio::get_initial_sptr(new spectrum_tap_c(rate, fft_size, average, decimation, name, sc16));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     spectrum_tap_c
+ */
+spectrum_tap_c::spectrum_tap_c(double rate, int fft_size, int average, int decimation, const std::string &name, bool sc16)
+    : gr::sync_block("spectrum_tap_c",
+          gr::io_signature::make(1, 1, sc16 ? 2 * sizeof(int16_t) : sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(0, 0, 0)),// output_signature
+      m_rate(rate),
+      m_fft_size(fft_size),
+      m_average(average),
+      m_decimation(decimation),
+      m_sc16(sc16),
+      m_fft(new gr::fft::fft_complex(fft_size, true, 1)),
+      m_window(gr::fft::window::blackman_harris(fft_size)),
+      m_power(fft_size, 0.0f),
+      m_fill(0),
+      m_skip(0),
+      m_nffts(0),
+      m_freq(0)
+{
+    // the window's coherent gain, and the integers' full scale
+    double sum = 0;
+    for(float w : m_window)
+    {
+        sum += w;
+    }
+    double full_scale = sc16 ? 32768.0 : 1.0;
+    m_norm = (float)(1.0 / (sum * sum * full_scale * full_scale * m_average));
+
+    std::string shm_name = shm_spectrum_ring::shm_name(name);
+    int err = m_ring.create(shm_name, fft_size, ring_frames, rate, average);
+    if(err < 0)
+    {
+        Logger::crit("[spectrum_tap_c::spectrum_tap_c] "+shm_name+": "+strerror(-err));
+        throw std::runtime_error("spectrum_tap_c");
+    }
+    Logger::info("[spectrum_tap_c::spectrum_tap_c] "+shm_name+": "+std::to_string(fft_size)+" bins, "
+        +std::to_string(get_frame_rate())+" frames/s");
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~spectrum_tap_c
+ */
+spectrum_tap_c::~spectrum_tap_c()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_frequency
+ */
+void spectrum_tap_c::set_frequency(double freq)
+{
+    m_freq.store(freq, std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_frame_rate
+ */
+double spectrum_tap_c::get_frame_rate()
+{
+    return m_rate / ((double)m_fft_size * m_decimation * m_average);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     work
+ */
+int spectrum_tap_c::work(int noutput_items,
+                         gr_vector_const_void_star &input_items,
+                         gr_vector_void_star &output_items)
+{
+    int i = 0;
+    while(i < noutput_items)
+    {
+        if(m_skip > 0)
+        {
+            int n = (int)std::min<int64_t>(m_skip, noutput_items - i);
+            m_skip -= n;
+            i += n;
+            continue;
+        }
+
+        // window the samples on the way into the FFT input
+        int n = std::min(m_fft_size - m_fill, noutput_items - i);
+        gr_complex *dst = m_fft->get_inbuf() + m_fill;
+        const float *w = &m_window[m_fill];
+        if(m_sc16)
+        {
+            const int16_t *in = (const int16_t *)input_items[0] + 2 * i;
+            for(int k = 0; k < n; k++)
+            {
+                dst[k] = gr_complex(in[2 * k] * w[k], in[2 * k + 1] * w[k]);
+            }
+        }
+        else
+        {
+            const gr_complex *in = (const gr_complex *)input_items[0] + i;
+            for(int k = 0; k < n; k++)
+            {
+                dst[k] = in[k] * w[k];
+            }
+        }
+        m_fill += n;
+        i += n;
+        if(m_fill < m_fft_size)
+        {
+            break;
+        }
+
+        m_fft->execute();
+        const gr_complex *out = m_fft->get_outbuf();
+        for(int k = 0; k < m_fft_size; k++)
+        {
+            m_power[k] += std::norm(out[k]);
+        }
+        m_fill = 0;
+        m_skip = (int64_t)(m_decimation - 1) * m_fft_size;
+        if(++m_nffts == m_average)
+        {
+            publish();
+            m_nffts = 0;
+            std::fill(m_power.begin(), m_power.end(), 0.0f);
+        }
+    }
+    return noutput_items;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     publish
+ */
+void spectrum_tap_c::publish()
+{
+    uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    float *bins = m_ring.begin_frame(m_freq.load(std::memory_order_relaxed), now);
+    // the FFT has 0 Hz first; the viewers get the lowest frequency first
+    int half = m_fft_size / 2;
+    for(int k = 0; k < m_fft_size; k++)
+    {
+        float power = m_power[(k + half) % m_fft_size] * m_norm;
+        bins[k] = 10.0f * std::log10(power + 1e-20f);
+    }
+    m_ring.end_frame();
+}
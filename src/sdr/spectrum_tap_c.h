@@ -0,0 +1,121 @@
+/**-------------------------------------------------------------------------
+ * @file spectrum_tap_c.h
+ * @brief windowed FFT of the SDR stream for panadapters
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __SPECTRUM_TAP_C_H__
+#define __SPECTRUM_TAP_C_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "sdr/shm_spectrum_ring.h"
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/fft/fft.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+class spectrum_tap_c;
+
+/**
+ * A tap on the SDR source that publishes power spectra to a
+ * shm_spectrum_ring, so a panadapter can run next to the decoders
+ * without opening the SDR itself.
+ *
+ * Of every decimation blocks of fft_size samples, one is windowed and
+ * transformed, and the power of average transforms is summed into each
+ * frame, which is written in dBFS straight into the ring.  The samples
+ * in between are skipped without being touched.
+ */
+class spectrum_tap_c : public gr::sync_block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the spectrum tap */
+    typedef boost::shared_ptr<spectrum_tap_c> sptr;
+
+    static sptr make(double rate, int fft_size, int average, int decimation, const std::string &name, bool sc16 = false);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param rate - sample rate
+     * @param fft_size - bins per frame
+     * @param average - FFTs per frame
+     * @param decimation - one FFT per this many blocks of fft_size samples
+     * @param name - ring name, see shm_spectrum_ring::shm_name
+     * @param sc16 - true if the samples are 16 bit I & Q pairs
+     */
+    spectrum_tap_c(double rate, int fft_size, int average, int decimation, const std::string &name, bool sc16);
+
+public:
+    /** @brief Deconstructor, removes the ring
+     *
+     */
+    ~spectrum_tap_c();
+
+    /** @brief the SDR center frequency to put in the frames
+     *
+     * @param freq - frequency in Hz
+     * @return Void.
+     */
+    void set_frequency(double freq);
+
+    /** @brief frames per second
+     *
+     * @return double
+     */
+    double get_frame_rate();
+
+    int work(int noutput_items,
+             gr_vector_const_void_star &input_items,
+             gr_vector_void_star &output_items);
+
+private:
+    double m_rate;
+    int m_fft_size;
+    int m_average;
+    int m_decimation;
+    bool m_sc16;
+    std::unique_ptr<gr::fft::fft_complex> m_fft;
+    std::vector<float> m_window;
+    std::vector<float> m_power;         // sum of |X|^2 over the frame
+    float m_norm;                       // makes a full scale tone 0 dB
+    int m_fill;                         // samples in the FFT input
+    int64_t m_skip;                     // samples to pass over first
+    int m_nffts;                        // FFTs in m_power
+    std::atomic<double> m_freq;
+    shm_spectrum_ring m_ring;
+
+    /** @brief write m_power to the ring in dB, 0 Hz in the middle
+     *
+     * @return Void.
+     */
+    void publish();
+};
+
+#endif /* __SPECTRUM_TAP_C_H__ */
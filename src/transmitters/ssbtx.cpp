@@ -27,6 +27,8 @@
 #include "receivers/receiver_util.h"
 #include "application/logger.h"
 #include <gnuradio/filter/firdes.h>
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <gnuradio/io_signature.h>
 
@@ -35,16 +37,16 @@
  * Function:
  *     make
  */
-ssbtx::sptr ssbtx::make(float input_rate, float audio_rate)
+ssbtx::sptr ssbtx::make(float input_rate, float audio_rate, bool time_tags)
 {
-    return gnuradio::get_initial_sptr(new ssbtx(input_rate, audio_rate));
+    return gnuradio::get_initial_sptr(new ssbtx(input_rate, audio_rate, time_tags));
 }
 
 /*--------------------------------------------------------------------------
  * Function:
  *     ssbtx
  */
-ssbtx::ssbtx(float input_rate, float audio_rate)
+ssbtx::ssbtx(float input_rate, float audio_rate, bool time_tags)
     : gr::hier_block2("ssb_tx",
          gr::io_signature::make(1, 1, sizeof(float)), // input_signature
          gr::io_signature::make(1, 1, sizeof(gr_complex)))//output_signature
@@ -71,55 +73,43 @@ ssbtx::ssbtx(float input_rate, float audio_rate)
         Logger::crit("[ssbtx::ssbtx] quad_rate must be an integer multiple of prefered rate."+std::to_string(m_quad_rate)+" % "+std::to_string(m_audio_rate ));
     }
 
-    bool do_interp = (m_audio_rate != m_quad_rate);
-    int interp_factor = 1;
-    if(do_interp)
-    {
-        interp_factor = int(m_quad_rate / m_audio_rate);
-    }
+    int interp_factor = int(m_quad_rate / m_audio_rate);
+    std::vector<int> stages = Receiver_Util::get_rate_stages(interp_factor);
+    // the sharp filter at the low rate, the long stages last
+    std::reverse(stages.begin(), stages.end());
 
-    int interp_1 = 1;
-    if(9 < interp_factor){
-        if(0 == (interp_factor % 9))
-            interp_1 = 9;
-        else if(0 == (interp_factor % 8))
-            interp_1 = 8;
-        else if(0 == (interp_factor % 7))
-            interp_1 = 7;
-        else if(0 == (interp_factor % 6))
-            interp_1 = 6;
-        else if(0 == (interp_factor % 5))
-            interp_1 = 5;
-        else if(0 == (interp_factor % 4))
-            interp_1 = 4;
-        else if(0 == (interp_factor % 3))
-            interp_1 = 3;
-        else if(0 == (interp_factor % 2))
-            interp_1 = 2;
-        else 
-            interp_1 = 1;
-    }
-    int interp_2 = (int)(interp_factor / interp_1);
-    if(interp_2 > 9)
+    // the images of the band at each stage's input rate must go
+    double band = m_audio_rate * 0.3;
+    double rate = m_audio_rate;
+    for(int interp : stages)
     {
-        Logger::warn("[ssbtx::ssbtx] interpolation factors are large: "+std::to_string(interp_1)+", "+std::to_string(interp_2));
+        std::vector<float> taps = gr::filter::firdes::low_pass_2(interp, rate*interp, (rate * 0.5), (rate - 2*band), 100 );
+        Logger::debug("[ssbtx::ssbtx] interpolation factor: "+std::to_string(interp)+"  number of taps: "+std::to_string(taps.size()));
+        m_interpolators.push_back(gr::filter::interp_fir_filter_ccf::make(interp, taps));
+        rate *= interp;
     }
 
-    std::vector<float> taps_interp_1 = gr::filter::firdes::low_pass_2(interp_1, m_audio_rate*interp_1, (m_audio_rate * 0.3), (m_audio_rate * 0.2), 100 );
-    Logger::debug("[ssbtx::ssbtx] interpolation factor 1: "+std::to_string(interp_1)+"  number of taps: "+std::to_string(taps_interp_1.size()));
-    m_interpolator_1 = gr::filter::interp_fir_filter_ccf::make(interp_1, taps_interp_1);
+    // direct tone synthesis at the output rate; passes audio through when idle
+    // and holds everything back until a scheduled start
+    m_tone_synth = tone_synth_cc::make(m_quad_rate, 0.5, time_tags);
 
-    std::vector<float> taps_interp_2 = gr::filter::firdes::low_pass_2(interp_2, (m_audio_rate*interp_1*interp_2), (m_audio_rate*interp_1 * 0.3), (m_audio_rate*interp_1 * 0.2), 100 );
-    Logger::debug("[ssbtx::ssbtx] interpolation factor 2: "+std::to_string(interp_2)+"  number of taps: "+std::to_string(taps_interp_2.size()));
-    m_interpolator_2 = gr::filter::interp_fir_filter_ccf::make(interp_2, taps_interp_2);
+    // a split TX frequency is a shift, not an SDR retune
+    m_offset = 0;
+    m_shifter = gr::blocks::rotator_cc::make(0.0);
 
     try
     {
         connect( self(), 0, m_key_sptr, 0);
         connect( m_key_sptr, 0, m_ssb_filter, 0);
-        connect( m_ssb_filter, 0, m_interpolator_1, 0);
-        connect( m_interpolator_1, 0, m_interpolator_2, 0);
-        connect( m_interpolator_2, 0, self(), 0);
+        gr::basic_block_sptr last = m_ssb_filter;
+        for(gr::filter::interp_fir_filter_ccf::sptr interpolator : m_interpolators)
+        {
+            connect( last, 0, interpolator, 0);
+            last = interpolator;
+        }
+        connect( last, 0, m_tone_synth, 0);
+        connect( m_tone_synth, 0, m_shifter, 0);
+        connect( m_shifter, 0, self(), 0);
     }
     catch(std::invalid_argument& e)
     {
@@ -160,6 +150,8 @@ void ssbtx::set_filter(double low, double high, double tw)
 void ssbtx::ptt_off()
 {
     m_key_sptr->set_k(0);
+    m_tone_synth->clear_schedule();
+    m_tone_synth->set_start_time(0);
 }
 
 /*--------------------------------------------------------------------------
@@ -171,6 +163,86 @@ void ssbtx::ptt_on()
     m_key_sptr->set_k(1);
 }
 
+/*--------------------------------------------------------------------------
+ * Function:
+ *     send_tones
+ */
+void ssbtx::send_tones(const std::vector<tone_synth_cc::tone_t> &tones)
+{
+    m_tone_synth->set_schedule(tones);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     stop_tones
+ */
+void ssbtx::stop_tones()
+{
+    m_tone_synth->clear_schedule();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     is_sending_tones
+ */
+bool ssbtx::is_sending_tones()
+{
+    return m_tone_synth->is_active();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_start_time
+ */
+void ssbtx::set_start_time(double utc)
+{
+    m_tone_synth->set_start_time(utc);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_start_time
+ */
+double ssbtx::get_start_time()
+{
+    return m_tone_synth->get_start_time();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_offset
+ */
+bool ssbtx::set_offset(double offset)
+{
+    if(std::abs(offset) > get_max_offset())
+    {
+        return false;
+    }
+    m_shifter->set_phase_inc(2.0 * M_PI * offset / m_quad_rate);
+    m_offset = offset;
+    Logger::debug("[ssbtx::set_offset] offset is "+std::to_string(offset));
+    return true;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_offset
+ */
+double ssbtx::get_offset()
+{
+    return m_offset;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_max_offset
+ */
+double ssbtx::get_max_offset()
+{
+    // clear of the SDR's own anti-image filter at the band edge
+    return 0.4 * m_quad_rate;
+}
+
 /*--------------------------------------------------------------------------
  * Function:
  *     get_taps
@@ -182,3 +254,16 @@ std::vector<gr_complex> ssbtx::get_taps(double rate, double low, double high, do
 
     return taps;
 }
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_blocks
+ */
+std::vector<gr::block_sptr> ssbtx::get_blocks()
+{
+    std::vector<gr::block_sptr> blocks = { m_key_sptr, m_ssb_filter };
+    blocks.insert(blocks.end(), m_interpolators.begin(), m_interpolators.end());
+    blocks.push_back(m_tone_synth);
+    blocks.push_back(m_shifter);
+    return blocks;
+}
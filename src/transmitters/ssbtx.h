@@ -27,9 +27,11 @@
  * -----------------------------------------------------------------------*/
 #include <gnuradio/hier_block2.h>
 #include <gnuradio/blocks/multiply_const_ff.h>
+#include <gnuradio/blocks/rotator_cc.h>
 #include <gnuradio/filter/fir_filter_fcc.h>
 #include <gnuradio/filter/interp_fir_filter_ccf.h>
 #include <gnuradio/gr_complex.h>
+#include "transmitters/tone_synth_cc.h"
 #include <vector>
 
 class ssbtx;
@@ -43,7 +45,7 @@ public:
     typedef boost::shared_ptr<ssbtx> sptr;
 
     /*! @brief Public constructor of wfm_tx. */
-    static sptr make(float input_rate, float audio_rate);
+    static sptr make(float input_rate, float audio_rate, bool time_tags = false);
 
 
 /*--------------------------------------------------------------------------
@@ -52,9 +54,11 @@ public:
 protected:
     /** @brief Constructor
      *
-     * @param Void.
+     * @param input_rate - data rate out to the SDR
+     * @param audio_rate - data rate of the audio
+     * @param time_tags - tag a scheduled burst with tx_time for the sink
      */
-    ssbtx(float input_rate, float audio_rate);
+    ssbtx(float input_rate, float audio_rate, bool time_tags);
 
 public:
     /** @brief Deconstructor
@@ -83,13 +87,80 @@ public:
      */
     void ptt_on();
 
+    /** @brief transmit a tone schedule instead of the audio input
+     *
+     * The tones are generated at the output rate, bypassing the audio
+     * filter and interpolators.  The audio path resumes after the last tone.
+     *
+     * @param tones - list of tones to transmit in order
+     * @return Void.
+     */
+    void send_tones(const std::vector<tone_synth_cc::tone_t> &tones);
+
+    /** @brief stop the tone schedule
+     *
+     * @return Void.
+     */
+    void stop_tones();
+
+    /** @brief true while a tone schedule is being transmitted
+     *
+     * @return bool
+     */
+    bool is_sending_tones();
+
+    /** @brief start the next keyed burst at a UTC instant
+     *
+     * Until then the output is silent and up to a second of audio waits,
+     * so the burst starts on the SDR's sample count, not when the audio
+     * arrived.
+     * ptt_off() cancels it.
+     *
+     * @param utc - seconds since the epoch, 0 to start now
+     * @return Void.
+     */
+    void set_start_time(double utc);
+
+    /** @brief the start time being waited for
+     *
+     * @return double - UTC seconds, 0 if none
+     */
+    double get_start_time();
+
+    /** @brief move the transmit signal away from the SDR frequency
+     *
+     * @param offset - Hz, from the SDR center frequency
+     * @return bool - false if offset is outside the band the SDR sends
+     */
+    bool set_offset(double offset);
+
+    /** @brief get the offset from the SDR center frequency
+     *
+     * @return double - Hz
+     */
+    double get_offset();
+
+    /** @brief the largest offset set_offset() takes
+     *
+     * @return double - Hz
+     */
+    double get_max_offset();
+
+    /** @brief the GNU Radio blocks inside, in connection order
+     *
+     * @return std::vector<gr::block_sptr>
+     */
+    std::vector<gr::block_sptr> get_blocks();
+
 private:
     float m_quad_rate;
     int m_audio_rate;
     float m_interp_factor;
     gr::filter::fir_filter_fcc::sptr m_ssb_filter;
-    gr::filter::interp_fir_filter_ccf::sptr m_interpolator_1;
-    gr::filter::interp_fir_filter_ccf::sptr m_interpolator_2;
+    std::vector<gr::filter::interp_fir_filter_ccf::sptr> m_interpolators;
+    tone_synth_cc::sptr m_tone_synth;
+    gr::blocks::rotator_cc::sptr m_shifter;
+    double m_offset;
 
     gr::blocks::multiply_const_ff::sptr m_key_sptr;
 
@@ -0,0 +1,398 @@
+/**-------------------------------------------------------------------------
+ * @file tone_synth_cc.cpp
+ * @brief synthesize a tone schedule directly at the transmit rate
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+*-------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include "transmitters/tone_synth_cc.h"
+#include "sdr/sample_time.h"
+#include "application/logger.h"
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+// 4096 entries keeps the phase truncation spurs near -72 dBc
+const int tone_synth_cc::lut_bits = 12;
+// key up and key down ramp to keep the keying clicks out of the band
+const double tone_synth_cc::ramp_time = 0.005;
+// behind the clock by more than this, the sink ran dry and the count is off
+const double tone_synth_cc::resync_seconds = 0.1;
+// audio sent ahead of a start time that is kept for it, the oldest goes first
+const double tone_synth_cc::preroll_seconds = 1.0;
+// below this (-60 dBFS) the audio path is taken to be idle, not speaking
+const float tone_synth_cc::silence_level = 1e-3f;
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     make
+ */
+tone_synth_cc::sptr tone_synth_cc::make(double sample_rate, float amplitude, bool time_tags)
+{
+    return gnuradio::get_initial_sptr(new tone_synth_cc(sample_rate, amplitude, time_tags));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     tone_synth_cc
+ */
+tone_synth_cc::tone_synth_cc(double sample_rate, float amplitude, bool time_tags)
+    : gr::block("tone_synth_cc",
+          gr::io_signature::make(1, 1, sizeof(gr_complex)),// input_signature
+          gr::io_signature::make(1, 1, sizeof(gr_complex))),// output_signature
+      m_sample_rate(sample_rate),
+      m_amplitude(amplitude),
+      m_phase(0),
+      m_phase_inc(0),
+      m_gain(0),
+      m_time_tags(time_tags),
+      m_start_time(0),
+      m_epoch(0),
+      m_epoch_item(0),
+      m_preroll_started(false),
+      m_preroll_dropped(0)
+{
+    const int lut_size = 1 << lut_bits;
+    m_lut.resize(lut_size);
+    for(int i = 0; i < lut_size; i++)
+    {
+        double phase = 2.0 * M_PI * i / lut_size;
+        m_lut[i] = gr_complex(std::cos(phase), std::sin(phase));
+    }
+    m_gain_step = m_amplitude / std::max(1.0, ramp_time * m_sample_rate);
+    m_max_preroll = (size_t)(preroll_seconds * m_sample_rate);
+    Logger::debug("[tone_synth_cc::tone_synth_cc] sample_rate is "+std::to_string(m_sample_rate));
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     ~tone_synth_cc
+ */
+tone_synth_cc::~tone_synth_cc()
+{
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_schedule
+ */
+void tone_synth_cc::set_schedule(const std::vector<tone_t> &tones)
+{
+    std::deque<segment_t> schedule;
+    double total = 0;
+    for(const tone_t &tone : tones)
+    {
+        segment_t seg;
+        seg.phase_inc = get_phase_inc(tone.freq);
+        seg.nsamples = (uint64_t)std::llround(tone.duration * m_sample_rate);
+        if(0 < seg.nsamples)
+        {
+            schedule.push_back(seg);
+            total += tone.duration;
+        }
+    }
+    Logger::debug("[tone_synth_cc::set_schedule] "+std::to_string(schedule.size())+" tones, "+std::to_string(total)+" seconds");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_schedule.swap(schedule);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     clear_schedule
+ */
+void tone_synth_cc::clear_schedule()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_schedule.clear();
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     is_active
+ */
+bool tone_synth_cc::is_active()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (!m_schedule.empty() || 0 < m_gain);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     set_start_time
+ */
+void tone_synth_cc::set_start_time(double utc)
+{
+    Logger::debug("[tone_synth_cc::set_start_time] "+std::to_string(utc));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_start_time = utc;
+    // audio held for the last start belongs to that burst
+    m_preroll.clear();
+    m_preroll_started = false;
+    m_preroll_dropped = 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_start_time
+ */
+double tone_synth_cc::get_start_time()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_start_time;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     forecast
+ */
+void tone_synth_cc::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+    // the audio path is not needed while the tones are playing or held, or
+    // while the pre-roll is being played out
+    bool preroll;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        preroll = !m_preroll.empty();
+    }
+    ninput_items_required[0] = (is_active() || 0 < get_start_time() || preroll) ? 0 : noutput_items;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     general_work
+ */
+int tone_synth_cc::general_work(int noutput_items,
+                                gr_vector_int &ninput_items,
+                                gr_vector_const_void_star &input_items,
+                                gr_vector_void_star &output_items)
+{
+    const gr_complex *in = (const gr_complex *)input_items[0];
+    gr_complex *out = (gr_complex *)output_items[0];
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    update_epoch(nitems_written(0));
+    int nheld = hold(out, noutput_items);
+    if(0 < nheld)
+    {
+        if(m_schedule.empty())
+        {
+            // audio sent ahead of the start is kept for it, so the source
+            // never waits on this block
+            preroll(in, ninput_items[0]);
+        }
+        else
+        {
+            // tones replace the audio, so none of it is wanted
+            m_preroll.clear();
+        }
+        consume_each(ninput_items[0]);
+        return nheld;
+    }
+
+    if(!m_schedule.empty() || 0 < m_gain)
+    {
+        synthesize(out, noutput_items);
+        // throw away the audio so it does not back up behind the tones
+        m_preroll.clear();
+        consume_each(ninput_items[0]);
+        return noutput_items;
+    }
+
+    if(!m_preroll.empty())
+    {
+        // the audio goes out behind the pre-roll, through it, until the
+        // pre-roll runs dry
+        preroll(in, ninput_items[0]);
+        consume_each(ninput_items[0]);
+        int nitems = (int)std::min((size_t)noutput_items, m_preroll.size());
+        std::copy(m_preroll.begin(), m_preroll.begin() + nitems, out);
+        m_preroll.erase(m_preroll.begin(), m_preroll.begin() + nitems);
+        return nitems;
+    }
+
+    int nitems = std::min(noutput_items, ninput_items[0]);
+    std::memcpy(out, in, nitems * sizeof(gr_complex));
+    consume_each(nitems);
+    return nitems;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_time
+ */
+double tone_synth_cc::get_time(uint64_t item)
+{
+    return m_epoch + (int64_t)(item - m_epoch_item) / m_sample_rate;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     update_epoch
+ */
+void tone_synth_cc::update_epoch(uint64_t item)
+{
+    // the buffers after this block are empty at first and after the sink
+    // ran dry, so the next sample goes out about now; otherwise the count
+    // runs ahead of the clock by what they hold, and goes out on the count
+    double now = Sample_Time::now();
+    if(0 == m_epoch || now - get_time(item) > resync_seconds)
+    {
+        m_epoch = now;
+        m_epoch_item = item;
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     hold
+ */
+int tone_synth_cc::hold(gr_complex *out, int noutput_items)
+{
+    if(0 >= m_start_time)
+    {
+        return 0;
+    }
+
+    uint64_t item = nitems_written(0);
+    double wait = m_start_time - get_time(item);
+    int64_t nitems = std::llround(wait * m_sample_rate);
+    if(0 < nitems)
+    {
+        nitems = std::min<int64_t>(nitems, noutput_items);
+        std::fill(out, out + nitems, gr_complex(0, 0));
+        return (int)nitems;
+    }
+
+    if(wait < -resync_seconds)
+    {
+        Logger::warn("[tone_synth_cc::hold] started "+std::to_string(-wait)+" s late");
+    }
+    if(0 < m_preroll_dropped)
+    {
+        Logger::warn("[tone_synth_cc::hold] audio came more than "+std::to_string(preroll_seconds)+" s early, dropped the first "+std::to_string(m_preroll_dropped / m_sample_rate)+" s");
+    }
+    m_preroll_dropped = 0;
+    if(m_time_tags)
+    {
+        add_item_tag(0, item, Sample_Time::TX_TIME, Sample_Time::to_pmt(std::max(m_start_time, get_time(item))));
+    }
+    m_start_time = 0;
+    return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     preroll
+ */
+void tone_synth_cc::preroll(const gr_complex *in, int ninput_items)
+{
+    int i = 0;
+    if(!m_preroll_started)
+    {
+        // an idle audio path isn't exactly zero (a sound card never is), so
+        // the audio starts at the first sample above the noise
+        const float level = silence_level * silence_level;
+        while(i < ninput_items && std::norm(in[i]) < level)
+        {
+            i++;
+        }
+        m_preroll_started = (i < ninput_items);
+    }
+    m_preroll.insert(m_preroll.end(), in + i, in + ninput_items);
+
+    if(m_preroll.size() > m_max_preroll)
+    {
+        size_t excess = m_preroll.size() - m_max_preroll;
+        m_preroll.erase(m_preroll.begin(), m_preroll.begin() + excess);
+        m_preroll_dropped += excess;
+    }
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     get_phase_inc
+ */
+uint32_t tone_synth_cc::get_phase_inc(double freq)
+{
+    // a negative frequency wraps around to the top of the accumulator
+    double cycles = freq / m_sample_rate;
+    cycles -= std::floor(cycles);
+    return (uint32_t)(int64_t)std::llround(cycles * 4294967296.0);
+}
+
+/*--------------------------------------------------------------------------
+ * Function:
+ *     synthesize
+ */
+void tone_synth_cc::synthesize(gr_complex *out, int noutput_items)
+{
+    const int shift = 32 - lut_bits;
+    int i = 0;
+    while(i < noutput_items)
+    {
+        int nitems = noutput_items - i;
+        float target = 0;
+        if(!m_schedule.empty())
+        {
+            segment_t &seg = m_schedule.front();
+            m_phase_inc = seg.phase_inc;
+            target = m_amplitude;
+            nitems = (int)std::min<uint64_t>(nitems, seg.nsamples);
+            seg.nsamples -= nitems;
+            if(0 == seg.nsamples)
+            {
+                m_schedule.pop_front();
+            }
+        }
+
+        int end = i + nitems;
+        if(m_gain == target)
+        {
+            // steady state; no envelope to apply
+            for(; i < end; i++)
+            {
+                out[i] = m_lut[m_phase >> shift] * m_gain;
+                m_phase += m_phase_inc;
+            }
+        }
+        else
+        {
+            for(; i < end; i++)
+            {
+                if(m_gain < target)
+                {
+                    m_gain = std::min(target, m_gain + m_gain_step);
+                }
+                else if(m_gain > target)
+                {
+                    m_gain = std::max(target, m_gain - m_gain_step);
+                }
+                out[i] = m_lut[m_phase >> shift] * m_gain;
+                m_phase += m_phase_inc;
+            }
+        }
+    }
+}
@@ -0,0 +1,209 @@
+/**-------------------------------------------------------------------------
+ * @file tone_synth_cc.h
+ * @brief synthesize a tone schedule directly at the transmit rate
+ *
+ * Copyright 2019 Free Software Foundation, Inc.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ * ---------------------------------------------------------------------- */
+#ifndef __TONE_SYNTH_CC_H__
+#define __TONE_SYNTH_CC_H__
+
+/*--------------------------------------------------------------------------
+ * Include Files
+ * -----------------------------------------------------------------------*/
+#include <gnuradio/block.h>
+#include <gnuradio/gr_complex.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class tone_synth_cc;
+
+/**
+ * Passes the SSB audio path through until a tone schedule is loaded.  While
+ * a schedule is playing the input is discarded and a phase continuous tone
+ * is generated from a lookup table NCO, so the transmit timing follows the
+ * SDR sample clock instead of the sound card.
+ *
+ * A start time holds the output silent, audio and tones alike, until the
+ * sample that goes out at that UTC instant.  Audio that arrives early is
+ * kept in a pre-roll of up to preroll_seconds and goes out from that
+ * sample on, the oldest dropped if there is more; the input below
+ * silence_level ahead of it is let go so keying early doesn't delay it.
+ * The input is always consumed, so a capture device feeding this block
+ * never overruns while it waits.  The output is counted in
+ * samples from the system clock when it started, so buffering ahead of
+ * this block doesn't move the start.  With time tags on, that sample also
+ * carries a "tx_time" tag for a sink that can start it on its own clock.
+ */
+class tone_synth_cc : public gr::block
+{
+public:
+/*--------------------------------------------------------------------------
+ * Type Definitions
+ * -----------------------------------------------------------------------*/
+    /** shared pointer to the tone synthesizer */
+    typedef boost::shared_ptr<tone_synth_cc> sptr;
+
+    /** one entry of a tone schedule */
+    struct {
+        double freq;     /**< tone frequency in Hz, relative to the carrier */
+        double duration; /**< length of the tone in seconds */
+    } typedef tone_t;
+
+    static sptr make(double sample_rate, float amplitude = 0.5, bool time_tags = false);
+
+/*--------------------------------------------------------------------------
+ * Function Definitions
+ * -----------------------------------------------------------------------*/
+protected:
+    /** @brief Constructor
+     *
+     * @param sample_rate - output data rate
+     * @param amplitude - peak amplitude of the generated tone
+     * @param time_tags - tag the first sample after a start time
+     */
+    tone_synth_cc(double sample_rate, float amplitude, bool time_tags);
+
+public:
+    /** @brief Deconstructor
+     *
+     */
+    ~tone_synth_cc();
+
+    /** @brief replace the tone schedule
+     *
+     * The phase accumulator is not reset, so consecutive schedules stay
+     * phase continuous.
+     *
+     * @param tones - list of tones to play in order
+     * @return Void.
+     */
+    void set_schedule(const std::vector<tone_t> &tones);
+
+    /** @brief drop the rest of the schedule and ramp down
+     *
+     * @return Void.
+     */
+    void clear_schedule();
+
+    /** @brief true while tones are being generated
+     *
+     * @return bool
+     */
+    bool is_active();
+
+    /** @brief hold the output silent until a UTC instant
+     *
+     * @param utc - seconds since the epoch, 0 to start now
+     * @return Void.
+     */
+    void set_start_time(double utc);
+
+    /** @brief the start time being waited for
+     *
+     * @return double - UTC seconds, 0 if none
+     */
+    double get_start_time();
+
+    void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+    int general_work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+
+private:
+    struct {
+        uint32_t phase_inc;
+        uint64_t nsamples;
+    } typedef segment_t;
+
+    static const int lut_bits;
+    static const double ramp_time;
+    static const double resync_seconds;
+    static const double preroll_seconds;
+    static const float silence_level;
+    double m_sample_rate;
+    float m_amplitude;
+    std::vector<gr_complex> m_lut;
+    uint32_t m_phase;
+    uint32_t m_phase_inc;
+    float m_gain;
+    float m_gain_step;
+    std::deque<segment_t> m_schedule;
+    std::mutex m_mutex;
+    bool m_time_tags;
+    double m_start_time;        // UTC, 0 for none
+    double m_epoch;             // UTC of sample m_epoch_item, 0 before any
+    uint64_t m_epoch_item;
+    std::deque<gr_complex> m_preroll;   // audio held for the start time
+    size_t m_max_preroll;
+    bool m_preroll_started;     // past the silence ahead of the audio
+    uint64_t m_preroll_dropped;
+
+    /** @brief the UTC an output sample goes out at
+     *
+     * @param item - absolute sample number
+     * @return double
+     */
+    double get_time(uint64_t item);
+
+    /** @brief count output samples from the system clock, again if the
+     *         sink ran dry and the count fell behind
+     *
+     * @param item - the next sample to be written
+     * @return Void.
+     */
+    void update_epoch(uint64_t item);
+
+    /** @brief silence up to the start time, and tag the first sample
+     *         after it
+     *
+     * @param out - output buffer
+     * @param noutput_items - room in it
+     * @return int - samples of silence written, 0 once started
+     */
+    int hold(gr_complex *out, int noutput_items);
+
+    /** @brief keep audio for the start time, from the first sample above
+     *         silence_level, and no more than preroll_seconds of it
+     *
+     * @param in - input buffer
+     * @param ninput_items - samples in it
+     * @return Void.
+     */
+    void preroll(const gr_complex *in, int ninput_items);
+
+    /** @brief convert a frequency to an NCO phase increment
+     *
+     * @param freq - frequency in Hz
+     * @return uint32_t
+     */
+    uint32_t get_phase_inc(double freq);
+
+    /** @brief generate tone samples
+     *
+     * @param out - output buffer
+     * @param noutput_items - number of samples to generate
+     * @return Void.
+     */
+    void synthesize(gr_complex *out, int noutput_items);
+};
+
+#endif /* __TONE_SYNTH_CC_H__ */